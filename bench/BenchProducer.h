@@ -0,0 +1,314 @@
+#pragma once
+
+#if !defined(_WIN32)
+
+#include <OceanAudio/BridgeIntegrity.h>
+#include <OceanAudio/BridgeSharedMemory.h>
+#include <OceanAudio/BroadcastRing.h>
+#include <OceanAudio/InterleaveKernels.h>
+#include <OceanAudio/PosixSharedMemory.h>
+#include <OceanAudio/WakeupSignalling.h>
+
+#if defined(__linux__)
+#include <OceanAudio/UnixSocketTransport.h>
+#endif
+
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace oceanaudio::bench
+{
+// Publishes the ring exactly like BridgeClient's POSIX backend, without pulling JUCE
+// into the benchmarks.
+class PosixBenchProducer
+{
+public:
+    // Reserves payload for at least `reservedChannels` x `reservedFramesPerBlock`, so
+    // changeFormat() can move to any format within that.
+    bool create(std::uint32_t channels,
+                std::uint32_t sampleRate,
+                std::uint32_t framesPerBlock,
+                std::uint32_t reservedChannels = 0,
+                std::uint32_t reservedFramesPerBlock = 0)
+    {
+        return createMapping(channels, sampleRate, framesPerBlock, reservedChannels, reservedFramesPerBlock, false);
+    }
+
+    // Like create(), but keeps a compatible mapping a dead producer left behind the way
+    // BridgeClient does: its readers keep their slots and see a format change.
+    bool takeOver(std::uint32_t channels,
+                  std::uint32_t sampleRate,
+                  std::uint32_t framesPerBlock,
+                  std::uint32_t reservedChannels = 0,
+                  std::uint32_t reservedFramesPerBlock = 0)
+    {
+        return createMapping(channels, sampleRate, framesPerBlock, reservedChannels, reservedFramesPerBlock, true);
+    }
+
+#if defined(__linux__)
+    // Like create(), but over BridgeClient's socket transport: the ring in a memfd, the
+    // events as eventfds, announced on `socketPath`. Consumers are let in by
+    // acceptConsumers() and heartbeat().
+    bool createOverSocket(std::uint32_t channels,
+                          std::uint32_t sampleRate,
+                          std::uint32_t framesPerBlock,
+                          const std::string& socketPath)
+    {
+        return socketServer.listen(socketPath) && createMapping(channels, sampleRate, framesPerBlock, 0, 0, false);
+    }
+
+    // What BridgeClient's heartbeat timer does for the socket: accept waiting consumers
+    // and hand them the ring.
+    void acceptConsumers()
+    {
+        socketServer.acceptPending();
+    }
+#endif
+
+    // What BridgeClient's heartbeat timer does: beat, evict readers that have been
+    // silent for `readerTimeoutNs`, and report whether any reader is still alive.
+    bool heartbeat(std::uint64_t readerTimeoutNs)
+    {
+#if defined(__linux__)
+        socketServer.acceptPending();
+#endif
+        if (header == nullptr)
+        {
+            return false;
+        }
+
+        const auto now = sharedClockNanoseconds();
+        header->producerHeartbeat.beat(now);
+        header->evictDeadReaders(now, readerTimeoutNs);
+        return header->anyReaderAlive(now, readerTimeoutNs);
+    }
+
+    // Renegotiates in place the way BridgeClient::publishFormat does; fails if the new
+    // format does not fit the reservation made by create().
+    bool changeFormat(std::uint32_t channels, std::uint32_t sampleRate, std::uint32_t framesPerBlock)
+    {
+        const auto capacity = ringCapacityFor(framesPerBlock);
+        if (header == nullptr || !header->fitsReservation(channels, capacity))
+        {
+            return false;
+        }
+
+        const auto previousCapacity = header->frameCapacity.load(std::memory_order_relaxed);
+        const auto startFrame = header->writeCursor.load(std::memory_order_relaxed) + previousCapacity;
+        producer.setFormatGeneration(header->writeFormat(channels, sampleRate, capacity, framesPerBlock, startFrame));
+        header->writeCursor.store(startFrame, std::memory_order_release);
+        producer.attach(header->writeCursor, header->readers, capacity, &header->readerDetachments);
+
+        header->wakeSleepingReaders([this](std::uint32_t slot)
+        {
+            header->wakeSignals.fetch_add(1, std::memory_order_relaxed);
+            readyEvents[slot].set();
+        });
+        return true;
+    }
+
+    // True while writes are held back for readers to adopt the last format change.
+    [[nodiscard]] bool isAwaitingReaders() const noexcept
+    {
+        return producer.isAwaitingAcknowledgements();
+    }
+
+    void destroy()
+    {
+        producer.detach();
+        if (header != nullptr)
+        {
+            header->formatGeneration.store(SharedAudioRingBufferHeader::kFormatRetired, std::memory_order_release);
+            header->wakeSleepingReaders([this](std::uint32_t slot) { readyEvents[slot].set(); });
+        }
+        header = nullptr;
+#if defined(__linux__)
+        socketServer.close();
+#endif
+        for (auto& readyEvent : readyEvents)
+        {
+            readyEvent.close();
+        }
+        consumedEvent.close();
+        mapping.close();
+    }
+
+    bool write(const float* const* samples, std::uint32_t numChannels, std::uint32_t frames)
+    {
+        SpscRingRegions regions;
+        if (header == nullptr || !producer.prepareWrite(frames, regions))
+        {
+            if (header != nullptr)
+            {
+                header->overruns.fetch_add(1, std::memory_order_relaxed);
+            }
+            ++unpublishedDrops;
+            return false;
+        }
+
+        const std::size_t stride = header->channels.load(std::memory_order_relaxed);
+        interleave::fromPlanar(samples, numChannels, 0,
+                               header->payload() + regions.first.offset * stride, stride, regions.first.frames);
+        interleave::fromPlanar(samples, numChannels, regions.first.frames,
+                               header->payload() + regions.second.offset * stride, stride, regions.second.frames);
+        std::uint32_t checksum = 0;
+        if (blockChecksums)
+        {
+            checksum = crc32c(0, header->payload() + regions.first.offset * stride,
+                              regions.first.frames * stride * sizeof(float));
+            checksum = crc32c(checksum, header->payload() + regions.second.offset * stride,
+                              regions.second.frames * stride * sizeof(float));
+        }
+        const auto captureTime = sharedClockNanoseconds();
+        header->producerHeartbeat.beat(captureTime);
+        header->publishBlock(producer.cursor(), frames, captureTime, unpublishedDrops,
+                             blockChecksums ? kBlockHasChecksum : 0, checksum);
+        unpublishedDrops = 0;
+        header->writeTimestampNs.store(captureTime, std::memory_order_relaxed);
+        producer.commitWrite(frames);
+        if (signalEveryBlock)
+        {
+            header->wakeSignals.fetch_add(1, std::memory_order_relaxed);
+            readyEvents[0].set();
+            return true;
+        }
+
+        header->wakeSleepingReaders([this](std::uint32_t slot)
+        {
+            header->wakeSignals.fetch_add(1, std::memory_order_relaxed);
+            readyEvents[slot].set();
+        });
+        return true;
+    }
+
+    // Restores the pre-waiter-flag behaviour of signalling on every block, so the
+    // benchmarks can compare the two.
+    void setSignalEveryBlock(bool shouldSignal) noexcept
+    {
+        signalEveryBlock = shouldSignal;
+    }
+
+    // What BridgeClient::setBlockChecksums does: sum every block into its descriptor.
+    void setBlockChecksums(bool enabled) noexcept
+    {
+        blockChecksums = enabled;
+    }
+
+    [[nodiscard]] SharedAudioRingBufferHeader* getHeader() const noexcept
+    {
+        return header;
+    }
+
+private:
+    bool createMapping(std::uint32_t channels,
+                       std::uint32_t sampleRate,
+                       std::uint32_t framesPerBlock,
+                       std::uint32_t reservedChannels,
+                       std::uint32_t reservedFramesPerBlock,
+                       bool keepCompatibleHeader)
+    {
+        const auto capacity = ringCapacityFor(framesPerBlock);
+        const auto reservedCapacity = ringCapacityFor(framesPerBlock > reservedFramesPerBlock ? framesPerBlock
+                                                                                               : reservedFramesPerBlock);
+        const auto payloadChannels = channels > reservedChannels ? channels : reservedChannels;
+        const std::size_t requiredBytes = sizeof(SharedAudioRingBufferHeader)
+                                          + static_cast<std::size_t>(reservedCapacity) * payloadChannels * sizeof(float);
+        bool newlyCreated = true;
+#if defined(__linux__)
+        const bool overSocket = socketServer.isListening();
+        const bool created = overSocket ? mapping.createAnonymous(posix::kAnonymousMappingName, requiredBytes)
+                                        : mapping.create(posix::kMappingName, requiredBytes, newlyCreated);
+#else
+        const bool created = mapping.create(posix::kMappingName, requiredBytes, newlyCreated);
+#endif
+        if (!created)
+        {
+            return false;
+        }
+
+        if (!keepCompatibleHeader || newlyCreated
+            || checkSharedLayoutVersion(mapping.data()) != SharedLayoutStatus::Compatible)
+        {
+            std::memset(mapping.data(), 0, requiredBytes);
+            new (mapping.data()) SharedAudioRingBufferHeader {};
+        }
+        header = static_cast<SharedAudioRingBufferHeader*>(mapping.data());
+        header->payloadCapacityBytes = requiredBytes - sizeof(SharedAudioRingBufferHeader);
+        header->producerHeartbeat.beat(sharedClockNanoseconds());
+
+        const auto startFrame = header->writeCursor.load(std::memory_order_relaxed)
+                                + header->frameCapacity.load(std::memory_order_relaxed);
+        producer.setFormatGeneration(header->writeFormat(channels, sampleRate, capacity, framesPerBlock, startFrame));
+        header->writeCursor.store(startFrame, std::memory_order_release);
+
+        producer.attach(header->writeCursor, header->readers, capacity, &header->readerDetachments);
+#if defined(__linux__)
+        if (overSocket)
+        {
+            return createSocketEvents();
+        }
+#endif
+        for (std::uint32_t slot = 0; slot < kMaxBroadcastReaders; ++slot)
+        {
+            if (!readyEvents[slot].create(readerEventName(std::string(posix::kAudioReadyEventName), slot), false))
+            {
+                return false;
+            }
+        }
+        return consumedEvent.create(posix::kAudioConsumedEventName, true);
+    }
+
+#if defined(__linux__)
+    bool createSocketEvents()
+    {
+        int descriptors[posix::kAnnouncedDescriptorCount];
+        descriptors[posix::kAnnouncedRingDescriptor] = mapping.descriptor();
+        if (!consumedEvent.createDescriptor(true))
+        {
+            return false;
+        }
+        descriptors[posix::kAnnouncedConsumedEventDescriptor] = consumedEvent.descriptor();
+        for (std::uint32_t slot = 0; slot < kMaxBroadcastReaders; ++slot)
+        {
+            if (!readyEvents[slot].createDescriptor(false))
+            {
+                return false;
+            }
+            descriptors[posix::kAnnouncedReadyEventDescriptor + slot] = readyEvents[slot].descriptor();
+        }
+
+        posix::SocketBridgeAnnouncement announcement;
+        announcement.layoutVersion = SharedAudioRingBufferHeader::kVersion;
+        announcement.descriptorCount = posix::kAnnouncedDescriptorCount;
+        socketServer.announce(announcement, descriptors);
+        return true;
+    }
+#endif
+
+    static std::uint32_t ringCapacityFor(std::uint32_t framesPerBlock) noexcept
+    {
+        std::uint32_t capacity = 1;
+        while (capacity < framesPerBlock * 16)
+        {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    posix::SharedMapping mapping;
+    posix::NamedEvent readyEvents[kMaxBroadcastReaders];
+    posix::NamedEvent consumedEvent;
+    SharedAudioRingBufferHeader* header = nullptr;
+    BroadcastRingProducer producer;
+    bool signalEveryBlock = false;
+    bool blockChecksums = false;
+    // Blocks write() refused since the last one it published.
+    std::uint32_t unpublishedDrops = 0;
+#if defined(__linux__)
+    posix::BridgeSocketServer socketServer;
+#endif
+};
+} // namespace oceanaudio::bench
+
+#endif
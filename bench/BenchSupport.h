@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace oceanaudio::bench
+{
+using Clock = std::chrono::steady_clock;
+
+inline std::uint64_t nowNanoseconds() noexcept
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+
+// Pins the calling thread to one logical CPU; returns false if the OS refused.
+inline bool pinCurrentThread(int cpu)
+{
+    if (cpu < 0)
+    {
+        return false;
+    }
+
+#if defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR {1} << cpu) != 0;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+inline void cpuRelax() noexcept
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Spins with a pause hint, then starts yielding so two spinning threads still make
+// progress when they share a CPU.
+class Backoff
+{
+public:
+    void pause() noexcept
+    {
+        if (++spins < kSpinLimit)
+        {
+            cpuRelax();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void reset() noexcept
+    {
+        spins = 0;
+    }
+
+private:
+    static constexpr int kSpinLimit = 256;
+    int spins = 0;
+};
+
+// Minimal "--name value" lookup so the bench executables need no option parser.
+inline const char* findOption(int argc, char** argv, const char* name)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::strcmp(argv[i], name) == 0)
+        {
+            return argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+inline int intOption(int argc, char** argv, const char* name, int fallback)
+{
+    const auto* value = findOption(argc, argv, name);
+    return value != nullptr ? std::atoi(value) : fallback;
+}
+
+inline double doubleOption(int argc, char** argv, const char* name, double fallback)
+{
+    const auto* value = findOption(argc, argv, name);
+    return value != nullptr ? std::atof(value) : fallback;
+}
+} // namespace oceanaudio::bench
@@ -0,0 +1,424 @@
+// Bridge stress sweep: the producer and BridgeConsumer under load, for tracking ring
+// performance from release to release.
+//
+// Every case publishes a fresh ring the way BridgeClient does and attaches one Stall
+// reader (the virtual microphone's policy), either on a second thread or in a forked
+// process. The reader can be made to stall for `stall` ms every `--stall-period-ms`.
+// Each case runs two phases on its own mapping:
+//   - throughput: the producer writes flat out, held back only by the reader. Reports
+//     frames/s and CPU time per frame (both sides, including a forked reader).
+//   - realtime: blocks paced at the device rate; a block that does not fit is dropped
+//     as BridgeClient drops it. Reports the per-block latency distribution (capture to
+//     release, from the shared residency histogram), overruns (dropped blocks),
+//     underruns and CPU time per frame.
+// Results go out as JSON (stdout, or --json PATH with a table on stdout). The
+// OceanAudioBridgeBenchReport target runs the default sweep into the build tree.
+//
+// Usage: OceanAudioBridgeBench [--modes threads,processes] [--blocks 16,32,...,4096]
+//                              [--channels 1,2,8] [--stalls 0,5,50] [--stall-period-ms N]
+//                              [--rate N] [--seconds N] [--producer-cpu N] [--consumer-cpu N]
+//                              [--json PATH]
+
+#include "BenchProducer.h"
+#include "BenchSupport.h"
+
+#include "BridgeConsumer.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef OCEANAUDIO_VERSION
+    #define OCEANAUDIO_VERSION ""
+#endif
+
+namespace
+{
+constexpr wchar_t kMappingName[] = L"Global\\OceanAudio_AudioRing";
+constexpr wchar_t kReadyEventName[] = L"Global\\OceanAudio_AudioReady";
+constexpr wchar_t kConsumedEventName[] = L"Global\\OceanAudio_AudioConsumed";
+
+constexpr std::uint64_t kHeartbeatIntervalNs = 50'000'000;
+constexpr std::uint64_t kReaderTimeoutNs = std::uint64_t {oceanaudio::kDefaultPeerTimeoutMs} * 1'000'000;
+// How long the reader gets to attach, and to drain what is left after a phase.
+constexpr std::uint64_t kAttachTimeoutNs = 2'000'000'000;
+constexpr std::uint64_t kDrainTimeoutNs = 200'000'000;
+
+struct Options
+{
+    std::vector<int> modes {0, 1};
+    std::vector<int> blockSizes {16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+    std::vector<int> channelCounts {1, 2, 8};
+    std::vector<int> stallsMs {0, 5, 50};
+    int stallPeriodMs = 250;
+    std::uint32_t sampleRate = 48000;
+    double seconds = 0.25;
+    int producerCpu = 0;
+    int consumerCpu = 1;
+    const char* jsonPath = nullptr;
+};
+
+struct Case
+{
+    bool processes = false;
+    std::uint32_t framesPerBlock = 0;
+    std::uint32_t channels = 0;
+    int stallMs = 0;
+};
+
+struct PhaseResult
+{
+    bool ok = false;
+    double seconds = 0.0;
+    std::uint64_t framesWritten = 0;
+    std::uint64_t framesConsumed = 0;
+    double framesPerSecond = 0.0;
+    double cpuNsPerFrame = 0.0;
+    std::uint64_t blocksTimed = 0;
+    std::uint64_t latencyP50Us = 0;
+    std::uint64_t latencyP99Us = 0;
+    std::uint64_t latencyP999Us = 0;
+    std::uint64_t latencyMaxUs = 0;
+    std::uint64_t overruns = 0;
+    std::uint64_t underruns = 0;
+};
+
+std::vector<int> listOption(int argc, char** argv, const char* name, std::vector<int> fallback)
+{
+    const auto* value = oceanaudio::bench::findOption(argc, argv, name);
+    if (value == nullptr)
+    {
+        return fallback;
+    }
+
+    std::vector<int> values;
+    const std::string text = value;
+    std::size_t start = 0;
+    while (start <= text.size())
+    {
+        const auto end = text.find(',', start);
+        const auto item = text.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        if (!item.empty())
+        {
+            values.push_back(item == "threads" ? 0 : item == "processes" ? 1 : std::atoi(item.c_str()));
+        }
+        if (end == std::string::npos)
+        {
+            break;
+        }
+        start = end + 1;
+    }
+    return values;
+}
+
+std::uint64_t cpuNanoseconds(int who)
+{
+    rusage usage {};
+    ::getrusage(who, &usage);
+    return (static_cast<std::uint64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1'000'000'000ull)
+           + static_cast<std::uint64_t>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000ull;
+}
+
+// The reader: drains until the producer retires the mapping, stalling on schedule.
+void runConsumer(const Options& options, const Case& benchCase)
+{
+    oceanaudio::bench::pinCurrentThread(options.consumerCpu);
+
+    BridgeConsumer consumer;
+    const auto openDeadline = oceanaudio::bench::nowNanoseconds() + kAttachTimeoutNs;
+    while (!consumer.open(kMappingName, kReadyEventName, kConsumedEventName))
+    {
+        if (oceanaudio::bench::nowNanoseconds() > openDeadline)
+        {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    std::vector<float> buffer;
+    buffer.reserve(static_cast<std::size_t>(benchCase.framesPerBlock) * benchCase.channels);
+    const auto stallPeriodNs = static_cast<std::uint64_t>(options.stallPeriodMs) * 1'000'000;
+    // The first stall comes half a period in, so even short phases see one.
+    auto nextStall = oceanaudio::bench::nowNanoseconds() + stallPeriodNs / 2;
+    while (!consumer.isRetired() && consumer.isProducerAlive())
+    {
+        if (benchCase.stallMs > 0 && oceanaudio::bench::nowNanoseconds() >= nextStall)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(benchCase.stallMs));
+            nextStall += stallPeriodNs;
+        }
+
+        if (consumer.waitForData(10))
+        {
+            std::uint32_t framesRead = 0;
+            while (consumer.readAvailableFrames(buffer, framesRead))
+            {
+            }
+        }
+    }
+}
+
+// Beats like BridgeClient's timer and waits for `condition`, or gives up after `timeoutNs`.
+template <typename Condition>
+bool waitWhileBeating(oceanaudio::bench::PosixBenchProducer& producer, std::uint64_t timeoutNs, Condition condition)
+{
+    const auto deadline = oceanaudio::bench::nowNanoseconds() + timeoutNs;
+    while (!condition())
+    {
+        if (oceanaudio::bench::nowNanoseconds() > deadline)
+        {
+            return false;
+        }
+        producer.heartbeat(kReaderTimeoutNs);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return true;
+}
+
+PhaseResult runPhase(const Options& options, const Case& benchCase, bool realtime)
+{
+    using namespace oceanaudio::bench;
+
+    PhaseResult result;
+    PosixBenchProducer producer;
+    if (!producer.create(benchCase.channels, options.sampleRate, benchCase.framesPerBlock))
+    {
+        return result;
+    }
+    auto* header = producer.getHeader();
+
+    const auto selfCpuBefore = cpuNanoseconds(RUSAGE_SELF);
+    const auto childCpuBefore = cpuNanoseconds(RUSAGE_CHILDREN);
+    pid_t child = -1;
+    std::thread consumerThread;
+    if (benchCase.processes)
+    {
+        std::fflush(stdout);
+        child = ::fork();
+        if (child == 0)
+        {
+            runConsumer(options, benchCase);
+            _exit(0);
+        }
+    }
+    else
+    {
+        consumerThread = std::thread([&]() { runConsumer(options, benchCase); });
+    }
+
+    pinCurrentThread(options.producerCpu);
+    const bool attached = waitWhileBeating(producer, kAttachTimeoutNs, [header]()
+    {
+        return (header->attachedReaders.load(std::memory_order_acquire) & 1u) != 0;
+    });
+
+    std::vector<float> channel(benchCase.framesPerBlock, 0.25f);
+    std::vector<const float*> planes(benchCase.channels, channel.data());
+    const auto& slot = header->readers[0];
+    const auto startCursor = slot.cursor.load(std::memory_order_acquire);
+    const auto overrunsBefore = header->overruns.load(std::memory_order_relaxed);
+    const auto blockPeriodNs = static_cast<std::uint64_t>(1.0e9 * benchCase.framesPerBlock / options.sampleRate);
+    const auto durationNs = static_cast<std::uint64_t>(options.seconds * 1.0e9);
+    const auto start = nowNanoseconds();
+    auto nextBlock = start;
+    auto nextBeat = start;
+    Backoff backoff;
+    while (attached && nowNanoseconds() - start < durationNs)
+    {
+        if (nowNanoseconds() >= nextBeat)
+        {
+            producer.heartbeat(kReaderTimeoutNs);
+            nextBeat += kHeartbeatIntervalNs;
+        }
+
+        if (realtime)
+        {
+            nextBlock += blockPeriodNs;
+            while (nowNanoseconds() < nextBlock)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+
+        if (producer.write(planes.data(), benchCase.channels, benchCase.framesPerBlock))
+        {
+            result.framesWritten += benchCase.framesPerBlock;
+            backoff.reset();
+        }
+        else if (!realtime)
+        {
+            backoff.pause();
+        }
+    }
+    const auto stopCursor = header->writeCursor.load(std::memory_order_acquire);
+    result.seconds = static_cast<double>(nowNanoseconds() - start) * 1.0e-9;
+
+    // Let the reader finish what it was given before taking the counters.
+    waitWhileBeating(producer, kDrainTimeoutNs, [&]()
+    {
+        return slot.cursor.load(std::memory_order_acquire) >= stopCursor;
+    });
+    result.framesConsumed = slot.cursor.load(std::memory_order_acquire) - startCursor;
+    result.blocksTimed = header->residency.totalCount.load(std::memory_order_relaxed);
+    result.latencyP50Us = header->residency.percentileUs(0.50);
+    result.latencyP99Us = header->residency.percentileUs(0.99);
+    result.latencyP999Us = header->residency.percentileUs(0.999);
+    result.latencyMaxUs = header->residency.maxValueUs.load(std::memory_order_relaxed);
+    result.underruns = slot.underruns.load(std::memory_order_relaxed);
+    // Flat out, a full ring only means "try again"; paced, it means a dropped block.
+    result.overruns = realtime ? header->overruns.load(std::memory_order_relaxed) - overrunsBefore : 0;
+
+    // Retiring the mapping is what tells the reader to go.
+    producer.destroy();
+    if (child > 0)
+    {
+        int status = 0;
+        ::waitpid(child, &status, 0);
+    }
+    if (consumerThread.joinable())
+    {
+        consumerThread.join();
+    }
+
+    const auto cpuNs = (cpuNanoseconds(RUSAGE_SELF) - selfCpuBefore) + (cpuNanoseconds(RUSAGE_CHILDREN) - childCpuBefore);
+    result.framesPerSecond = result.seconds > 0.0 ? static_cast<double>(result.framesConsumed) / result.seconds : 0.0;
+    result.cpuNsPerFrame = result.framesConsumed > 0 ? static_cast<double>(cpuNs)
+                                                           / static_cast<double>(result.framesConsumed)
+                                                     : 0.0;
+    result.ok = attached && result.framesConsumed > 0;
+    return result;
+}
+
+void writePhaseJson(std::FILE* out, const char* name, const PhaseResult& phase, bool last)
+{
+    std::fprintf(out,
+                 "      \"%s\": {\"ok\": %s, \"seconds\": %.3f, \"framesWritten\": %llu, \"framesConsumed\": %llu, "
+                 "\"framesPerSecond\": %.0f, \"cpuNsPerFrame\": %.2f, \"blocksTimed\": %llu, "
+                 "\"latencyUs\": {\"p50\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu}, "
+                 "\"overruns\": %llu, \"underruns\": %llu}%s\n",
+                 name,
+                 phase.ok ? "true" : "false",
+                 phase.seconds,
+                 static_cast<unsigned long long>(phase.framesWritten),
+                 static_cast<unsigned long long>(phase.framesConsumed),
+                 phase.framesPerSecond,
+                 phase.cpuNsPerFrame,
+                 static_cast<unsigned long long>(phase.blocksTimed),
+                 static_cast<unsigned long long>(phase.latencyP50Us),
+                 static_cast<unsigned long long>(phase.latencyP99Us),
+                 static_cast<unsigned long long>(phase.latencyP999Us),
+                 static_cast<unsigned long long>(phase.latencyMaxUs),
+                 static_cast<unsigned long long>(phase.overruns),
+                 static_cast<unsigned long long>(phase.underruns),
+                 last ? "" : ",");
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.modes = listOption(argc, argv, "--modes", options.modes);
+    options.blockSizes = listOption(argc, argv, "--blocks", options.blockSizes);
+    options.channelCounts = listOption(argc, argv, "--channels", options.channelCounts);
+    options.stallsMs = listOption(argc, argv, "--stalls", options.stallsMs);
+    options.stallPeriodMs = intOption(argc, argv, "--stall-period-ms", options.stallPeriodMs);
+    options.sampleRate = static_cast<std::uint32_t>(intOption(argc, argv, "--rate", 48000));
+    options.seconds = doubleOption(argc, argv, "--seconds", options.seconds);
+    options.producerCpu = intOption(argc, argv, "--producer-cpu", options.producerCpu);
+    options.consumerCpu = intOption(argc, argv, "--consumer-cpu", options.consumerCpu);
+    options.jsonPath = findOption(argc, argv, "--json");
+
+    std::FILE* json = stdout;
+    if (options.jsonPath != nullptr)
+    {
+        json = std::fopen(options.jsonPath, "w");
+        if (json == nullptr)
+        {
+            std::fprintf(stderr, "Unable to write %s\n", options.jsonPath);
+            return 1;
+        }
+        std::printf("%-9s %6s %3s %6s %4s %14s %10s %9s %9s %9s %9s %8s %9s\n",
+                    "mode", "frames", "ch", "stall", "", "frames/s", "cpu ns/fr", "p50 us", "p99 us", "p999 us",
+                    "max us", "overruns", "underruns");
+    }
+
+    std::fprintf(json, "{\n  \"bench\": \"OceanAudioBridgeBench\",\n  \"version\": \"%s\",\n", OCEANAUDIO_VERSION);
+    std::fprintf(json, "  \"layoutVersion\": %u,\n  \"sampleRate\": %u,\n  \"secondsPerPhase\": %.3f,\n",
+                 oceanaudio::SharedAudioRingBufferHeader::kVersion, options.sampleRate, options.seconds);
+    std::fprintf(json, "  \"stallPeriodMs\": %d,\n  \"hardwareThreads\": %u,\n  \"cases\": [\n",
+                 options.stallPeriodMs, std::thread::hardware_concurrency());
+
+    bool allOk = true;
+    bool firstCase = true;
+    for (const auto mode : options.modes)
+    {
+        for (const auto blockSize : options.blockSizes)
+        {
+            for (const auto channels : options.channelCounts)
+            {
+                for (const auto stallMs : options.stallsMs)
+                {
+                    if (blockSize <= 0 || channels <= 0 || stallMs < 0)
+                    {
+                        continue;
+                    }
+
+                    Case benchCase;
+                    benchCase.processes = mode != 0;
+                    benchCase.framesPerBlock = static_cast<std::uint32_t>(blockSize);
+                    benchCase.channels = static_cast<std::uint32_t>(channels);
+                    benchCase.stallMs = stallMs;
+
+                    const auto throughput = runPhase(options, benchCase, false);
+                    const auto realtime = runPhase(options, benchCase, true);
+                    allOk = allOk && throughput.ok && realtime.ok;
+
+                    const char* modeName = benchCase.processes ? "processes" : "threads";
+                    std::fprintf(json, "%s    {\n      \"mode\": \"%s\", \"framesPerBlock\": %d, \"channels\": %d, "
+                                       "\"stallMs\": %d,\n",
+                                 firstCase ? "" : ",\n", modeName, blockSize, channels, stallMs);
+                    writePhaseJson(json, "throughput", throughput, false);
+                    writePhaseJson(json, "realtime", realtime, true);
+                    std::fprintf(json, "    }");
+                    std::fflush(json);
+                    firstCase = false;
+
+                    if (json != stdout)
+                    {
+                        std::printf("%-9s %6d %3d %6d %4s %14.0f %10.1f %9llu %9llu %9llu %9llu %8llu %9llu\n",
+                                    modeName,
+                                    blockSize,
+                                    channels,
+                                    stallMs,
+                                    throughput.ok && realtime.ok ? "ok" : "FAIL",
+                                    throughput.framesPerSecond,
+                                    throughput.cpuNsPerFrame,
+                                    static_cast<unsigned long long>(realtime.latencyP50Us),
+                                    static_cast<unsigned long long>(realtime.latencyP99Us),
+                                    static_cast<unsigned long long>(realtime.latencyP999Us),
+                                    static_cast<unsigned long long>(realtime.latencyMaxUs),
+                                    static_cast<unsigned long long>(realtime.overruns),
+                                    static_cast<unsigned long long>(realtime.underruns));
+                        std::fflush(stdout);
+                    }
+                }
+            }
+        }
+    }
+
+    std::fprintf(json, "\n  ],\n  \"ok\": %s\n}\n", allOk ? "true" : "false");
+    if (json != stdout)
+    {
+        std::fclose(json);
+    }
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+// One producer feeding several readers through the broadcast ring.
+//
+// A paced producer publishes blocks the way BridgeClient does; a number of healthy
+// readers (real BridgeConsumers, one thread each) drain them, while one extra reader
+// stops reading for --stall-ms out of every second. The run is repeated with the
+// laggard on each lag policy. With "stall" the producer has to drop blocks and every
+// reader loses them; with "skip" and "detach" only the laggard loses audio and the
+// healthy readers keep the full rate.
+//
+// Usage: OceanAudioBroadcastBench [--readers N] [--stall-ms N] [--frames N]
+//                                 [--channels N] [--rate N] [--seconds N]
+
+#include "BenchProducer.h"
+#include "BenchSupport.h"
+
+#include "BridgeConsumer.h"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr wchar_t kMappingName[] = L"Global\\OceanAudio_AudioRing";
+constexpr wchar_t kReadyEventName[] = L"Global\\OceanAudio_AudioReady";
+constexpr wchar_t kConsumedEventName[] = L"Global\\OceanAudio_AudioConsumed";
+
+struct Options
+{
+    std::uint32_t healthyReaders = 2;
+    std::uint32_t stallMilliseconds = 400;
+    std::uint32_t framesPerBlock = 256;
+    std::uint32_t channels = 2;
+    std::uint32_t sampleRate = 48000;
+    double seconds = 4.0;
+};
+
+struct ReaderResult
+{
+    BridgeConsumer::Statistics stats;
+};
+
+void runReader(const Options& options,
+               oceanaudio::ReaderLagPolicy policy,
+               bool lagging,
+               std::atomic<std::uint32_t>& readersReady,
+               std::atomic<bool>& stop,
+               ReaderResult& result)
+{
+    BridgeConsumer consumer;
+    if (!consumer.open(kMappingName, kReadyEventName, kConsumedEventName, policy))
+    {
+        std::fprintf(stderr, "Unable to attach a reader\n");
+        std::exit(1);
+    }
+    readersReady.fetch_add(1, std::memory_order_release);
+
+    std::vector<float> buffer;
+    buffer.reserve(static_cast<std::size_t>(options.framesPerBlock) * options.channels);
+    const auto stallNs = static_cast<std::uint64_t>(options.stallMilliseconds) * 1'000'000;
+    const auto startTime = oceanaudio::bench::nowNanoseconds();
+
+    while (!stop.load(std::memory_order_acquire))
+    {
+        if (lagging && (oceanaudio::bench::nowNanoseconds() - startTime) % 1'000'000'000 < stallNs)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        if (consumer.waitForData(10, 50))
+        {
+            std::uint32_t framesRead = 0;
+            while (consumer.readAvailableFrames(buffer, framesRead))
+            {
+            }
+        }
+    }
+
+    result.stats = consumer.getStatistics();
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.healthyReaders = static_cast<std::uint32_t>(intOption(argc, argv, "--readers", 2));
+    options.stallMilliseconds = static_cast<std::uint32_t>(intOption(argc, argv, "--stall-ms", 400));
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 256));
+    options.channels = static_cast<std::uint32_t>(intOption(argc, argv, "--channels", 2));
+    options.sampleRate = static_cast<std::uint32_t>(intOption(argc, argv, "--rate", 48000));
+    options.seconds = doubleOption(argc, argv, "--seconds", options.seconds);
+
+    if (options.healthyReaders + 1 > oceanaudio::kMaxBroadcastReaders)
+    {
+        std::fprintf(stderr, "At most %u healthy readers\n", oceanaudio::kMaxBroadcastReaders - 1);
+        return 1;
+    }
+
+    std::printf("%u healthy readers + 1 stalling %u ms/s, %u frames x %u channels @ %u Hz, %.0f s\n",
+                options.healthyReaders,
+                options.stallMilliseconds,
+                options.framesPerBlock,
+                options.channels,
+                options.sampleRate,
+                options.seconds);
+    std::printf("%-8s %10s %14s %14s %12s %12s %12s %8s\n",
+                "laggard", "overruns", "healthy fr/s", "laggard fr/s", "skipped", "overwritten",
+                "detached", "rejoins");
+
+    for (const auto policy : {oceanaudio::ReaderLagPolicy::Stall,
+                              oceanaudio::ReaderLagPolicy::Skip,
+                              oceanaudio::ReaderLagPolicy::Detach})
+    {
+        PosixBenchProducer producer;
+        if (!producer.create(options.channels, options.sampleRate, options.framesPerBlock))
+        {
+            std::fprintf(stderr, "Unable to create the shared ring\n");
+            return 1;
+        }
+
+        const auto readerCount = options.healthyReaders + 1;
+        std::atomic<std::uint32_t> readersReady {0};
+        std::atomic<bool> stop {false};
+        std::vector<ReaderResult> results(readerCount);
+        std::vector<std::thread> readers;
+        for (std::uint32_t index = 0; index < readerCount; ++index)
+        {
+            const bool lagging = index == readerCount - 1;
+            readers.emplace_back([&, index, lagging]()
+            {
+                runReader(options,
+                          lagging ? policy : oceanaudio::ReaderLagPolicy::Stall,
+                          lagging,
+                          readersReady,
+                          stop,
+                          results[index]);
+            });
+            // Attach in order so the laggard takes the last slot.
+            while (readersReady.load(std::memory_order_acquire) <= index)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        std::vector<std::vector<float>> channelData(options.channels,
+                                                    std::vector<float>(options.framesPerBlock, 0.25f));
+        std::vector<const float*> channelPointers;
+        for (const auto& channel : channelData)
+        {
+            channelPointers.push_back(channel.data());
+        }
+
+        const auto blockPeriodNs = static_cast<std::uint64_t>(1.0e9 * options.framesPerBlock / options.sampleRate);
+        const auto durationNs = static_cast<std::uint64_t>(options.seconds * 1.0e9);
+        const auto startTime = nowNanoseconds();
+        auto nextBlockTime = startTime;
+        while (nowNanoseconds() - startTime < durationNs)
+        {
+            nextBlockTime += blockPeriodNs;
+            while (nowNanoseconds() < nextBlockTime)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            producer.write(channelPointers.data(), options.channels, options.framesPerBlock);
+        }
+
+        const auto elapsed = static_cast<double>(nowNanoseconds() - startTime) * 1.0e-9;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        stop.store(true, std::memory_order_release);
+        for (auto& reader : readers)
+        {
+            reader.join();
+        }
+
+        const auto* header = producer.getHeader();
+        const auto overruns = header->overruns.load(std::memory_order_relaxed);
+        const auto detachments = header->readerDetachments.load(std::memory_order_relaxed);
+        producer.destroy();
+
+        double healthyFrames = 0.0;
+        for (std::uint32_t index = 0; index + 1 < readerCount; ++index)
+        {
+            healthyFrames += static_cast<double>(results[index].stats.totalFramesRead);
+        }
+        const auto& laggard = results.back().stats;
+
+        std::printf("%-8s %10u %14.0f %14.0f %12llu %12llu %12u %8llu\n",
+                    oceanaudio::toString(policy),
+                    overruns,
+                    healthyFrames / options.healthyReaders / elapsed,
+                    static_cast<double>(laggard.totalFramesRead) / elapsed,
+                    static_cast<unsigned long long>(laggard.framesSkipped),
+                    static_cast<unsigned long long>(laggard.framesOverwritten),
+                    detachments,
+                    static_cast<unsigned long long>(laggard.rejoins));
+    }
+
+    return 0;
+}
@@ -0,0 +1,298 @@
+// Copy path versus Direct mode, from the ring write to the capture endpoint.
+//
+// A producer writes paced blocks into the bridge ring, beating as BridgeClient does.
+// Each row moves the audio to a capture endpoint a different way:
+//   - copy: ConsumerEngine wakes for every block and hands it to a sink that does what
+//     SubmitFrames costs today: copy into the packet buffer, the kernel's copy into its
+//     system buffer, and the driver's copy into the capture buffer.
+//   - direct: DirectBridgeSupervisor offers the ring to a StandInCapture through
+//     QuerySharedBuffer; the stand-in reads it on its own clock with a single copy into
+//     its capture buffer, and the service only polls.
+//   - refused: the same offer to a stand-in that answers Copy, which must fall back to
+//     the copy path.
+// "copies" is bytes copied after the ring write per byte produced. CPU time and
+// voluntary context switches are for the whole process, producer included, so only
+// the differences between rows mean something. The copy rows leave out the driver's
+// own capture clock, which the real copy path wakes for on top of the service.
+//
+// Usage: OceanAudioDirectModeBench [--frames N] [--rate N] [--channels N] [--seconds N]
+
+#include "BenchProducer.h"
+#include "BenchSupport.h"
+
+#include "ConsumerEngine.h"
+#include "DirectBridgeSupervisor.h"
+#include "StandInCapture.h"
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr std::uint32_t kHeartbeatIntervalMs = 50;
+
+struct Options
+{
+    std::uint32_t framesPerBlock = 128;
+    std::uint32_t sampleRate = 48000;
+    std::uint32_t channels = 2;
+    std::uint32_t seconds = 3;
+};
+
+struct Result
+{
+    bool ok = false;
+    const char* mode = "";
+    double framesPerSecond = 0.0;
+    double copies = 0.0;
+    double consumerWakeupsPerSecond = 0.0;
+    double contextSwitchesPerSecond = 0.0;
+    double cpuPercent = 0.0;
+};
+
+// What the SubmitFrames path costs per block: DriverIoctlSink's copy into its packet
+// buffer, the I/O manager's copy into the system buffer (METHOD_BUFFERED) and the
+// driver's copy from there into its capture buffer.
+class SubmitFramesSink final : public FrameSink
+{
+public:
+    bool open(const StreamFormat& newFormat) override
+    {
+        format = newFormat;
+        const auto bytes = static_cast<std::size_t>(format.framesPerBlock) * format.bytesPerFrame();
+        packetBuffer.assign(bytes, std::byte {});
+        systemBuffer.assign(bytes, std::byte {});
+        captureBuffer.assign(bytes, std::byte {});
+        return true;
+    }
+
+    bool write(const FrameSpans& frames) override
+    {
+        const std::size_t frameBytes = format.bytesPerFrame();
+        const std::size_t firstBytes = frames.firstFrames * frameBytes;
+        const std::size_t totalBytes = frames.totalFrames() * frameBytes;
+        if (totalBytes > packetBuffer.size())
+        {
+            return false;
+        }
+
+        std::memcpy(packetBuffer.data(), frames.first, firstBytes);
+        std::memcpy(packetBuffer.data() + firstBytes, frames.second, totalBytes - firstBytes);
+        std::memcpy(systemBuffer.data(), packetBuffer.data(), totalBytes);
+        std::memcpy(captureBuffer.data(), systemBuffer.data(), totalBytes);
+        bytesCopied += 3 * totalBytes;
+        return true;
+    }
+
+    void close() override
+    {
+    }
+
+    [[nodiscard]] std::uint64_t getBytesCopied() const noexcept override
+    {
+        return bytesCopied;
+    }
+
+private:
+    StreamFormat format;
+    std::vector<std::byte> packetBuffer;
+    std::vector<std::byte> systemBuffer;
+    std::vector<std::byte> captureBuffer;
+    std::uint64_t bytesCopied = 0;
+};
+
+struct ProcessUsage
+{
+    double cpuSeconds = 0.0;
+    long voluntarySwitches = 0;
+};
+
+ProcessUsage processUsage()
+{
+    rusage usage {};
+    ::getrusage(RUSAGE_SELF, &usage);
+    ProcessUsage result;
+    result.cpuSeconds = static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+                        + static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1.0e-6;
+    result.voluntarySwitches = usage.ru_nvcsw;
+    return result;
+}
+
+// Writes paced blocks for the configured time, beating every kHeartbeatIntervalMs.
+// Returns the frames written.
+std::uint64_t produce(oceanaudio::bench::PosixBenchProducer& producer, const Options& options)
+{
+    std::vector<float> channel(options.framesPerBlock, 0.25f);
+    std::vector<const float*> planes(options.channels, channel.data());
+    const auto period = std::chrono::nanoseconds(std::uint64_t {options.framesPerBlock} * 1'000'000'000ull
+                                                 / options.sampleRate);
+    const auto timeoutNs = std::uint64_t {oceanaudio::kDefaultPeerTimeoutMs} * 1'000'000;
+
+    const auto start = oceanaudio::bench::Clock::now();
+    const auto end = start + std::chrono::seconds(options.seconds);
+    auto nextBlock = start;
+    auto nextBeat = start;
+    std::uint64_t framesWritten = 0;
+    while (oceanaudio::bench::Clock::now() < end)
+    {
+        std::this_thread::sleep_until(nextBlock);
+        nextBlock += period;
+        if (oceanaudio::bench::Clock::now() >= nextBeat)
+        {
+            producer.heartbeat(timeoutNs);
+            nextBeat += std::chrono::milliseconds(kHeartbeatIntervalMs);
+        }
+        if (producer.write(planes.data(), options.channels, options.framesPerBlock))
+        {
+            framesWritten += options.framesPerBlock;
+        }
+    }
+    return framesWritten;
+}
+
+void finish(Result& result,
+            const Options& options,
+            std::uint64_t framesWritten,
+            std::uint64_t framesDelivered,
+            std::uint64_t bytesCopied,
+            std::uint64_t wakeups,
+            const ProcessUsage& before)
+{
+    const auto after = processUsage();
+    const auto seconds = static_cast<double>(options.seconds);
+    const auto bytesWritten = static_cast<double>(framesWritten) * options.channels * sizeof(float);
+    result.framesPerSecond = static_cast<double>(framesDelivered) / seconds;
+    result.copies = bytesWritten > 0.0 ? static_cast<double>(bytesCopied) / bytesWritten : 0.0;
+    result.consumerWakeupsPerSecond = static_cast<double>(wakeups) / seconds;
+    result.contextSwitchesPerSecond = static_cast<double>(after.voluntarySwitches - before.voluntarySwitches) / seconds;
+    result.cpuPercent = (after.cpuSeconds - before.cpuSeconds) / seconds * 100.0;
+}
+
+// The copy path as the service runs it: one engine thread, woken per block.
+Result runCopy(const Options& options, oceanaudio::bench::PosixBenchProducer& producer, const char* mode)
+{
+    Result result;
+    result.mode = mode;
+
+    SubmitFramesSink sink;
+    ConsumerEngine::Settings settings;
+    settings.residency.lock = false;
+    ConsumerEngine engine(sink, settings);
+    if (!engine.connect())
+    {
+        return result;
+    }
+
+    std::atomic<bool> stop {false};
+    ConsumerEngine::Statistics stats;
+    const auto before = processUsage();
+    std::thread consumer([&]()
+    {
+        engine.run([&]()
+        {
+            return stop.load(std::memory_order_relaxed);
+        });
+        stats = engine.getStatistics();
+    });
+
+    const auto framesWritten = produce(producer, options);
+    stop.store(true, std::memory_order_relaxed);
+    consumer.join();
+    engine.disconnect();
+
+    finish(result, options, framesWritten, stats.framesDelivered, stats.bytesCopied, stats.wakeups, before);
+    result.ok = stats.framesDelivered > 0;
+    return result;
+}
+
+Result runDirect(const Options& options, oceanaudio::bench::PosixBenchProducer& producer, bool acceptDirect)
+{
+    StandInCapture::Settings captureSettings;
+    captureSettings.acceptDirect = acceptDirect;
+    StandInCapture capture(captureSettings);
+    DirectBridgeSupervisor supervisor(capture, {});
+    if (!supervisor.connect())
+    {
+        return {};
+    }
+
+    if (!supervisor.isDirect())
+    {
+        // What the service does when the endpoint answers Copy.
+        return runCopy(options, producer, "refused");
+    }
+
+    Result result;
+    result.mode = "direct";
+    std::atomic<bool> stop {false};
+    const auto before = processUsage();
+    std::thread service([&]()
+    {
+        supervisor.run([&]()
+        {
+            return stop.load(std::memory_order_relaxed);
+        });
+    });
+
+    const auto framesWritten = produce(producer, options);
+    stop.store(true, std::memory_order_relaxed);
+    service.join();
+
+    const auto captureStats = capture.getStatistics();
+    const auto supervisorStats = supervisor.getStatistics();
+    supervisor.disconnect();
+
+    const auto polls = static_cast<std::uint64_t>(options.seconds) * 1000 / DirectBridgeSupervisor::Settings {}.pollIntervalMs;
+    finish(result, options, framesWritten, captureStats.framesCaptured,
+           captureStats.bytesCopied + supervisorStats.bytesCopied, captureStats.packets + polls, before);
+    result.ok = captureStats.framesCaptured > 0 && supervisorStats.reconnects == 0;
+    return result;
+}
+
+void printResult(const Result& result)
+{
+    std::printf("%-9s %4s %12.0f %8.2f %12.0f %14.0f %8.1f\n",
+                result.mode,
+                result.ok ? "ok" : "FAIL",
+                result.framesPerSecond,
+                result.copies,
+                result.consumerWakeupsPerSecond,
+                result.contextSwitchesPerSecond,
+                result.cpuPercent);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 128));
+    options.sampleRate = static_cast<std::uint32_t>(intOption(argc, argv, "--rate", 48000));
+    options.channels = static_cast<std::uint32_t>(intOption(argc, argv, "--channels", 2));
+    options.seconds = static_cast<std::uint32_t>(intOption(argc, argv, "--seconds", 3));
+
+    std::printf("%u frames x %u channels @ %u Hz, %u s per mode\n",
+                options.framesPerBlock, options.channels, options.sampleRate, options.seconds);
+    std::printf("%-9s %4s %12s %8s %12s %14s %8s\n",
+                "mode", "", "frames/s", "copies", "wakeups/s", "ctx switches/s", "cpu %");
+
+    PosixBenchProducer producer;
+    if (!producer.create(options.channels, options.sampleRate, options.framesPerBlock))
+    {
+        std::printf("could not create the bridge mapping\n");
+        return 1;
+    }
+
+    printResult(runCopy(options, producer, "copy"));
+    printResult(runDirect(options, producer, true));
+    printResult(runDirect(options, producer, false));
+
+    producer.destroy();
+    return 0;
+}
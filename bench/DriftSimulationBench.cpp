@@ -0,0 +1,236 @@
+// Clock-drift simulation for the consumer-side drift compensation.
+//
+// The producer fills an SpscRing at a skewed clock (nominal rate * (1 + skew ppm), with
+// optional scheduling jitter) while the consumer drains it once per block of its own
+// nominal clock through DriftCompensator. Everything runs in simulated time, so minutes
+// of drift take milliseconds. For every skew the bench reports the steady-state latency
+// (mean and spread over the last quarter of the run), the time the controller took to
+// settle within the tolerance for good, the correction it settled on, and the
+// overruns/underruns with and without compensation.
+//
+// Usage: OceanAudioDriftSimulationBench [--frames N] [--channels N] [--rate N]
+//                                       [--seconds N] [--target-frames N]
+//                                       [--jitter-us N] [--tolerance-frames N]
+
+#include "BenchSupport.h"
+
+#include "DriftCompensator.h"
+
+#include <OceanAudio/SpscRing.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+struct Options
+{
+    std::uint32_t framesPerBlock = 256;
+    std::uint32_t channels = 2;
+    std::uint32_t sampleRate = 48000;
+    double seconds = 600.0;
+    std::uint32_t targetFrames = 0;
+    double jitterMicroseconds = 500.0;
+    double toleranceFrames = 32.0;
+};
+
+struct Result
+{
+    double meanLatencyFrames = 0.0;
+    double minLatencyFrames = 0.0;
+    double maxLatencyFrames = 0.0;
+    double convergenceSeconds = -1.0;
+    double finalCorrectionPpm = 0.0;
+    std::uint64_t overruns = 0;
+    std::uint64_t underruns = 0;
+};
+
+Result simulate(const Options& options, double skewPpm, bool compensate)
+{
+    const auto blockFrames = options.framesPerBlock;
+    const auto channels = options.channels;
+
+    std::uint32_t capacity = 1;
+    while (capacity < blockFrames * 16)
+    {
+        capacity <<= 1;
+    }
+
+    std::atomic<std::uint64_t> writeCursor {0};
+    std::atomic<std::uint64_t> readCursor {0};
+    oceanaudio::SpscRingProducer producer;
+    oceanaudio::SpscRingConsumer consumer;
+    producer.attach(writeCursor, readCursor, capacity);
+    consumer.attach(writeCursor, readCursor, capacity);
+
+    std::vector<float> ring(static_cast<std::size_t>(capacity) * channels, 0.0f);
+    std::vector<float> output(static_cast<std::size_t>(blockFrames) * channels, 0.0f);
+
+    StreamFormat format;
+    format.channels = channels;
+    format.sampleRate = options.sampleRate;
+    format.framesPerBlock = blockFrames;
+
+    DriftCompensator::Settings settings;
+    settings.targetLatencyFrames = options.targetFrames;
+    DriftCompensator compensator;
+    compensator.prepare(format, settings);
+    const double target = compensator.getTargetLatencyFrames();
+
+    const double consumerPeriod = static_cast<double>(blockFrames) / options.sampleRate;
+    const double producerPeriod = consumerPeriod / (1.0 + skewPpm * 1.0e-6);
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<double> jitter(0.0, options.jitterMicroseconds * 1.0e-6);
+
+    double nextProduce = 0.0;
+    double nextConsume = 0.0;
+    double lastCommit = 0.0;
+    std::uint64_t producedBlocks = 0;
+    std::uint64_t consumedBlocks = 0;
+    double lastOutsideTolerance = 0.0;
+
+    Result result;
+    double latencySum = 0.0;
+    std::uint64_t latencySamples = 0;
+    result.minLatencyFrames = 1.0e9;
+    const double steadyStateStart = options.seconds * 0.75;
+
+    while (nextConsume < options.seconds)
+    {
+        const double produceAt = nextProduce + jitter(random);
+        if (produceAt <= nextConsume)
+        {
+            oceanaudio::SpscRingRegions regions;
+            if (producer.prepareWrite(blockFrames, regions))
+            {
+                producer.commitWrite(blockFrames);
+                lastCommit = produceAt;
+            }
+            else
+            {
+                ++result.overruns;
+            }
+            nextProduce = static_cast<double>(++producedBlocks) * producerPeriod;
+            continue;
+        }
+
+        const auto ringFrames = consumer.readableFrames();
+        const double queued = DriftCompensator::estimateQueuedFrames(
+            ringFrames, static_cast<std::uint64_t>((nextConsume - lastCommit) * 1.0e9), format);
+        if (compensate)
+        {
+            auto wanted = compensator.beginBlock(queued, consumerPeriod);
+            while (wanted > 0)
+            {
+                const auto regions = consumer.prepareRead(wanted);
+                if (regions.totalFrames() == 0)
+                {
+                    break;
+                }
+
+                FrameSpans spans;
+                spans.first = ring.data() + static_cast<std::size_t>(regions.first.offset) * channels;
+                spans.firstFrames = regions.first.frames;
+                spans.second = ring.data() + static_cast<std::size_t>(regions.second.offset) * channels;
+                spans.secondFrames = regions.second.frames;
+                compensator.pushInput(spans);
+                consumer.commitRead(regions.totalFrames());
+                wanted -= regions.totalFrames();
+            }
+            compensator.renderBlock(output.data());
+        }
+        else
+        {
+            // Plain consumer: wait for the target to build up once, then take a block
+            // per tick.
+            const auto regions = consumer.prepareRead(blockFrames);
+            if (consumedBlocks > 0 || ringFrames >= target)
+            {
+                if (regions.totalFrames() < blockFrames)
+                {
+                    ++result.underruns;
+                }
+                consumer.commitRead(regions.totalFrames());
+                ++consumedBlocks;
+            }
+        }
+
+        const auto stats = compensator.getStatistics();
+        const double latency = compensate ? stats.latencyFrames : queued;
+        if (nextConsume >= steadyStateStart)
+        {
+            latencySum += latency;
+            ++latencySamples;
+            result.minLatencyFrames = std::min(result.minLatencyFrames, latency);
+            result.maxLatencyFrames = std::max(result.maxLatencyFrames, latency);
+        }
+
+        // Convergence is judged on the smoothed level the controller sees; the raw
+        // value carries a sawtooth of up to a block from the two clocks' phases.
+        nextConsume += consumerPeriod;
+        const double level = compensate ? stats.smoothedLatencyFrames : queued;
+        if (std::abs(level - target) > options.toleranceFrames)
+        {
+            lastOutsideTolerance = nextConsume;
+        }
+    }
+
+    const auto stats = compensator.getStatistics();
+    result.meanLatencyFrames = latencySamples > 0 ? latencySum / static_cast<double>(latencySamples) : 0.0;
+    result.convergenceSeconds = lastOutsideTolerance < steadyStateStart ? lastOutsideTolerance : -1.0;
+    result.finalCorrectionPpm = stats.correctionPpm;
+    if (compensate)
+    {
+        result.underruns = stats.starvations;
+    }
+    return result;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 256));
+    options.channels = static_cast<std::uint32_t>(intOption(argc, argv, "--channels", 2));
+    options.sampleRate = static_cast<std::uint32_t>(intOption(argc, argv, "--rate", 48000));
+    options.seconds = doubleOption(argc, argv, "--seconds", options.seconds);
+    options.targetFrames = static_cast<std::uint32_t>(intOption(argc, argv, "--target-frames", 0));
+    options.jitterMicroseconds = doubleOption(argc, argv, "--jitter-us", options.jitterMicroseconds);
+    options.toleranceFrames = doubleOption(argc, argv, "--tolerance-frames", options.toleranceFrames);
+
+    std::printf("%u frames x %u channels @ %u Hz, %.0f s simulated, jitter %.0f us\n",
+                options.framesPerBlock,
+                options.channels,
+                options.sampleRate,
+                options.seconds,
+                options.jitterMicroseconds);
+    std::printf("%10s %10s %10s %10s %10s %12s %12s %10s %10s %12s\n",
+                "skew ppm", "target", "mean", "min", "max", "settled s", "trim ppm",
+                "overruns", "underruns", "uncomp o/u");
+
+    for (const double skew : {-500.0, -200.0, -50.0, -10.0, 10.0, 50.0, 200.0, 500.0})
+    {
+        const auto compensated = simulate(options, skew, true);
+        const auto plain = simulate(options, skew, false);
+        std::printf("%10.0f %10u %10.1f %10.1f %10.1f %12.1f %12.1f %10llu %10llu %6llu/%-5llu\n",
+                    skew,
+                    options.targetFrames != 0 ? options.targetFrames : options.framesPerBlock * 3,
+                    compensated.meanLatencyFrames,
+                    compensated.minLatencyFrames,
+                    compensated.maxLatencyFrames,
+                    compensated.convergenceSeconds,
+                    compensated.finalCorrectionPpm,
+                    static_cast<unsigned long long>(compensated.overruns),
+                    static_cast<unsigned long long>(compensated.underruns),
+                    static_cast<unsigned long long>(plain.overruns),
+                    static_cast<unsigned long long>(plain.underruns));
+    }
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+// In-place format renegotiation under load.
+//
+// A paced producer cycles the mapping through a set of formats (channel count, rate and
+// block size) without tearing it down, the way BridgeClient does when the host device
+// changes. One reader per lag policy (real BridgeConsumers, one thread each) follows
+// along. Every sample encodes the format it was written in and its channel, so a reader
+// that reads a frame at the wrong stride, or a frame from the wrong format, counts it as
+// torn. The producer reports how long each change held its writes back while Stall
+// readers adopted the new generation.
+//
+// Usage: OceanAudioFormatChangeBench [--changes N] [--blocks-per-format N]
+
+#include "BenchProducer.h"
+#include "BenchSupport.h"
+
+#include "BridgeConsumer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr wchar_t kMappingName[] = L"Global\\OceanAudio_AudioRing";
+constexpr wchar_t kReadyEventName[] = L"Global\\OceanAudio_AudioReady";
+constexpr wchar_t kConsumedEventName[] = L"Global\\OceanAudio_AudioConsumed";
+
+// Stays within BridgeClient's reservation (stereo, 4096-frame blocks).
+constexpr std::uint32_t kReservedChannels = 2;
+constexpr std::uint32_t kReservedFramesPerBlock = 4096;
+
+struct Format
+{
+    std::uint32_t channels;
+    std::uint32_t sampleRate;
+    std::uint32_t framesPerBlock;
+};
+
+constexpr Format kFormats[] = {
+    {2, 48000, 256},
+    {1, 44100, 128},
+    {2, 96000, 512},
+    {1, 16000, 64},
+    {2, 48000, 2048},
+};
+
+// Formats differ in sample rate, so the rate identifies the one a frame belongs to.
+float sampleValue(std::uint32_t sampleRate, std::uint32_t channel)
+{
+    return static_cast<float>(sampleRate / 100 + channel);
+}
+
+struct ReaderResult
+{
+    BridgeConsumer::Statistics stats;
+    std::uint64_t tornFrames = 0;
+};
+
+void runReader(oceanaudio::ReaderLagPolicy policy,
+               std::atomic<std::uint32_t>& readersReady,
+               std::atomic<bool>& stop,
+               ReaderResult& result)
+{
+    BridgeConsumer consumer;
+    if (!consumer.open(kMappingName, kReadyEventName, kConsumedEventName, policy))
+    {
+        std::fprintf(stderr, "Unable to attach a reader\n");
+        std::exit(1);
+    }
+    readersReady.fetch_add(1, std::memory_order_release);
+
+    while (!stop.load(std::memory_order_acquire))
+    {
+        if (!consumer.waitForData(10, 50))
+        {
+            continue;
+        }
+
+        FrameSpans frames;
+        while (consumer.acquireFrames(kReservedFramesPerBlock, frames))
+        {
+            const auto format = consumer.getFormat();
+            for (const auto& [data, count] : {std::pair {frames.first, frames.firstFrames},
+                                              std::pair {frames.second, frames.secondFrames}})
+            {
+                for (std::uint32_t frame = 0; frame < count; ++frame)
+                {
+                    for (std::uint32_t channel = 0; channel < format.channels; ++channel)
+                    {
+                        if (data[frame * format.channels + channel] != sampleValue(format.sampleRate, channel))
+                        {
+                            ++result.tornFrames;
+                            break;
+                        }
+                    }
+                }
+            }
+            consumer.releaseFrames(frames);
+        }
+    }
+
+    result.stats = consumer.getStatistics();
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    const auto changes = static_cast<std::uint32_t>(intOption(argc, argv, "--changes", 40));
+    const auto blocksPerFormat = static_cast<std::uint32_t>(intOption(argc, argv, "--blocks-per-format", 50));
+
+    PosixBenchProducer producer;
+    const auto& first = kFormats[0];
+    if (!producer.create(first.channels, first.sampleRate, first.framesPerBlock,
+                         kReservedChannels, kReservedFramesPerBlock))
+    {
+        std::fprintf(stderr, "Unable to create the shared ring\n");
+        return 1;
+    }
+
+    const oceanaudio::ReaderLagPolicy policies[] = {oceanaudio::ReaderLagPolicy::Stall,
+                                                    oceanaudio::ReaderLagPolicy::Skip,
+                                                    oceanaudio::ReaderLagPolicy::Detach};
+    std::atomic<std::uint32_t> readersReady {0};
+    std::atomic<bool> stop {false};
+    std::vector<ReaderResult> results(std::size(policies));
+    std::vector<std::thread> readers;
+    for (std::size_t index = 0; index < std::size(policies); ++index)
+    {
+        readers.emplace_back([&, index]() { runReader(policies[index], readersReady, stop, results[index]); });
+    }
+    while (readersReady.load(std::memory_order_acquire) < std::size(policies))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::vector<std::vector<float>> channelData(kReservedChannels, std::vector<float>(kReservedFramesPerBlock));
+    const float* channelPointers[kReservedChannels] = {channelData[0].data(), channelData[1].data()};
+
+    std::uint64_t blocksDropped = 0;
+    std::uint64_t totalHoldNs = 0;
+    std::uint64_t worstHoldNs = 0;
+    for (std::uint32_t change = 0; change <= changes; ++change)
+    {
+        const auto& format = kFormats[change % std::size(kFormats)];
+        if (change > 0 && !producer.changeFormat(format.channels, format.sampleRate, format.framesPerBlock))
+        {
+            std::fprintf(stderr, "Format %u ch x %u frames does not fit the reservation\n",
+                         format.channels, format.framesPerBlock);
+            return 1;
+        }
+
+        for (std::uint32_t channel = 0; channel < format.channels; ++channel)
+        {
+            std::fill(channelData[channel].begin(), channelData[channel].end(),
+                      sampleValue(format.sampleRate, channel));
+        }
+
+        // The first block goes out as soon as the readers let it: the time that takes is
+        // what a change costs the producer.
+        if (change > 0)
+        {
+            const auto changeTime = nowNanoseconds();
+            while (!producer.write(channelPointers, format.channels, format.framesPerBlock))
+            {
+                if (!producer.isAwaitingReaders())
+                {
+                    ++blocksDropped;
+                    break;
+                }
+                std::this_thread::yield();
+            }
+
+            const auto holdNs = nowNanoseconds() - changeTime;
+            totalHoldNs += holdNs;
+            worstHoldNs = holdNs > worstHoldNs ? holdNs : worstHoldNs;
+        }
+
+        // Pace the rest at 4x real time so a run covers many changes quickly.
+        const auto blockPeriodNs = static_cast<std::uint64_t>(0.25e9 * format.framesPerBlock / format.sampleRate);
+        auto nextBlockTime = nowNanoseconds();
+        for (std::uint32_t block = change > 0 ? 1 : 0; block < blocksPerFormat; ++block)
+        {
+            nextBlockTime += blockPeriodNs;
+            while (nowNanoseconds() < nextBlockTime)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+
+            if (!producer.write(channelPointers, format.channels, format.framesPerBlock))
+            {
+                ++blocksDropped;
+            }
+        }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    stop.store(true, std::memory_order_release);
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    const auto detachments = producer.getHeader()->readerDetachments.load(std::memory_order_relaxed);
+    producer.destroy();
+
+    std::printf("%u format changes, %u blocks per format, %llu blocks dropped, "
+                "readers adopted each change in: mean %.1f us, worst %.1f us, %u detachments\n",
+                changes,
+                blocksPerFormat,
+                static_cast<unsigned long long>(blocksDropped),
+                changes > 0 ? static_cast<double>(totalHoldNs) / changes * 1.0e-3 : 0.0,
+                static_cast<double>(worstHoldNs) * 1.0e-3,
+                detachments);
+    std::printf("%-8s %10s %12s %12s %12s %10s %8s\n",
+                "reader", "changes", "frames read", "discarded", "overwritten", "torn", "rejoins");
+
+    bool intact = true;
+    for (std::size_t index = 0; index < std::size(policies); ++index)
+    {
+        const auto& result = results[index];
+        std::printf("%-8s %10llu %12llu %12llu %12llu %10llu %8llu\n",
+                    oceanaudio::toString(policies[index]),
+                    static_cast<unsigned long long>(result.stats.formatChanges),
+                    static_cast<unsigned long long>(result.stats.totalFramesRead),
+                    static_cast<unsigned long long>(result.stats.framesDiscarded),
+                    static_cast<unsigned long long>(result.stats.framesOverwritten),
+                    static_cast<unsigned long long>(result.tornFrames),
+                    static_cast<unsigned long long>(result.stats.rejoins));
+        // Only frames the reader was told were overwritten may be torn.
+        intact = intact && result.tornFrames <= result.stats.framesOverwritten;
+    }
+
+    return intact ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+// Cost of per-consumer format views.
+//
+// Runs a stream of blocks (a two-tone signal, interleaved float as read from the ring)
+// through FormatViewConverter for a set of typical views and reports the time per
+// block, per output frame, and as a share of the block's real-time period on one core.
+// A second table compares the SIMD float-to-integer kernels against their scalar
+// fallbacks, with and without dither.
+//
+// Usage: OceanAudioFormatViewBench [--frames N] [--channels N] [--rate N] [--blocks N]
+
+#include "BenchSupport.h"
+
+#include "FormatViewConverter.h"
+
+#include <OceanAudio/SampleConversionKernels.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+struct Options
+{
+    std::uint32_t framesPerBlock = 256;
+    std::uint32_t channels = 2;
+    std::uint32_t sampleRate = 48000;
+    std::uint32_t blocks = 20000;
+};
+
+struct NamedView
+{
+    const char* name;
+    FormatView view;
+};
+
+std::vector<float> makeSignal(const Options& options, std::uint32_t frames)
+{
+    std::vector<float> signal(static_cast<std::size_t>(frames) * options.channels);
+    for (std::uint32_t frame = 0; frame < frames; ++frame)
+    {
+        const double t = static_cast<double>(frame) / options.sampleRate;
+        const double value = 0.45 * std::sin(2.0 * 3.14159265358979 * 440.0 * t)
+                             + 0.25 * std::sin(2.0 * 3.14159265358979 * 6000.0 * t);
+        for (std::uint32_t channel = 0; channel < options.channels; ++channel)
+        {
+            signal[static_cast<std::size_t>(frame) * options.channels + channel] = static_cast<float>(value);
+        }
+    }
+    return signal;
+}
+
+template <typename Function>
+double nanosecondsPerCall(std::uint32_t calls, Function&& function)
+{
+    const auto start = oceanaudio::bench::nowNanoseconds();
+    for (std::uint32_t call = 0; call < calls; ++call)
+    {
+        function(call);
+    }
+    return static_cast<double>(oceanaudio::bench::nowNanoseconds() - start) / calls;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 256));
+    options.channels = static_cast<std::uint32_t>(intOption(argc, argv, "--channels", 2));
+    options.sampleRate = static_cast<std::uint32_t>(intOption(argc, argv, "--rate", 48000));
+    options.blocks = static_cast<std::uint32_t>(intOption(argc, argv, "--blocks", 20000));
+
+    StreamFormat source;
+    source.channels = options.channels;
+    source.sampleRate = options.sampleRate;
+    source.framesPerBlock = options.framesPerBlock;
+
+    // A few seconds of signal, walked block by block so the caches see realistic data.
+    constexpr std::uint32_t kSignalBlocks = 64;
+    const auto signal = makeSignal(options, options.framesPerBlock * kSignalBlocks);
+    const auto blockSamples = static_cast<std::size_t>(options.framesPerBlock) * options.channels;
+    const double blockPeriodNs = 1.0e9 * options.framesPerBlock / options.sampleRate;
+
+    using oceanaudio::BridgeSampleFormat;
+    const NamedView views[] = {
+        {"f32 (passthrough copy)", {BridgeSampleFormat::Float32, 0, 0}},
+        {"s16", {BridgeSampleFormat::Int16, 0, 0}},
+        {"s24", {BridgeSampleFormat::Int24, 0, 0}},
+        {"f32 mono", {BridgeSampleFormat::Float32, 0, 1}},
+        {"f32 @ 44.1 kHz", {BridgeSampleFormat::Float32, 44100, 0}},
+        {"s16 @ 16 kHz", {BridgeSampleFormat::Int16, 16000, 0}},
+        {"s16 @ 16 kHz mono", {BridgeSampleFormat::Int16, 16000, 1}},
+    };
+
+    std::printf("%u frames x %u channels @ %u Hz, %u blocks per view (block period %.1f us)\n",
+                options.framesPerBlock,
+                options.channels,
+                options.sampleRate,
+                options.blocks,
+                blockPeriodNs * 1.0e-3);
+    std::printf("%-24s %8s %6s %12s %14s %12s %10s\n",
+                "view", "rate", "ch", "ns/block", "ns/out frame", "% realtime", "delay fr");
+
+    std::vector<float> copyTarget(blockSamples);
+    for (const auto& [name, view] : views)
+    {
+        FormatViewConverter converter;
+        if (!converter.prepare(source, view))
+        {
+            std::printf("%-24s unsupported\n", name);
+            continue;
+        }
+        const auto output = converter.getOutputFormat();
+
+        // Split every other block, as the ring does when a block straddles its end.
+        std::uint64_t outputFrames = 0;
+        const auto nsPerBlock = nanosecondsPerCall(options.blocks, [&](std::uint32_t block)
+        {
+            const float* data = signal.data() + (block % kSignalBlocks) * blockSamples;
+            FrameSpans spans;
+            spans.first = data;
+            spans.firstFrames = (block & 1) != 0 ? options.framesPerBlock / 3 : options.framesPerBlock;
+            spans.second = data + static_cast<std::size_t>(spans.firstFrames) * options.channels;
+            spans.secondFrames = options.framesPerBlock - spans.firstFrames;
+
+            if (converter.isPassthrough())
+            {
+                // What a plain sink costs: one copy out of the ring.
+                std::copy(spans.first, spans.first + blockSamples, copyTarget.data());
+                outputFrames += options.framesPerBlock;
+                return;
+            }
+            outputFrames += converter.process(spans);
+        });
+
+        std::printf("%-24s %8u %6u %12.0f %14.2f %12.3f %10.1f\n",
+                    name,
+                    output.sampleRate,
+                    output.channels,
+                    nsPerBlock,
+                    nsPerBlock * options.blocks / static_cast<double>(outputFrames),
+                    100.0 * nsPerBlock / blockPeriodNs,
+                    converter.getLatencyFrames());
+    }
+
+#if OCEANAUDIO_CONVERT_AVX2
+    const char* vectorName = "AVX2";
+#elif OCEANAUDIO_CONVERT_SSE2
+    const char* vectorName = "SSE2";
+#else
+    const char* vectorName = "scalar (no vector unit)";
+#endif
+    std::printf("\nquantise %zu samples per block, vector kernels: %s\n", blockSamples, vectorName);
+    std::printf("%-16s %14s %14s %10s\n", "kernel", "scalar ns", "vector ns", "speedup");
+
+    std::vector<std::int16_t> int16Out(blockSamples);
+    std::vector<std::uint8_t> int24Out(blockSamples * 3);
+    oceanaudio::convert::DitherState dither;
+    for (const bool dithered : {false, true})
+    {
+        auto* state = dithered ? &dither : nullptr;
+        const auto block = [&](std::uint32_t index)
+        {
+            return signal.data() + (index % kSignalBlocks) * blockSamples;
+        };
+
+        const auto scalar16 = nanosecondsPerCall(options.blocks, [&](std::uint32_t index)
+        {
+            oceanaudio::convert::scalar::toInt16(block(index), int16Out.data(), blockSamples, state);
+        });
+        const auto vector16 = nanosecondsPerCall(options.blocks, [&](std::uint32_t index)
+        {
+            oceanaudio::convert::toInt16(block(index), int16Out.data(), blockSamples, state);
+        });
+        const auto scalar24 = nanosecondsPerCall(options.blocks, [&](std::uint32_t index)
+        {
+            oceanaudio::convert::scalar::toInt24(block(index), int24Out.data(), blockSamples, state);
+        });
+        const auto vector24 = nanosecondsPerCall(options.blocks, [&](std::uint32_t index)
+        {
+            oceanaudio::convert::toInt24(block(index), int24Out.data(), blockSamples, state);
+        });
+
+        std::printf("%-16s %14.0f %14.0f %9.1fx\n",
+                    dithered ? "s16 dithered" : "s16", scalar16, vector16, scalar16 / vector16);
+        std::printf("%-16s %14.0f %14.0f %9.1fx\n",
+                    dithered ? "s24 dithered" : "s24", scalar24, vector24, scalar24 / vector24);
+    }
+
+    // Keep the outputs observable so the loops are not optimised away.
+    return int16Out[0] == 12345 && int24Out[0] == 0x7F ? 1 : 0;
+}
@@ -0,0 +1,341 @@
+// Cross-core cache-line ping-pong between header layouts.
+//
+// A producer and a consumer thread, optionally pinned to different CPUs, push small
+// blocks through the ring while re-reading the format fields every block exactly as
+// BridgeClient and BridgeConsumer do. Three layouts are compared:
+//   v1        32-bit positions plus a framesAvailable counter both sides RMW
+//   v2-packed 64-bit cursors, but every field on one cache line
+//   current   SharedAudioRingBufferHeader (cursors on separate lines)
+//
+// Usage: OceanAudioHeaderLayoutBench [--producer-cpu N] [--consumer-cpu N]
+//                                    [--blocks N] [--frames N] [--channels N]
+
+#include "BenchSupport.h"
+
+#include <OceanAudio/BridgeSharedMemory.h>
+#include <OceanAudio/SpscRing.h>
+
+#include <atomic>
+#include <cstdio>
+#include <new>
+#include <thread>
+
+namespace
+{
+using oceanaudio::kCacheLineSize;
+
+// Keeps the consumer's reads observable so the copy loops are not optimised away.
+volatile float benchSink = 0.0f;
+
+struct Options
+{
+    int producerCpu = 0;
+    int consumerCpu = 1;
+    std::uint64_t blocks = 2'000'000;
+    std::uint32_t framesPerBlock = 32;
+    std::uint32_t channels = 2;
+    std::uint32_t capacity = 512;
+};
+
+struct V1Header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t channels;
+    std::uint32_t sampleRate;
+    std::uint32_t frameCapacity;
+    std::uint32_t framesPerBlock;
+    std::atomic<std::uint32_t> writePosition;
+    std::atomic<std::uint32_t> readPosition;
+    std::atomic<std::uint32_t> framesAvailable;
+    std::atomic<std::uint32_t> overruns;
+    std::atomic<std::uint32_t> underruns;
+};
+
+struct V2PackedHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t channels;
+    std::uint32_t sampleRate;
+    std::uint32_t frameCapacity;
+    std::uint32_t framesPerBlock;
+    std::atomic<std::uint64_t> writeCursor;
+    std::atomic<std::uint64_t> readCursor;
+    std::atomic<std::uint32_t> overruns;
+    std::atomic<std::uint32_t> underruns;
+};
+
+class AlignedRegion
+{
+public:
+    explicit AlignedRegion(std::size_t bytesToAllocate)
+        : bytes(bytesToAllocate),
+          data(static_cast<std::byte*>(::operator new(bytes, std::align_val_t {kCacheLineSize})))
+    {
+        std::memset(data, 0, bytes);
+    }
+
+    ~AlignedRegion()
+    {
+        ::operator delete(data, std::align_val_t {kCacheLineSize});
+    }
+
+    AlignedRegion(const AlignedRegion&) = delete;
+    AlignedRegion& operator=(const AlignedRegion&) = delete;
+
+    std::byte* get() const noexcept { return data; }
+
+private:
+    std::size_t bytes;
+    std::byte* data;
+};
+
+template <typename Header>
+Header* initialiseHeader(AlignedRegion& region, const Options& options)
+{
+    auto* header = new (region.get()) Header {};
+    header->channels = options.channels;
+    header->frameCapacity = options.capacity;
+    header->framesPerBlock = options.framesPerBlock;
+    return header;
+}
+
+template <typename Header>
+float* payloadFor(Header* header)
+{
+    constexpr auto headerBytes = (sizeof(Header) + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+    return reinterpret_cast<float*>(reinterpret_cast<std::byte*>(header) + headerBytes);
+}
+
+struct Result
+{
+    double seconds = 0.0;
+    std::uint64_t producerStalls = 0;
+    std::uint64_t consumerStalls = 0;
+};
+
+template <typename Producer, typename Consumer>
+Result runPair(const Options& options, Producer&& producer, Consumer&& consumer)
+{
+    Result result;
+    std::atomic<bool> start {false};
+
+    std::thread consumerThread([&]()
+    {
+        oceanaudio::bench::pinCurrentThread(options.consumerCpu);
+        oceanaudio::bench::Backoff backoff;
+        while (!start.load(std::memory_order_acquire))
+        {
+            oceanaudio::bench::cpuRelax();
+        }
+
+        for (std::uint64_t block = 0; block < options.blocks;)
+        {
+            if (consumer())
+            {
+                ++block;
+                backoff.reset();
+            }
+            else
+            {
+                ++result.consumerStalls;
+                backoff.pause();
+            }
+        }
+    });
+
+    oceanaudio::bench::pinCurrentThread(options.producerCpu);
+    const auto startTime = oceanaudio::bench::nowNanoseconds();
+    start.store(true, std::memory_order_release);
+
+    oceanaudio::bench::Backoff backoff;
+    for (std::uint64_t block = 0; block < options.blocks;)
+    {
+        if (producer())
+        {
+            ++block;
+            backoff.reset();
+        }
+        else
+        {
+            ++result.producerStalls;
+            backoff.pause();
+        }
+    }
+
+    consumerThread.join();
+    result.seconds = static_cast<double>(oceanaudio::bench::nowNanoseconds() - startTime) * 1.0e-9;
+    return result;
+}
+
+Result runV1(const Options& options)
+{
+    AlignedRegion region(kCacheLineSize + options.capacity * options.channels * sizeof(float));
+    auto* header = initialiseHeader<V1Header>(region, options);
+    float* payload = payloadFor(header);
+    float sink = 0.0f;
+
+    auto producer = [&]()
+    {
+        const auto channels = header->channels;
+        const auto capacity = header->frameCapacity;
+        const auto frames = options.framesPerBlock;
+        if (header->framesAvailable.load(std::memory_order_acquire) + frames > capacity)
+        {
+            return false;
+        }
+
+        const auto position = header->writePosition.load(std::memory_order_relaxed);
+        for (std::uint32_t i = 0; i < frames * channels; ++i)
+        {
+            payload[((position + i / channels) % capacity) * channels + i % channels] = static_cast<float>(i);
+        }
+
+        header->writePosition.store((position + frames) % capacity, std::memory_order_release);
+        header->framesAvailable.fetch_add(frames, std::memory_order_release);
+        return true;
+    };
+
+    auto consumer = [&]()
+    {
+        const auto channels = header->channels;
+        const auto capacity = header->frameCapacity;
+        const auto frames = header->framesPerBlock;
+        if (header->framesAvailable.load(std::memory_order_acquire) < frames)
+        {
+            return false;
+        }
+
+        const auto position = header->readPosition.load(std::memory_order_relaxed);
+        for (std::uint32_t i = 0; i < frames * channels; ++i)
+        {
+            sink += payload[((position + i / channels) % capacity) * channels + i % channels];
+        }
+
+        header->readPosition.store((position + frames) % capacity, std::memory_order_release);
+        header->framesAvailable.fetch_sub(frames, std::memory_order_release);
+        return true;
+    };
+
+    const auto result = runPair(options, producer, consumer);
+    benchSink = sink;
+    return result;
+}
+
+std::atomic<std::uint64_t>& readCursorOf(V2PackedHeader& header)
+{
+    return header.readCursor;
+}
+
+// The current layout has one cursor per broadcast reader; a lone reader uses slot 0.
+std::atomic<std::uint64_t>& readCursorOf(oceanaudio::SharedAudioRingBufferHeader& header)
+{
+    return header.readers[0].cursor;
+}
+
+template <typename Header>
+Result runCursorLayout(const Options& options)
+{
+    constexpr auto headerBytes = (sizeof(Header) + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+    AlignedRegion region(headerBytes + options.capacity * options.channels * sizeof(float));
+    auto* header = initialiseHeader<Header>(region, options);
+    float* payload = payloadFor(header);
+    float sink = 0.0f;
+
+    oceanaudio::SpscRingProducer ringProducer;
+    oceanaudio::SpscRingConsumer ringConsumer;
+    ringProducer.attach(header->writeCursor, readCursorOf(*header), header->frameCapacity);
+    ringConsumer.attach(header->writeCursor, readCursorOf(*header), header->frameCapacity);
+
+    auto producer = [&]()
+    {
+        const std::uint32_t channels = header->channels;
+        oceanaudio::SpscRingRegions regions;
+        if (!ringProducer.prepareWrite(options.framesPerBlock, regions))
+        {
+            return false;
+        }
+
+        for (const auto& span : {regions.first, regions.second})
+        {
+            float* destination = payload + span.offset * channels;
+            for (std::uint32_t i = 0; i < span.frames * channels; ++i)
+            {
+                destination[i] = static_cast<float>(i);
+            }
+        }
+
+        ringProducer.commitWrite(options.framesPerBlock);
+        return true;
+    };
+
+    auto consumer = [&]()
+    {
+        const std::uint32_t channels = header->channels;
+        const auto regions = ringConsumer.prepareRead(header->framesPerBlock);
+        if (regions.totalFrames() < header->framesPerBlock)
+        {
+            return false;
+        }
+
+        for (const auto& span : {regions.first, regions.second})
+        {
+            const float* source = payload + span.offset * channels;
+            for (std::uint32_t i = 0; i < span.frames * channels; ++i)
+            {
+                sink += source[i];
+            }
+        }
+
+        ringConsumer.commitRead(regions.totalFrames());
+        return true;
+    };
+
+    const auto result = runPair(options, producer, consumer);
+    benchSink = sink;
+    return result;
+}
+
+void report(const char* name, const Options& options, const Result& result)
+{
+    const auto blocks = static_cast<double>(options.blocks);
+    std::printf("%-10s  %10.0f blocks/s  %8.1f ns/block  producer stalls %llu  consumer stalls %llu\n",
+                name,
+                blocks / result.seconds,
+                result.seconds * 1.0e9 / blocks,
+                static_cast<unsigned long long>(result.producerStalls),
+                static_cast<unsigned long long>(result.consumerStalls));
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.producerCpu = intOption(argc, argv, "--producer-cpu", options.producerCpu);
+    options.consumerCpu = intOption(argc, argv, "--consumer-cpu", options.consumerCpu);
+    options.blocks = static_cast<std::uint64_t>(intOption(argc, argv, "--blocks", static_cast<int>(options.blocks)));
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 32));
+    options.channels = static_cast<std::uint32_t>(intOption(argc, argv, "--channels", 2));
+    options.capacity = 1;
+    while (options.capacity < options.framesPerBlock * 16)
+    {
+        options.capacity <<= 1;
+    }
+
+    std::printf("blocks %llu, %u frames x %u channels, capacity %u, cpus %d -> %d (hw threads %u)\n",
+                static_cast<unsigned long long>(options.blocks),
+                options.framesPerBlock,
+                options.channels,
+                options.capacity,
+                options.producerCpu,
+                options.consumerCpu,
+                std::thread::hardware_concurrency());
+
+    report("v1", options, runV1(options));
+    report("v2-packed", options, runCursorLayout<V2PackedHeader>(options));
+    report("current", options, runCursorLayout<oceanaudio::SharedAudioRingBufferHeader>(options));
+    return 0;
+}
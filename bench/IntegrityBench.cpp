@@ -0,0 +1,252 @@
+// Bridge integrity checks: cost, and whether they catch what they should.
+//
+//   - crc32c: throughput of the block checksum at a few block sizes, plus the standard
+//     check value, so a build that picked the wrong kernel shows up straight away.
+//   - detection: a producer writes a continuous sine with checksums on and a
+//     BridgeConsumer reads it on the same thread. Every so often a fault is injected:
+//     the ring is filled until the producer has to drop a block (a producer drop and a
+//     click), or a sample is flipped in the ring after the commit (a checksum
+//     mismatch). Injected and detected counts must match. The sine runs a quarter
+//     period per block, so every boundary falls on a peak or a zero crossing and a
+//     dropped block always leaves a step of the full amplitude: each drop has to show
+//     up as a discontinuity too, and nothing else may.
+//     The same run over white noise counts false discontinuities; noise can always
+//     happen to look like a click, so up to one in a thousand boundaries passes. Its
+//     samples are independent, so a dropped block leaves nothing for the boundary
+//     detector to see (its minimum detection rate there is zero); the sequence and
+//     checksum checks still have to catch every fault.
+//   - overhead: producer write plus consumer read per block with the checks off, with
+//     sequence and discontinuity checks only, and with checksums on both sides.
+//
+// Usage: OceanAudioIntegrityBench [--frames N] [--channels N] [--blocks N] [--fault-every N]
+
+#include "BenchProducer.h"
+#include "BenchSupport.h"
+
+#include "BridgeConsumer.h"
+
+#include <OceanAudio/BridgeIntegrity.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+constexpr wchar_t kMappingName[] = L"Global\\OceanAudio_AudioRing";
+constexpr wchar_t kReadyEventName[] = L"Global\\OceanAudio_AudioReady";
+constexpr wchar_t kConsumedEventName[] = L"Global\\OceanAudio_AudioConsumed";
+
+constexpr std::uint32_t kSampleRate = 48000;
+constexpr double kPi = 3.14159265358979323846;
+
+struct Options
+{
+    std::uint32_t framesPerBlock = 128;
+    std::uint32_t channels = 2;
+    std::uint32_t blocks = 20000;
+    std::uint32_t faultEvery = 500;
+};
+
+// A continuous sine a quarter period per block (or white noise), block after block,
+// whether or not the block gets written.
+class TestSignal
+{
+public:
+    TestSignal(std::uint32_t frames, std::uint32_t channels, bool whiteNoise)
+        : samples(frames),
+          planes(channels, samples.data()),
+          noise(whiteNoise),
+          phaseStep(kPi / (2.0 * frames))
+    {
+    }
+
+    const float* const* next()
+    {
+        for (auto& sample : samples)
+        {
+            if (noise)
+            {
+                noiseState = noiseState * 1664525u + 1013904223u;
+                sample = static_cast<float>(noiseState >> 8) / static_cast<float>(1u << 24) * 1.6f - 0.8f;
+                continue;
+            }
+            sample = static_cast<float>(0.8 * std::sin(phase));
+            phase += phaseStep;
+        }
+        return planes.data();
+    }
+
+private:
+    std::vector<float> samples;
+    std::vector<const float*> planes;
+    bool noise = false;
+    double phaseStep = 0.0;
+    double phase = 0.0;
+    std::uint32_t noiseState = 1;
+};
+
+void drain(BridgeConsumer& consumer, std::vector<float>& buffer)
+{
+    std::uint32_t framesRead = 0;
+    while (consumer.readAvailableFrames(buffer, framesRead))
+    {
+    }
+}
+
+void benchCrc()
+{
+    std::printf("crc32c(\"123456789\") = %08X (expected E3069283)\n",
+                oceanaudio::crc32c(0, "123456789", 9));
+    std::printf("%-12s %10s\n", "block bytes", "GB/s");
+    for (const std::size_t bytes : {512u, 4096u, 32768u})
+    {
+        std::vector<unsigned char> data(bytes, 0x5A);
+        const auto iterations = static_cast<int>((256u << 20) / bytes);
+        std::uint32_t crc = 0;
+        const auto start = oceanaudio::bench::nowNanoseconds();
+        for (int i = 0; i < iterations; ++i)
+        {
+            crc = oceanaudio::crc32c(crc, data.data(), data.size());
+        }
+        const auto elapsed = static_cast<double>(oceanaudio::bench::nowNanoseconds() - start);
+        std::printf("%-12zu %10.2f%s\n", bytes, static_cast<double>(bytes) * iterations / elapsed,
+                    crc == 0 ? " (!)" : "");
+    }
+}
+
+bool runDetection(const Options& options, bool whiteNoise)
+{
+    oceanaudio::bench::PosixBenchProducer producer;
+    BridgeConsumer consumer;
+    if (!producer.create(options.channels, kSampleRate, options.framesPerBlock)
+        || !consumer.open(kMappingName, kReadyEventName, kConsumedEventName))
+    {
+        std::printf("detection: could not set up the ring\n");
+        return false;
+    }
+    producer.setBlockChecksums(true);
+
+    TestSignal source(options.framesPerBlock, options.channels, whiteNoise);
+    std::vector<float> buffer;
+    auto* header = producer.getHeader();
+    std::uint64_t injectedDrops = 0;
+    std::uint64_t injectedCorruptions = 0;
+    for (std::uint32_t block = 1; block <= options.blocks; ++block)
+    {
+        const bool fault = block % options.faultEvery == 0;
+        if (fault && (block / options.faultEvery) % 2 == 1)
+        {
+            // Fill the ring without reading; the block that does not fit is lost.
+            while (producer.write(source.next(), options.channels, options.framesPerBlock))
+            {
+            }
+            ++injectedDrops;
+        }
+        else
+        {
+            producer.write(source.next(), options.channels, options.framesPerBlock);
+            if (fault)
+            {
+                // Flip one sample of the block just committed, as a stray write would.
+                const auto mask = header->frameCapacity.load(std::memory_order_relaxed) - 1;
+                const auto lastFrame = (header->writeCursor.load(std::memory_order_relaxed) - 1) & mask;
+                header->payload()[lastFrame * options.channels] += 1.0e-3f;
+                ++injectedCorruptions;
+            }
+        }
+        drain(consumer, buffer);
+    }
+
+    const auto stats = consumer.getStatistics();
+    // Over the sine every drop is a click and nothing else is; over noise the boundary
+    // detector only has its false alarms bounded.
+    const bool clicksOk = whiteNoise ? stats.discontinuities <= injectedDrops + options.blocks / 1000
+                                     : stats.discontinuities == injectedDrops;
+    const bool ok = stats.producerDroppedBlocks == injectedDrops && stats.checksumMismatches == injectedCorruptions
+                    && clicksOk
+                    && stats.framesMissing == 0
+                    && stats.framesDuplicated == 0;
+    std::printf("detection over %s %s: %llu blocks verified\n", whiteNoise ? "white noise" : "a sine",
+                ok ? "ok" : "FAIL", static_cast<unsigned long long>(stats.blocksVerified));
+    std::printf("  %-20s %9s %9s\n", "", "injected", "detected");
+    std::printf("  %-20s %9llu %9llu\n", "producer drops", static_cast<unsigned long long>(injectedDrops),
+                static_cast<unsigned long long>(stats.producerDroppedBlocks));
+    std::printf("  %-20s %9llu %9llu\n", "discontinuities", static_cast<unsigned long long>(injectedDrops),
+                static_cast<unsigned long long>(stats.discontinuities));
+    std::printf("  %-20s %9llu %9llu\n", "checksum mismatches", static_cast<unsigned long long>(injectedCorruptions),
+                static_cast<unsigned long long>(stats.checksumMismatches));
+    std::printf("  %-20s %9d %9llu\n", "frames missing", 0, static_cast<unsigned long long>(stats.framesMissing));
+    std::printf("  %-20s %9d %9llu\n", "frames duplicated", 0,
+                static_cast<unsigned long long>(stats.framesDuplicated));
+
+    oceanaudio::IntegrityEvent events[4];
+    const auto count = consumer.getIntegrityEvents().copyEvents(events, 4);
+    for (std::uint32_t index = 0; index < count; ++index)
+    {
+        std::printf("  event: %s at block %llu, frame %llu, value %llu, magnitude %.3f\n",
+                    oceanaudio::toString(events[index].kind),
+                    static_cast<unsigned long long>(events[index].sequence),
+                    static_cast<unsigned long long>(events[index].frameIndex),
+                    static_cast<unsigned long long>(events[index].value),
+                    static_cast<double>(events[index].magnitude));
+    }
+
+    consumer.close();
+    producer.destroy();
+    return ok;
+}
+
+double runOverhead(const Options& options, bool checks, bool checksums)
+{
+    oceanaudio::bench::PosixBenchProducer producer;
+    BridgeConsumer consumer;
+    BridgeConsumer::IntegritySettings integrity;
+    integrity.enabled = checks;
+    consumer.setIntegritySettings(integrity);
+    if (!producer.create(options.channels, kSampleRate, options.framesPerBlock)
+        || !consumer.open(kMappingName, kReadyEventName, kConsumedEventName))
+    {
+        return 0.0;
+    }
+    producer.setBlockChecksums(checksums);
+
+    TestSignal source(options.framesPerBlock, options.channels, false);
+    std::vector<float> buffer;
+    const auto* planes = source.next();
+    const auto start = oceanaudio::bench::nowNanoseconds();
+    for (std::uint32_t block = 0; block < options.blocks; ++block)
+    {
+        producer.write(planes, options.channels, options.framesPerBlock);
+        drain(consumer, buffer);
+    }
+    const auto elapsed = static_cast<double>(oceanaudio::bench::nowNanoseconds() - start);
+
+    consumer.close();
+    producer.destroy();
+    return elapsed / options.blocks;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 128));
+    options.channels = static_cast<std::uint32_t>(intOption(argc, argv, "--channels", 2));
+    options.blocks = static_cast<std::uint32_t>(intOption(argc, argv, "--blocks", 20000));
+    options.faultEvery = static_cast<std::uint32_t>(intOption(argc, argv, "--fault-every", 500));
+
+    benchCrc();
+    std::printf("\n%u frames x %u channels, %u blocks, a fault every %u blocks\n",
+                options.framesPerBlock, options.channels, options.blocks, options.faultEvery);
+    const bool sineOk = runDetection(options, false);
+    const bool noiseOk = runDetection(options, true);
+
+    std::printf("\n%-28s %12s\n", "write + read per block", "ns");
+    std::printf("%-28s %12.0f\n", "checks off", runOverhead(options, false, false));
+    std::printf("%-28s %12.0f\n", "sequence + discontinuity", runOverhead(options, true, false));
+    std::printf("%-28s %12.0f\n", "all, with checksums", runOverhead(options, true, true));
+    return sineOk && noiseOk ? 0 : 1;
+}
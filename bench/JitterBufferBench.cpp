@@ -0,0 +1,308 @@
+// Jitter buffer under simulated producer jitter.
+//
+// A producer commits blocks of a sine wave into an SpscRing at its nominal period plus
+// scheduling jitter (uniform, with occasional spikes and optional long stalls), and the
+// consumer plays them out once per block of its own clock through DriftCompensator and
+// JitterBuffer, exactly as ConsumerEngine's clocked path does. Everything runs in
+// simulated time. For each jitter profile the bench compares a fixed three-block target
+// with the adaptive one (mean and minimum latency, dropouts, concealed frames), then
+// runs the stall profile through every overrun policy and concealment mode. "max step"
+// is the largest sample-to-sample jump in the output relative to the sine's own, so 1.0
+// means no click got through. The bench fails if the adaptive target drops out more
+// often than the fixed one under any profile: lower latency must not cost stability.
+//
+// Usage: OceanAudioJitterBufferBench [--frames N] [--rate N] [--seconds N]
+
+#include "BenchSupport.h"
+
+#include "DriftCompensator.h"
+#include "JitterBuffer.h"
+
+#include <OceanAudio/SpscRing.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr std::uint32_t kChannels = 2;
+constexpr double kToneHz = 220.0;
+constexpr float kToneAmplitude = 0.5f;
+constexpr double kPi = 3.14159265358979323846;
+
+struct Options
+{
+    std::uint32_t framesPerBlock = 256;
+    std::uint32_t sampleRate = 48000;
+    double seconds = 120.0;
+};
+
+struct Profile
+{
+    const char* name;
+    double jitterMicroseconds;
+    double spikeProbability;
+    double spikeMilliseconds;
+    // Every `stallEverySeconds` the producer goes quiet for `stallMilliseconds`, then
+    // commits the blocks it owes in one burst.
+    double stallEverySeconds;
+    double stallMilliseconds;
+};
+
+struct Result
+{
+    double meanLatencyFrames = 0.0;
+    double minLatencyFrames = 0.0;
+    double maxStepRatio = 0.0;
+    JitterBuffer::Statistics jitter;
+    std::uint64_t producerOverruns = 0;
+};
+
+Result simulate(const Options& options, const Profile& profile, const JitterBuffer::Settings& jitterSettings)
+{
+    const auto blockFrames = options.framesPerBlock;
+
+    std::uint32_t capacity = 1;
+    while (capacity < blockFrames * 16)
+    {
+        capacity <<= 1;
+    }
+
+    std::atomic<std::uint64_t> writeCursor {0};
+    std::atomic<std::uint64_t> readCursor {0};
+    oceanaudio::SpscRingProducer producer;
+    oceanaudio::SpscRingConsumer consumer;
+    producer.attach(writeCursor, readCursor, capacity);
+    consumer.attach(writeCursor, readCursor, capacity);
+
+    std::vector<float> ring(static_cast<std::size_t>(capacity) * kChannels, 0.0f);
+    std::vector<float> output(static_cast<std::size_t>(blockFrames) * kChannels, 0.0f);
+
+    StreamFormat format;
+    format.channels = kChannels;
+    format.sampleRate = options.sampleRate;
+    format.framesPerBlock = blockFrames;
+
+    JitterBuffer jitterBuffer;
+    jitterBuffer.prepare(format, jitterSettings, 0, capacity);
+    DriftCompensator::Settings driftSettings;
+    driftSettings.targetLatencyFrames = jitterBuffer.getTargetLatencyFrames();
+    driftSettings.prefillFrames = jitterBuffer.getPrefillFrames();
+    driftSettings.surplusInputFrames = jitterBuffer.getSurplusInputFrames();
+    DriftCompensator compensator;
+    compensator.prepare(format, driftSettings);
+
+    const double period = static_cast<double>(blockFrames) / options.sampleRate;
+    const double phaseStep = 2.0 * kPi * kToneHz / options.sampleRate;
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    auto readFrames = [&](std::uint32_t frames, FrameSpans& spans)
+    {
+        const auto regions = consumer.prepareRead(frames);
+        spans.first = ring.data() + static_cast<std::size_t>(regions.first.offset) * kChannels;
+        spans.firstFrames = regions.first.frames;
+        spans.second = ring.data() + static_cast<std::size_t>(regions.second.offset) * kChannels;
+        spans.secondFrames = regions.second.frames;
+        return regions.totalFrames();
+    };
+    auto skipFrames = [&](std::uint32_t frames)
+    {
+        FrameSpans spans;
+        const auto skipped = readFrames(frames, spans);
+        consumer.commitRead(skipped);
+        return skipped;
+    };
+
+    Result result;
+    result.minLatencyFrames = 1.0e9;
+    double latencySum = 0.0;
+    std::uint64_t latencySamples = 0;
+    const double maxToneStep = kToneAmplitude * phaseStep;
+    float previousSample = 0.0f;
+    bool outputStarted = false;
+
+    std::uint64_t producedFrames = 0;
+    std::uint64_t producedBlocks = 0;
+    double nextProduce = 0.0;
+    double lastCommit = 0.0;
+    double nextConsume = 0.0;
+
+    while (nextConsume < options.seconds)
+    {
+        if (nextProduce <= nextConsume)
+        {
+            oceanaudio::SpscRingRegions regions;
+            if (producer.prepareWrite(blockFrames, regions))
+            {
+                for (const auto& region : {regions.first, regions.second})
+                {
+                    for (std::uint32_t frame = 0; frame < region.frames; ++frame)
+                    {
+                        const auto sample = static_cast<float>(kToneAmplitude
+                                                               * std::sin(phaseStep * static_cast<double>(producedFrames++)));
+                        float* destination = ring.data() + static_cast<std::size_t>(region.offset + frame) * kChannels;
+                        std::fill(destination, destination + kChannels, sample);
+                    }
+                }
+                producer.commitWrite(blockFrames);
+            }
+            else
+            {
+                producedFrames += blockFrames;
+                ++result.producerOverruns;
+            }
+            lastCommit = nextProduce;
+
+            // Commits stay in order: a late block delays the ones queued behind it.
+            const double nominal = static_cast<double>(++producedBlocks) * period;
+            double delay = uniform(random) * profile.jitterMicroseconds * 1.0e-6;
+            if (uniform(random) < profile.spikeProbability)
+            {
+                delay += profile.spikeMilliseconds * 1.0e-3;
+            }
+            if (profile.stallEverySeconds > 0.0)
+            {
+                const double intoCycle = std::fmod(nominal, profile.stallEverySeconds);
+                const double stall = profile.stallMilliseconds * 1.0e-3;
+                if (nominal > profile.stallEverySeconds && intoCycle < stall)
+                {
+                    delay = std::max(delay, stall - intoCycle);
+                }
+            }
+            nextProduce = std::max(nextProduce, nominal + delay);
+            continue;
+        }
+
+        const auto ringFrames = consumer.readableFrames();
+        auto queued = DriftCompensator::estimateQueuedFrames(
+            ringFrames, static_cast<std::uint64_t>((nextConsume - lastCommit) * 1.0e9), format);
+
+        compensator.setTargetLatency(jitterBuffer.observe(queued, period), jitterBuffer.getPrefillFrames());
+        queued -= skipFrames(jitterBuffer.planOverrun(queued, ringFrames));
+
+        auto wanted = compensator.beginBlock(queued, period);
+        if (wanted > 0)
+        {
+            wanted += jitterBuffer.squeezeFrames();
+        }
+        while (wanted > 0)
+        {
+            skipFrames(jitterBuffer.takeDueDrop());
+            FrameSpans spans;
+            const auto frames = readFrames(jitterBuffer.readLimit(wanted), spans);
+            if (frames == 0)
+            {
+                break;
+            }
+            compensator.pushInput(jitterBuffer.consume(spans));
+            consumer.commitRead(frames);
+            wanted -= std::min(wanted, frames);
+        }
+
+        jitterBuffer.finishBlock(output.data(), compensator.renderBlock(output.data()));
+
+        for (std::uint32_t frame = 0; frame < blockFrames; ++frame)
+        {
+            const float sample = output[static_cast<std::size_t>(frame) * kChannels];
+            if (outputStarted)
+            {
+                result.maxStepRatio = std::max(result.maxStepRatio, std::abs(sample - previousSample) / maxToneStep);
+            }
+            outputStarted = outputStarted || sample != 0.0f;
+            previousSample = sample;
+        }
+
+        if (compensator.isPrimed())
+        {
+            const double latency = compensator.getStatistics().latencyFrames;
+            latencySum += latency;
+            ++latencySamples;
+            result.minLatencyFrames = std::min(result.minLatencyFrames, latency);
+        }
+        nextConsume += period;
+    }
+
+    result.meanLatencyFrames = latencySamples > 0 ? latencySum / static_cast<double>(latencySamples) : 0.0;
+    result.jitter = jitterBuffer.getStatistics();
+    return result;
+}
+
+void printResult(const char* profile, const char* configuration, const Result& result)
+{
+    std::printf("%-8s %-22s %8u %8.0f %8.0f %8llu %10llu %8llu %9llu %9llu %9.2f\n",
+                profile,
+                configuration,
+                result.jitter.targetLatencyFrames,
+                result.meanLatencyFrames,
+                result.minLatencyFrames,
+                static_cast<unsigned long long>(result.jitter.underruns),
+                static_cast<unsigned long long>(result.jitter.concealedFrames),
+                static_cast<unsigned long long>(result.jitter.overruns),
+                static_cast<unsigned long long>(result.jitter.framesDropped),
+                static_cast<unsigned long long>(result.jitter.framesSqueezed),
+                result.maxStepRatio);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 256));
+    options.sampleRate = static_cast<std::uint32_t>(intOption(argc, argv, "--rate", 48000));
+    options.seconds = doubleOption(argc, argv, "--seconds", options.seconds);
+
+    const Profile profiles[] = {
+        {"quiet", 100.0, 0.0, 0.0, 0.0, 0.0},
+        {"typical", 1000.0, 0.0, 0.0, 0.0, 0.0},
+        {"spiky", 1000.0, 0.01, 8.0, 0.0, 0.0},
+        {"stall", 500.0, 0.0, 0.0, 10.0, 60.0},
+    };
+
+    std::printf("%u frames x %u channels @ %u Hz, %.0f s simulated\n",
+                options.framesPerBlock, kChannels, options.sampleRate, options.seconds);
+    std::printf("%-8s %-22s %8s %8s %8s %8s %10s %8s %9s %9s %9s\n",
+                "profile", "configuration", "target", "mean", "min", "dropouts", "concealed",
+                "overruns", "dropped", "squeezed", "max step");
+
+    bool ok = true;
+    for (const auto& profile : profiles)
+    {
+        JitterBuffer::Settings fixed;
+        fixed.adaptive = false;
+        const auto fixedResult = simulate(options, profile, fixed);
+        const auto adaptiveResult = simulate(options, profile, JitterBuffer::Settings {});
+        printResult(profile.name, "fixed 3 blocks", fixedResult);
+        printResult(profile.name, "adaptive", adaptiveResult);
+        if (adaptiveResult.jitter.underruns > fixedResult.jitter.underruns)
+        {
+            std::fprintf(stderr, "FAIL: %s: adaptive dropped out %llu times, fixed %llu\n",
+                         profile.name,
+                         static_cast<unsigned long long>(adaptiveResult.jitter.underruns),
+                         static_cast<unsigned long long>(fixedResult.jitter.underruns));
+            ok = false;
+        }
+    }
+
+    const auto& stall = profiles[3];
+    for (const auto policy : {OverrunPolicy::DropOldest, OverrunPolicy::DropNewest, OverrunPolicy::Squeeze})
+    {
+        for (const auto concealment : {UnderrunConcealment::FadeToSilence, UnderrunConcealment::RepeatGrain})
+        {
+            JitterBuffer::Settings settings;
+            settings.overrunPolicy = policy;
+            settings.concealment = concealment;
+            char configuration[64];
+            std::snprintf(configuration, sizeof(configuration), "%s/%s", toString(policy), toString(concealment));
+            printResult(stall.name, configuration, simulate(options, stall, settings));
+        }
+    }
+
+    return ok ? 0 : 1;
+}
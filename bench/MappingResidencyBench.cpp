@@ -0,0 +1,197 @@
+// Page faults the audio thread takes on the bridge mapping in its first callbacks.
+//
+// For each residency configuration the bench maps a fresh ring-sized shared-memory
+// object the way BridgeClient's POSIX backend does, applies MappingResidencyOptions on
+// the main thread (the control thread's role), then starts a "callback" thread that
+// writes one interleaved block per period through the ring, exactly the producer's
+// access pattern. Page faults are sampled around every callback with
+// threadPageFaults(), so only faults on the callback thread count. The object is not
+// cleared first, which is the case of a producer taking over a mapping someone else
+// created: without prefaulting, every page costs a fault the first time round. "huge"
+// reports how much of the view the kernel actually backed with huge pages (from
+// /proc/self/smaps), which is zero unless shmem_enabled allows it.
+//
+// Usage: OceanAudioMappingResidencyBench [--ring-frames N] [--channels N] [--frames N]
+//                                        [--callbacks N] [--cpu N]
+
+#include "BenchSupport.h"
+
+#include <OceanAudio/BridgeSharedMemory.h>
+#include <OceanAudio/MappingResidency.h>
+#include <OceanAudio/PosixSharedMemory.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr char kObjectName[] = "/OceanAudio_ResidencyBench";
+
+struct Options
+{
+    std::uint32_t ringFrames = 1u << 19;
+    std::uint32_t channels = 2;
+    std::uint32_t framesPerBlock = 128;
+    std::uint32_t callbacks = 0;
+    int cpu = 0;
+};
+
+struct Configuration
+{
+    const char* name;
+    oceanaudio::MappingResidencyOptions residency;
+};
+
+struct Result
+{
+    bool mapped = false;
+    oceanaudio::MappingResidency residency;
+    double setupMs = 0.0;
+    std::uint64_t faults = 0;
+    std::uint32_t callbacksWithFaults = 0;
+    double worstCallbackUs = 0.0;
+    std::size_t hugeKiB = 0;
+};
+
+// Huge-page-backed part of the mapping containing `address`, in KiB.
+std::size_t hugePageKiB(const void* address)
+{
+    std::ifstream smaps("/proc/self/smaps");
+    const auto target = reinterpret_cast<std::uintptr_t>(address);
+    std::string line;
+    bool inMapping = false;
+    std::size_t total = 0;
+    while (std::getline(smaps, line))
+    {
+        unsigned long long start = 0;
+        unsigned long long end = 0;
+        if (std::sscanf(line.c_str(), "%llx-%llx ", &start, &end) == 2 && line.find(':') > line.find(' '))
+        {
+            inMapping = target >= start && target < end;
+            continue;
+        }
+
+        unsigned long long kib = 0;
+        if (inMapping
+            && (std::sscanf(line.c_str(), "ShmemPmdMapped: %llu kB", &kib) == 1
+                || std::sscanf(line.c_str(), "FilePmdMapped: %llu kB", &kib) == 1))
+        {
+            total += static_cast<std::size_t>(kib);
+        }
+    }
+    return total;
+}
+
+Result run(const Options& options, const Configuration& configuration)
+{
+    Result result;
+    const std::size_t hugeBytes = configuration.residency.hugePages ? oceanaudio::hugePageSize() : 0;
+    const std::size_t bytes = oceanaudio::roundUpToMultiple(
+        sizeof(oceanaudio::SharedAudioRingBufferHeader)
+            + static_cast<std::size_t>(options.ringFrames) * options.channels * sizeof(float),
+        hugeBytes);
+
+    ::shm_unlink(kObjectName);
+    oceanaudio::posix::SharedMapping mapping;
+    bool newlyCreated = false;
+    if (!mapping.create(kObjectName, bytes, newlyCreated, hugeBytes))
+    {
+        return result;
+    }
+    result.mapped = true;
+
+    const auto setupStart = oceanaudio::bench::nowNanoseconds();
+    result.residency = oceanaudio::makeResident(mapping.data(), bytes, configuration.residency);
+    result.setupMs = static_cast<double>(oceanaudio::bench::nowNanoseconds() - setupStart) * 1.0e-6;
+
+    auto* payload = static_cast<float*>(static_cast<void*>(static_cast<std::byte*>(mapping.data())
+                                                            + sizeof(oceanaudio::SharedAudioRingBufferHeader)));
+    const std::size_t blockSamples = static_cast<std::size_t>(options.framesPerBlock) * options.channels;
+    const std::size_t ringSamples = static_cast<std::size_t>(options.ringFrames) * options.channels;
+    const std::uint32_t callbacks = options.callbacks > 0 ? options.callbacks
+                                                          : options.ringFrames / options.framesPerBlock;
+
+    std::thread callbackThread([&]()
+    {
+        oceanaudio::bench::pinCurrentThread(options.cpu);
+        std::vector<float> block(blockSamples, 0.25f);
+        std::size_t position = 0;
+        for (std::uint32_t callback = 0; callback < callbacks; ++callback)
+        {
+            const auto faultsBefore = oceanaudio::threadPageFaults();
+            const auto start = oceanaudio::bench::nowNanoseconds();
+
+            const auto firstPart = std::min(blockSamples, ringSamples - position);
+            std::memcpy(payload + position, block.data(), firstPart * sizeof(float));
+            std::memcpy(payload, block.data() + firstPart, (blockSamples - firstPart) * sizeof(float));
+            position = (position + blockSamples) % ringSamples;
+
+            const auto elapsedUs = static_cast<double>(oceanaudio::bench::nowNanoseconds() - start) * 1.0e-3;
+            const auto faults = oceanaudio::threadPageFaults() - faultsBefore;
+            result.faults += faults;
+            result.callbacksWithFaults += faults > 0 ? 1u : 0u;
+            result.worstCallbackUs = std::max(result.worstCallbackUs, elapsedUs);
+        }
+    });
+    callbackThread.join();
+
+    result.hugeKiB = hugePageKiB(mapping.data());
+    mapping.close();
+    return result;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.ringFrames = static_cast<std::uint32_t>(intOption(argc, argv, "--ring-frames", 1 << 19));
+    options.channels = static_cast<std::uint32_t>(intOption(argc, argv, "--channels", 2));
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 128));
+    options.callbacks = static_cast<std::uint32_t>(intOption(argc, argv, "--callbacks", 0));
+    options.cpu = intOption(argc, argv, "--cpu", 0);
+
+    const Configuration configurations[] = {
+        {"lazy", {false, false, false}},
+        {"prefault", {true, false, false}},
+        {"prefault+lock", {true, true, false}},
+        {"prefault+lock+huge", {true, true, true}},
+    };
+
+    std::printf("%u ring frames x %u channels (%.1f MiB payload), %u-frame callbacks, huge page %zu KiB\n",
+                options.ringFrames,
+                options.channels,
+                static_cast<double>(options.ringFrames) * options.channels * sizeof(float) / (1024.0 * 1024.0),
+                options.framesPerBlock,
+                oceanaudio::hugePageSize() / 1024);
+    std::printf("%-20s %9s %7s %9s %9s %10s %11s %10s\n",
+                "configuration", "setup ms", "locked", "huge KiB", "faults", "callbacks", "worst us", "faulting");
+
+    for (const auto& configuration : configurations)
+    {
+        const auto result = run(options, configuration);
+        if (!result.mapped)
+        {
+            std::printf("%-20s could not create the mapping\n", configuration.name);
+            continue;
+        }
+
+        std::printf("%-20s %9.2f %7s %9zu %9llu %10u %11.1f %10u\n",
+                    configuration.name,
+                    result.setupMs,
+                    result.residency.locked ? "yes" : "no",
+                    result.hugeKiB,
+                    static_cast<unsigned long long>(result.faults),
+                    options.callbacks > 0 ? options.callbacks : options.ringFrames / options.framesPerBlock,
+                    result.worstCallbackUs,
+                    result.callbacksWithFaults);
+    }
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+// Host-to-consumer throughput over the POSIX shared-memory backend.
+//
+// The producer publishes the ring the way BridgeClient does on Linux; the consumer is
+// the real BridgeConsumer from the service. They run either as two threads or as two
+// processes (fork), each optionally pinned to its own CPU. With --realtime the producer
+// paces blocks at the nominal device rate, otherwise it pushes as fast as the consumer
+// drains.
+//
+// Usage: OceanAudioPosixBridgeBench [--processes 0|1] [--producer-cpu N] [--consumer-cpu N]
+//                                   [--frames N] [--channels N] [--rate N]
+//                                   [--seconds N] [--realtime 0|1]
+
+#include "BenchProducer.h"
+#include "BenchSupport.h"
+
+#include "BridgeConsumer.h"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+constexpr wchar_t kMappingName[] = L"Global\\OceanAudio_AudioRing";
+constexpr wchar_t kReadyEventName[] = L"Global\\OceanAudio_AudioReady";
+constexpr wchar_t kConsumedEventName[] = L"Global\\OceanAudio_AudioConsumed";
+
+struct Options
+{
+    bool processes = false;
+    bool realtime = false;
+    int producerCpu = 0;
+    int consumerCpu = 1;
+    std::uint32_t framesPerBlock = 256;
+    std::uint32_t channels = 2;
+    std::uint32_t sampleRate = 48000;
+    double seconds = 5.0;
+};
+
+void runConsumer(const Options& options, std::atomic<bool>* stop)
+{
+    oceanaudio::bench::pinCurrentThread(options.consumerCpu);
+
+    BridgeConsumer consumer;
+    while (!consumer.open(kMappingName, kReadyEventName, kConsumedEventName))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::vector<float> buffer;
+    buffer.reserve(static_cast<std::size_t>(options.framesPerBlock) * options.channels * 16);
+
+    std::uint64_t wakeups = 0;
+    const auto startTime = oceanaudio::bench::nowNanoseconds();
+    const auto durationNs = static_cast<std::uint64_t>(options.seconds * 1.0e9);
+
+    while (oceanaudio::bench::nowNanoseconds() - startTime < durationNs + 200'000'000
+           && (stop == nullptr || !stop->load(std::memory_order_acquire)))
+    {
+        if (consumer.waitForData(10))
+        {
+            ++wakeups;
+            std::uint32_t framesRead = 0;
+            consumer.readAvailableFrames(buffer, framesRead);
+        }
+    }
+
+    const auto elapsed = static_cast<double>(oceanaudio::bench::nowNanoseconds() - startTime) * 1.0e-9;
+    const auto stats = consumer.getStatistics();
+    std::printf("consumer: %.0f frames/s, %llu frames, %llu wakeups, %llu empty reads\n",
+                static_cast<double>(stats.totalFramesRead) / elapsed,
+                static_cast<unsigned long long>(stats.totalFramesRead),
+                static_cast<unsigned long long>(wakeups),
+                static_cast<unsigned long long>(stats.underruns));
+}
+
+void runProducer(const Options& options, oceanaudio::bench::PosixBenchProducer& producer)
+{
+    oceanaudio::bench::pinCurrentThread(options.producerCpu);
+
+    std::vector<std::vector<float>> channelData(options.channels, std::vector<float>(options.framesPerBlock, 0.25f));
+    std::vector<const float*> channelPointers;
+    for (const auto& channel : channelData)
+    {
+        channelPointers.push_back(channel.data());
+    }
+
+    const auto blockPeriodNs = static_cast<std::uint64_t>(1.0e9 * options.framesPerBlock / options.sampleRate);
+    const auto durationNs = static_cast<std::uint64_t>(options.seconds * 1.0e9);
+    const auto startTime = oceanaudio::bench::nowNanoseconds();
+    auto nextBlockTime = startTime;
+
+    std::uint64_t blocksWritten = 0;
+    std::uint64_t blocksRejected = 0;
+    oceanaudio::bench::Backoff backoff;
+
+    while (oceanaudio::bench::nowNanoseconds() - startTime < durationNs)
+    {
+        if (options.realtime)
+        {
+            nextBlockTime += blockPeriodNs;
+            while (oceanaudio::bench::nowNanoseconds() < nextBlockTime)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+
+        if (producer.write(channelPointers.data(), options.channels, options.framesPerBlock))
+        {
+            ++blocksWritten;
+            backoff.reset();
+        }
+        else
+        {
+            ++blocksRejected;
+            backoff.pause();
+        }
+    }
+
+    const auto elapsed = static_cast<double>(oceanaudio::bench::nowNanoseconds() - startTime) * 1.0e-9;
+    std::printf("producer: %.0f frames/s, %llu blocks written, %llu rejected (ring full)\n",
+                static_cast<double>(blocksWritten * options.framesPerBlock) / elapsed,
+                static_cast<unsigned long long>(blocksWritten),
+                static_cast<unsigned long long>(blocksRejected));
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.processes = intOption(argc, argv, "--processes", 0) != 0;
+    options.realtime = intOption(argc, argv, "--realtime", 0) != 0;
+    options.producerCpu = intOption(argc, argv, "--producer-cpu", options.producerCpu);
+    options.consumerCpu = intOption(argc, argv, "--consumer-cpu", options.consumerCpu);
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 256));
+    options.channels = static_cast<std::uint32_t>(intOption(argc, argv, "--channels", 2));
+    options.sampleRate = static_cast<std::uint32_t>(intOption(argc, argv, "--rate", 48000));
+    options.seconds = doubleOption(argc, argv, "--seconds", options.seconds);
+
+    std::printf("%s, %u frames x %u channels @ %u Hz, %s, cpus %d -> %d\n",
+                options.processes ? "two processes" : "two threads",
+                options.framesPerBlock,
+                options.channels,
+                options.sampleRate,
+                options.realtime ? "paced" : "flat out",
+                options.producerCpu,
+                options.consumerCpu);
+
+    PosixBenchProducer producer;
+    if (!producer.create(options.channels, options.sampleRate, options.framesPerBlock))
+    {
+        std::fprintf(stderr, "Unable to create the shared ring\n");
+        return 1;
+    }
+
+    if (options.processes)
+    {
+        std::fflush(stdout);
+        const pid_t child = fork();
+        if (child == 0)
+        {
+            runConsumer(options, nullptr);
+            std::fflush(stdout);
+            _exit(0);
+        }
+
+        runProducer(options, producer);
+        int status = 0;
+        waitpid(child, &status, 0);
+    }
+    else
+    {
+        std::atomic<bool> stop {false};
+        std::thread consumerThread([&]() { runConsumer(options, &stop); });
+        runProducer(options, producer);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        stop.store(true, std::memory_order_release);
+        consumerThread.join();
+    }
+
+    producer.destroy();
+    return 0;
+}
@@ -0,0 +1,304 @@
+// Reattaching after a peer dies, simulated in one process.
+//
+// A paced producer, beating the way BridgeClient's heartbeat timer does, feeds a
+// ConsumerEngine with a null sink. Then the producer "crashes": it stops writing and
+// beating but leaves the mapping behind as a killed process would, and a second
+// producer takes the mapping over after a gap. Rows:
+//   - slow restart: the gap is longer than the producer timeout. The engine has to
+//     notice the loss, let go, turn the dead mapping down, and reattach once the new
+//     producer beats.
+//   - fast restart: the gap is well inside the timeout. The engine stays attached and
+//     simply picks up the new producer's blocks; nothing is counted as lost.
+//   - dead reader: a second Stall reader attaches and never reads or beats again. The
+//     producer stalls until it evicts that reader; the engine must keep going, and the
+//     dead reader must find itself evicted when it wakes up.
+// "detect" is the last beat of the dead peer to the other side giving up on it;
+// "resume" is the new producer's first beat (or the eviction) to the engine's next
+// delivered frame.
+//
+// Usage: OceanAudioReattachBench [--frames N] [--rate N] [--timeout-ms N]
+
+#include "BenchProducer.h"
+#include "BenchSupport.h"
+
+#include "BridgeConsumer.h"
+#include "ConsumerEngine.h"
+#include "FrameSinks.h"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr std::uint32_t kChannels = 2;
+constexpr std::uint32_t kHeartbeatIntervalMs = 50;
+
+struct Options
+{
+    std::uint32_t framesPerBlock = 128;
+    std::uint32_t sampleRate = 48000;
+    std::uint32_t timeoutMs = 200;
+};
+
+struct Result
+{
+    bool ok = false;
+    double detectMs = 0.0;
+    double resumeMs = 0.0;
+    std::uint64_t framesAfter = 0;
+    std::uint64_t producerLosses = 0;
+    std::uint64_t reconnects = 0;
+    std::uint64_t formatChanges = 0;
+    std::uint32_t evictions = 0;
+    bool deadReaderNoticed = false;
+};
+
+// Runs the engine on its own thread and republishes the counters the main thread
+// watches; the engine's statistics are only safe to read on the thread that pumps it.
+class EngineThread
+{
+public:
+    EngineThread(ConsumerEngine& engineToRun)
+        : engine(engineToRun),
+          thread([this]()
+          {
+              engine.run([this]()
+              {
+                  const auto stats = engine.getStatistics();
+                  framesDelivered.store(stats.framesDelivered, std::memory_order_relaxed);
+                  producerLosses.store(stats.producerLosses, std::memory_order_relaxed);
+                  reconnects.store(stats.reconnects, std::memory_order_relaxed);
+                  formatChanges.store(stats.formatChanges, std::memory_order_relaxed);
+                  return stop.load(std::memory_order_relaxed);
+              });
+          })
+    {
+    }
+
+    ~EngineThread()
+    {
+        stop.store(true, std::memory_order_relaxed);
+        thread.join();
+    }
+
+    ConsumerEngine& engine;
+    std::atomic<std::uint64_t> framesDelivered {0};
+    std::atomic<std::uint64_t> producerLosses {0};
+    std::atomic<std::uint64_t> reconnects {0};
+    std::atomic<std::uint64_t> formatChanges {0};
+    std::atomic<bool> stop {false};
+    std::thread thread;
+};
+
+struct Timeline
+{
+    std::uint64_t firstDeliveryNs = 0;
+    std::uint64_t firstEvictionNs = 0;
+};
+
+// Writes paced blocks for `milliseconds`, beating every kHeartbeatIntervalMs, and notes
+// when the engine first delivered more than `baseline` frames and when the producer
+// first evicted a reader.
+Timeline produceFor(oceanaudio::bench::PosixBenchProducer& producer,
+                         const Options& options,
+                         std::uint32_t milliseconds,
+                         const EngineThread& engine,
+                         std::uint64_t baseline)
+{
+    std::vector<float> channel(options.framesPerBlock, 0.25f);
+    const float* planes[kChannels] = {channel.data(), channel.data()};
+    const auto period = std::chrono::nanoseconds(std::uint64_t {options.framesPerBlock} * 1'000'000'000ull
+                                                 / options.sampleRate);
+    const auto timeoutNs = std::uint64_t {options.timeoutMs} * 1'000'000;
+
+    const auto start = oceanaudio::bench::Clock::now();
+    const auto end = start + std::chrono::milliseconds(milliseconds);
+    auto nextBlock = start;
+    auto nextBeat = start;
+    const auto evictionsBefore = producer.getHeader()->readerEvictions.load(std::memory_order_relaxed);
+    Timeline timeline;
+    while (oceanaudio::bench::Clock::now() < end)
+    {
+        std::this_thread::sleep_until(nextBlock);
+        nextBlock += period;
+        if (oceanaudio::bench::Clock::now() >= nextBeat)
+        {
+            producer.heartbeat(timeoutNs);
+            nextBeat += std::chrono::milliseconds(kHeartbeatIntervalMs);
+            if (timeline.firstEvictionNs == 0
+                && producer.getHeader()->readerEvictions.load(std::memory_order_relaxed) != evictionsBefore)
+            {
+                timeline.firstEvictionNs = oceanaudio::bench::nowNanoseconds();
+            }
+        }
+        producer.write(planes, kChannels, options.framesPerBlock);
+
+        if (timeline.firstDeliveryNs == 0 && engine.framesDelivered.load(std::memory_order_relaxed) > baseline)
+        {
+            timeline.firstDeliveryNs = oceanaudio::bench::nowNanoseconds();
+        }
+    }
+    return timeline;
+}
+
+ConsumerEngine::Settings engineSettings(const Options& options)
+{
+    ConsumerEngine::Settings settings;
+    settings.producerTimeoutMs = options.timeoutMs;
+    settings.residency.lock = false;
+    return settings;
+}
+
+Result runRestart(const Options& options, std::uint32_t gapMs)
+{
+    Result result;
+    oceanaudio::bench::PosixBenchProducer crashed;
+    oceanaudio::bench::PosixBenchProducer restarted;
+    if (!crashed.create(kChannels, options.sampleRate, options.framesPerBlock))
+    {
+        return result;
+    }
+
+    NullFrameSink sink;
+    ConsumerEngine engine(sink, engineSettings(options));
+    if (!engine.connect())
+    {
+        crashed.destroy();
+        return result;
+    }
+
+    {
+        EngineThread consumer(engine);
+        produceFor(crashed, options, 300, consumer, 0);
+
+        // The crash: no more blocks, no more beats, nothing retired or unlinked.
+        const auto crashTime = crashed.getHeader()->producerHeartbeat.lastBeatNs.load(std::memory_order_relaxed);
+        const auto gapEnd = crashTime + std::uint64_t {gapMs} * 1'000'000;
+        std::uint64_t detectTime = 0;
+        while (oceanaudio::bench::nowNanoseconds() < gapEnd)
+        {
+            if (detectTime == 0 && consumer.producerLosses.load(std::memory_order_relaxed) > 0)
+            {
+                detectTime = oceanaudio::bench::nowNanoseconds();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        const auto baseline = consumer.framesDelivered.load(std::memory_order_relaxed);
+        if (!restarted.takeOver(kChannels, options.sampleRate, options.framesPerBlock))
+        {
+            crashed.destroy();
+            return result;
+        }
+        const auto beatTime = oceanaudio::bench::nowNanoseconds();
+        const auto firstDelivery = produceFor(restarted, options, 500, consumer, baseline).firstDeliveryNs;
+
+        result.ok = firstDelivery != 0;
+        result.detectMs = detectTime != 0 ? static_cast<double>(detectTime - crashTime) * 1.0e-6 : 0.0;
+        result.resumeMs = firstDelivery != 0 ? static_cast<double>(firstDelivery - beatTime) * 1.0e-6 : 0.0;
+        result.framesAfter = consumer.framesDelivered.load(std::memory_order_relaxed) - baseline;
+        result.producerLosses = consumer.producerLosses.load(std::memory_order_relaxed);
+        result.reconnects = consumer.reconnects.load(std::memory_order_relaxed);
+        result.formatChanges = consumer.formatChanges.load(std::memory_order_relaxed);
+    }
+
+    engine.disconnect();
+    restarted.destroy();
+    crashed.destroy();
+    return result;
+}
+
+Result runDeadReader(const Options& options)
+{
+    Result result;
+    oceanaudio::bench::PosixBenchProducer producer;
+    if (!producer.create(kChannels, options.sampleRate, options.framesPerBlock))
+    {
+        return result;
+    }
+
+    NullFrameSink sink;
+    ConsumerEngine engine(sink, engineSettings(options));
+    BridgeConsumer deadReader;
+    if (!engine.connect()
+        || !deadReader.open(L"Global\\OceanAudio_AudioRing", L"Global\\OceanAudio_AudioReady",
+                            L"Global\\OceanAudio_AudioConsumed", oceanaudio::ReaderLagPolicy::Stall, {false, false, false}))
+    {
+        producer.destroy();
+        return result;
+    }
+
+    {
+        EngineThread consumer(engine);
+        const auto lastBeat = oceanaudio::bench::nowNanoseconds();
+
+        // The dead reader holds the ring back as soon as it fills; the engine starves
+        // until the producer gives up on it.
+        const auto baseline = consumer.framesDelivered.load(std::memory_order_relaxed);
+        produceFor(producer, options, 100, consumer, baseline);
+        const auto stalledAt = consumer.framesDelivered.load(std::memory_order_relaxed);
+        const auto timeline = produceFor(producer, options, options.timeoutMs * 2, consumer, stalledAt);
+
+        const auto evictions = producer.getHeader()->readerEvictions.load(std::memory_order_relaxed);
+        result.ok = timeline.firstDeliveryNs > timeline.firstEvictionNs && timeline.firstEvictionNs != 0
+                    && evictions == 1;
+        result.detectMs = timeline.firstEvictionNs != 0
+                              ? static_cast<double>(timeline.firstEvictionNs - lastBeat) * 1.0e-6
+                              : 0.0;
+        result.resumeMs = result.ok ? static_cast<double>(timeline.firstDeliveryNs - timeline.firstEvictionNs) * 1.0e-6
+                                    : 0.0;
+        result.framesAfter = consumer.framesDelivered.load(std::memory_order_relaxed) - stalledAt;
+        result.evictions = evictions;
+        result.producerLosses = consumer.producerLosses.load(std::memory_order_relaxed);
+        result.reconnects = consumer.reconnects.load(std::memory_order_relaxed);
+        result.formatChanges = consumer.formatChanges.load(std::memory_order_relaxed);
+    }
+
+    // Waking up, it must see the slot is gone rather than read on.
+    (void) deadReader.availableFrames();
+    result.deadReaderNoticed = deadReader.isEvicted() && deadReader.isRetired();
+    deadReader.close();
+
+    engine.disconnect();
+    producer.destroy();
+    return result;
+}
+
+void printResult(const char* scenario, const Result& result)
+{
+    std::printf("%-14s %4s %9.1f %9.1f %10llu %7llu %11llu %8llu %10u %6s\n",
+                scenario,
+                result.ok ? "ok" : "FAIL",
+                result.detectMs,
+                result.resumeMs,
+                static_cast<unsigned long long>(result.framesAfter),
+                static_cast<unsigned long long>(result.producerLosses),
+                static_cast<unsigned long long>(result.reconnects),
+                static_cast<unsigned long long>(result.formatChanges),
+                result.evictions,
+                result.deadReaderNoticed ? "yes" : "-");
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 128));
+    options.sampleRate = static_cast<std::uint32_t>(intOption(argc, argv, "--rate", 48000));
+    options.timeoutMs = static_cast<std::uint32_t>(intOption(argc, argv, "--timeout-ms", 200));
+
+    std::printf("%u frames x %u channels @ %u Hz, peer timeout %u ms\n",
+                options.framesPerBlock, kChannels, options.sampleRate, options.timeoutMs);
+    std::printf("%-14s %4s %9s %9s %10s %7s %11s %8s %10s %6s\n",
+                "scenario", "", "detect ms", "resume ms", "frames", "losses", "reconnects", "formats",
+                "evictions", "woke");
+
+    printResult("slow restart", runRestart(options, options.timeoutMs * 2));
+    printResult("fast restart", runRestart(options, options.timeoutMs / 4));
+    printResult("dead reader", runDeadReader(options));
+    return 0;
+}
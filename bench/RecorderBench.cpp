@@ -0,0 +1,376 @@
+// BridgeRecorder: does it leave the producer alone, and does the file line up.
+//
+// A producer writes a ramp (every sample holds its own frame index) and a Stall reader
+// on another thread drains it, as the service would. A BridgeRecorder records the
+// same ring, and the file is read back afterwards:
+//   - paced: blocks at the device rate, first without and then with the recorder.
+//     The producer's write time should only grow by the wakeup of one more reader,
+//     and the file should hold every
+//     frame, with each block's descriptor pointing at the sample that carries its
+//     frame index.
+//   - flat out: the producer writes as fast as the service reader drains and the
+//     recorder gets a buffer of two small chunks, so it has to lose frames. They must
+//     show up as markers in the trail and nowhere else.
+//   - raw: a short paced recording to a raw file, whose trail stays in PATH.blocks.
+//
+// Usage: OceanAudioRecorderBench [--frames N] [--channels N] [--rate N] [--seconds N]
+//                                [--path PATH]
+
+#include "BenchProducer.h"
+#include "BenchSupport.h"
+
+#include "BridgeConsumer.h"
+#include "BridgeRecorder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr wchar_t kMappingName[] = L"Global\\OceanAudio_AudioRing";
+constexpr wchar_t kReadyEventName[] = L"Global\\OceanAudio_AudioReady";
+constexpr wchar_t kConsumedEventName[] = L"Global\\OceanAudio_AudioConsumed";
+constexpr std::uint32_t kRampMask = 0xFFFFFF;
+
+struct Options
+{
+    std::uint32_t framesPerBlock = 128;
+    std::uint32_t channels = 2;
+    std::uint32_t sampleRate = 48000;
+    double seconds = 2.0;
+    std::string path = "/tmp/oceanaudio-recorder-bench.wav";
+};
+
+struct ProducerResult
+{
+    std::uint64_t blocks = 0;
+    std::uint64_t frames = 0;
+    double writeP50Us = 0.0;
+    double writeP99Us = 0.0;
+    double writeMaxUs = 0.0;
+};
+
+// What came back from disk.
+struct Recording
+{
+    bool parsed = false;
+    bool rf64 = false;
+    std::uint32_t channels = 0;
+    std::vector<float> samples;
+    std::vector<RecordedEvent> events;
+};
+
+double percentileUs(const std::vector<std::uint64_t>& sorted, double fraction)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    const auto index = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1));
+    return static_cast<double>(sorted[index]) * 1.0e-3;
+}
+
+// Writes the ramp for `seconds`, paced at the device rate or flat out, while a Stall
+// reader drains it on another thread.
+ProducerResult produce(oceanaudio::bench::PosixBenchProducer& producer, const Options& options, bool paced)
+{
+    std::atomic<bool> done {false};
+    std::thread service([&]()
+    {
+        BridgeConsumer consumer;
+        if (!consumer.open(kMappingName, kReadyEventName, kConsumedEventName))
+        {
+            return;
+        }
+        std::vector<float> buffer;
+        std::uint32_t framesRead = 0;
+        while (!done.load(std::memory_order_relaxed))
+        {
+            if (consumer.waitForData(5))
+            {
+                consumer.readAvailableFrames(buffer, framesRead);
+            }
+        }
+        consumer.close();
+    });
+    // Let the service reader attach before the first block.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    std::vector<float> samples(options.framesPerBlock);
+    std::vector<const float*> planes(options.channels, samples.data());
+    std::vector<std::uint64_t> writeNs;
+    ProducerResult result;
+    const auto periodNs = static_cast<std::uint64_t>(1.0e9 * options.framesPerBlock / options.sampleRate);
+    const auto start = oceanaudio::bench::nowNanoseconds();
+    const auto end = start + static_cast<std::uint64_t>(options.seconds * 1.0e9);
+    auto nextBlock = start;
+    while (oceanaudio::bench::nowNanoseconds() < end)
+    {
+        if (paced)
+        {
+            while (oceanaudio::bench::nowNanoseconds() < nextBlock)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            nextBlock += periodNs;
+        }
+
+        for (std::uint32_t frame = 0; frame < options.framesPerBlock; ++frame)
+        {
+            samples[frame] = static_cast<float>((result.frames + frame) & kRampMask);
+        }
+        const auto before = oceanaudio::bench::nowNanoseconds();
+        const bool written = producer.write(planes.data(), options.channels, options.framesPerBlock);
+        writeNs.push_back(oceanaudio::bench::nowNanoseconds() - before);
+        if (!written)
+        {
+            // The service reader is behind; offer the same block again.
+            oceanaudio::bench::cpuRelax();
+            continue;
+        }
+        ++result.blocks;
+        result.frames += options.framesPerBlock;
+    }
+
+    done.store(true);
+    service.join();
+    std::sort(writeNs.begin(), writeNs.end());
+    result.writeP50Us = percentileUs(writeNs, 0.50);
+    result.writeP99Us = percentileUs(writeNs, 0.99);
+    result.writeMaxUs = writeNs.empty() ? 0.0 : static_cast<double>(writeNs.back()) * 1.0e-3;
+    return result;
+}
+
+std::uint32_t readLittleEndian(const unsigned char* at, int bytes)
+{
+    std::uint32_t value = 0;
+    for (int i = 0; i < bytes; ++i)
+    {
+        value |= static_cast<std::uint32_t>(at[i]) << (8 * i);
+    }
+    return value;
+}
+
+bool readTrail(std::FILE* file, std::uint64_t chunkBytes, Recording& recording)
+{
+    RecordingTrailHeader trailHeader;
+    if (chunkBytes < sizeof(trailHeader) || std::fread(&trailHeader, sizeof(trailHeader), 1, file) != 1
+        || trailHeader.eventBytes != sizeof(RecordedEvent))
+    {
+        return false;
+    }
+    recording.events.resize((chunkBytes - sizeof(trailHeader)) / sizeof(RecordedEvent));
+    return std::fread(recording.events.data(), sizeof(RecordedEvent), recording.events.size(), file)
+           == recording.events.size();
+}
+
+Recording readWav(const std::string& path)
+{
+    Recording recording;
+    auto* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return recording;
+    }
+
+    unsigned char header[4096];
+    if (std::fread(header, 1, sizeof(header), file) == sizeof(header) && std::memcmp(header + 8, "WAVE", 4) == 0
+        && std::memcmp(header + 4088, "data", 4) == 0)
+    {
+        recording.rf64 = std::memcmp(header, "RF64", 4) == 0;
+        recording.channels = readLittleEndian(header + 48 + 10, 2);
+        std::uint64_t dataBytes = readLittleEndian(header + 4092, 4);
+        if (recording.rf64)
+        {
+            dataBytes = readLittleEndian(header + 28, 4) | (std::uint64_t {readLittleEndian(header + 32, 4)} << 32);
+        }
+        recording.samples.resize(dataBytes / sizeof(float));
+        unsigned char chunk[8];
+        recording.parsed = std::fread(recording.samples.data(), sizeof(float), recording.samples.size(), file)
+                               == recording.samples.size()
+                           && std::fread(chunk, 1, sizeof(chunk), file) == sizeof(chunk)
+                           && std::memcmp(chunk, "oabk", 4) == 0
+                           && readTrail(file, readLittleEndian(chunk + 4, 4), recording);
+    }
+    std::fclose(file);
+    return recording;
+}
+
+Recording readRaw(const std::string& path, std::uint32_t channels)
+{
+    Recording recording;
+    recording.channels = channels;
+    auto* file = std::fopen(path.c_str(), "rb");
+    auto* trail = std::fopen((path + ".blocks").c_str(), "rb");
+    if (file != nullptr && trail != nullptr)
+    {
+        std::fseek(file, 0, SEEK_END);
+        recording.samples.resize(static_cast<std::size_t>(std::ftell(file)) / sizeof(float));
+        std::fseek(file, 0, SEEK_SET);
+        unsigned char chunk[8];
+        recording.parsed = std::fread(recording.samples.data(), sizeof(float), recording.samples.size(), file)
+                               == recording.samples.size()
+                           && std::fread(chunk, 1, sizeof(chunk), trail) == sizeof(chunk)
+                           && std::memcmp(chunk, "oabk", 4) == 0
+                           && readTrail(trail, readLittleEndian(chunk + 4, 4), recording);
+    }
+    if (file != nullptr)
+    {
+        std::fclose(file);
+    }
+    if (trail != nullptr)
+    {
+        std::fclose(trail);
+    }
+    return recording;
+}
+
+// Counts blocks whose first sample is not the frame index their descriptor gives,
+// leaving out blocks the producer may have overwritten under the recorder.
+struct TrailCheck
+{
+    std::uint64_t blocks = 0;
+    std::uint64_t misplaced = 0;
+    std::uint64_t markers = 0;
+    std::uint64_t markedFrames = 0;
+};
+
+TrailCheck checkTrail(const Recording& recording)
+{
+    TrailCheck check;
+    const auto frames = recording.channels != 0 ? recording.samples.size() / recording.channels : 0;
+    std::uint64_t overwrittenUntil = 0;
+    for (const auto& event : recording.events)
+    {
+        if (event.kind != RecordedEventKind::Block)
+        {
+            ++check.markers;
+            check.markedFrames += event.frames;
+            if (event.kind == RecordedEventKind::FramesOverwritten)
+            {
+                overwrittenUntil = std::max(overwrittenUntil, event.recordingFrame + event.frames);
+            }
+            continue;
+        }
+
+        ++check.blocks;
+        if (event.recordingFrame >= frames || event.recordingFrame < overwrittenUntil)
+        {
+            continue;
+        }
+        const auto sample = recording.samples[event.recordingFrame * recording.channels];
+        if (sample != static_cast<float>(event.streamFrame & kRampMask))
+        {
+            ++check.misplaced;
+        }
+    }
+    return check;
+}
+
+bool runCase(const Options& options, const char* name, bool paced, BridgeRecorder::Settings settings)
+{
+    oceanaudio::bench::PosixBenchProducer producer;
+    if (!producer.create(options.channels, options.sampleRate, options.framesPerBlock))
+    {
+        std::printf("%s: could not create the ring\n", name);
+        return false;
+    }
+
+    BridgeRecorder recorder;
+    recorder.start(settings);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const auto produced = produce(producer, options, paced);
+    const auto ringFrames = producer.getHeader()->frameCapacity.load();
+    recorder.stop();
+    producer.destroy();
+
+    const auto stats = recorder.getStatistics();
+    const auto recording = settings.fileFormat == BridgeRecorder::FileFormat::Wav
+                               ? readWav(settings.path)
+                               : readRaw(settings.path, options.channels);
+    const auto check = checkTrail(recording);
+    const auto framesOnDisk = recording.channels != 0 ? recording.samples.size() / recording.channels : 0;
+    bool ok = recording.parsed && stats.writeFailures == 0 && framesOnDisk == stats.framesWritten
+              && check.blocks + check.markers == recording.events.size() && check.misplaced == 0;
+    if (paced)
+    {
+        // Nothing to lose at the device rate: every frame and block is in the file.
+        ok = ok && stats.framesWritten == produced.frames && check.blocks == produced.blocks && check.markers == 0;
+    }
+    else
+    {
+        // Everything missing is marked, but for what was still in the ring at the end.
+        ok = ok && stats.framesWritten + check.markedFrames + stats.framesOverwritten + ringFrames >= produced.frames;
+    }
+
+    std::printf("%-10s %s: %llu blocks written, %llu frames on disk, %llu blocks in the trail, %llu misplaced\n",
+                name, ok ? "ok" : "FAIL", static_cast<unsigned long long>(produced.blocks),
+                static_cast<unsigned long long>(framesOnDisk), static_cast<unsigned long long>(check.blocks),
+                static_cast<unsigned long long>(check.misplaced));
+    std::printf("%-10s producer write p50 %.2f us, p99 %.2f us, max %.1f us\n", "", produced.writeP50Us,
+                produced.writeP99Us, produced.writeMaxUs);
+    std::printf("%-10s markers: %llu frames skipped by the reader, %llu lost to overflow, %llu overwritten, "
+                "%llu events lost\n",
+                "", static_cast<unsigned long long>(stats.readerGapFrames),
+                static_cast<unsigned long long>(stats.overflowFrames),
+                static_cast<unsigned long long>(stats.framesOverwritten),
+                static_cast<unsigned long long>(stats.eventsLost));
+    std::remove(settings.path.c_str());
+    std::remove((settings.path + ".blocks").c_str());
+    return ok;
+}
+
+void runBaseline(const Options& options)
+{
+    oceanaudio::bench::PosixBenchProducer producer;
+    if (!producer.create(options.channels, options.sampleRate, options.framesPerBlock))
+    {
+        return;
+    }
+    const auto produced = produce(producer, options, true);
+    producer.destroy();
+    std::printf("%-10s producer write p50 %.2f us, p99 %.2f us, max %.1f us\n", "no record", produced.writeP50Us,
+                produced.writeP99Us, produced.writeMaxUs);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 128));
+    options.channels = static_cast<std::uint32_t>(intOption(argc, argv, "--channels", 2));
+    options.sampleRate = static_cast<std::uint32_t>(intOption(argc, argv, "--rate", 48000));
+    options.seconds = doubleOption(argc, argv, "--seconds", 2.0);
+    if (const auto* path = findOption(argc, argv, "--path"))
+    {
+        options.path = path;
+    }
+
+    std::printf("%u frames x %u channels at %u Hz, %.1f s per case\n", options.framesPerBlock, options.channels,
+                options.sampleRate, options.seconds);
+    runBaseline(options);
+
+    BridgeRecorder::Settings settings;
+    settings.path = options.path;
+    const bool pacedOk = runCase(options, "paced", true, settings);
+
+    auto small = settings;
+    small.chunkBytes = 64u << 10;
+    small.bufferBytes = 128u << 10;
+    const bool flatOutOk = runCase(options, "flat out", false, small);
+
+    auto raw = settings;
+    raw.fileFormat = BridgeRecorder::FileFormat::Raw;
+    raw.path = options.path + ".raw";
+    auto rawOptions = options;
+    rawOptions.seconds = std::min(options.seconds, 1.0);
+    const bool rawOk = runCase(rawOptions, "raw", true, raw);
+    return pacedOk && flatOutOk && rawOk ? 0 : 1;
+}
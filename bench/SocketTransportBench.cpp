@@ -0,0 +1,323 @@
+// Named mapping versus the socket transport (memfd + eventfds over a Unix socket).
+//
+// For each transport a producer publishes the ring the way BridgeClient does, with its
+// control work (heartbeat, and accepting socket clients) every 50 ms, and the real
+// BridgeConsumer reads it on another thread:
+//   - attach: producer create to the consumer's first successful open, and the cost
+//     of that open call alone.
+//   - throughput: the producer writes as fast as the consumer drains.
+//   - wake: paced blocks, consumer blocking straight away (no spin), commit to wakeup.
+//   - reattach: the producer replaces the mapping; time until the consumer holds the
+//     new one.
+// Only the control plane differs, so throughput and wake latency should match; the
+// socket's cost is in attach and reattach, which wait for the producer's next accept.
+//
+// Usage: OceanAudioSocketTransportBench [--frames N] [--channels N] [--rate N]
+//                                       [--seconds N] [--producer-cpu N] [--consumer-cpu N]
+//                                       [--socket-path PATH]
+
+#include "BenchProducer.h"
+#include "BenchSupport.h"
+
+#include "BridgeConsumer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr wchar_t kMappingName[] = L"Global\\OceanAudio_AudioRing";
+constexpr wchar_t kReadyEventName[] = L"Global\\OceanAudio_AudioReady";
+constexpr wchar_t kConsumedEventName[] = L"Global\\OceanAudio_AudioConsumed";
+
+// BridgeClient's heartbeat timer, which also accepts socket clients.
+constexpr std::uint64_t kControlIntervalNs = 50'000'000;
+constexpr std::uint64_t kReaderTimeoutNs = std::uint64_t {oceanaudio::kDefaultPeerTimeoutMs} * 1'000'000;
+
+struct Options
+{
+    int producerCpu = 0;
+    int consumerCpu = 1;
+    std::uint32_t framesPerBlock = 128;
+    std::uint32_t channels = 2;
+    std::uint32_t sampleRate = 48000;
+    double seconds = 2.0;
+    std::string socketPath;
+};
+
+enum class Phase
+{
+    Throughput,
+    Wake,
+    Reattach,
+};
+
+struct Result
+{
+    bool ok = false;
+    double attachMs = 0.0;
+    double openUs = 0.0;
+    double framesPerSecond = 0.0;
+    double wakeP50Us = 0.0;
+    double wakeP99Us = 0.0;
+    double reattachMs = 0.0;
+};
+
+double percentileUs(const std::vector<std::uint64_t>& sorted, double fraction)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    const auto index = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1));
+    return static_cast<double>(sorted[index]) * 1.0e-3;
+}
+
+bool createProducer(oceanaudio::bench::PosixBenchProducer& producer, const Options& options, bool overSocket)
+{
+    return overSocket ? producer.createOverSocket(options.channels, options.sampleRate, options.framesPerBlock,
+                                                  options.socketPath)
+                      : producer.create(options.channels, options.sampleRate, options.framesPerBlock);
+}
+
+bool openConsumer(BridgeConsumer& consumer, const Options& options, bool overSocket)
+{
+    return overSocket ? consumer.openSocket(options.socketPath)
+                      : consumer.open(kMappingName, kReadyEventName, kConsumedEventName);
+}
+
+// Runs the producer's control work until `done` says so or `timeoutNs` passes.
+bool controlUntil(oceanaudio::bench::PosixBenchProducer& producer,
+                  const std::atomic<bool>& done,
+                  std::uint64_t timeoutNs)
+{
+    using namespace oceanaudio::bench;
+
+    const auto start = nowNanoseconds();
+    auto nextControl = start;
+    while (!done.load(std::memory_order_acquire))
+    {
+        const auto now = nowNanoseconds();
+        if (now - start > timeoutNs)
+        {
+            return false;
+        }
+        if (now >= nextControl)
+        {
+            producer.heartbeat(kReaderTimeoutNs);
+            nextControl += kControlIntervalNs;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+}
+
+Result runTransport(const Options& options, bool overSocket)
+{
+    using namespace oceanaudio::bench;
+
+    Result result;
+    std::atomic<Phase> phase {Phase::Throughput};
+    std::atomic<bool> attached {false};
+    std::atomic<bool> reattached {false};
+    std::atomic<bool> stop {false};
+    std::atomic<std::uint64_t> framesRead {0};
+    std::atomic<std::uint64_t> lastCommitNs {0};
+    std::uint64_t attachedNs = 0;
+    std::uint64_t openNs = 0;
+    std::uint64_t reattachedNs = 0;
+    std::vector<std::uint64_t> wakeLatencies;
+    wakeLatencies.reserve(static_cast<std::size_t>(options.seconds * options.sampleRate / options.framesPerBlock) + 64);
+
+    std::thread consumerThread([&]()
+    {
+        pinCurrentThread(options.consumerCpu);
+
+        BridgeConsumer consumer;
+        std::vector<float> scratch(static_cast<std::size_t>(options.framesPerBlock) * 16);
+        std::vector<float*> planes(options.channels, scratch.data());
+        while (!stop.load(std::memory_order_acquire))
+        {
+            if (!consumer.isOpen() || consumer.isRetired())
+            {
+                consumer.close();
+                const auto before = nowNanoseconds();
+                if (!openConsumer(consumer, options, overSocket))
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    continue;
+                }
+
+                const auto after = nowNanoseconds();
+                if (!attached.load(std::memory_order_relaxed))
+                {
+                    attachedNs = after;
+                    openNs = after - before;
+                    attached.store(true, std::memory_order_release);
+                }
+                else
+                {
+                    reattachedNs = after;
+                    reattached.store(true, std::memory_order_release);
+                }
+            }
+
+            const auto waitsBefore = consumer.getStatistics().blockingWaits;
+            if (!consumer.waitForData(10))
+            {
+                continue;
+            }
+
+            if (phase.load(std::memory_order_relaxed) == Phase::Wake
+                && consumer.getStatistics().blockingWaits > waitsBefore)
+            {
+                wakeLatencies.push_back(nowNanoseconds() - lastCommitNs.load(std::memory_order_acquire));
+            }
+
+            const auto backlog = consumer.availableFrames();
+            std::uint32_t frames = 0;
+            consumer.readAvailableFrames(planes.data(), options.channels,
+                                         backlog < 16 * options.framesPerBlock ? backlog : 16 * options.framesPerBlock,
+                                         frames);
+            framesRead.fetch_add(frames, std::memory_order_relaxed);
+        }
+        consumer.close();
+    });
+
+    pinCurrentThread(options.producerCpu);
+    PosixBenchProducer producer;
+    const auto createdNs = nowNanoseconds();
+    if (!createProducer(producer, options, overSocket) || !controlUntil(producer, attached, 2'000'000'000))
+    {
+        stop.store(true, std::memory_order_release);
+        consumerThread.join();
+        producer.destroy();
+        return result;
+    }
+    result.attachMs = static_cast<double>(attachedNs - createdNs) * 1.0e-6;
+    result.openUs = static_cast<double>(openNs) * 1.0e-3;
+
+    std::vector<float> channel(options.framesPerBlock, 0.25f);
+    std::vector<const float*> channelPointers(options.channels, channel.data());
+    const auto durationNs = static_cast<std::uint64_t>(options.seconds * 1.0e9);
+
+    // Throughput: unpaced, held back only by the consumer.
+    {
+        const auto framesBefore = framesRead.load(std::memory_order_relaxed);
+        const auto start = nowNanoseconds();
+        auto nextControl = start;
+        Backoff backoff;
+        while (nowNanoseconds() - start < durationNs)
+        {
+            if (nowNanoseconds() >= nextControl)
+            {
+                producer.heartbeat(kReaderTimeoutNs);
+                nextControl += kControlIntervalNs;
+            }
+            if (producer.write(channelPointers.data(), options.channels, options.framesPerBlock))
+            {
+                backoff.reset();
+            }
+            else
+            {
+                backoff.pause();
+            }
+        }
+        const auto elapsed = static_cast<double>(nowNanoseconds() - start) * 1.0e-9;
+        result.framesPerSecond = static_cast<double>(framesRead.load(std::memory_order_relaxed) - framesBefore) / elapsed;
+    }
+
+    // Wake latency: paced at the device rate.
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        phase.store(Phase::Wake, std::memory_order_relaxed);
+        const auto blockPeriodNs = static_cast<std::uint64_t>(1.0e9 * options.framesPerBlock / options.sampleRate);
+        const auto start = nowNanoseconds();
+        auto nextBlock = start;
+        auto nextControl = start;
+        while (nowNanoseconds() - start < durationNs)
+        {
+            nextBlock += blockPeriodNs;
+            while (nowNanoseconds() < nextBlock)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            if (nowNanoseconds() >= nextControl)
+            {
+                producer.heartbeat(kReaderTimeoutNs);
+                nextControl += kControlIntervalNs;
+            }
+
+            // Stamp before the commit so the consumer never sees a stamp newer than its data.
+            lastCommitNs.store(nowNanoseconds(), std::memory_order_release);
+            producer.write(channelPointers.data(), options.channels, options.framesPerBlock);
+        }
+        phase.store(Phase::Reattach, std::memory_order_relaxed);
+    }
+
+    // Reattach: what BridgeClient does when a format outgrows the mapping.
+    producer.destroy();
+    const auto replacedNs = nowNanoseconds();
+    const bool recreated = createProducer(producer, options, overSocket)
+                           && controlUntil(producer, reattached, 2'000'000'000);
+    stop.store(true, std::memory_order_release);
+    consumerThread.join();
+    producer.destroy();
+    if (!recreated)
+    {
+        return result;
+    }
+    result.reattachMs = static_cast<double>(reattachedNs - replacedNs) * 1.0e-6;
+
+    std::sort(wakeLatencies.begin(), wakeLatencies.end());
+    result.wakeP50Us = percentileUs(wakeLatencies, 0.50);
+    result.wakeP99Us = percentileUs(wakeLatencies, 0.99);
+    result.ok = result.framesPerSecond > 0.0 && !wakeLatencies.empty();
+    return result;
+}
+
+void printResult(const char* transport, const Result& result)
+{
+    std::printf("%-8s %4s %10.2f %9.1f %14.0f %9.1f %9.1f %12.2f\n",
+                transport,
+                result.ok ? "ok" : "FAIL",
+                result.attachMs,
+                result.openUs,
+                result.framesPerSecond,
+                result.wakeP50Us,
+                result.wakeP99Us,
+                result.reattachMs);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.producerCpu = intOption(argc, argv, "--producer-cpu", options.producerCpu);
+    options.consumerCpu = intOption(argc, argv, "--consumer-cpu", options.consumerCpu);
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 128));
+    options.channels = static_cast<std::uint32_t>(intOption(argc, argv, "--channels", 2));
+    options.sampleRate = static_cast<std::uint32_t>(intOption(argc, argv, "--rate", 48000));
+    options.seconds = doubleOption(argc, argv, "--seconds", options.seconds);
+    const auto* socketPath = findOption(argc, argv, "--socket-path");
+    options.socketPath = socketPath != nullptr ? socketPath : oceanaudio::posix::defaultBridgeSocketPath();
+
+    std::printf("%u frames x %u channels @ %u Hz, %.1f s per phase, socket %s\n",
+                options.framesPerBlock,
+                options.channels,
+                options.sampleRate,
+                options.seconds,
+                options.socketPath.c_str());
+    std::printf("%-8s %4s %10s %9s %14s %9s %9s %12s\n",
+                "transport", "", "attach ms", "open us", "frames/s", "wake p50", "wake p99", "reattach ms");
+
+    printResult("named", runTransport(options, false));
+    printResult("socket", runTransport(options, true));
+    return 0;
+}
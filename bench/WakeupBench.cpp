@@ -0,0 +1,219 @@
+// Wakeup cost on the bridge: syscalls per second and wake-to-read latency.
+//
+// A paced producer publishes blocks the way BridgeClient does; the real BridgeConsumer
+// waits for them with a range of spin budgets. "every-block" reproduces the old scheme
+// (signal on every block, block straight away); the other rows use the waiter flag, so
+// the producer only signals a consumer that said it is going to sleep. Syscalls are the
+// producer's signals plus the consumer's blocking waits. Latency runs from the
+// producer's commit to the consumer seeing the frames.
+//
+// Usage: OceanAudioWakeupBench [--frames N] [--channels N] [--rate N] [--seconds N]
+//                              [--producer-cpu N] [--consumer-cpu N]
+
+#include "BenchProducer.h"
+#include "BenchSupport.h"
+
+#include "BridgeConsumer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr wchar_t kMappingName[] = L"Global\\OceanAudio_AudioRing";
+constexpr wchar_t kReadyEventName[] = L"Global\\OceanAudio_AudioReady";
+constexpr wchar_t kConsumedEventName[] = L"Global\\OceanAudio_AudioConsumed";
+
+struct Options
+{
+    int producerCpu = 0;
+    int consumerCpu = 1;
+    std::uint32_t framesPerBlock = 128;
+    std::uint32_t channels = 2;
+    std::uint32_t sampleRate = 48000;
+    double seconds = 2.0;
+};
+
+struct Mode
+{
+    const char* name;
+    bool signalEveryBlock;
+    std::uint32_t spinMicroseconds;
+};
+
+struct Result
+{
+    double syscallsPerSecond = 0.0;
+    double producerSignalsPerSecond = 0.0;
+    double blockingWaitsPerSecond = 0.0;
+    double p50Us = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+    std::uint64_t wakeups = 0;
+};
+
+double percentileUs(const std::vector<std::uint64_t>& sorted, double fraction)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    const auto index = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1));
+    return static_cast<double>(sorted[index]) * 1.0e-3;
+}
+
+Result runMode(const Options& options, const Mode& mode)
+{
+    using namespace oceanaudio::bench;
+
+    PosixBenchProducer producer;
+    if (!producer.create(options.channels, options.sampleRate, options.framesPerBlock))
+    {
+        std::fprintf(stderr, "Unable to create the shared ring\n");
+        std::exit(1);
+    }
+    producer.setSignalEveryBlock(mode.signalEveryBlock);
+
+    std::atomic<std::uint64_t> lastCommitNs {0};
+    std::atomic<bool> consumerReady {false};
+    std::atomic<bool> stop {false};
+    std::vector<std::uint64_t> latencies;
+    latencies.reserve(static_cast<std::size_t>(options.seconds * options.sampleRate / options.framesPerBlock) + 64);
+    BridgeConsumer::Statistics consumerStats;
+
+    std::thread consumerThread([&]()
+    {
+        pinCurrentThread(options.consumerCpu);
+
+        BridgeConsumer consumer;
+        if (!consumer.open(kMappingName, kReadyEventName, kConsumedEventName))
+        {
+            std::fprintf(stderr, "Unable to open the shared ring\n");
+            std::exit(1);
+        }
+        consumerReady.store(true, std::memory_order_release);
+
+        const auto channels = options.channels;
+        std::vector<float> scratch(static_cast<std::size_t>(options.framesPerBlock) * 16);
+        std::vector<float*> planes(channels, scratch.data());
+
+        while (!stop.load(std::memory_order_acquire))
+        {
+            if (!consumer.waitForData(10, mode.spinMicroseconds))
+            {
+                continue;
+            }
+
+            latencies.push_back(nowNanoseconds() - lastCommitNs.load(std::memory_order_acquire));
+
+            // The old scheme read one block per wakeup; the new one drains everything.
+            const auto backlog = mode.signalEveryBlock ? options.framesPerBlock : consumer.availableFrames();
+            std::uint32_t framesRead = 0;
+            consumer.readAvailableFrames(planes.data(), channels, backlog < 16 * options.framesPerBlock
+                                                                      ? backlog
+                                                                      : 16 * options.framesPerBlock,
+                                         framesRead);
+        }
+
+        consumerStats = consumer.getStatistics();
+    });
+
+    while (!consumerReady.load(std::memory_order_acquire))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    pinCurrentThread(options.producerCpu);
+    std::vector<std::vector<float>> channelData(options.channels, std::vector<float>(options.framesPerBlock, 0.25f));
+    std::vector<const float*> channelPointers;
+    for (const auto& channel : channelData)
+    {
+        channelPointers.push_back(channel.data());
+    }
+
+    const auto blockPeriodNs = static_cast<std::uint64_t>(1.0e9 * options.framesPerBlock / options.sampleRate);
+    const auto durationNs = static_cast<std::uint64_t>(options.seconds * 1.0e9);
+    const auto startTime = nowNanoseconds();
+    auto nextBlockTime = startTime;
+
+    while (nowNanoseconds() - startTime < durationNs)
+    {
+        nextBlockTime += blockPeriodNs;
+        while (nowNanoseconds() < nextBlockTime)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        // Stamp before the commit so the consumer never sees a stamp newer than its data.
+        lastCommitNs.store(nowNanoseconds(), std::memory_order_release);
+        producer.write(channelPointers.data(), options.channels, options.framesPerBlock);
+    }
+
+    const auto elapsed = static_cast<double>(nowNanoseconds() - startTime) * 1.0e-9;
+    stop.store(true, std::memory_order_release);
+    consumerThread.join();
+    producer.destroy();
+
+    std::sort(latencies.begin(), latencies.end());
+
+    Result result;
+    result.producerSignalsPerSecond = static_cast<double>(consumerStats.producerSignals) / elapsed;
+    result.blockingWaitsPerSecond = static_cast<double>(consumerStats.blockingWaits) / elapsed;
+    result.syscallsPerSecond = result.producerSignalsPerSecond + result.blockingWaitsPerSecond;
+    result.p50Us = percentileUs(latencies, 0.50);
+    result.p99Us = percentileUs(latencies, 0.99);
+    result.maxUs = latencies.empty() ? 0.0 : static_cast<double>(latencies.back()) * 1.0e-3;
+    result.wakeups = latencies.size();
+    return result;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace oceanaudio::bench;
+
+    Options options;
+    options.producerCpu = intOption(argc, argv, "--producer-cpu", options.producerCpu);
+    options.consumerCpu = intOption(argc, argv, "--consumer-cpu", options.consumerCpu);
+    options.framesPerBlock = static_cast<std::uint32_t>(intOption(argc, argv, "--frames", 128));
+    options.channels = static_cast<std::uint32_t>(intOption(argc, argv, "--channels", 2));
+    options.sampleRate = static_cast<std::uint32_t>(intOption(argc, argv, "--rate", 48000));
+    options.seconds = doubleOption(argc, argv, "--seconds", options.seconds);
+
+    std::printf("%u frames x %u channels @ %u Hz (%.0f blocks/s), cpus %d -> %d\n",
+                options.framesPerBlock,
+                options.channels,
+                options.sampleRate,
+                static_cast<double>(options.sampleRate) / options.framesPerBlock,
+                options.producerCpu,
+                options.consumerCpu);
+    std::printf("%-16s %12s %12s %12s %10s %10s %10s\n",
+                "mode", "syscalls/s", "signals/s", "waits/s", "p50 us", "p99 us", "max us");
+
+    const Mode modes[] = {
+        {"every-block", true, 0},
+        {"flag spin=0", false, 0},
+        {"flag spin=20", false, 20},
+        {"flag spin=100", false, 100},
+        {"flag spin=500", false, 500},
+        {"flag spin=5000", false, 5000},
+    };
+
+    for (const auto& mode : modes)
+    {
+        const auto result = runMode(options, mode);
+        std::printf("%-16s %12.0f %12.0f %12.0f %10.1f %10.1f %10.1f\n",
+                    mode.name,
+                    result.syscallsPerSecond,
+                    result.producerSignalsPerSecond,
+                    result.blockingWaitsPerSecond,
+                    result.p50Us,
+                    result.p99Us,
+                    result.maxUs);
+    }
+
+    return 0;
+}
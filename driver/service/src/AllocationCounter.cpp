@@ -0,0 +1,59 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+thread_local std::uint64_t allocationsOnThisThread = 0;
+
+void* countedAllocate(std::size_t size)
+{
+    ++allocationsOnThisThread;
+    if (void* memory = std::malloc(size != 0 ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+} // namespace
+
+namespace oceanaudio::allocation
+{
+std::uint64_t countOnThisThread() noexcept
+{
+    return allocationsOnThisThread;
+}
+} // namespace oceanaudio::allocation
+
+// The array and nothrow forms forward to these by default. Over-aligned allocations
+// keep the standard library's own (matching) new/delete pair and are not counted.
+void* operator new(std::size_t size)
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return countedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+namespace oceanaudio::allocation
+{
+// Number of global operator new calls made so far on the calling thread. Linking the
+// consumer core replaces the global allocation functions with counting wrappers around
+// malloc/free, so ConsumerEngine can report allocations on its delivery path.
+[[nodiscard]] std::uint64_t countOnThisThread() noexcept;
+} // namespace oceanaudio::allocation
@@ -2,7 +2,11 @@
 
 #include "BridgeConsumer.h"
 
+#include <OceanAudio/InterleaveKernels.h>
+#include <OceanAudio/WakeupSignalling.h>
+
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 
 namespace
@@ -10,13 +14,20 @@ namespace
 constexpr wchar_t kDefaultMappingName[] = L"Global\\OceanAudio_AudioRing";
 constexpr wchar_t kDefaultReadyEventName[] = L"Global\\OceanAudio_AudioReady";
 constexpr wchar_t kDefaultConsumedEventName[] = L"Global\\OceanAudio_AudioConsumed";
+
+// Reading the clock is far dearer than a pause; check the spin deadline every so often.
+constexpr std::uint32_t kSpinIterationsPerClockCheck = 64;
 } // namespace
 
 BridgeConsumer::BridgeConsumer()
-    : mappingHandle(nullptr),
+    :
+#if defined(_WIN32)
+      mappingHandle(nullptr),
       audioReadyEvent(nullptr),
       audioConsumedEvent(nullptr),
+#endif
       header(nullptr),
+      layoutStatus(oceanaudio::SharedLayoutStatus::Uninitialised),
       stats()
 {
 }
@@ -24,57 +35,151 @@ BridgeConsumer::BridgeConsumer()
 BridgeConsumer::~BridgeConsumer()
 {
     close();
+#if defined(__linux__)
+    socketClient.close();
+#endif
 }
 
 bool BridgeConsumer::open(const std::wstring& mappingName,
                           const std::wstring& readyEventName,
-                          const std::wstring& consumedEventName)
+                          const std::wstring& consumedEventName,
+                          oceanaudio::ReaderLagPolicy lagPolicy,
+                          const oceanaudio::MappingResidencyOptions& residency)
 {
     close();
+    layoutStatus = oceanaudio::SharedLayoutStatus::Uninitialised;
 
     const std::wstring mapping = mappingName.empty() ? std::wstring(kDefaultMappingName) : mappingName;
     const std::wstring ready = readyEventName.empty() ? std::wstring(kDefaultReadyEventName) : readyEventName;
     const std::wstring consumed = consumedEventName.empty() ? std::wstring(kDefaultConsumedEventName) : consumedEventName;
 
+#if defined(_WIN32)
     mappingHandle = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, mapping.c_str());
     if (mappingHandle == nullptr)
     {
         return false;
     }
 
-    audioReadyEvent = OpenEventW(SYNCHRONIZE, FALSE, ready.c_str());
+    audioConsumedEvent = OpenEventW(EVENT_MODIFY_STATE, FALSE, consumed.c_str());
+    if (audioConsumedEvent == nullptr)
+    {
+        close();
+        return false;
+    }
+
+    auto* mappedPtr = MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (mappedPtr == nullptr)
+    {
+        close();
+        return false;
+    }
+
+    MEMORY_BASIC_INFORMATION regionInfo {};
+    const std::size_t mappedBytes = VirtualQuery(mappedPtr, &regionInfo, sizeof(regionInfo)) != 0
+                                        ? regionInfo.RegionSize
+                                        : 0;
+#else
+    if (!sharedMapping.open(oceanaudio::posix::toObjectName(mapping)))
+    {
+        return false;
+    }
+
+    if (!audioConsumedEvent.open(oceanaudio::posix::toObjectName(consumed)))
+    {
+        close();
+        return false;
+    }
+
+    auto* mappedPtr = sharedMapping.data();
+    const std::size_t mappedBytes = sharedMapping.sizeInBytes();
+#endif
+
+    if (!attachReader(mappedPtr, mappedBytes, lagPolicy, residency))
+    {
+        close();
+        return false;
+    }
+
+    // Each reader sleeps on its own ready event; an auto-reset event shared by several
+    // readers would wake only one of them.
+    const auto slot = ring.getSlotIndex();
+#if defined(_WIN32)
+    audioReadyEvent = OpenEventW(SYNCHRONIZE, FALSE, oceanaudio::readerEventName(ready, slot).c_str());
     if (audioReadyEvent == nullptr)
+#else
+    if (!audioReadyEvent.open(oceanaudio::posix::toObjectName(oceanaudio::readerEventName(ready, slot))))
+#endif
     {
         close();
         return false;
     }
 
-    audioConsumedEvent = OpenEventW(EVENT_MODIFY_STATE, FALSE, consumed.c_str());
-    if (audioConsumedEvent == nullptr)
+    markAttached();
+    return true;
+}
+
+#if defined(__linux__)
+bool BridgeConsumer::openSocket(const std::string& socketPath,
+                                oceanaudio::ReaderLagPolicy lagPolicy,
+                                const oceanaudio::MappingResidencyOptions& residency)
+{
+    close();
+    layoutStatus = oceanaudio::SharedLayoutStatus::Uninitialised;
+
+    // The connection outlives close(): the producer announces a replacement mapping on
+    // it, and we take that on the next call.
+    const auto path = socketPath.empty() ? oceanaudio::posix::defaultBridgeSocketPath() : socketPath;
+    if (!socketClient.isConnected() && !socketClient.connect(path))
+    {
+        return false;
+    }
+
+    oceanaudio::posix::SocketBridgeAnnouncement announcement;
+    oceanaudio::posix::AnnouncedDescriptors descriptors;
+    if (!socketClient.receiveLatest(announcement, descriptors))
+    {
+        return false;
+    }
+
+    if (!sharedMapping.openFromDescriptor(descriptors.get(oceanaudio::posix::kAnnouncedRingDescriptor))
+        || !audioConsumedEvent.adoptDescriptor(
+            descriptors.take(oceanaudio::posix::kAnnouncedConsumedEventDescriptor)))
     {
         close();
         return false;
     }
 
-    auto* mappedPtr = MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
-    if (mappedPtr == nullptr)
+    if (!attachReader(sharedMapping.data(), sharedMapping.sizeInBytes(), lagPolicy, residency))
     {
         close();
         return false;
     }
 
-    header = static_cast<oceanaudio::SharedAudioRingBufferHeader*>(mappedPtr);
-    if (header->magic != oceanaudio::SharedAudioRingBufferHeader::kMagic)
+    // The other slots' ready events close with `descriptors`.
+    const auto slot = ring.getSlotIndex();
+    if (!audioReadyEvent.adoptDescriptor(descriptors.take(oceanaudio::posix::kAnnouncedReadyEventDescriptor + slot)))
     {
         close();
         return false;
     }
 
+    markAttached();
     return true;
 }
+#endif
 
 void BridgeConsumer::close()
 {
+    // An evicted reader's slot may already belong to someone else.
+    if (header != nullptr && ring.isAttached() && !ring.isEvicted())
+    {
+        const auto slot = ring.getSlotIndex();
+        header->attachedReaders.fetch_and(~(1u << slot), std::memory_order_acq_rel);
+        oceanaudio::wakeup::cancelSleep(header->readerWaiting[slot]);
+    }
+    ring.detach();
+
+#if defined(_WIN32)
     if (header != nullptr)
     {
         UnmapViewOfFile(header);
@@ -98,6 +203,63 @@ void BridgeConsumer::close()
         CloseHandle(mappingHandle);
         mappingHandle = nullptr;
     }
+#else
+    header = nullptr;
+    sharedMapping.close();
+    audioReadyEvent.close();
+    audioConsumedEvent.close();
+#endif
+
+    format = {};
+    retired = false;
+}
+
+bool BridgeConsumer::attachReader(void* mappedPtr,
+                                  std::size_t mappedBytes,
+                                  oceanaudio::ReaderLagPolicy lagPolicy,
+                                  const oceanaudio::MappingResidencyOptions& residency)
+{
+    header = static_cast<oceanaudio::SharedAudioRingBufferHeader*>(mappedPtr);
+
+    layoutStatus = oceanaudio::checkSharedLayout(mappedPtr, mappedBytes);
+    if (layoutStatus == oceanaudio::SharedLayoutStatus::Compatible && !isProducerAlive())
+    {
+        // Left behind by a producer that died; wait for the next one to take it over.
+        layoutStatus = oceanaudio::SharedLayoutStatus::ProducerGone;
+    }
+    if (layoutStatus != oceanaudio::SharedLayoutStatus::Compatible)
+    {
+        return false;
+    }
+
+    const bool formatRead = header->readFormatBounded(format);
+
+    if (!formatRead || !header->isReadable(format))
+    {
+        layoutStatus = formatRead ? oceanaudio::SharedLayoutStatus::InvalidFormat
+                                  : oceanaudio::SharedLayoutStatus::Uninitialised;
+        return false;
+    }
+
+    auto viewOptions = residency;
+    viewOptions.hugePages = false;
+    stats.memoryResidency = oceanaudio::makeResident(mappedPtr, mappedBytes, viewOptions);
+
+    return ring.attach(header->writeCursor,
+                       header->readers,
+                       format.frameCapacity,
+                       lagPolicy,
+                       format.framesPerBlock,
+                       format.generation);
+}
+
+void BridgeConsumer::markAttached()
+{
+    const auto slot = ring.getSlotIndex();
+    header->attachedReaders.fetch_or(1u << slot, std::memory_order_acq_rel);
+    stats.readerSlot = slot;
+    nextBlockSequence = header->blockSequence.load(std::memory_order_acquire) + 1;
+    resetIntegrityChecks();
 }
 
 bool BridgeConsumer::isOpen() const noexcept
@@ -105,93 +267,625 @@ bool BridgeConsumer::isOpen() const noexcept
     return header != nullptr;
 }
 
-bool BridgeConsumer::waitForData(DWORD timeoutMs) const
+bool BridgeConsumer::isRetired() const noexcept
 {
-    if (audioReadyEvent == nullptr)
+    return retired || ring.isEvicted();
+}
+
+bool BridgeConsumer::isEvicted() const noexcept
+{
+    return ring.isEvicted();
+}
+
+void BridgeConsumer::setProducerTimeout(std::uint32_t milliseconds) noexcept
+{
+    producerTimeoutNs = std::uint64_t {milliseconds} * 1'000'000;
+}
+
+bool BridgeConsumer::isProducerAlive() const noexcept
+{
+    if (header == nullptr)
     {
         return false;
     }
 
-    const DWORD result = WaitForSingleObject(audioReadyEvent, timeoutMs);
-    return result == WAIT_OBJECT_0;
+    const auto& producerHeartbeat = header->producerHeartbeat;
+    return producerTimeoutNs == 0 || producerHeartbeat.getBeats() == 0
+           || producerHeartbeat.isAlive(oceanaudio::sharedClockNanoseconds(), producerTimeoutNs);
 }
 
-bool BridgeConsumer::readAvailableFrames(std::vector<float>& frameBuffer, std::uint32_t& framesRead)
+void BridgeConsumer::heartbeat() noexcept
+{
+    if (header == nullptr || !ring.isAttached() || ring.isEvicted())
+    {
+        return;
+    }
+
+    if (!ring.heartbeat(oceanaudio::sharedClockNanoseconds()))
+    {
+        return;
+    }
+
+    // An eviction racing with a new claim of this slot can clear the new owner's bit;
+    // put it back so the producer keeps waking us.
+    const auto bit = 1u << ring.getSlotIndex();
+    if ((header->attachedReaders.load(std::memory_order_relaxed) & bit) == 0)
+    {
+        header->attachedReaders.fetch_or(bit, std::memory_order_acq_rel);
+    }
+}
+
+bool BridgeConsumer::refreshFormat()
 {
-    framesRead = 0;
     if (header == nullptr)
     {
         return false;
     }
 
-    const auto available = header->framesAvailable.load(std::memory_order_acquire);
-    if (available == 0)
+    const auto generation = header->formatGeneration.load(std::memory_order_acquire);
+    if (generation == format.generation)
+    {
+        return false;
+    }
+
+    if (generation == oceanaudio::SharedAudioRingBufferHeader::kFormatRetired)
+    {
+        retired = true;
+        return false;
+    }
+
+    // Mid-change (odd generation), or an unusable format: keep the old one for now and
+    // look again on the next call. The producer is not writing meanwhile.
+    oceanaudio::BridgeFormat next;
+    if (!header->readFormat(next) || !header->isReadable(next))
     {
-        header->underruns.fetch_add(1, std::memory_order_relaxed);
-        ++stats.underruns;
         return false;
     }
 
-    const auto channels = header->channels;
-    if (channels == 0)
+    ring.reformat(next.frameCapacity, next.framesPerBlock, next.startFrame, next.generation);
+    format = next;
+    ++stats.formatChanges;
+    // The reader jumps to the new format's first frame; that is not a gap. Blocks
+    // before it are passed over by the walk.
+    integrityCursor = kUnknownFrame;
+    producerStreamEnd = kUnknownFrame;
+    checkingBlock = false;
+    boundaryDetector.reset();
+    return true;
+}
+
+bool BridgeConsumer::waitForData(std::uint32_t timeoutMs, std::uint32_t spinMicroseconds)
+{
+    if (header == nullptr)
     {
         return false;
     }
 
-    const auto capacity = header->frameCapacity;
-    const auto framesPerBlock = header->framesPerBlock != 0 ? header->framesPerBlock : available;
-    const auto framesToRead = std::min(available, framesPerBlock);
+    heartbeat();
+    refreshFormat();
+    if (isRetired())
+    {
+        return false;
+    }
 
-    frameBuffer.resize(static_cast<std::size_t>(framesToRead * channels));
+    if (ring.readableFrames() > 0)
+    {
+        ++stats.immediateReads;
+        return true;
+    }
 
-    const auto readPosition = header->readPosition.load(std::memory_order_relaxed);
-    auto* payload = reinterpret_cast<const float*>(header + 1);
+    if (spinMicroseconds > 0)
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto spinDeadline = Clock::now() + std::chrono::microseconds(spinMicroseconds);
+        for (std::uint32_t iteration = 1;; ++iteration)
+        {
+            oceanaudio::wakeup::cpuRelax();
+            if (ring.readableFrames() > 0)
+            {
+                ++stats.spinWakeups;
+                return true;
+            }
+            if (iteration % kSpinIterationsPerClockCheck == 0 && Clock::now() >= spinDeadline)
+            {
+                break;
+            }
+        }
+    }
 
-    const std::uint32_t firstChunk = std::min(framesToRead, capacity - readPosition);
-    const std::uint32_t secondChunk = framesToRead - firstChunk;
+    // Tell the producer to signal, then look once more: a block committed before the
+    // flag became visible would otherwise be missed until the timeout.
+    auto& waitingFlag = header->readerWaiting[ring.getSlotIndex()];
+    oceanaudio::wakeup::announceSleep(waitingFlag);
+    if (ring.readableFrames() > 0)
+    {
+        oceanaudio::wakeup::cancelSleep(waitingFlag);
+        ++stats.spinWakeups;
+        return true;
+    }
 
-    const std::size_t frameStride = channels;
+    ++stats.blockingWaits;
+#if defined(_WIN32)
+    if (audioReadyEvent != nullptr)
+    {
+        WaitForSingleObject(audioReadyEvent, timeoutMs);
+    }
+#else
+    if (audioReadyEvent.isOpen())
+    {
+        audioReadyEvent.wait(timeoutMs);
+    }
+#endif
+    oceanaudio::wakeup::cancelSleep(waitingFlag);
+
+    // A signal left over from an earlier sleep that timed out can wake us with nothing
+    // to read; report that as a timeout rather than a wakeup.
+    return ring.readableFrames() > 0;
+}
+
+std::uint32_t BridgeConsumer::availableFrames()
+{
+    return header != nullptr ? ring.readableFrames() : 0;
+}
+
+std::uint64_t BridgeConsumer::lastWriteTimestamp() const noexcept
+{
+    return header != nullptr ? header->writeTimestampNs.load(std::memory_order_relaxed) : 0;
+}
+
+std::uint64_t BridgeConsumer::getReadPosition() const noexcept
+{
+    return ring.cursor();
+}
+
+bool BridgeConsumer::acquireFrames(std::uint32_t maxFrames, FrameSpans& frames)
+{
+    frames = {};
+    if (header == nullptr || format.channels == 0)
+    {
+        return false;
+    }
+
+    const auto regions = beginRead(maxFrames);
+    if (regions.totalFrames() == 0)
+    {
+        return false;
+    }
+
+    const std::size_t frameStride = format.channels;
+    const auto* payload = header->payload();
+    frames.first = payload + regions.first.offset * frameStride;
+    frames.firstFrames = regions.first.frames;
+    frames.second = payload + regions.second.offset * frameStride;
+    frames.secondFrames = regions.second.frames;
+    return true;
+}
+
+void BridgeConsumer::releaseFrames(const FrameSpans& frames)
+{
+    if (frames.totalFrames() != 0)
+    {
+        finishRead(frames.totalFrames());
+    }
+}
+
+bool BridgeConsumer::readAvailableFrames(std::vector<float>& frameBuffer, std::uint32_t& framesRead)
+{
+    framesRead = 0;
+    if (header == nullptr || format.channels == 0)
+    {
+        return false;
+    }
+
+    const auto framesPerBlock = format.framesPerBlock != 0 ? format.framesPerBlock : ring.capacity();
+    const auto regions = beginRead(framesPerBlock);
+    const auto framesToRead = regions.totalFrames();
+    if (framesToRead == 0)
+    {
+        return false;
+    }
+
+    const std::size_t frameStride = format.channels;
+    frameBuffer.resize(static_cast<std::size_t>(framesToRead) * frameStride);
+
+    const auto* payload = header->payload();
     float* destination = frameBuffer.data();
 
-    for (std::uint32_t i = 0; i < firstChunk; ++i)
+    std::memcpy(destination,
+                payload + regions.first.offset * frameStride,
+                regions.first.frames * frameStride * sizeof(float));
+    std::memcpy(destination + regions.first.frames * frameStride,
+                payload + regions.second.offset * frameStride,
+                regions.second.frames * frameStride * sizeof(float));
+
+    framesRead = framesToRead;
+    finishRead(framesToRead);
+    return true;
+}
+
+bool BridgeConsumer::readAvailableFrames(float* const* channelBuffers,
+                                         std::uint32_t numChannels,
+                                         std::uint32_t maxFrames,
+                                         std::uint32_t& framesRead)
+{
+    framesRead = 0;
+    if (header == nullptr || format.channels == 0 || channelBuffers == nullptr || numChannels == 0)
     {
-        const auto frameIndex = readPosition + i;
-        const auto offset = frameIndex * frameStride;
-        std::memcpy(destination + (i * frameStride), payload + offset, frameStride * sizeof(float));
+        return false;
     }
 
-    for (std::uint32_t i = 0; i < secondChunk; ++i)
+    const auto regions = beginRead(maxFrames);
+    const auto framesToRead = regions.totalFrames();
+    if (framesToRead == 0)
     {
-        const auto offset = i * frameStride;
-        std::memcpy(destination + ((firstChunk + i) * frameStride),
-                    payload + offset,
-                    frameStride * sizeof(float));
+        return false;
     }
 
+    const std::size_t frameStride = format.channels;
+    const auto* payload = header->payload();
+
+    oceanaudio::deinterleave::toPlanar(payload + regions.first.offset * frameStride, frameStride,
+                                       channelBuffers, numChannels, 0, regions.first.frames);
+    oceanaudio::deinterleave::toPlanar(payload + regions.second.offset * frameStride, frameStride,
+                                       channelBuffers, numChannels, regions.first.frames, regions.second.frames);
+
     framesRead = framesToRead;
-    advanceReadPointer(framesToRead);
-    stats.totalFramesRead += framesToRead;
+    finishRead(framesToRead);
+    return true;
+}
+
+const oceanaudio::SharedLatencyHistogram* BridgeConsumer::getResidencyHistogram() const noexcept
+{
+    return header != nullptr ? &header->residency : nullptr;
+}
+
+oceanaudio::SharedLayoutStatus BridgeConsumer::getLayoutStatus() const noexcept
+{
+    return layoutStatus;
+}
+
+StreamFormat BridgeConsumer::getFormat() const noexcept
+{
+    StreamFormat streamFormat;
+    if (header != nullptr)
+    {
+        streamFormat.channels = format.channels;
+        streamFormat.sampleRate = format.sampleRate;
+        streamFormat.framesPerBlock = format.framesPerBlock;
+    }
+    return streamFormat;
+}
+
+std::uint32_t BridgeConsumer::getFormatGeneration() const noexcept
+{
+    return format.generation;
+}
+
+std::uint32_t BridgeConsumer::getRingCapacity() const noexcept
+{
+    return format.frameCapacity;
+}
+
+void BridgeConsumer::setIntegritySettings(const IntegritySettings& settings) noexcept
+{
+    integritySettings = settings;
+    boundaryDetector.setSettings(settings.discontinuity);
+    resetIntegrityChecks();
+}
+
+const oceanaudio::IntegrityEventLog& BridgeConsumer::getIntegrityEvents() const noexcept
+{
+    return integrityEvents;
+}
+
+void BridgeConsumer::setBlockLog(bool enabled)
+{
+    blockLog.clear();
+    if (enabled)
+    {
+        blockLog.reserve(oceanaudio::kBlockDescriptorCount);
+    }
+    else
+    {
+        blockLog.shrink_to_fit();
+    }
+}
 
+std::uint32_t BridgeConsumer::takeLoggedBlocks(oceanaudio::BridgeBlockTiming* blocks, std::uint32_t maxBlocks) noexcept
+{
+    const auto count = static_cast<std::uint32_t>(std::min<std::size_t>(blockLog.size(), maxBlocks));
+    std::copy(blockLog.begin(), blockLog.begin() + count, blocks);
+    blockLog.erase(blockLog.begin(), blockLog.begin() + count);
+    return count;
+}
+
+BridgeConsumer::Statistics BridgeConsumer::getStatistics() const noexcept
+{
+    auto snapshot = stats;
+    if (header != nullptr)
+    {
+        snapshot.producerSignals = header->wakeSignals.load(std::memory_order_relaxed);
+    }
+    snapshot.framesSkipped = ring.getFramesSkipped();
+    snapshot.framesOverwritten = ring.getFramesOverwritten();
+    snapshot.rejoins = ring.getRejoins();
+    snapshot.framesDiscarded = ring.getFramesDiscarded();
+    return snapshot;
+}
+
+oceanaudio::SpscRingRegions BridgeConsumer::beginRead(std::uint32_t maxFrames)
+{
+    const auto regions = ring.prepareRead(maxFrames);
+
+    // The producer publishes a new format before moving its cursor past the old one, so
+    // once the cursor has been loaded a stale generation shows here. The frames beyond
+    // the old format's end are not frames at all; read nothing until refreshFormat()
+    // has caught up.
+    if (header->formatGeneration.load(std::memory_order_relaxed) != format.generation)
+    {
+        return {};
+    }
+
+    if (regions.totalFrames() == 0)
+    {
+        ring.getSlot()->underruns.fetch_add(1, std::memory_order_relaxed);
+        ++stats.underruns;
+    }
+    return regions;
+}
+
+void BridgeConsumer::finishRead(std::uint32_t frames)
+{
+    // While the frames are still ours: once released the producer may overwrite them.
+    if (integritySettings.enabled)
+    {
+        checkReleasedFrames(frames);
+    }
+
+    ring.commitRead(frames);
+    stats.totalFramesRead += frames;
+    if (ring.getSlotIndex() == 0)
+    {
+        timeReleasedBlocks();
+    }
+
+    if (!oceanaudio::wakeup::claimSleepingPeer(header->producerWaiting))
+    {
+        return;
+    }
+
+#if defined(_WIN32)
     if (audioConsumedEvent != nullptr)
     {
         SetEvent(audioConsumedEvent);
     }
+#else
+    if (audioConsumedEvent.isOpen())
+    {
+        audioConsumedEvent.set();
+    }
+#endif
+}
 
-    return true;
+void BridgeConsumer::timeReleasedBlocks()
+{
+    const auto newest = header->blockSequence.load(std::memory_order_acquire);
+    if (nextBlockSequence > newest + 1 || newest - nextBlockSequence >= oceanaudio::kBlockDescriptorCount)
+    {
+        // The producer restarted its sequence, or published faster than we released
+        // and lapped the side ring: pick up from its newest block.
+        stats.blockTimingsLost += nextBlockSequence <= newest ? newest - nextBlockSequence + 1 : 0;
+        nextBlockSequence = newest + 1;
+        return;
+    }
+
+    const auto now = oceanaudio::sharedClockNanoseconds();
+    const auto released = ring.cursor();
+    while (nextBlockSequence <= newest)
+    {
+        oceanaudio::BridgeBlockTiming block;
+        if (!header->readBlock(nextBlockSequence, block) || block.frameIndex + block.frames > released)
+        {
+            // Being rewritten, or its last frame is still queued: look again next time.
+            break;
+        }
+
+        const auto residencyNs = now > block.captureTimeNs ? now - block.captureTimeNs : 0;
+        header->residency.record(residencyNs / 1000);
+        ++stats.blocksTimed;
+        ++nextBlockSequence;
+    }
 }
 
-BridgeConsumer::Statistics BridgeConsumer::getStatistics() const noexcept
+void BridgeConsumer::resetIntegrityChecks()
+{
+    integrityCursor = kUnknownFrame;
+    producerStreamEnd = kUnknownFrame;
+    nextCheckedSequence = header != nullptr ? header->blockSequence.load(std::memory_order_acquire) + 1 : 0;
+    checkingBlock = false;
+    boundaryDetector.reset();
+}
+
+void BridgeConsumer::checkReleasedFrames(std::uint32_t frames)
+{
+    const auto start = ring.cursor();
+    const auto end = start + frames;
+    if (integrityCursor != kUnknownFrame && start != integrityCursor)
+    {
+        // This reader's stream jumped: it skipped ahead (Skip policy) or went back.
+        const bool missing = start > integrityCursor;
+        const auto count = missing ? start - integrityCursor : integrityCursor - start;
+        (missing ? stats.framesMissing : stats.framesDuplicated) += count;
+        recordIntegrityEvent(missing ? oceanaudio::IntegrityEventKind::FrameGap
+                                     : oceanaudio::IntegrityEventKind::DuplicateFrames,
+                             0, integrityCursor, count);
+        checkingBlock = false;
+        boundaryDetector.reset();
+    }
+    integrityCursor = end;
+
+    auto position = start;
+    while (position < end)
+    {
+        if (!checkingBlock && !nextCheckedBlock(position))
+        {
+            // No descriptor for these frames (yet): nothing to check them against.
+            boundaryDetector.reset();
+            return;
+        }
+
+        if (position < checkedBlock.frameIndex)
+        {
+            position = std::min(end, checkedBlock.frameIndex);
+            boundaryDetector.reset();
+            continue;
+        }
+
+        const auto blockEnd = checkedBlock.frameIndex + checkedBlock.frames;
+        const auto chunkEnd = std::min(end, blockEnd);
+        checkFrames(position, chunkEnd, position == checkedBlock.frameIndex);
+        position = chunkEnd;
+        if (position == blockEnd)
+        {
+            finishCheckedBlock();
+        }
+    }
+}
+
+bool BridgeConsumer::nextCheckedBlock(std::uint64_t position)
 {
-    return stats;
+    const auto newest = header->blockSequence.load(std::memory_order_acquire);
+    if (nextCheckedSequence > newest + 1)
+    {
+        // The producer restarted its sequence; follow it from its newest block.
+        nextCheckedSequence = newest + 1;
+        producerStreamEnd = kUnknownFrame;
+    }
+
+    while (nextCheckedSequence <= newest)
+    {
+        const auto sequence = nextCheckedSequence++;
+        oceanaudio::BridgeBlockTiming block;
+        if (newest - sequence >= oceanaudio::kBlockDescriptorCount || !header->readBlock(sequence, block))
+        {
+            // Lapped by the producer, or being rewritten for a later block right now.
+            const auto lost = newest - sequence >= oceanaudio::kBlockDescriptorCount
+                                  ? newest - sequence - oceanaudio::kBlockDescriptorCount + 1
+                                  : 1;
+            nextCheckedSequence = sequence + lost;
+            stats.descriptorsLost += lost;
+            recordIntegrityEvent(oceanaudio::IntegrityEventKind::DescriptorsLost, sequence, position, lost);
+            producerStreamEnd = kUnknownFrame;
+            continue;
+        }
+
+        if (block.droppedBefore > 0)
+        {
+            stats.producerDroppedBlocks += block.droppedBefore;
+            recordIntegrityEvent(oceanaudio::IntegrityEventKind::ProducerDrop, sequence, block.frameIndex,
+                                 block.droppedBefore);
+        }
+        if (producerStreamEnd != kUnknownFrame && block.frameIndex < producerStreamEnd)
+        {
+            // The producer wrote over frames it had already described.
+            const auto repeated = std::min<std::uint64_t>(producerStreamEnd - block.frameIndex, block.frames);
+            stats.framesDuplicated += repeated;
+            recordIntegrityEvent(oceanaudio::IntegrityEventKind::DuplicateFrames, sequence, block.frameIndex, repeated);
+        }
+        producerStreamEnd = block.frameIndex + block.frames;
+
+        if (producerStreamEnd <= position)
+        {
+            // Released before we attached, or skipped: nothing left of it to check.
+            continue;
+        }
+
+        if (blockLog.capacity() != 0)
+        {
+            // Capacity was reserved in setBlockLog(), so this never reallocates.
+            if (blockLog.size() < blockLog.capacity())
+            {
+                blockLog.push_back(block);
+            }
+            else
+            {
+                ++stats.blocksNotLogged;
+            }
+        }
+
+        checkedBlock = block;
+        checkingBlock = true;
+        summingBlock = integritySettings.verifyChecksums && (block.flags & oceanaudio::kBlockHasChecksum) != 0
+                       && position <= block.frameIndex;
+        blockChecksum = 0;
+        return true;
+    }
+    return false;
 }
 
-void BridgeConsumer::advanceReadPointer(std::uint32_t frames)
+void BridgeConsumer::checkFrames(std::uint64_t from, std::uint64_t to, bool blockStart)
 {
-    const auto capacity = header->frameCapacity;
-    auto readPosition = header->readPosition.load(std::memory_order_relaxed);
+    const std::size_t stride = format.channels;
+    const auto mask = static_cast<std::uint64_t>(format.frameCapacity) - 1;
+    const auto* payload = header->payload();
+    while (from < to)
+    {
+        // Split where the ring wraps.
+        const auto offset = from & mask;
+        const auto frames = static_cast<std::uint32_t>(std::min(to - from, format.frameCapacity - offset));
+        const float* span = payload + offset * stride;
+        if (summingBlock)
+        {
+            blockChecksum = oceanaudio::crc32c(blockChecksum, span, frames * stride * sizeof(float));
+        }
+        if (integritySettings.detectDiscontinuities)
+        {
+            const auto finding = boundaryDetector.feed(span, frames, format.channels, blockStart);
+            if (finding.found)
+            {
+                ++stats.discontinuities;
+                recordIntegrityEvent(oceanaudio::IntegrityEventKind::Discontinuity, checkedBlock.sequence, from, 0,
+                                     finding.channel, finding.jump);
+            }
+        }
+        blockStart = false;
+        from += frames;
+    }
+}
 
-    readPosition = (readPosition + frames) % capacity;
-    header->readPosition.store(readPosition, std::memory_order_release);
-    header->framesAvailable.fetch_sub(frames, std::memory_order_release);
+void BridgeConsumer::finishCheckedBlock()
+{
+    checkingBlock = false;
+    if (!summingBlock)
+    {
+        return;
+    }
+
+    if (blockChecksum == checkedBlock.checksum)
+    {
+        ++stats.blocksVerified;
+        return;
+    }
+
+    ++stats.checksumMismatches;
+    recordIntegrityEvent(oceanaudio::IntegrityEventKind::ChecksumMismatch, checkedBlock.sequence,
+                         checkedBlock.frameIndex, blockChecksum);
 }
 
+void BridgeConsumer::recordIntegrityEvent(oceanaudio::IntegrityEventKind kind,
+                                          std::uint64_t sequence,
+                                          std::uint64_t frameIndex,
+                                          std::uint64_t value,
+                                          std::uint32_t channel,
+                                          float magnitude)
+{
+    oceanaudio::IntegrityEvent event;
+    event.kind = kind;
+    event.channel = channel;
+    event.sequence = sequence;
+    event.frameIndex = frameIndex;
+    event.timeNs = oceanaudio::sharedClockNanoseconds();
+    event.value = value;
+    event.magnitude = magnitude;
+    integrityEvents.record(event);
+}
@@ -1,8 +1,21 @@
 #pragma once
 
+#include "FrameSink.h"
+
+#include <OceanAudio/BridgeIntegrity.h>
 #include <OceanAudio/BridgeSharedMemory.h>
+#include <OceanAudio/BroadcastRing.h>
+#include <OceanAudio/MappingResidency.h>
 
+#if defined(_WIN32)
 #include <Windows.h>
+#else
+#include <OceanAudio/PosixSharedMemory.h>
+#endif
+
+#if defined(__linux__)
+#include <OceanAudio/UnixSocketTransport.h>
+#endif
 
 #include <cstdint>
 #include <string>
@@ -17,31 +30,211 @@ public:
     BridgeConsumer(const BridgeConsumer&) = delete;
     BridgeConsumer& operator=(const BridgeConsumer&) = delete;
 
+    // Attaches as one reader of the broadcast ring, in the first free reader slot; fails
+    // if the mapping is unusable or every slot is taken. `lagPolicy` says what the
+    // producer does once this reader falls a whole ring behind. `residency` is applied
+    // to this reader's view before it attaches; huge pages are the producer's choice,
+    // so only prefault and lock matter here.
     bool open(const std::wstring& mappingName,
               const std::wstring& readyEventName,
-              const std::wstring& consumedEventName);
+              const std::wstring& consumedEventName,
+              oceanaudio::ReaderLagPolicy lagPolicy = oceanaudio::ReaderLagPolicy::Stall,
+              const oceanaudio::MappingResidencyOptions& residency = {});
+#if defined(__linux__)
+    // Same over the socket transport: connects to the producer's socket (the default
+    // path if empty) and attaches to the newest mapping it announced. Fails while none
+    // is announced; the connection stays open across close() so the next attempt picks
+    // up the next announcement.
+    bool openSocket(const std::string& socketPath,
+                    oceanaudio::ReaderLagPolicy lagPolicy = oceanaudio::ReaderLagPolicy::Stall,
+                    const oceanaudio::MappingResidencyOptions& residency = {});
+#endif
     void close();
 
     [[nodiscard]] bool isOpen() const noexcept;
+    // The producer gave this mapping up (disconnected, or needed a bigger one) or
+    // evicted this reader for missing heartbeats; close and open again.
+    [[nodiscard]] bool isRetired() const noexcept;
+    [[nodiscard]] bool isEvicted() const noexcept;
+
+    // How long the producer may go without a heartbeat before isProducerAlive() says
+    // it is gone and open() refuses its mapping; 0 trusts it forever. Producers that
+    // never beat at all are always trusted.
+    void setProducerTimeout(std::uint32_t milliseconds) noexcept;
+    [[nodiscard]] bool isProducerAlive() const noexcept;
+    // Tells the producer this reader is alive. waitForData() does it on every call;
+    // callers that only poll must call it at least every few tens of milliseconds, or
+    // the producer evicts the reader (see SharedAudioRingBufferHeader::evictDeadReaders).
+    void heartbeat() noexcept;
+    // Why the last open() rejected the mapping, if it got far enough to inspect it.
+    [[nodiscard]] oceanaudio::SharedLayoutStatus getLayoutStatus() const noexcept;
+    // Format this reader has adopted; invalid while closed.
+    [[nodiscard]] StreamFormat getFormat() const noexcept;
+    [[nodiscard]] std::uint32_t getFormatGeneration() const noexcept;
+    // Frames the ring holds in the adopted format.
+    [[nodiscard]] std::uint32_t getRingCapacity() const noexcept;
+
+    // Moves to the producer's current format if it changed (the producer changes format
+    // in place and waits for Stall readers to follow). Old-format frames not yet read
+    // are dropped. Call between reads, never while frames are acquired; waitForData()
+    // does so itself. Returns true if the format changed.
+    bool refreshFormat();
+
+    // Returns true once frames are readable. Polls the ring for up to
+    // `spinMicroseconds` first, then raises the consumer's waiter flag and blocks on
+    // the ready event for at most `timeoutMs`.
+    bool waitForData(std::uint32_t timeoutMs, std::uint32_t spinMicroseconds = 0);
+    [[nodiscard]] std::uint32_t availableFrames();
+    // sharedClockNanoseconds() of the producer's last commit, or 0 if it does not stamp.
+    [[nodiscard]] std::uint64_t lastWriteTimestamp() const noexcept;
+    // Producer frame index of the next frame this reader releases; between
+    // acquireFrames() and releaseFrames(), that of the first acquired frame.
+    [[nodiscard]] std::uint64_t getReadPosition() const noexcept;
+
+    // Zero-copy read: points `frames` at up to `maxFrames` readable frames inside the
+    // ring (two spans when the data wraps). The spans stay valid until
+    // releaseFrames(), which must be called before the next acquire.
+    bool acquireFrames(std::uint32_t maxFrames, FrameSpans& frames);
+    void releaseFrames(const FrameSpans& frames);
 
-    bool waitForData(DWORD timeoutMs) const;
     bool readAvailableFrames(std::vector<float>& frameBuffer, std::uint32_t& framesRead);
+    // Planar variant for sinks that want one buffer per channel; each channel must hold
+    // at least `maxFrames` samples.
+    bool readAvailableFrames(float* const* channelBuffers,
+                             std::uint32_t numChannels,
+                             std::uint32_t maxFrames,
+                             std::uint32_t& framesRead);
 
     struct Statistics
     {
         std::uint64_t totalFramesRead = 0;
         std::uint64_t underruns = 0;
+        // How waitForData found data: already there, while spinning, or after blocking
+        // (the blocking case is the one that costs a wait syscall).
+        std::uint64_t immediateReads = 0;
+        std::uint64_t spinWakeups = 0;
+        std::uint64_t blockingWaits = 0;
+        // Ready-event signals the producer actually issued (from the shared header).
+        std::uint64_t producerSignals = 0;
+        // Blocks whose residency went into the shared histogram, and blocks skipped
+        // because their descriptors were overwritten or the producer restarted.
+        std::uint64_t blocksTimed = 0;
+        std::uint64_t blockTimingsLost = 0;
+        // Broadcast reader state: the slot this reader holds, frames jumped over (Skip),
+        // frames the producer may have reached while they were being read (Skip and
+        // Detach), and times the producer detached this reader (Detach).
+        std::uint32_t readerSlot = 0;
+        std::uint64_t framesSkipped = 0;
+        std::uint64_t framesOverwritten = 0;
+        std::uint64_t rejoins = 0;
+        // In-place format changes followed, and old-format frames dropped by them.
+        std::uint64_t formatChanges = 0;
+        std::uint64_t framesDiscarded = 0;
+        // What open() achieved for the view it mapped.
+        oceanaudio::MappingResidency memoryResidency;
+        // Integrity checks (see IntegritySettings): blocks the producer reported
+        // dropping, frames missing from or repeated in this reader's stream, descriptors
+        // overwritten before they were checked, blocks whose checksum matched and did
+        // not, and sample jumps at block boundaries. In Skip and Detach readers,
+        // mismatches go together with framesOverwritten.
+        std::uint64_t producerDroppedBlocks = 0;
+        std::uint64_t framesMissing = 0;
+        std::uint64_t framesDuplicated = 0;
+        std::uint64_t descriptorsLost = 0;
+        std::uint64_t blocksVerified = 0;
+        std::uint64_t checksumMismatches = 0;
+        std::uint64_t discontinuities = 0;
+        // Blocks the walk reached while the block log (setBlockLog) was full.
+        std::uint64_t blocksNotLogged = 0;
     };
 
     Statistics getStatistics() const noexcept;
 
+    // Checks run on every read, before the frames are released: walks the block
+    // sequence numbers for drops, gaps and repeats, verifies each block the producer
+    // summed, and looks for sample jumps at block boundaries. Findings are counted in
+    // Statistics and logged with where they happened. The log survives close(), so it
+    // covers reconnects too.
+    struct IntegritySettings
+    {
+        bool enabled = true;
+        // Only blocks with kBlockHasChecksum are verified, and only whole ones: a block
+        // this reader joined half-way (or skipped into) is not.
+        bool verifyChecksums = true;
+        bool detectDiscontinuities = true;
+        oceanaudio::DiscontinuitySettings discontinuity;
+    };
+
+    void setIntegritySettings(const IntegritySettings& settings) noexcept;
+    [[nodiscard]] const oceanaudio::IntegrityEventLog& getIntegrityEvents() const noexcept;
+    // Also keeps the descriptor of every block the integrity walk reaches (its frame
+    // index, capture time and the drops before it), oldest first, for callers that
+    // keep their own per-block trail. Up to kBlockDescriptorCount wait for
+    // takeLoggedBlocks(); call it after every read. Needs the integrity checks on.
+    void setBlockLog(bool enabled);
+    std::uint32_t takeLoggedBlocks(oceanaudio::BridgeBlockTiming* blocks, std::uint32_t maxBlocks) noexcept;
+    // Capture-to-release time per block, kept in the mapping so the host can read it
+    // too; null while closed.
+    [[nodiscard]] const oceanaudio::SharedLatencyHistogram* getResidencyHistogram() const noexcept;
+
 private:
-    void advanceReadPointer(std::uint32_t frames);
+    // Checks the mapped header, adopts its format and takes a reader slot. Leaves the
+    // slot's ready event and the attached bit to the caller.
+    bool attachReader(void* mappedPtr,
+                      std::size_t mappedBytes,
+                      oceanaudio::ReaderLagPolicy lagPolicy,
+                      const oceanaudio::MappingResidencyOptions& residency);
+    void markAttached();
+    oceanaudio::SpscRingRegions beginRead(std::uint32_t maxFrames);
+    void finishRead(std::uint32_t frames);
+    void timeReleasedBlocks();
+    void checkReleasedFrames(std::uint32_t frames);
+    bool nextCheckedBlock(std::uint64_t position);
+    void checkFrames(std::uint64_t from, std::uint64_t to, bool blockStart);
+    void finishCheckedBlock();
+    void resetIntegrityChecks();
+    void recordIntegrityEvent(oceanaudio::IntegrityEventKind kind,
+                              std::uint64_t sequence,
+                              std::uint64_t frameIndex,
+                              std::uint64_t value,
+                              std::uint32_t channel = 0,
+                              float magnitude = 0.0f);
 
+#if defined(_WIN32)
     HANDLE mappingHandle;
     HANDLE audioReadyEvent;
     HANDLE audioConsumedEvent;
+#else
+    oceanaudio::posix::SharedMapping sharedMapping;
+    oceanaudio::posix::NamedEvent audioReadyEvent;
+    oceanaudio::posix::NamedEvent audioConsumedEvent;
+#endif
+#if defined(__linux__)
+    oceanaudio::posix::BridgeSocketClient socketClient;
+#endif
     oceanaudio::SharedAudioRingBufferHeader* header;
+    oceanaudio::SharedLayoutStatus layoutStatus;
+    oceanaudio::BroadcastRingReader ring;
+    oceanaudio::BridgeFormat format;
+    bool retired = false;
+    std::uint64_t producerTimeoutNs = std::uint64_t {oceanaudio::kDefaultPeerTimeoutMs} * 1'000'000;
+    std::uint64_t nextBlockSequence = 0;
     Statistics stats;
+
+    // Integrity walk: the next frame this reader should release, the producer's stream
+    // position after the last block walked, and the block being checked right now.
+    static constexpr std::uint64_t kUnknownFrame = ~std::uint64_t {0};
+    IntegritySettings integritySettings;
+    oceanaudio::IntegrityEventLog integrityEvents;
+    oceanaudio::BlockBoundaryDetector boundaryDetector;
+    std::uint64_t integrityCursor = kUnknownFrame;
+    std::uint64_t producerStreamEnd = kUnknownFrame;
+    std::uint64_t nextCheckedSequence = 0;
+    oceanaudio::BridgeBlockTiming checkedBlock;
+    bool checkingBlock = false;
+    bool summingBlock = false;
+    std::uint32_t blockChecksum = 0;
+    // Blocks walked but not yet taken (setBlockLog); empty capacity means off.
+    std::vector<oceanaudio::BridgeBlockTiming> blockLog;
 };
 
@@ -0,0 +1,597 @@
+#include "BridgeRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+constexpr std::uint16_t kWaveFormatIeeeFloat = 3;
+// Audio starts here in Wav files, and chunk buffers are aligned to it.
+constexpr std::size_t kPageBytes = 4096;
+constexpr std::size_t kDs64Offset = 12;
+constexpr std::uint32_t kDs64Bytes = 28;
+constexpr std::size_t kFmtOffset = kDs64Offset + 8 + kDs64Bytes;
+constexpr std::uint32_t kFmtBytes = 16;
+constexpr std::size_t kPadOffset = kFmtOffset + 8 + kFmtBytes;
+constexpr std::size_t kDataOffset = kPageBytes - 8;
+constexpr std::uint64_t kUnknownPosition = ~std::uint64_t {0};
+constexpr std::uint32_t kMaxEventsPerChunk = 4096;
+
+void putLittleEndian(std::byte* at, std::uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+    {
+        at[i] = static_cast<std::byte>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+void putTag(std::byte* at, const char* tag)
+{
+    std::memcpy(at, tag, 4);
+}
+
+std::string segmentPath(const std::string& basePath, int segmentIndex)
+{
+    auto path = basePath;
+    if (segmentIndex > 0)
+    {
+        const auto extension = path.rfind('.');
+        const auto suffix = std::string("-").append(std::to_string(segmentIndex));
+        path.insert(extension == std::string::npos ? path.size() : extension, suffix);
+    }
+    return path;
+}
+} // namespace
+
+const char* toString(RecordedEventKind kind) noexcept
+{
+    switch (kind)
+    {
+        case RecordedEventKind::Block:
+            return "block";
+        case RecordedEventKind::ReaderGap:
+            return "reader gap";
+        case RecordedEventKind::RecorderOverflow:
+            return "recorder overflow";
+        case RecordedEventKind::FramesOverwritten:
+            return "frames overwritten";
+        case RecordedEventKind::Reconnect:
+            return "reconnect";
+    }
+    return "unknown";
+}
+
+BridgeRecorder::~BridgeRecorder()
+{
+    stop();
+}
+
+bool BridgeRecorder::start(const Settings& newSettings)
+{
+    if (recording.load())
+    {
+        return false;
+    }
+
+    settings = newSettings;
+    const auto chunkBytes = std::max(settings.chunkBytes, kPageBytes) / kPageBytes * kPageBytes;
+    const auto chunkCount = std::max<std::size_t>(2, settings.bufferBytes / chunkBytes);
+    chunks.clear();
+    chunks.resize(chunkCount);
+    for (auto& chunk : chunks)
+    {
+        chunk.storage.resize(chunkBytes + kPageBytes);
+        void* aligned = chunk.storage.data();
+        auto space = chunk.storage.size();
+        chunk.audio = static_cast<std::byte*>(std::align(kPageBytes, chunkBytes, aligned, space));
+        chunk.events.reserve(kMaxEventsPerChunk);
+    }
+    settings.chunkBytes = chunkBytes;
+
+    chunksFilled.store(0);
+    chunksWritten.store(0);
+    stopRequested.store(false);
+    captureFinished.store(false);
+    filling = nullptr;
+    captureFormat = {};
+    segmentFrames = 0;
+    pendingGapFrames = 0;
+    pendingOverflowFrames = 0;
+    segmentIndex = 0;
+    for (auto* counter : {&framesWritten, &bytesWritten, &blocksRecorded, &segments, &readerGapFrames,
+                          &overflowFrames, &framesOverwritten, &reconnects, &eventsLost, &writeFailures})
+    {
+        counter->store(0);
+    }
+
+    recording.store(true);
+    captureThread = std::thread([this]() { captureLoop(); });
+    writerThread = std::thread([this]() { writerLoop(); });
+    return true;
+}
+
+void BridgeRecorder::stop()
+{
+    if (!recording.load())
+    {
+        return;
+    }
+
+    stopRequested.store(true);
+    captureThread.join();
+    writerThread.join();
+    chunks.clear();
+    recording.store(false);
+}
+
+bool BridgeRecorder::isRecording() const noexcept
+{
+    return recording.load();
+}
+
+BridgeRecorder::Statistics BridgeRecorder::getStatistics() const noexcept
+{
+    Statistics snapshot;
+    snapshot.recording = recording.load(std::memory_order_relaxed);
+    snapshot.readerSlot = readerSlot.load(std::memory_order_relaxed);
+    snapshot.framesWritten = framesWritten.load(std::memory_order_relaxed);
+    snapshot.bytesWritten = bytesWritten.load(std::memory_order_relaxed);
+    snapshot.blocksRecorded = blocksRecorded.load(std::memory_order_relaxed);
+    snapshot.segments = segments.load(std::memory_order_relaxed);
+    snapshot.readerGapFrames = readerGapFrames.load(std::memory_order_relaxed);
+    snapshot.overflowFrames = overflowFrames.load(std::memory_order_relaxed);
+    snapshot.framesOverwritten = framesOverwritten.load(std::memory_order_relaxed);
+    snapshot.reconnects = reconnects.load(std::memory_order_relaxed);
+    snapshot.eventsLost = eventsLost.load(std::memory_order_relaxed);
+    snapshot.writeFailures = writeFailures.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void BridgeRecorder::captureLoop()
+{
+    BridgeConsumer consumer;
+    consumer.setProducerTimeout(settings.producerTimeoutMs);
+    // Only the block walk is needed; the service's own reader does the checking.
+    BridgeConsumer::IntegritySettings integrity;
+    integrity.verifyChecksums = false;
+    integrity.detectDiscontinuities = false;
+    consumer.setIntegritySettings(integrity);
+    consumer.setBlockLog(true);
+
+    std::vector<oceanaudio::BridgeBlockTiming> blocks(oceanaudio::kBlockDescriptorCount);
+    std::uint64_t expectedPosition = kUnknownPosition;
+    std::uint64_t overwrittenSoFar = 0;
+    bool attachedBefore = false;
+    while (!stopRequested.load(std::memory_order_relaxed))
+    {
+        if (consumer.isOpen() && (!consumer.isProducerAlive() || consumer.isRetired()))
+        {
+            consumer.close();
+        }
+
+        if (!consumer.isOpen())
+        {
+            if (!openConsumer(consumer))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(settings.waitTimeoutMs));
+                continue;
+            }
+
+            readerSlot.store(consumer.getStatistics().readerSlot, std::memory_order_relaxed);
+            overwrittenSoFar = consumer.getStatistics().framesOverwritten;
+            expectedPosition = kUnknownPosition;
+            if (attachedBefore)
+            {
+                reconnects.fetch_add(1, std::memory_order_relaxed);
+                RecordedEvent event;
+                event.kind = RecordedEventKind::Reconnect;
+                event.recordingFrame = segmentFrames;
+                event.readTimeNs = oceanaudio::sharedClockNanoseconds();
+                addEvent(event);
+            }
+            attachedBefore = true;
+        }
+
+        if (!consumer.waitForData(settings.waitTimeoutMs))
+        {
+            continue;
+        }
+
+        const auto format = consumer.getFormat();
+        if (format != captureFormat)
+        {
+            // A new file for the new format; what is buffered belongs to the old one.
+            publishChunk();
+            captureFormat = format;
+            segmentFrames = 0;
+            expectedPosition = kUnknownPosition;
+        }
+
+        FrameSpans spans;
+        if (!consumer.acquireFrames(consumer.availableFrames(), spans))
+        {
+            continue;
+        }
+
+        const auto position = consumer.getReadPosition();
+        const auto readTime = oceanaudio::sharedClockNanoseconds();
+        if (expectedPosition != kUnknownPosition && position > expectedPosition)
+        {
+            RecordedEvent event;
+            event.kind = RecordedEventKind::ReaderGap;
+            event.recordingFrame = segmentFrames;
+            event.streamFrame = expectedPosition;
+            event.readTimeNs = readTime;
+            event.frames = position - expectedPosition;
+            readerGapFrames.fetch_add(event.frames, std::memory_order_relaxed);
+            if (!addEvent(event))
+            {
+                pendingGapFrames += event.frames;
+            }
+        }
+
+        // Once a chunk is missing the rest of the read goes too, so what is kept is
+        // always its start.
+        const auto firstRecordingFrame = segmentFrames;
+        auto framesKept = appendFrames(spans.first, spans.firstFrames);
+        if (framesKept == spans.firstFrames)
+        {
+            framesKept += appendFrames(spans.second, spans.secondFrames);
+        }
+        else
+        {
+            dropFrames(spans.secondFrames);
+        }
+        consumer.releaseFrames(spans);
+        expectedPosition = position + spans.totalFrames();
+
+        const auto overwritten = consumer.getStatistics().framesOverwritten;
+        if (overwritten != overwrittenSoFar)
+        {
+            RecordedEvent event;
+            event.kind = RecordedEventKind::FramesOverwritten;
+            event.recordingFrame = firstRecordingFrame;
+            event.streamFrame = position;
+            event.readTimeNs = readTime;
+            event.frames = overwritten - overwrittenSoFar;
+            framesOverwritten.fetch_add(event.frames, std::memory_order_relaxed);
+            addEvent(event);
+            overwrittenSoFar = overwritten;
+        }
+
+        const auto count = consumer.takeLoggedBlocks(blocks.data(), static_cast<std::uint32_t>(blocks.size()));
+        for (std::uint32_t index = 0; index < count; ++index)
+        {
+            const auto& block = blocks[index];
+            const auto offset = block.frameIndex > position ? block.frameIndex - position : 0;
+            if (offset >= framesKept)
+            {
+                // Dropped with the overflow; the marker covers it.
+                continue;
+            }
+
+            RecordedEvent event;
+            event.kind = RecordedEventKind::Block;
+            // A block joined part-way (after a skip, or on attaching) is described from
+            // the first of its frames the file has.
+            const auto firstFrame = block.frameIndex > position ? block.frameIndex : position;
+            event.recordingFrame = firstRecordingFrame + offset;
+            event.streamFrame = firstFrame;
+            event.sequence = block.sequence;
+            event.captureTimeNs = block.captureTimeNs;
+            event.readTimeNs = readTime;
+            event.frames = block.frameIndex + block.frames - firstFrame;
+            event.droppedBefore = block.droppedBefore;
+            blocksRecorded.fetch_add(1, std::memory_order_relaxed);
+            addEvent(event);
+        }
+    }
+
+    consumer.close();
+    // The writer is still draining, so waiting here for a chunk is fine and keeps the
+    // markers of frames lost at the end.
+    while ((pendingGapFrames > 0 || pendingOverflowFrames > 0) && filling == nullptr && !takeChunk())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    publishChunk();
+    captureFinished.store(true, std::memory_order_release);
+}
+
+bool BridgeRecorder::openConsumer(BridgeConsumer& consumer)
+{
+    // Skip, always: the producer must never wait for the recorder.
+    const auto lagPolicy = oceanaudio::ReaderLagPolicy::Skip;
+#if defined(__linux__)
+    if (!settings.socketPath.empty())
+    {
+        return consumer.openSocket(settings.socketPath, lagPolicy);
+    }
+#endif
+    return consumer.open(settings.mappingName, settings.readyEventName, settings.consumedEventName, lagPolicy);
+}
+
+bool BridgeRecorder::takeChunk()
+{
+    const auto filled = chunksFilled.load(std::memory_order_relaxed);
+    if (filled - chunksWritten.load(std::memory_order_acquire) >= chunks.size())
+    {
+        return false;
+    }
+
+    filling = &chunks[filled % chunks.size()];
+    filling->audioBytes = 0;
+    filling->format = captureFormat;
+    filling->events.clear();
+    chunkFrames = captureFormat.bytesPerFrame() != 0 ? settings.chunkBytes / captureFormat.bytesPerFrame() : 0;
+    // Markers that found no chunk go first, at the point the frames went missing.
+    for (auto* pending : {&pendingGapFrames, &pendingOverflowFrames})
+    {
+        if (*pending == 0)
+        {
+            continue;
+        }
+        RecordedEvent event;
+        event.kind = pending == &pendingGapFrames ? RecordedEventKind::ReaderGap : RecordedEventKind::RecorderOverflow;
+        event.recordingFrame = segmentFrames;
+        event.readTimeNs = oceanaudio::sharedClockNanoseconds();
+        event.frames = *pending;
+        filling->events.push_back(event);
+        *pending = 0;
+    }
+    return true;
+}
+
+void BridgeRecorder::publishChunk()
+{
+    if (filling == nullptr)
+    {
+        return;
+    }
+
+    filling = nullptr;
+    chunksFilled.fetch_add(1, std::memory_order_release);
+}
+
+std::uint32_t BridgeRecorder::appendFrames(const float* interleaved, std::uint32_t frames)
+{
+    const std::size_t frameBytes = captureFormat.bytesPerFrame();
+    std::uint32_t appended = 0;
+    while (frames > 0)
+    {
+        if (filling == nullptr && !takeChunk())
+        {
+            // Every chunk is queued for the writer: drop rather than wait.
+            dropFrames(frames);
+            return appended;
+        }
+
+        const auto room = chunkFrames - filling->audioBytes / frameBytes;
+        if (room == 0)
+        {
+            publishChunk();
+            continue;
+        }
+
+        const auto count = static_cast<std::uint32_t>(std::min<std::size_t>(room, frames));
+        std::memcpy(filling->audio + filling->audioBytes, interleaved, count * frameBytes);
+        filling->audioBytes += count * frameBytes;
+        segmentFrames += count;
+        interleaved += static_cast<std::size_t>(count) * captureFormat.channels;
+        frames -= count;
+        appended += count;
+    }
+    return appended;
+}
+
+void BridgeRecorder::dropFrames(std::uint32_t frames)
+{
+    pendingOverflowFrames += frames;
+    overflowFrames.fetch_add(frames, std::memory_order_relaxed);
+}
+
+bool BridgeRecorder::addEvent(const RecordedEvent& event)
+{
+    if (filling != nullptr && filling->events.size() == kMaxEventsPerChunk)
+    {
+        publishChunk();
+    }
+    if (filling == nullptr && !takeChunk())
+    {
+        eventsLost.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Reserved in start(), so this never reallocates.
+    filling->events.push_back(event);
+    return true;
+}
+
+void BridgeRecorder::writerLoop()
+{
+    for (;;)
+    {
+        const auto written = chunksWritten.load(std::memory_order_relaxed);
+        if (written == chunksFilled.load(std::memory_order_acquire))
+        {
+            if (captureFinished.load(std::memory_order_acquire)
+                && written == chunksFilled.load(std::memory_order_acquire))
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+
+        writeChunk(chunks[written % chunks.size()]);
+        chunksWritten.store(written + 1, std::memory_order_release);
+    }
+
+    closeSegment();
+}
+
+void BridgeRecorder::writeChunk(const Chunk& chunk)
+{
+    if (!chunk.format.isValid())
+    {
+        return;
+    }
+    if (audioFile == nullptr || chunk.format != segmentFormat)
+    {
+        closeSegment();
+        if (!openSegment(chunk.format))
+        {
+            writeFailures.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    if (chunk.audioBytes > 0)
+    {
+        const auto written = std::fwrite(chunk.audio, 1, chunk.audioBytes, audioFile);
+        if (written != chunk.audioBytes)
+        {
+            writeFailures.fetch_add(1, std::memory_order_relaxed);
+        }
+        segmentDataBytes += written;
+        bytesWritten.fetch_add(written, std::memory_order_relaxed);
+        framesWritten.fetch_add(written / segmentFormat.bytesPerFrame(), std::memory_order_relaxed);
+    }
+
+    if (!chunk.events.empty()
+        && std::fwrite(chunk.events.data(), sizeof(RecordedEvent), chunk.events.size(), trailFile)
+               != chunk.events.size())
+    {
+        writeFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool BridgeRecorder::openSegment(const StreamFormat& format)
+{
+    const auto path = segmentPath(settings.path, segmentIndex++);
+    trailPath = path + ".blocks";
+    audioFile = std::fopen(path.c_str(), "wb");
+    trailFile = std::fopen(trailPath.c_str(), "w+b");
+    if (audioFile == nullptr || trailFile == nullptr)
+    {
+        closeSegment();
+        return false;
+    }
+
+    // Chunks are already large and page-sized; stdio's own buffer would only add a
+    // copy.
+    std::setvbuf(audioFile, nullptr, _IONBF, 0);
+    segmentFormat = format;
+    segmentDataBytes = 0;
+    segments.fetch_add(1, std::memory_order_relaxed);
+    if (settings.fileFormat == FileFormat::Wav)
+    {
+        writeWavHeader(0, 0);
+    }
+
+    // The chunk size is filled in by closeSegment().
+    RecordingTrailHeader trailHeader;
+    trailHeader.sampleRate = format.sampleRate;
+    trailHeader.channels = format.channels;
+    trailHeader.startTimeNs = oceanaudio::sharedClockNanoseconds();
+    std::fwrite("oabk\0\0\0\0", 1, 8, trailFile);
+    std::fwrite(&trailHeader, sizeof(trailHeader), 1, trailFile);
+    return true;
+}
+
+void BridgeRecorder::closeSegment()
+{
+    if (audioFile == nullptr || trailFile == nullptr)
+    {
+        if (audioFile != nullptr)
+        {
+            std::fclose(audioFile);
+        }
+        if (trailFile != nullptr)
+        {
+            std::fclose(trailFile);
+        }
+        audioFile = nullptr;
+        trailFile = nullptr;
+        return;
+    }
+
+    const auto trailBytes = static_cast<std::uint64_t>(std::ftell(trailFile));
+    std::byte chunkSize[4];
+    putLittleEndian(chunkSize, trailBytes - 8, 4);
+    std::fseek(trailFile, 4, SEEK_SET);
+    std::fwrite(chunkSize, 1, sizeof(chunkSize), trailFile);
+
+    if (settings.fileFormat == FileFormat::Wav)
+    {
+        // Float frames are always an even number of bytes, so the trail chunk needs no
+        // pad byte in front.
+        std::fseek(trailFile, 0, SEEK_SET);
+        std::vector<char> copy(std::size_t {64} << 10);
+        std::size_t bytes = 0;
+        while ((bytes = std::fread(copy.data(), 1, copy.size(), trailFile)) > 0)
+        {
+            if (std::fwrite(copy.data(), 1, bytes, audioFile) != bytes)
+            {
+                writeFailures.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+        std::fseek(audioFile, 0, SEEK_SET);
+        writeWavHeader(segmentDataBytes, kPageBytes + segmentDataBytes + trailBytes);
+    }
+
+    std::fclose(audioFile);
+    std::fclose(trailFile);
+    audioFile = nullptr;
+    trailFile = nullptr;
+    if (settings.fileFormat == FileFormat::Wav)
+    {
+        std::remove(trailPath.c_str());
+    }
+}
+
+void BridgeRecorder::writeWavHeader(std::uint64_t dataBytes, std::uint64_t fileBytes)
+{
+    // RIFF, then a 28-byte chunk that is JUNK until the file outgrows 4 GiB and ds64
+    // after, fmt, padding, and the data chunk header ending on the first page boundary.
+    std::byte header[kPageBytes] {};
+    const auto riffBytes = fileBytes > 8 ? fileBytes - 8 : 0;
+    const bool rf64 = riffBytes > 0xFFFFFFFFull || dataBytes > 0xFFFFFFFFull;
+    const std::uint32_t blockAlign = segmentFormat.bytesPerFrame();
+
+    putTag(header, rf64 ? "RF64" : "RIFF");
+    putLittleEndian(header + 4, rf64 ? 0xFFFFFFFFull : riffBytes, 4);
+    putTag(header + 8, "WAVE");
+
+    putTag(header + kDs64Offset, rf64 ? "ds64" : "JUNK");
+    putLittleEndian(header + kDs64Offset + 4, kDs64Bytes, 4);
+    if (rf64)
+    {
+        putLittleEndian(header + kDs64Offset + 8, riffBytes, 8);
+        putLittleEndian(header + kDs64Offset + 16, dataBytes, 8);
+        putLittleEndian(header + kDs64Offset + 24, dataBytes / blockAlign, 8);
+    }
+
+    putTag(header + kFmtOffset, "fmt ");
+    putLittleEndian(header + kFmtOffset + 4, kFmtBytes, 4);
+    putLittleEndian(header + kFmtOffset + 8, kWaveFormatIeeeFloat, 2);
+    putLittleEndian(header + kFmtOffset + 10, segmentFormat.channels, 2);
+    putLittleEndian(header + kFmtOffset + 12, segmentFormat.sampleRate, 4);
+    putLittleEndian(header + kFmtOffset + 16, std::uint64_t {segmentFormat.sampleRate} * blockAlign, 4);
+    putLittleEndian(header + kFmtOffset + 20, blockAlign, 2);
+    putLittleEndian(header + kFmtOffset + 22, 32, 2);
+
+    putTag(header + kPadOffset, "JUNK");
+    putLittleEndian(header + kPadOffset + 4, kDataOffset - kPadOffset - 8, 4);
+
+    putTag(header + kDataOffset, "data");
+    putLittleEndian(header + kDataOffset + 4, rf64 ? 0xFFFFFFFFull : dataBytes, 4);
+
+    if (std::fwrite(header, 1, sizeof(header), audioFile) != sizeof(header))
+    {
+        writeFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+}
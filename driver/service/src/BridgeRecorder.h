@@ -0,0 +1,211 @@
+#pragma once
+
+#include "BridgeConsumer.h"
+#include "FrameSink.h"
+
+#include <OceanAudio/BridgeSharedMemory.h>
+#include <OceanAudio/PeerHeartbeat.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One entry of a recording's trail: a block as the producer described it, or a marker
+// for frames that are not in the file. Written little-endian, as laid out here.
+enum class RecordedEventKind : std::uint32_t
+{
+    // A block the recorder read: its producer frame index, sequence number, capture
+    // time and the blocks the producer dropped just before it.
+    Block = 0,
+    // Frames the recorder's reader jumped over because it fell a whole ring behind.
+    ReaderGap = 1,
+    // Frames read but thrown away because the writer thread was behind and every
+    // buffer chunk was full.
+    RecorderOverflow = 2,
+    // Frames the producer may have overwritten while the recorder was copying them.
+    FramesOverwritten = 3,
+    // The reader lost the mapping (producer gone, mapping replaced) and attached again.
+    Reconnect = 4,
+};
+
+[[nodiscard]] const char* toString(RecordedEventKind kind) noexcept;
+
+struct RecordedEvent
+{
+    // Frame of this file the event applies to: where the block starts, or where the
+    // missing frames would have been.
+    std::uint64_t recordingFrame = 0;
+    // The producer's frame index of the same point, and the block's sequence number.
+    std::uint64_t streamFrame = 0;
+    std::uint64_t sequence = 0;
+    // sharedClockNanoseconds() when the producer captured the block (Block only) and
+    // when the recorder read it, to line up with host and consumer telemetry.
+    std::uint64_t captureTimeNs = 0;
+    std::uint64_t readTimeNs = 0;
+    // Frames in the block, or frames missing. A block the recorder joined part-way
+    // is described from the first of its frames in the file.
+    std::uint64_t frames = 0;
+    RecordedEventKind kind = RecordedEventKind::Block;
+    std::uint32_t droppedBefore = 0;
+};
+
+static_assert(sizeof(RecordedEvent) == 56, "RecordedEvent is a file format");
+
+// Payload of the trail chunk, ahead of the events.
+struct RecordingTrailHeader
+{
+    std::uint32_t version = 1;
+    std::uint32_t eventBytes = sizeof(RecordedEvent);
+    std::uint32_t sampleRate = 0;
+    std::uint32_t channels = 0;
+    // sharedClockNanoseconds() when the file was started.
+    std::uint64_t startTimeNs = 0;
+};
+
+static_assert(sizeof(RecordingTrailHeader) == 24, "RecordingTrailHeader is a file format");
+
+// Records what the bridge carried to disk, for lining customer captures up with
+// telemetry. Attaches as a Skip reader of its own, so the producer never waits for
+// it: a recorder that falls a ring behind loses frames, not the virtual microphone.
+//
+// A capture thread copies every read into fixed chunks of a buffer allocated by
+// start(), and a writer thread writes the chunks whole. Nothing grows while
+// recording; when every chunk is waiting to be written, frames are dropped and a
+// RecorderOverflow marker records where.
+//
+// Wav files are 32-bit float and turn into RF64 past 4 GiB. The 4 KiB header leaves
+// room for the ds64 chunk, so the audio starts page-aligned. The trail (block
+// descriptors and markers) goes into a trailing "oabk" chunk: a RecordingTrailHeader
+// followed by RecordedEvents. Raw files hold only samples; their trail stays next to
+// them in PATH.blocks, as the same chunk. A format change starts a new file with a
+// numeric suffix, as WavFileFrameSink does.
+class BridgeRecorder
+{
+public:
+    enum class FileFormat
+    {
+        Wav,
+        Raw,
+    };
+
+    struct Settings
+    {
+        std::string path = "bridge-recording.wav";
+        FileFormat fileFormat = FileFormat::Wav;
+        // Memory for audio on its way to disk, and the size of one write.
+        std::size_t bufferBytes = std::size_t {8} << 20;
+        std::size_t chunkBytes = std::size_t {1} << 20;
+        // Where the ring is, as ConsumerEngine::Settings.
+        std::wstring mappingName = L"Global\\OceanAudio_AudioRing";
+        std::wstring readyEventName = L"Global\\OceanAudio_AudioReady";
+        std::wstring consumedEventName = L"Global\\OceanAudio_AudioConsumed";
+        std::string socketPath;
+        std::uint32_t waitTimeoutMs = 10;
+        std::uint32_t producerTimeoutMs = oceanaudio::kDefaultPeerTimeoutMs;
+    };
+
+    struct Statistics
+    {
+        bool recording = false;
+        std::uint32_t readerSlot = 0;
+        // Frames and bytes on disk, blocks in the trail, and files started.
+        std::uint64_t framesWritten = 0;
+        std::uint64_t bytesWritten = 0;
+        std::uint64_t blocksRecorded = 0;
+        std::uint64_t segments = 0;
+        // Frames missing from the file, by cause (see RecordedEventKind).
+        std::uint64_t readerGapFrames = 0;
+        std::uint64_t overflowFrames = 0;
+        std::uint64_t framesOverwritten = 0;
+        std::uint64_t reconnects = 0;
+        // Trail entries lost because no chunk was free (markers of missing frames wait
+        // for the next chunk instead), and failed file operations.
+        std::uint64_t eventsLost = 0;
+        std::uint64_t writeFailures = 0;
+    };
+
+    BridgeRecorder() = default;
+    ~BridgeRecorder();
+
+    BridgeRecorder(const BridgeRecorder&) = delete;
+    BridgeRecorder& operator=(const BridgeRecorder&) = delete;
+
+    // Allocates the buffer and starts both threads; the file is created once the
+    // recorder has attached and knows the format. Fails if already recording.
+    bool start(const Settings& newSettings);
+    // Stops reading, writes out what is buffered and finishes the file. Waits for the
+    // writer, so call it from a control thread rather than an audio one.
+    void stop();
+
+    [[nodiscard]] bool isRecording() const noexcept;
+    [[nodiscard]] Statistics getStatistics() const noexcept;
+
+private:
+    struct Chunk
+    {
+        std::vector<std::byte> storage;
+        std::byte* audio = nullptr;
+        std::size_t audioBytes = 0;
+        StreamFormat format;
+        std::vector<RecordedEvent> events;
+    };
+
+    void captureLoop();
+    bool openConsumer(BridgeConsumer& consumer);
+    bool takeChunk();
+    void publishChunk();
+    std::uint32_t appendFrames(const float* interleaved, std::uint32_t frames);
+    void dropFrames(std::uint32_t frames);
+    bool addEvent(const RecordedEvent& event);
+
+    void writerLoop();
+    void writeChunk(const Chunk& chunk);
+    bool openSegment(const StreamFormat& format);
+    void closeSegment();
+    void writeWavHeader(std::uint64_t dataBytes, std::uint64_t fileBytes);
+
+    Settings settings;
+    std::vector<Chunk> chunks;
+    std::thread captureThread;
+    std::thread writerThread;
+    std::atomic<bool> recording {false};
+    std::atomic<bool> stopRequested {false};
+    std::atomic<bool> captureFinished {false};
+    // Chunks handed to the writer and chunks it has written; the difference is how
+    // many are queued.
+    std::atomic<std::uint64_t> chunksFilled {0};
+    std::atomic<std::uint64_t> chunksWritten {0};
+
+    // Capture thread only.
+    Chunk* filling = nullptr;
+    std::size_t chunkFrames = 0;
+    StreamFormat captureFormat;
+    std::uint64_t segmentFrames = 0;
+    // Frames missing whose marker is waiting for a free chunk.
+    std::uint64_t pendingGapFrames = 0;
+    std::uint64_t pendingOverflowFrames = 0;
+
+    // Writer thread only.
+    std::FILE* audioFile = nullptr;
+    std::FILE* trailFile = nullptr;
+    std::string trailPath;
+    StreamFormat segmentFormat;
+    std::uint64_t segmentDataBytes = 0;
+    int segmentIndex = 0;
+
+    std::atomic<std::uint32_t> readerSlot {0};
+    std::atomic<std::uint64_t> framesWritten {0};
+    std::atomic<std::uint64_t> bytesWritten {0};
+    std::atomic<std::uint64_t> blocksRecorded {0};
+    std::atomic<std::uint64_t> segments {0};
+    std::atomic<std::uint64_t> readerGapFrames {0};
+    std::atomic<std::uint64_t> overflowFrames {0};
+    std::atomic<std::uint64_t> framesOverwritten {0};
+    std::atomic<std::uint64_t> reconnects {0};
+    std::atomic<std::uint64_t> eventsLost {0};
+    std::atomic<std::uint64_t> writeFailures {0};
+};
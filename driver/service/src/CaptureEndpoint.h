@@ -0,0 +1,25 @@
+#pragma once
+
+#include <OceanAudio/BridgeProtocol.h>
+
+// The final consumer of the bridge audio as the service negotiates with it: the
+// virtual microphone driver, or a user-mode stand-in playing its part. In Direct mode
+// the endpoint maps the ring itself and reads it as a broadcast reader, so the service
+// copies nothing and only supervises; in Copy mode the service drains the ring and
+// hands blocks over as before.
+class CaptureEndpoint
+{
+public:
+    virtual ~CaptureEndpoint() = default;
+
+    // QuerySharedBuffer. `offer` describes the mapping (handle, format, header version)
+    // and the mode the service wants; the endpoint fills in `answer`. Direct in
+    // answer.transferMode means it has mapped the ring and attached as a reader in
+    // answer.readerSlot, and owes the ring a heartbeat from then on. Returns false if
+    // the endpoint could not be reached at all.
+    virtual bool querySharedBuffer(const oceanaudio::SharedBufferInfo& offer, oceanaudio::SharedBufferInfo& answer) = 0;
+
+    // ReleaseSharedBuffer: detach from the ring and unmap it. Called when the producer
+    // went away or replaced the mapping, and before the service stops.
+    virtual void releaseSharedBuffer() = 0;
+};
@@ -0,0 +1,390 @@
+#include "ConsumerEngine.h"
+
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <utility>
+
+ConsumerEngine::ConsumerEngine(FrameSink& sinkToUse, Settings engineSettings)
+    : sink(sinkToUse),
+      settings(std::move(engineSettings))
+{
+    consumer.setProducerTimeout(settings.producerTimeoutMs);
+    consumer.setIntegritySettings(settings.integrity);
+}
+
+ConsumerEngine::~ConsumerEngine()
+{
+    disconnect();
+}
+
+bool ConsumerEngine::connect()
+{
+    if (consumer.isOpen())
+    {
+        return true;
+    }
+
+#if defined(__linux__)
+    if (!settings.socketPath.empty())
+    {
+        return consumer.openSocket(settings.socketPath, settings.lagPolicy, settings.residency);
+    }
+#endif
+    return consumer.open(settings.mappingName, settings.readyEventName, settings.consumedEventName,
+                         settings.lagPolicy, settings.residency);
+}
+
+void ConsumerEngine::disconnect()
+{
+    if (sinkOpen)
+    {
+        sink.close();
+        sinkOpen = false;
+    }
+
+    currentFormat = {};
+    reattaching = false;
+    consumer.close();
+}
+
+bool ConsumerEngine::isConnected() const noexcept
+{
+    return consumer.isOpen();
+}
+
+oceanaudio::SharedLayoutStatus ConsumerEngine::getLayoutStatus() const noexcept
+{
+    return consumer.getLayoutStatus();
+}
+
+void ConsumerEngine::pump()
+{
+    if (consumer.isOpen() && !consumer.isProducerAlive())
+    {
+        // Crashed or killed without retiring the mapping. Letting go frees our slot, so
+        // a new producer taking the mapping over is not held back by a reader of the
+        // old one; connect() turns the mapping down until someone beats on it again.
+        ++stats.producerLosses;
+        dropConnection();
+    }
+    else if (consumer.isRetired())
+    {
+        // The producer replaced the mapping, went away or evicted us: drop this one and
+        // pick up the next as soon as it appears.
+        if (consumer.isEvicted())
+        {
+            ++stats.evictions;
+        }
+        dropConnection();
+    }
+
+    if (!consumer.isOpen())
+    {
+        if (!reattaching)
+        {
+            return;
+        }
+
+        if (!connect())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(settings.waitTimeoutMs));
+            return;
+        }
+    }
+
+    if (settings.compensateDrift)
+    {
+        pumpClocked();
+        return;
+    }
+
+    if (!consumer.waitForData(settings.waitTimeoutMs, settings.spinMicroseconds))
+    {
+        ++stats.waitTimeouts;
+        return;
+    }
+
+    const auto wakeTime = TickClock::nowNanoseconds();
+    ++stats.wakeups;
+
+    if (!followFormat())
+    {
+        return;
+    }
+
+    // Drain what was queued at wakeup in one go rather than a block per wakeup; frames
+    // that arrive meanwhile are left for the next pass so a fast producer cannot keep
+    // us here forever.
+    const auto blockFrames = currentFormat.framesPerBlock != 0 ? currentFormat.framesPerBlock
+                                                               : std::numeric_limits<std::uint32_t>::max();
+    auto backlog = consumer.availableFrames();
+    std::uint32_t blocks = 0;
+    while (backlog > 0)
+    {
+        const auto frames = deliverBlock(backlog < blockFrames ? backlog : blockFrames);
+        if (frames == 0)
+        {
+            break;
+        }
+        backlog -= frames;
+        ++blocks;
+    }
+
+    if (blocks > 1)
+    {
+        ++stats.batchedWakeups;
+    }
+
+    const auto deliveryNs = TickClock::nowNanoseconds() - wakeTime;
+    stats.totalDeliveryNs += deliveryNs;
+    stats.maxDeliveryNs = deliveryNs > stats.maxDeliveryNs ? deliveryNs : stats.maxDeliveryNs;
+}
+
+void ConsumerEngine::dropConnection()
+{
+    disconnect();
+    ++stats.reconnects;
+    reattaching = true;
+}
+
+void ConsumerEngine::run(const std::function<bool()>& shouldStop)
+{
+    while (!shouldStop())
+    {
+        pump();
+    }
+}
+
+ConsumerEngine::Statistics ConsumerEngine::getStatistics() const noexcept
+{
+    auto snapshot = stats;
+    const auto consumerStats = consumer.getStatistics();
+    snapshot.underruns = consumerStats.underruns;
+    snapshot.spinWakeups = consumerStats.spinWakeups;
+    snapshot.blockingWaits = consumerStats.blockingWaits;
+    snapshot.producerSignals = consumerStats.producerSignals;
+    snapshot.readerSlot = consumerStats.readerSlot;
+    snapshot.framesSkipped = consumerStats.framesSkipped;
+    snapshot.framesOverwritten = consumerStats.framesOverwritten;
+    snapshot.rejoins = consumerStats.rejoins;
+    snapshot.memoryResidency = consumerStats.memoryResidency;
+    snapshot.framesDiscarded = consumerStats.framesDiscarded;
+    snapshot.bytesCopied = sink.getBytesCopied();
+    snapshot.producerDroppedBlocks = consumerStats.producerDroppedBlocks;
+    snapshot.framesMissing = consumerStats.framesMissing;
+    snapshot.framesDuplicated = consumerStats.framesDuplicated;
+    snapshot.descriptorsLost = consumerStats.descriptorsLost;
+    snapshot.blocksVerified = consumerStats.blocksVerified;
+    snapshot.checksumMismatches = consumerStats.checksumMismatches;
+    snapshot.discontinuities = consumerStats.discontinuities;
+    if (const auto* residency = consumer.getResidencyHistogram())
+    {
+        snapshot.residencyP50Us = residency->percentileUs(0.50);
+        snapshot.residencyP99Us = residency->percentileUs(0.99);
+        snapshot.residencyP999Us = residency->percentileUs(0.999);
+    }
+    if (settings.compensateDrift)
+    {
+        const auto driftStats = compensator.getStatistics();
+        snapshot.driftCorrectionPpm = driftStats.correctionPpm;
+        snapshot.driftLatencyFrames = driftStats.latencyFrames;
+        snapshot.driftStarvations = driftStats.starvations;
+        snapshot.jitter = jitterBuffer.getStatistics();
+        // Running dry is only an underrun once the jitter buffer could not cover it;
+        // an empty ring between blocks is normal here.
+        snapshot.underruns = snapshot.jitter.underruns;
+    }
+    return snapshot;
+}
+
+const oceanaudio::IntegrityEventLog& ConsumerEngine::getIntegrityEvents() const noexcept
+{
+    return consumer.getIntegrityEvents();
+}
+
+StreamFormat ConsumerEngine::getFormat() const noexcept
+{
+    return currentFormat;
+}
+
+StreamFormat ConsumerEngine::getSinkFormat() const noexcept
+{
+    return converter.getOutputFormat();
+}
+
+bool ConsumerEngine::followFormat()
+{
+    const auto format = consumer.getFormat();
+    if (sinkOpen && format == currentFormat)
+    {
+        return true;
+    }
+
+    if (sinkOpen)
+    {
+        sink.close();
+        sinkOpen = false;
+        ++stats.formatChanges;
+    }
+
+    currentFormat = format;
+    if (!format.isValid())
+    {
+        return false;
+    }
+
+    if (!converter.prepare(format, settings.view))
+    {
+        ++stats.sinkFailures;
+        return false;
+    }
+
+    sinkOpen = sink.open(converter.getOutputFormat());
+    if (!sinkOpen)
+    {
+        ++stats.sinkFailures;
+        return false;
+    }
+
+    if (settings.compensateDrift)
+    {
+        jitterBuffer.prepare(format, settings.jitter, settings.drift.targetLatencyFrames, consumer.getRingCapacity());
+        auto driftSettings = settings.drift;
+        driftSettings.targetLatencyFrames = jitterBuffer.getTargetLatencyFrames();
+        driftSettings.prefillFrames = jitterBuffer.getPrefillFrames();
+        driftSettings.surplusInputFrames = jitterBuffer.getSurplusInputFrames();
+        compensator.prepare(format, driftSettings);
+        compensatedBlock.assign(static_cast<std::size_t>(format.framesPerBlock) * format.channels, 0.0f);
+        tickClock.reset();
+    }
+    return true;
+}
+
+std::uint32_t ConsumerEngine::deliverBlock(std::uint32_t maxFrames)
+{
+    const auto allocationsBefore = oceanaudio::allocation::countOnThisThread();
+
+    FrameSpans frames;
+    if (!consumer.acquireFrames(maxFrames, frames))
+    {
+        return 0;
+    }
+
+    if (!writeToSink(frames))
+    {
+        ++stats.sinkFailures;
+    }
+
+    consumer.releaseFrames(frames);
+    stats.allocations += oceanaudio::allocation::countOnThisThread() - allocationsBefore;
+    ++stats.blocksDelivered;
+    stats.framesDelivered += frames.totalFrames();
+    return frames.totalFrames();
+}
+
+void ConsumerEngine::pumpClocked()
+{
+    consumer.heartbeat();
+    consumer.refreshFormat();
+    if (!followFormat() || currentFormat.framesPerBlock == 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(settings.waitTimeoutMs));
+        return;
+    }
+
+    const auto periodNs = static_cast<std::uint64_t>(currentFormat.framesPerBlock) * 1'000'000'000ull
+                          / currentFormat.sampleRate;
+    const auto tick = tickClock.waitForTick(periodNs);
+    const auto now = tick.nowNs;
+    const double elapsedSeconds = tick.elapsedSeconds;
+    ++stats.wakeups;
+
+    const auto allocationsBefore = oceanaudio::allocation::countOnThisThread();
+    const auto lastCommit = consumer.lastWriteTimestamp();
+    const auto sinceCommit = lastCommit != 0 && now > lastCommit ? now - lastCommit : 0;
+    auto queued = DriftCompensator::estimateQueuedFrames(consumer.availableFrames(), sinceCommit, currentFormat);
+
+    compensator.setTargetLatency(jitterBuffer.observe(queued, elapsedSeconds), jitterBuffer.getPrefillFrames());
+    queued -= skipFrames(jitterBuffer.planOverrun(queued, consumer.availableFrames()));
+
+    auto wanted = compensator.beginBlock(queued, elapsedSeconds);
+    if (wanted > 0)
+    {
+        wanted += jitterBuffer.squeezeFrames();
+    }
+    while (wanted > 0)
+    {
+        // Only read what is there, so an empty ring does not count as an underrun.
+        skipFrames(jitterBuffer.takeDueDrop());
+        const auto readable = jitterBuffer.readLimit(std::min(wanted, consumer.availableFrames()));
+        FrameSpans frames;
+        if (readable == 0 || !consumer.acquireFrames(readable, frames))
+        {
+            break;
+        }
+        compensator.pushInput(jitterBuffer.consume(frames));
+        consumer.releaseFrames(frames);
+        wanted -= std::min(wanted, frames.totalFrames());
+    }
+
+    jitterBuffer.finishBlock(compensatedBlock.data(), compensator.renderBlock(compensatedBlock.data()));
+
+    FrameSpans block;
+    block.first = compensatedBlock.data();
+    block.firstFrames = currentFormat.framesPerBlock;
+    if (!writeToSink(block))
+    {
+        ++stats.sinkFailures;
+    }
+
+    stats.allocations += oceanaudio::allocation::countOnThisThread() - allocationsBefore;
+    ++stats.blocksDelivered;
+    stats.framesDelivered += currentFormat.framesPerBlock;
+
+    const auto deliveryNs = TickClock::nowNanoseconds() - now;
+    stats.totalDeliveryNs += deliveryNs;
+    stats.maxDeliveryNs = deliveryNs > stats.maxDeliveryNs ? deliveryNs : stats.maxDeliveryNs;
+}
+
+std::uint32_t ConsumerEngine::skipFrames(std::uint32_t frames)
+{
+    FrameSpans skipped;
+    if (frames == 0 || !consumer.acquireFrames(frames, skipped))
+    {
+        return 0;
+    }
+
+    consumer.releaseFrames(skipped);
+    return skipped.totalFrames();
+}
+
+bool ConsumerEngine::writeToSink(const FrameSpans& frames)
+{
+    if (converter.isPassthrough())
+    {
+        return sink.write(frames);
+    }
+
+    const auto startNs = TickClock::nowNanoseconds();
+    const auto outputFrames = converter.process(frames);
+    stats.conversionNs += TickClock::nowNanoseconds() - startNs;
+    stats.framesConverted += outputFrames;
+    if (outputFrames == 0)
+    {
+        return true;
+    }
+
+    if (converter.getOutputFormat().sampleFormat == oceanaudio::BridgeSampleFormat::Float32)
+    {
+        FrameSpans converted;
+        converted.first = converter.getFloatOutput();
+        converted.firstFrames = outputFrames;
+        return sink.write(converted);
+    }
+
+    return sink.writePacked(PackedFrames {converter.getPackedOutput(), outputFrames});
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "BridgeConsumer.h"
+#include "DriftCompensator.h"
+#include "FormatViewConverter.h"
+#include "FrameSink.h"
+#include "JitterBuffer.h"
+#include "TickClock.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Platform-neutral consumer loop: waits for the producer, drains the ring, follows
+// format changes and pushes frames into a FrameSink. The Windows service plugs in the
+// driver IOCTL sink; tools and benchmarks use the stand-in sinks from FrameSinks.h.
+class ConsumerEngine
+{
+public:
+    struct Settings
+    {
+        std::wstring mappingName = L"Global\\OceanAudio_AudioRing";
+        std::wstring readyEventName = L"Global\\OceanAudio_AudioReady";
+        std::wstring consumedEventName = L"Global\\OceanAudio_AudioConsumed";
+        // Linux only: take the ring from the producer's socket (memfd and eventfds, see
+        // UnixSocketTransport.h) instead of opening the names above. Empty uses the
+        // names.
+        std::string socketPath;
+        std::uint32_t waitTimeoutMs = 10;
+        // How long to poll the ring before blocking. Spinning trades CPU for wake
+        // latency and saves both sides a syscall whenever the next block arrives in
+        // time; 0 blocks straight away.
+        std::uint32_t spinMicroseconds = 50;
+        // What the producer does if this reader falls a whole ring behind. Secondary
+        // readers (recorders, monitors) should use Skip or Detach so they cannot stall
+        // the virtual microphone.
+        oceanaudio::ReaderLagPolicy lagPolicy = oceanaudio::ReaderLagPolicy::Stall;
+        // A producer silent for this long (no heartbeat, not just no audio) is taken
+        // for dead: the engine lets go of the mapping and reattaches once a new
+        // producer beats. 0 waits for the old one forever.
+        std::uint32_t producerTimeoutMs = oceanaudio::kDefaultPeerTimeoutMs;
+        // Prefault and lock the ring view so the delivery thread never faults on it.
+        oceanaudio::MappingResidencyOptions residency;
+        // Sequence, checksum and discontinuity checks on everything read from the ring.
+        BridgeConsumer::IntegritySettings integrity;
+        // Deliver one block per period of this process's clock through the drift
+        // compensator instead of forwarding blocks as they arrive. Use when the sink
+        // plays out at its own pace and must never see the producer's clock.
+        bool compensateDrift = false;
+        DriftCompensator::Settings drift;
+        // Playout policy of that clocked path: adaptive latency target, prefill,
+        // overrun handling and underrun concealment. drift.targetLatencyFrames is where
+        // the target starts.
+        JitterBuffer::Settings jitter;
+        // Sample format, rate and channel count the sink receives. The default is the
+        // ring's own format, delivered without conversion.
+        FormatView view;
+    };
+
+    struct Statistics
+    {
+        std::uint64_t wakeups = 0;
+        std::uint64_t waitTimeouts = 0;
+        // Wakeups that drained more than one block because the consumer fell behind.
+        std::uint64_t batchedWakeups = 0;
+        std::uint64_t blocksDelivered = 0;
+        std::uint64_t framesDelivered = 0;
+        std::uint64_t sinkFailures = 0;
+        // Sink reopens for a new format. The bridge applies most format changes in
+        // place, so the reader itself stays attached; old-format frames it had not
+        // read yet are counted in framesDiscarded. A reconnect means the producer
+        // replaced the mapping, this reader was evicted, or the producer died.
+        std::uint64_t formatChanges = 0;
+        std::uint64_t framesDiscarded = 0;
+        std::uint64_t reconnects = 0;
+        // Producers that stopped beating, and times the producer evicted this reader
+        // for missing heartbeats (both also count as reconnects).
+        std::uint64_t producerLosses = 0;
+        std::uint64_t evictions = 0;
+        std::uint64_t underruns = 0;
+        // Bytes the sink copied out of the ring, and heap allocations made on the
+        // delivery path (acquire, sink write, release). The latter should stay zero.
+        std::uint64_t bytesCopied = 0;
+        std::uint64_t allocations = 0;
+        // Wait syscalls on our side and signal syscalls on the producer's side.
+        std::uint64_t spinWakeups = 0;
+        std::uint64_t blockingWaits = 0;
+        std::uint64_t producerSignals = 0;
+        // Broadcast reader slot and lag handling (see BridgeConsumer::Statistics).
+        std::uint32_t readerSlot = 0;
+        std::uint64_t framesSkipped = 0;
+        std::uint64_t framesOverwritten = 0;
+        std::uint64_t rejoins = 0;
+        oceanaudio::MappingResidency memoryResidency;
+        // Bridge residency (capture timestamp to release) from the shared histogram.
+        std::uint64_t residencyP50Us = 0;
+        std::uint64_t residencyP99Us = 0;
+        std::uint64_t residencyP999Us = 0;
+        // Time from the wakeup to the sink accepting the block.
+        std::uint64_t totalDeliveryNs = 0;
+        std::uint64_t maxDeliveryNs = 0;
+        // Drift compensation only: current trim, queued audio, and blocks padded
+        // because the ring ran dry.
+        double driftCorrectionPpm = 0.0;
+        double driftLatencyFrames = 0.0;
+        std::uint64_t driftStarvations = 0;
+        // Jitter buffer (drift compensation only), see JitterBuffer::Statistics.
+        JitterBuffer::Statistics jitter;
+        // Format view only: time spent converting, and frames the sink received.
+        std::uint64_t conversionNs = 0;
+        std::uint64_t framesConverted = 0;
+        // Integrity checks (see BridgeConsumer::Statistics); the events themselves are
+        // in getIntegrityEvents().
+        std::uint64_t producerDroppedBlocks = 0;
+        std::uint64_t framesMissing = 0;
+        std::uint64_t framesDuplicated = 0;
+        std::uint64_t descriptorsLost = 0;
+        std::uint64_t blocksVerified = 0;
+        std::uint64_t checksumMismatches = 0;
+        std::uint64_t discontinuities = 0;
+    };
+
+    ConsumerEngine(FrameSink& sinkToUse, Settings engineSettings);
+    ~ConsumerEngine();
+
+    ConsumerEngine(const ConsumerEngine&) = delete;
+    ConsumerEngine& operator=(const ConsumerEngine&) = delete;
+
+    bool connect();
+    void disconnect();
+    [[nodiscard]] bool isConnected() const noexcept;
+    [[nodiscard]] oceanaudio::SharedLayoutStatus getLayoutStatus() const noexcept;
+
+    // Waits up to Settings::waitTimeoutMs for data and forwards the whole backlog that
+    // was queued at wakeup, one sink write per block. After a successful connect() it
+    // reattaches by itself when the producer retires the mapping, dies or evicts us.
+    void pump();
+    // Calls pump() until shouldStop returns true.
+    void run(const std::function<bool()>& shouldStop);
+
+    [[nodiscard]] Statistics getStatistics() const noexcept;
+    [[nodiscard]] const oceanaudio::IntegrityEventLog& getIntegrityEvents() const noexcept;
+    [[nodiscard]] StreamFormat getFormat() const noexcept;
+    // What the sink was opened with: getFormat() seen through Settings::view.
+    [[nodiscard]] StreamFormat getSinkFormat() const noexcept;
+
+private:
+    void dropConnection();
+    bool followFormat();
+    std::uint32_t deliverBlock(std::uint32_t maxFrames);
+    void pumpClocked();
+    std::uint32_t skipFrames(std::uint32_t frames);
+    bool writeToSink(const FrameSpans& frames);
+
+    FrameSink& sink;
+    Settings settings;
+    BridgeConsumer consumer;
+    StreamFormat currentFormat;
+    bool sinkOpen = false;
+    bool reattaching = false;
+    FormatViewConverter converter;
+    DriftCompensator compensator;
+    JitterBuffer jitterBuffer;
+    std::vector<float> compensatedBlock;
+    TickClock tickClock;
+    Statistics stats;
+};
@@ -0,0 +1,288 @@
+#include "DirectBridgeSupervisor.h"
+
+#include <chrono>
+#include <thread>
+#include <utility>
+
+DirectBridgeSupervisor::DirectBridgeSupervisor(CaptureEndpoint& endpointToSupervise, Settings supervisorSettings)
+    : endpoint(endpointToSupervise),
+      settings(std::move(supervisorSettings))
+{
+}
+
+DirectBridgeSupervisor::~DirectBridgeSupervisor()
+{
+    disconnect();
+}
+
+bool DirectBridgeSupervisor::connect()
+{
+    if (header != nullptr)
+    {
+        return true;
+    }
+
+    if (!openMapping())
+    {
+        return false;
+    }
+
+    oceanaudio::BridgeFormat format;
+    const bool formatRead = header->readFormatBounded(format);
+
+    if (!formatRead || !header->isReadable(format))
+    {
+        layoutStatus = formatRead ? oceanaudio::SharedLayoutStatus::InvalidFormat
+                                  : oceanaudio::SharedLayoutStatus::Uninitialised;
+        closeMapping();
+        return false;
+    }
+
+    oceanaudio::SharedBufferInfo offer {};
+    offer.channels = format.channels;
+    offer.sampleRate = format.sampleRate;
+    offer.frameCapacity = format.frameCapacity;
+    offer.framesPerBlock = format.framesPerBlock;
+    offer.transferMode = static_cast<std::uint32_t>(oceanaudio::BridgeTransferMode::Direct);
+    offer.layoutVersion = header->version;
+#if defined(_WIN32)
+    offer.sharedMemoryHandle = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(mappingHandle));
+#else
+    // The endpoint maps its own view from this and we close ours straight after.
+    const int descriptor = oceanaudio::posix::SharedMapping::openDescriptor(
+        oceanaudio::posix::toObjectName(settings.mappingName));
+    offer.sharedMemoryHandle = static_cast<std::uint64_t>(descriptor);
+#endif
+
+    oceanaudio::SharedBufferInfo answer {};
+    const bool reached = endpoint.querySharedBuffer(offer, answer);
+#if !defined(_WIN32)
+    if (descriptor >= 0)
+    {
+        ::close(descriptor);
+    }
+#endif
+    if (!reached)
+    {
+        closeMapping();
+        return false;
+    }
+
+    if (answer.transferMode != static_cast<std::uint32_t>(oceanaudio::BridgeTransferMode::Direct))
+    {
+        // The endpoint wants its blocks handed over; nothing left for us to watch.
+        ++stats.refusals;
+        closeMapping();
+        reattaching = false;
+        return true;
+    }
+
+    // A slot we cannot watch is as good as a refusal: let go of the endpoint's view
+    // and have it take its blocks handed over.
+    if (answer.readerSlot >= oceanaudio::kMaxBroadcastReaders
+        || header->readers[answer.readerSlot].state.load(std::memory_order_acquire)
+               != static_cast<std::uint32_t>(oceanaudio::ReaderSlotState::Active))
+    {
+        ++stats.refusals;
+        endpoint.releaseSharedBuffer();
+        closeMapping();
+        reattaching = false;
+        return true;
+    }
+
+    direct = true;
+    ++stats.negotiations;
+    readerSlot = answer.readerSlot;
+    const auto& slot = header->readers[readerSlot];
+    readerEpoch = slot.epoch.load(std::memory_order_acquire);
+    startCursor = slot.cursor.load(std::memory_order_acquire);
+    formatGeneration = format.generation;
+    stats.readerSlot = readerSlot;
+    stats.framesConsumed = 0;
+    stats.lagFrames = 0;
+    reattaching = false;
+    return true;
+}
+
+void DirectBridgeSupervisor::disconnect()
+{
+    if (direct)
+    {
+        endpoint.releaseSharedBuffer();
+        direct = false;
+    }
+
+    closeMapping();
+    reattaching = false;
+}
+
+bool DirectBridgeSupervisor::isConnected() const noexcept
+{
+    return header != nullptr;
+}
+
+bool DirectBridgeSupervisor::isDirect() const noexcept
+{
+    return direct;
+}
+
+oceanaudio::SharedLayoutStatus DirectBridgeSupervisor::getLayoutStatus() const noexcept
+{
+    return layoutStatus;
+}
+
+void DirectBridgeSupervisor::pump()
+{
+    if (header != nullptr && direct)
+    {
+        const auto generation = header->formatGeneration.load(std::memory_order_acquire);
+        if (!isProducerAlive())
+        {
+            ++stats.producerLosses;
+            dropConnection();
+        }
+        else if (generation == oceanaudio::SharedAudioRingBufferHeader::kFormatRetired)
+        {
+            ++stats.retiredMappings;
+            dropConnection();
+        }
+        else if (!isEndpointAlive())
+        {
+            // Crashed, stuck, or evicted by the producer for missing heartbeats.
+            ++stats.endpointLosses;
+            dropConnection();
+        }
+        else
+        {
+            if (generation != formatGeneration && (generation & 1u) == 0)
+            {
+                ++stats.formatChanges;
+                formatGeneration = generation;
+            }
+
+            const auto cursor = header->readers[readerSlot].cursor.load(std::memory_order_acquire);
+            const auto writeCursor = header->writeCursor.load(std::memory_order_acquire);
+            stats.framesConsumed = cursor - startCursor;
+            stats.lagFrames = writeCursor > cursor ? writeCursor - cursor : 0;
+        }
+    }
+
+    if (header == nullptr && reattaching)
+    {
+        connect();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(settings.pollIntervalMs));
+}
+
+void DirectBridgeSupervisor::run(const std::function<bool()>& shouldStop)
+{
+    while (!shouldStop())
+    {
+        pump();
+        if (!direct && !reattaching)
+        {
+            return;
+        }
+    }
+}
+
+DirectBridgeSupervisor::Statistics DirectBridgeSupervisor::getStatistics() const noexcept
+{
+    return stats;
+}
+
+bool DirectBridgeSupervisor::openMapping()
+{
+    layoutStatus = oceanaudio::SharedLayoutStatus::Uninitialised;
+
+#if defined(_WIN32)
+    mappingHandle = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, settings.mappingName.c_str());
+    if (mappingHandle == nullptr)
+    {
+        return false;
+    }
+
+    auto* view = MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (view == nullptr)
+    {
+        closeMapping();
+        return false;
+    }
+
+    MEMORY_BASIC_INFORMATION regionInfo {};
+    const std::size_t mappedBytes = VirtualQuery(view, &regionInfo, sizeof(regionInfo)) != 0 ? regionInfo.RegionSize : 0;
+#else
+    if (!mapping.open(oceanaudio::posix::toObjectName(settings.mappingName)))
+    {
+        return false;
+    }
+
+    auto* view = mapping.data();
+    const std::size_t mappedBytes = mapping.sizeInBytes();
+#endif
+
+    header = static_cast<oceanaudio::SharedAudioRingBufferHeader*>(view);
+    layoutStatus = oceanaudio::checkSharedLayout(view, mappedBytes);
+    if (layoutStatus == oceanaudio::SharedLayoutStatus::Compatible && !isProducerAlive())
+    {
+        layoutStatus = oceanaudio::SharedLayoutStatus::ProducerGone;
+    }
+    if (layoutStatus != oceanaudio::SharedLayoutStatus::Compatible)
+    {
+        closeMapping();
+        return false;
+    }
+    return true;
+}
+
+void DirectBridgeSupervisor::closeMapping() noexcept
+{
+#if defined(_WIN32)
+    if (header != nullptr)
+    {
+        UnmapViewOfFile(header);
+    }
+    if (mappingHandle != nullptr)
+    {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+#else
+    mapping.close();
+#endif
+    header = nullptr;
+}
+
+bool DirectBridgeSupervisor::isProducerAlive() const noexcept
+{
+    // Producers that never beat are trusted, as in BridgeConsumer.
+    const auto& producerHeartbeat = header->producerHeartbeat;
+    const auto timeoutNs = std::uint64_t {settings.producerTimeoutMs} * 1'000'000;
+    return timeoutNs == 0 || producerHeartbeat.getBeats() == 0
+           || producerHeartbeat.isAlive(oceanaudio::sharedClockNanoseconds(), timeoutNs);
+}
+
+bool DirectBridgeSupervisor::isEndpointAlive() const noexcept
+{
+    const auto& slot = header->readers[readerSlot];
+    const auto state = slot.state.load(std::memory_order_acquire);
+    if ((state != static_cast<std::uint32_t>(oceanaudio::ReaderSlotState::Active)
+         && state != static_cast<std::uint32_t>(oceanaudio::ReaderSlotState::Detached))
+        || slot.epoch.load(std::memory_order_acquire) != readerEpoch)
+    {
+        return false;
+    }
+
+    const auto timeoutNs = std::uint64_t {settings.endpointTimeoutMs} * 1'000'000;
+    return timeoutNs == 0 || slot.heartbeat.isAlive(oceanaudio::sharedClockNanoseconds(), timeoutNs);
+}
+
+void DirectBridgeSupervisor::dropConnection()
+{
+    endpoint.releaseSharedBuffer();
+    direct = false;
+    closeMapping();
+    ++stats.reconnects;
+    reattaching = true;
+}
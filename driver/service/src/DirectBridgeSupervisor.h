@@ -0,0 +1,109 @@
+#pragma once
+
+#include "CaptureEndpoint.h"
+
+#include <OceanAudio/BridgeSharedMemory.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <OceanAudio/PosixSharedMemory.h>
+#endif
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Service side of Direct mode. It opens the host's mapping without taking a reader
+// slot, offers it to the capture endpoint through QuerySharedBuffer, and from then on
+// only watches: the producer's heartbeat, a retired mapping and the endpoint's own
+// reader slot. When any of them goes, it releases the endpoint and offers the next
+// mapping once there is one. No audio passes through the service.
+//
+// If the endpoint answers Copy, connect() still succeeds but isDirect() is false; the
+// caller runs ConsumerEngine for that endpoint instead.
+class DirectBridgeSupervisor
+{
+public:
+    struct Settings
+    {
+        std::wstring mappingName = L"Global\\OceanAudio_AudioRing";
+        // As ConsumerEngine::Settings::producerTimeoutMs.
+        std::uint32_t producerTimeoutMs = oceanaudio::kDefaultPeerTimeoutMs;
+        // An endpoint reader silent for this long is taken for stuck: it is released
+        // and offered the mapping again. 0 trusts it forever.
+        std::uint32_t endpointTimeoutMs = oceanaudio::kDefaultPeerTimeoutMs;
+        // How often run() looks at the mapping.
+        std::uint32_t pollIntervalMs = 20;
+    };
+
+    struct Statistics
+    {
+        // Offers answered with Direct and with Copy; a Direct answer naming a slot
+        // that is out of range or not Active counts as Copy.
+        std::uint64_t negotiations = 0;
+        std::uint64_t refusals = 0;
+        // Times the endpoint was released and offered the next mapping, and why.
+        std::uint64_t reconnects = 0;
+        std::uint64_t producerLosses = 0;
+        std::uint64_t endpointLosses = 0;
+        std::uint64_t retiredMappings = 0;
+        // In-place format changes the endpoint had to follow on its own.
+        std::uint64_t formatChanges = 0;
+        std::uint32_t readerSlot = 0;
+        // Frames the endpoint has read in the current connection, and how far it is
+        // behind the producer.
+        std::uint64_t framesConsumed = 0;
+        std::uint64_t lagFrames = 0;
+        // Always zero in Direct mode: the service never touches the audio.
+        std::uint64_t bytesCopied = 0;
+    };
+
+    DirectBridgeSupervisor(CaptureEndpoint& endpointToSupervise, Settings supervisorSettings);
+    ~DirectBridgeSupervisor();
+
+    DirectBridgeSupervisor(const DirectBridgeSupervisor&) = delete;
+    DirectBridgeSupervisor& operator=(const DirectBridgeSupervisor&) = delete;
+
+    // Opens the mapping and negotiates with the endpoint. Fails while there is no
+    // usable mapping (see getLayoutStatus()) or the endpoint cannot be reached.
+    bool connect();
+    void disconnect();
+
+    [[nodiscard]] bool isConnected() const noexcept;
+    [[nodiscard]] bool isDirect() const noexcept;
+    [[nodiscard]] oceanaudio::SharedLayoutStatus getLayoutStatus() const noexcept;
+
+    // One supervision pass: checks the connection, reconnects if it was lost, then
+    // sleeps for the poll interval.
+    void pump();
+    // Supervises until `shouldStop` says so, or until the endpoint answers Copy to a
+    // reconnect; the caller should drain the ring for it from then on.
+    void run(const std::function<bool()>& shouldStop);
+
+    [[nodiscard]] Statistics getStatistics() const noexcept;
+
+private:
+    bool openMapping();
+    void closeMapping() noexcept;
+    bool isProducerAlive() const noexcept;
+    bool isEndpointAlive() const noexcept;
+    void dropConnection();
+
+    CaptureEndpoint& endpoint;
+    Settings settings;
+#if defined(_WIN32)
+    HANDLE mappingHandle = nullptr;
+#else
+    oceanaudio::posix::SharedMapping mapping;
+#endif
+    oceanaudio::SharedAudioRingBufferHeader* header = nullptr;
+    oceanaudio::SharedLayoutStatus layoutStatus = oceanaudio::SharedLayoutStatus::Uninitialised;
+    bool direct = false;
+    bool reattaching = false;
+    std::uint32_t readerSlot = 0;
+    std::uint32_t readerEpoch = 0;
+    std::uint32_t formatGeneration = 0;
+    std::uint64_t startCursor = 0;
+    Statistics stats;
+};
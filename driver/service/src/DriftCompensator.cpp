@@ -0,0 +1,285 @@
+#include "DriftCompensator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+// One frame before the interpolation point and two after it.
+constexpr std::uint32_t kHistoryFrames = 1;
+constexpr std::uint32_t kLookaheadFrames = 2;
+
+// Two blocks are what the consumer needs in hand at its tick; the third absorbs
+// producer scheduling jitter.
+constexpr std::uint32_t kDefaultTargetBlocks = 3;
+
+float cubicHermite(float previous, float current, float next, float afterNext, float fraction) noexcept
+{
+    const float c1 = 0.5f * (next - previous);
+    const float c2 = previous - 2.5f * current + 2.0f * next - 0.5f * afterNext;
+    const float c3 = 0.5f * (afterNext - previous) + 1.5f * (current - next);
+    return ((c3 * fraction + c2) * fraction + c1) * fraction + current;
+}
+} // namespace
+
+void FillLevelController::reset(const Settings& controllerSettings, double initialFillFrames)
+{
+    settings = controllerSettings;
+    smoothedFill = initialFillFrames;
+    integralPpm = 0.0;
+    correctionPpm = 0.0;
+}
+
+double FillLevelController::update(double fillFrames, double elapsedSeconds)
+{
+    if (elapsedSeconds <= 0.0)
+    {
+        return correctionPpm;
+    }
+
+    const double smoothing = settings.smoothingSeconds > 0.0
+                                 ? 1.0 - std::exp(-elapsedSeconds / settings.smoothingSeconds)
+                                 : 1.0;
+    smoothedFill += smoothing * (fillFrames - smoothedFill);
+
+    const double error = smoothedFill - settings.targetFillFrames;
+    const double limit = settings.maxCorrectionPpm;
+
+    // Clamping the integrator itself keeps it from winding up while the output is
+    // saturated, e.g. during a long stall upstream.
+    integralPpm = std::clamp(integralPpm + settings.integralPpmPerFrameSecond * error * elapsedSeconds,
+                             -limit,
+                             limit);
+    correctionPpm = std::clamp(settings.proportionalPpmPerFrame * error + integralPpm, -limit, limit);
+    return correctionPpm;
+}
+
+void FillLevelController::setTargetFill(double targetFillFrames) noexcept
+{
+    settings.targetFillFrames = targetFillFrames;
+}
+
+double FillLevelController::getCorrectionPpm() const noexcept
+{
+    return correctionPpm;
+}
+
+double FillLevelController::getSmoothedFill() const noexcept
+{
+    return smoothedFill;
+}
+
+void DriftResampler::prepare(std::uint32_t numChannels, std::uint32_t maxOutputFrames, double maxRatio)
+{
+    channels = numChannels;
+    capacityFrames = static_cast<std::uint32_t>(std::ceil(maxOutputFrames * maxRatio)) + kHistoryFrames
+                     + kLookaheadFrames + 2;
+    staging.assign(static_cast<std::size_t>(capacityFrames) * channels, 0.0f);
+    reset();
+}
+
+void DriftResampler::reset()
+{
+    std::fill(staging.begin(), staging.end(), 0.0f);
+    stagedFrames = kHistoryFrames;
+    position = static_cast<double>(kHistoryFrames);
+    ratio = 1.0;
+}
+
+void DriftResampler::setRatio(double inputFramesPerOutputFrame) noexcept
+{
+    ratio = inputFramesPerOutputFrame;
+}
+
+std::uint32_t DriftResampler::inputFramesNeeded(std::uint32_t outputFrames) const noexcept
+{
+    if (outputFrames == 0)
+    {
+        return 0;
+    }
+
+    const double lastPosition = position + static_cast<double>(outputFrames - 1) * ratio;
+    const auto framesRequired = static_cast<std::uint32_t>(std::floor(lastPosition)) + kLookaheadFrames + 1;
+    return framesRequired > stagedFrames ? framesRequired - stagedFrames : 0;
+}
+
+void DriftResampler::pushInput(const FrameSpans& frames)
+{
+    append(frames.first, frames.firstFrames);
+    append(frames.second, frames.secondFrames);
+}
+
+std::uint32_t DriftResampler::render(float* interleavedOutput, std::uint32_t outputFrames)
+{
+    std::uint32_t rendered = 0;
+    for (; rendered < outputFrames; ++rendered)
+    {
+        const auto index = static_cast<std::uint32_t>(position);
+        if (index + kLookaheadFrames >= stagedFrames)
+        {
+            break;
+        }
+
+        const auto fraction = static_cast<float>(position - index);
+        const float* previous = staging.data() + static_cast<std::size_t>(index - 1) * channels;
+        const float* current = previous + channels;
+        const float* next = current + channels;
+        const float* afterNext = next + channels;
+        float* destination = interleavedOutput + static_cast<std::size_t>(rendered) * channels;
+
+        for (std::uint32_t channel = 0; channel < channels; ++channel)
+        {
+            destination[channel] = cubicHermite(previous[channel], current[channel], next[channel],
+                                                afterNext[channel], fraction);
+        }
+
+        position += ratio;
+    }
+
+    // Drop consumed input, keeping the history the next interpolation point needs.
+    const auto consumed = std::min(static_cast<std::uint32_t>(position) - kHistoryFrames, stagedFrames);
+    if (consumed > 0)
+    {
+        std::memmove(staging.data(),
+                     staging.data() + static_cast<std::size_t>(consumed) * channels,
+                     static_cast<std::size_t>(stagedFrames - consumed) * channels * sizeof(float));
+        stagedFrames -= consumed;
+        position -= consumed;
+    }
+
+    return rendered;
+}
+
+double DriftResampler::bufferedFrames() const noexcept
+{
+    return std::max(0.0, static_cast<double>(stagedFrames) - position);
+}
+
+void DriftResampler::append(const float* interleavedFrames, std::uint32_t frames)
+{
+    const auto room = capacityFrames - stagedFrames;
+    const auto framesToCopy = std::min(frames, room);
+    if (framesToCopy == 0)
+    {
+        return;
+    }
+
+    std::memcpy(staging.data() + static_cast<std::size_t>(stagedFrames) * channels,
+                interleavedFrames,
+                static_cast<std::size_t>(framesToCopy) * channels * sizeof(float));
+    stagedFrames += framesToCopy;
+}
+
+void DriftCompensator::prepare(const StreamFormat& streamFormat, const Settings& compensatorSettings)
+{
+    format = streamFormat;
+    settings = compensatorSettings;
+    if (settings.targetLatencyFrames == 0)
+    {
+        settings.targetLatencyFrames = format.framesPerBlock * kDefaultTargetBlocks;
+    }
+    settings.controller.targetFillFrames = settings.targetLatencyFrames;
+
+    const double maxRatio = 1.0 + settings.controller.maxCorrectionPpm * 1.0e-6;
+    resampler.prepare(format.channels, format.framesPerBlock + settings.surplusInputFrames, maxRatio);
+    controller.reset(settings.controller, settings.targetLatencyFrames);
+    primed = false;
+    controllerStarted = false;
+    renderingThisBlock = false;
+    stats = {};
+}
+
+double DriftCompensator::estimateQueuedFrames(std::uint32_t ringFrames,
+                                              std::uint64_t nanosecondsSinceCommit,
+                                              const StreamFormat& streamFormat) noexcept
+{
+    const double accrued = static_cast<double>(nanosecondsSinceCommit) * 1.0e-9 * streamFormat.sampleRate;
+    return ringFrames + std::min(accrued, static_cast<double>(streamFormat.framesPerBlock));
+}
+
+void DriftCompensator::setTargetLatency(std::uint32_t targetFrames, std::uint32_t prefillFrames) noexcept
+{
+    settings.targetLatencyFrames = targetFrames;
+    settings.prefillFrames = prefillFrames;
+    settings.controller.targetFillFrames = targetFrames;
+    controller.setTargetFill(targetFrames);
+}
+
+std::uint32_t DriftCompensator::beginBlock(double queuedFrames, double elapsedSeconds)
+{
+    const double latency = queuedFrames + resampler.bufferedFrames();
+    stats.latencyFrames = latency;
+
+    if (!primed)
+    {
+        const auto prefill = settings.prefillFrames != 0 ? settings.prefillFrames : settings.targetLatencyFrames;
+        if (latency < prefill)
+        {
+            renderingThisBlock = false;
+            return 0;
+        }
+
+        primed = true;
+        resampler.reset();
+        if (!controllerStarted)
+        {
+            controller.reset(settings.controller, latency);
+            controllerStarted = true;
+        }
+    }
+
+    const double correction = controller.update(latency, elapsedSeconds);
+    stats.correctionPpm = correction;
+    stats.smoothedLatencyFrames = controller.getSmoothedFill();
+    resampler.setRatio(1.0 + correction * 1.0e-6);
+    renderingThisBlock = true;
+    return resampler.inputFramesNeeded(format.framesPerBlock);
+}
+
+void DriftCompensator::pushInput(const FrameSpans& frames)
+{
+    resampler.pushInput(frames);
+}
+
+std::uint32_t DriftCompensator::renderBlock(float* interleavedOutput)
+{
+    ++stats.blocksRendered;
+    const auto blockSamples = static_cast<std::size_t>(format.framesPerBlock) * format.channels;
+
+    if (!renderingThisBlock)
+    {
+        std::fill(interleavedOutput, interleavedOutput + blockSamples, 0.0f);
+        ++stats.silentBlocks;
+        return 0;
+    }
+
+    const auto rendered = resampler.render(interleavedOutput, format.framesPerBlock);
+    if (rendered == format.framesPerBlock)
+    {
+        return rendered;
+    }
+
+    // Ran dry: pad and wait for the queue to refill to the prefill level before resuming.
+    std::fill(interleavedOutput + static_cast<std::size_t>(rendered) * format.channels,
+              interleavedOutput + blockSamples,
+              0.0f);
+    ++stats.starvations;
+    primed = false;
+    return rendered;
+}
+
+bool DriftCompensator::isPrimed() const noexcept
+{
+    return primed;
+}
+
+std::uint32_t DriftCompensator::getTargetLatencyFrames() const noexcept
+{
+    return settings.targetLatencyFrames;
+}
+
+DriftCompensator::Statistics DriftCompensator::getStatistics() const noexcept
+{
+    return stats;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "FrameSink.h"
+
+#include <cstdint>
+#include <vector>
+
+// PI loop on the bridge fill level. The output is a rate correction in ppm: positive
+// while more audio is queued than the target, so the resampler consumes input faster
+// and the queue drains back towards the target.
+class FillLevelController
+{
+public:
+    struct Settings
+    {
+        // The queue moves by sampleRate * 1e-6 frames per second for each ppm of
+        // mismatch (0.048 at 48 kHz). These gains put the closed loop near
+        // critical damping with a natural frequency of about 0.2 rad/s at 48 kHz, so a
+        // step in drift settles in roughly 20 seconds.
+        double targetFillFrames = 0.0;
+        double proportionalPpmPerFrame = 8.0;
+        double integralPpmPerFrameSecond = 1.0;
+        double maxCorrectionPpm = 1000.0;
+        // Time constant of the low-pass on the measured fill; it hides the block-sized
+        // sawtooth so the correction does not audibly wobble.
+        double smoothingSeconds = 0.5;
+    };
+
+    void reset(const Settings& controllerSettings, double initialFillFrames);
+    double update(double fillFrames, double elapsedSeconds);
+    // Moves the setpoint without disturbing the integrator (the clocks did not change).
+    void setTargetFill(double targetFillFrames) noexcept;
+
+    [[nodiscard]] double getCorrectionPpm() const noexcept;
+    [[nodiscard]] double getSmoothedFill() const noexcept;
+
+private:
+    Settings settings;
+    double smoothedFill = 0.0;
+    double integralPpm = 0.0;
+    double correctionPpm = 0.0;
+};
+
+// Variable-ratio resampler for interleaved float frames (4-point cubic Hermite). The
+// ratio only ever moves by a few hundred ppm, where cubic interpolation is transparent
+// and far cheaper than a windowed-sinc kernel. Input is staged in a buffer sized by
+// prepare(), so pushInput() and render() never allocate.
+class DriftResampler
+{
+public:
+    void prepare(std::uint32_t numChannels, std::uint32_t maxOutputFrames, double maxRatio);
+    void reset();
+
+    // Input frames consumed per output frame.
+    void setRatio(double inputFramesPerOutputFrame) noexcept;
+    [[nodiscard]] std::uint32_t inputFramesNeeded(std::uint32_t outputFrames) const noexcept;
+    void pushInput(const FrameSpans& frames);
+    // Returns the number of frames rendered; fewer than requested means the input ran out.
+    std::uint32_t render(float* interleavedOutput, std::uint32_t outputFrames);
+
+    // Input frames held but not yet consumed; they count towards latency.
+    [[nodiscard]] double bufferedFrames() const noexcept;
+
+private:
+    void append(const float* interleavedFrames, std::uint32_t frames);
+
+    std::uint32_t channels = 0;
+    std::uint32_t capacityFrames = 0;
+    std::vector<float> staging;
+    std::uint32_t stagedFrames = 0;
+    double position = 1.0;
+    double ratio = 1.0;
+};
+
+// Consumer-side clock-drift compensation: once per consumer-clock block, measure how
+// much audio is queued, let the PI controller trim the resampling ratio, pull the
+// input that ratio needs and render exactly one block. Until the queue first reaches
+// the prefill level (and again after running dry) it renders silence so the latency
+// starts near the target instead of at zero. Running dry keeps the learned correction:
+// the clocks did not change, only the queue did. Overruns and concealment are the
+// jitter buffer's business (JitterBuffer.h).
+class DriftCompensator
+{
+public:
+    struct Settings
+    {
+        std::uint32_t targetLatencyFrames = 0;
+        // Queue level to wait for before rendering audio; 0 means the target.
+        std::uint32_t prefillFrames = 0;
+        // Input beyond what beginBlock() asks for that pushInput() may be handed in one
+        // block; the staging buffer makes room for it.
+        std::uint32_t surplusInputFrames = 0;
+        FillLevelController::Settings controller;
+    };
+
+    struct Statistics
+    {
+        std::uint64_t blocksRendered = 0;
+        std::uint64_t silentBlocks = 0;
+        std::uint64_t starvations = 0;
+        double correctionPpm = 0.0;
+        double latencyFrames = 0.0;
+        double smoothedLatencyFrames = 0.0;
+    };
+
+    void prepare(const StreamFormat& streamFormat, const Settings& compensatorSettings);
+
+    // Frames queued upstream plus what the producer has captured since its last commit.
+    // Sampling the ring alone sees a block-sized sawtooth whose phase drifts with the
+    // clocks (a 50 ppm skew at 256 frames takes minutes to sweep it), far too slow for
+    // the low-pass to hide; accounting for the producer's progress removes it.
+    [[nodiscard]] static double estimateQueuedFrames(std::uint32_t ringFrames,
+                                                     std::uint64_t nanosecondsSinceCommit,
+                                                     const StreamFormat& streamFormat) noexcept;
+
+    // Moves the latency target and the prefill level (0 means the target), e.g. as
+    // the jitter buffer adapts to the jitter it observes.
+    void setTargetLatency(std::uint32_t targetFrames, std::uint32_t prefillFrames) noexcept;
+
+    // Starts a block: `queuedFrames` is what is waiting upstream (see above) and
+    // `elapsedSeconds` the consumer-clock time since the previous block. Returns how
+    // many input frames to pushInput() before renderBlock().
+    std::uint32_t beginBlock(double queuedFrames, double elapsedSeconds);
+    void pushInput(const FrameSpans& frames);
+    // Renders format.framesPerBlock frames and returns how many of them are audio; the
+    // rest (all of them while priming) is silence padding.
+    std::uint32_t renderBlock(float* interleavedOutput);
+
+    [[nodiscard]] bool isPrimed() const noexcept;
+    [[nodiscard]] std::uint32_t getTargetLatencyFrames() const noexcept;
+    [[nodiscard]] Statistics getStatistics() const noexcept;
+
+private:
+    StreamFormat format;
+    Settings settings;
+    FillLevelController controller;
+    DriftResampler resampler;
+    bool primed = false;
+    bool controllerStarted = false;
+    bool renderingThisBlock = false;
+    Statistics stats;
+};
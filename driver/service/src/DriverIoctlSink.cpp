@@ -0,0 +1,241 @@
+#include "DriverIoctlSink.h"
+
+#include <OceanAudio/BridgeProtocol.h>
+
+#include <SetupAPI.h>
+#include <objbase.h>
+
+#include <cstring>
+
+namespace
+{
+GUID getBridgeInterfaceGuid()
+{
+    GUID guid {};
+    if (FAILED(CLSIDFromString(oceanaudio::kDeviceInterfaceId, &guid)))
+    {
+        return GUID {};
+    }
+    return guid;
+}
+
+HANDLE openDriverInterface()
+{
+    GUID interfaceGuid = getBridgeInterfaceGuid();
+    if (interfaceGuid == GUID {})
+    {
+        OutputDebugStringW(L"[OceanAudioBridgeService] Invalid device interface GUID.\n");
+        return INVALID_HANDLE_VALUE;
+    }
+
+    HDEVINFO deviceInfoSet = SetupDiGetClassDevsW(&interfaceGuid,
+                                                  nullptr,
+                                                  nullptr,
+                                                  DIGCF_DEVICEINTERFACE | DIGCF_PRESENT);
+    if (deviceInfoSet == INVALID_HANDLE_VALUE)
+    {
+        return INVALID_HANDLE_VALUE;
+    }
+
+    SP_DEVICE_INTERFACE_DATA interfaceData;
+    interfaceData.cbSize = sizeof(SP_DEVICE_INTERFACE_DATA);
+
+    HANDLE deviceHandle = INVALID_HANDLE_VALUE;
+
+    for (DWORD index = 0; SetupDiEnumDeviceInterfaces(deviceInfoSet, nullptr, &interfaceGuid, index, &interfaceData); ++index)
+    {
+        DWORD requiredSize = 0;
+        SetupDiGetDeviceInterfaceDetailW(deviceInfoSet, &interfaceData, nullptr, 0, &requiredSize, nullptr);
+        if (requiredSize == 0)
+        {
+            continue;
+        }
+
+        std::vector<wchar_t> buffer(requiredSize / sizeof(wchar_t) + 1);
+        auto* detailData = reinterpret_cast<PSP_DEVICE_INTERFACE_DETAIL_DATA_W>(buffer.data());
+        detailData->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_W);
+
+        if (!SetupDiGetDeviceInterfaceDetailW(deviceInfoSet, &interfaceData, detailData, requiredSize, nullptr, nullptr))
+        {
+            continue;
+        }
+
+        deviceHandle = CreateFileW(detailData->DevicePath,
+                                   GENERIC_READ | GENERIC_WRITE,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                   nullptr,
+                                   OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL,
+                                   nullptr);
+        if (deviceHandle != INVALID_HANDLE_VALUE)
+        {
+            break;
+        }
+    }
+
+    SetupDiDestroyDeviceInfoList(deviceInfoSet);
+    return deviceHandle;
+}
+} // namespace
+
+DriverIoctlSink::DriverIoctlSink()
+    : driverHandle(INVALID_HANDLE_VALUE)
+{
+}
+
+DriverIoctlSink::~DriverIoctlSink()
+{
+    if (driverHandle != nullptr && driverHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(driverHandle);
+    }
+}
+
+bool DriverIoctlSink::open(const StreamFormat& newFormat)
+{
+    format = newFormat;
+    packetBuffer.assign(sizeof(oceanaudio::BridgeAudioPacket)
+                            + static_cast<std::size_t>(format.framesPerBlock) * format.bytesPerFrame(),
+                        0);
+    ensureDriverHandle();
+    return true;
+}
+
+bool DriverIoctlSink::write(const FrameSpans& frames)
+{
+    const auto totalFrames = frames.totalFrames();
+    const std::size_t frameBytes = format.bytesPerFrame();
+    if (driverHandle == INVALID_HANDLE_VALUE || totalFrames == 0
+        || sizeof(oceanaudio::BridgeAudioPacket) + totalFrames * frameBytes > packetBuffer.size())
+    {
+        return false;
+    }
+
+    auto* payload = packetBuffer.data() + sizeof(oceanaudio::BridgeAudioPacket);
+    std::memcpy(payload, frames.first, frames.firstFrames * frameBytes);
+    std::memcpy(payload + frames.firstFrames * frameBytes, frames.second, frames.secondFrames * frameBytes);
+    return submitPacket(totalFrames);
+}
+
+bool DriverIoctlSink::writePacked(const PackedFrames& frames)
+{
+    const std::size_t frameBytes = format.bytesPerFrame();
+    if (driverHandle == INVALID_HANDLE_VALUE || frames.frames == 0
+        || sizeof(oceanaudio::BridgeAudioPacket) + frames.frames * frameBytes > packetBuffer.size())
+    {
+        return false;
+    }
+
+    std::memcpy(packetBuffer.data() + sizeof(oceanaudio::BridgeAudioPacket), frames.data, frames.frames * frameBytes);
+    return submitPacket(frames.frames);
+}
+
+void DriverIoctlSink::close()
+{
+    // The driver handle survives format changes; it is released with the sink.
+}
+
+std::uint64_t DriverIoctlSink::getBytesCopied() const noexcept
+{
+    return bytesCopied;
+}
+
+bool DriverIoctlSink::isDriverAvailable() const noexcept
+{
+    return driverHandle != INVALID_HANDLE_VALUE;
+}
+
+bool DriverIoctlSink::querySharedBuffer(const oceanaudio::SharedBufferInfo& offer, oceanaudio::SharedBufferInfo& answer)
+{
+    if (!ensureDriverHandle())
+    {
+        return false;
+    }
+
+    // METHOD_BUFFERED: the offer goes in and the answer comes back in the same struct.
+    oceanaudio::SharedBufferInfo exchange = offer;
+    DWORD bytesReturned = 0;
+    const BOOL result = DeviceIoControl(driverHandle,
+                                        oceanaudio::BridgeIoctlCode(oceanaudio::BridgeIoctl::QuerySharedBuffer),
+                                        &exchange,
+                                        sizeof(exchange),
+                                        &exchange,
+                                        sizeof(exchange),
+                                        &bytesReturned,
+                                        nullptr);
+
+    answer = offer;
+    answer.transferMode = static_cast<std::uint32_t>(oceanaudio::BridgeTransferMode::Copy);
+    answer.readerSlot = 0;
+    if (result != FALSE && bytesReturned >= oceanaudio::kNegotiatingSharedBufferInfoSize)
+    {
+        answer = exchange;
+    }
+    // A driver without the IOCTL, or one whose answer stops short of readerSlot, gets Copy.
+    return true;
+}
+
+void DriverIoctlSink::releaseSharedBuffer()
+{
+    if (driverHandle == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    DWORD bytesReturned = 0;
+    DeviceIoControl(driverHandle,
+                    oceanaudio::BridgeIoctlCode(oceanaudio::BridgeIoctl::ReleaseSharedBuffer),
+                    nullptr,
+                    0,
+                    nullptr,
+                    0,
+                    &bytesReturned,
+                    nullptr);
+}
+
+bool DriverIoctlSink::ensureDriverHandle()
+{
+    if (driverHandle == INVALID_HANDLE_VALUE)
+    {
+        driverHandle = openDriverInterface();
+        if (driverHandle == INVALID_HANDLE_VALUE)
+        {
+            OutputDebugStringW(L"[OceanAudioBridgeService] Driver handle unavailable; will continue without IOCTL forwarding.\n");
+        }
+    }
+    return driverHandle != INVALID_HANDLE_VALUE;
+}
+
+bool DriverIoctlSink::submitPacket(std::uint32_t frames)
+{
+    // The payload is already in place behind the header.
+    const std::size_t payloadBytes = static_cast<std::size_t>(frames) * format.bytesPerFrame();
+    const std::size_t totalBytes = sizeof(oceanaudio::BridgeAudioPacket) + payloadBytes;
+    auto* packet = reinterpret_cast<oceanaudio::BridgeAudioPacket*>(packetBuffer.data());
+    packet->framesWritten = frames;
+    packet->sampleFormat = static_cast<std::uint32_t>(format.sampleFormat);
+    bytesCopied += payloadBytes;
+
+    DWORD bytesReturned = 0;
+    const auto ioctlCode = oceanaudio::BridgeIoctlCode(oceanaudio::BridgeIoctl::SubmitFrames);
+    const BOOL result = DeviceIoControl(driverHandle,
+                                        ioctlCode,
+                                        packetBuffer.data(),
+                                        static_cast<DWORD>(totalBytes),
+                                        nullptr,
+                                        0,
+                                        &bytesReturned,
+                                        nullptr);
+
+    if (result == FALSE)
+    {
+        const auto error = GetLastError();
+        if (error != ERROR_NOT_SUPPORTED)
+        {
+            OutputDebugStringW(L"[OceanAudioBridgeService] DeviceIoControl failed when submitting frames.\n");
+        }
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CaptureEndpoint.h"
+#include "FrameSink.h"
+
+#include <Windows.h>
+
+#include <cstdint>
+#include <vector>
+
+// Forwards frames to the OceanAudioVirtualMic driver through the SubmitFrames IOCTL.
+// If the driver interface is missing the sink stays usable and simply reports failed
+// writes, so the service keeps draining the ring. The packet buffer is sized in open()
+// for one block, so each write is a single copy out of the ring and no allocation.
+//
+// It is also the driver's CaptureEndpoint: QuerySharedBuffer offers the driver the ring
+// itself, and a driver that takes it (Direct mode) never sees SubmitFrames.
+class DriverIoctlSink final : public FrameSink, public CaptureEndpoint
+{
+public:
+    DriverIoctlSink();
+    ~DriverIoctlSink() override;
+
+    DriverIoctlSink(const DriverIoctlSink&) = delete;
+    DriverIoctlSink& operator=(const DriverIoctlSink&) = delete;
+
+    bool open(const StreamFormat& format) override;
+    bool write(const FrameSpans& frames) override;
+    bool writePacked(const PackedFrames& frames) override;
+    void close() override;
+
+    bool querySharedBuffer(const oceanaudio::SharedBufferInfo& offer, oceanaudio::SharedBufferInfo& answer) override;
+    void releaseSharedBuffer() override;
+
+    [[nodiscard]] std::uint64_t getBytesCopied() const noexcept override;
+    [[nodiscard]] bool isDriverAvailable() const noexcept;
+
+private:
+    bool ensureDriverHandle();
+    bool submitPacket(std::uint32_t frames);
+
+    HANDLE driverHandle;
+    StreamFormat format;
+    std::vector<std::uint8_t> packetBuffer;
+    std::uint64_t bytesCopied = 0;
+};
@@ -0,0 +1,180 @@
+#include "FormatViewConverter.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool FormatViewConverter::prepare(const StreamFormat& sourceFormat, const FormatView& view)
+{
+    source = sourceFormat;
+    output = sourceFormat;
+    output.sampleFormat = view.sampleFormat;
+    output.sampleRate = view.sampleRate != 0 ? view.sampleRate : sourceFormat.sampleRate;
+    output.channels = view.channels != 0 ? view.channels : sourceFormat.channels;
+
+    remapChannels = output.channels != source.channels;
+    resample = output.sampleRate != source.sampleRate;
+    passthrough = !remapChannels && !resample && output.sampleFormat == oceanaudio::BridgeSampleFormat::Float32;
+    floatOutput = nullptr;
+    if (passthrough)
+    {
+        return true;
+    }
+
+    const auto blockFrames = source.framesPerBlock;
+    remapped.assign(remapChannels ? static_cast<std::size_t>(blockFrames) * output.channels : 0, 0.0f);
+
+    if (resample)
+    {
+        if (!resampler.prepare(output.channels, source.sampleRate, output.sampleRate, blockFrames))
+        {
+            return false;
+        }
+        output.framesPerBlock = resampler.maxOutputFrames(blockFrames);
+    }
+    resampled.assign(resample ? static_cast<std::size_t>(output.framesPerBlock) * output.channels : 0, 0.0f);
+
+    packed.assign(output.sampleFormat != oceanaudio::BridgeSampleFormat::Float32
+                      ? static_cast<std::size_t>(output.framesPerBlock) * output.bytesPerFrame()
+                      : 0,
+                  std::byte {0});
+    dither = oceanaudio::convert::DitherState {};
+    return true;
+}
+
+StreamFormat FormatViewConverter::getOutputFormat() const noexcept
+{
+    return output;
+}
+
+bool FormatViewConverter::isPassthrough() const noexcept
+{
+    return passthrough;
+}
+
+std::uint32_t FormatViewConverter::process(const FrameSpans& frames)
+{
+    const auto inputFrames = std::min(frames.totalFrames(), source.framesPerBlock);
+    const auto firstFrames = std::min(frames.firstFrames, inputFrames);
+    const auto secondFrames = inputFrames - firstFrames;
+
+    // Stage 1: channel remap, which also joins the two ring runs into one block.
+    // Without a remap the later stages read the runs straight from the ring.
+    const float* contiguous = nullptr;
+    if (remapChannels)
+    {
+        remapRun(frames.first, firstFrames, remapped.data());
+        remapRun(frames.second, secondFrames, remapped.data() + static_cast<std::size_t>(firstFrames) * output.channels);
+        contiguous = remapped.data();
+    }
+
+    // Stage 2: rate conversion.
+    std::uint32_t outputFrames = inputFrames;
+    if (resample)
+    {
+        if (contiguous != nullptr)
+        {
+            outputFrames = resampler.process(contiguous, inputFrames, resampled.data());
+        }
+        else
+        {
+            outputFrames = resampler.process(frames.first, firstFrames, resampled.data());
+            if (secondFrames > 0)
+            {
+                outputFrames += resampler.process(frames.second,
+                                                  secondFrames,
+                                                  resampled.data() + static_cast<std::size_t>(outputFrames) * output.channels);
+            }
+        }
+        floatOutput = resampled.data();
+    }
+    else if (contiguous != nullptr)
+    {
+        floatOutput = contiguous;
+    }
+    else
+    {
+        // Only the sample format differs: quantise straight out of the ring.
+        const auto firstSamples = static_cast<std::size_t>(firstFrames) * output.channels;
+        quantise(frames.first, firstSamples, 0);
+        if (secondFrames > 0)
+        {
+            quantise(frames.second, static_cast<std::size_t>(secondFrames) * output.channels, firstSamples);
+        }
+        floatOutput = nullptr;
+        return inputFrames;
+    }
+
+    quantise(floatOutput, static_cast<std::size_t>(outputFrames) * output.channels, 0);
+    return outputFrames;
+}
+
+const float* FormatViewConverter::getFloatOutput() const noexcept
+{
+    return floatOutput;
+}
+
+const std::byte* FormatViewConverter::getPackedOutput() const noexcept
+{
+    return packed.data();
+}
+
+double FormatViewConverter::getLatencyFrames() const noexcept
+{
+    return resample ? resampler.getLatencyFrames() : 0.0;
+}
+
+void FormatViewConverter::quantise(const float* input, std::size_t samples, std::size_t offset) noexcept
+{
+    switch (output.sampleFormat)
+    {
+        case oceanaudio::BridgeSampleFormat::Float32:
+            break;
+        case oceanaudio::BridgeSampleFormat::Int16:
+            oceanaudio::convert::toInt16(input, reinterpret_cast<std::int16_t*>(packed.data()) + offset, samples, &dither);
+            break;
+        case oceanaudio::BridgeSampleFormat::Int24:
+            oceanaudio::convert::toInt24(input, reinterpret_cast<std::uint8_t*>(packed.data()) + 3 * offset, samples, &dither);
+            break;
+    }
+}
+
+void FormatViewConverter::remapRun(const float* input, std::uint32_t frames, float* destination) const noexcept
+{
+    const auto inChannels = source.channels;
+    const auto outChannels = output.channels;
+
+    if (outChannels == 1)
+    {
+        // Downmix to mono by averaging, which cannot clip.
+        const float scale = 1.0f / static_cast<float>(inChannels);
+        for (std::uint32_t frame = 0; frame < frames; ++frame)
+        {
+            float sum = 0.0f;
+            for (std::uint32_t channel = 0; channel < inChannels; ++channel)
+            {
+                sum += input[static_cast<std::size_t>(frame) * inChannels + channel];
+            }
+            destination[frame] = sum * scale;
+        }
+        return;
+    }
+
+    if (inChannels == 1)
+    {
+        for (std::uint32_t frame = 0; frame < frames; ++frame)
+        {
+            std::fill_n(destination + static_cast<std::size_t>(frame) * outChannels, outChannels, input[frame]);
+        }
+        return;
+    }
+
+    // Otherwise keep the channels both layouts share and silence the rest.
+    const auto shared = std::min(inChannels, outChannels);
+    for (std::uint32_t frame = 0; frame < frames; ++frame)
+    {
+        const float* from = input + static_cast<std::size_t>(frame) * inChannels;
+        float* to = destination + static_cast<std::size_t>(frame) * outChannels;
+        std::copy_n(from, shared, to);
+        std::fill(to + shared, to + outChannels, 0.0f);
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "FrameSink.h"
+#include "PolyphaseResampler.h"
+
+#include <OceanAudio/SampleConversionKernels.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What a consumer wants to receive, as opposed to what the producer writes into the
+// ring. Zero fields mean "as produced".
+struct FormatView
+{
+    oceanaudio::BridgeSampleFormat sampleFormat = oceanaudio::BridgeSampleFormat::Float32;
+    std::uint32_t sampleRate = 0;
+    std::uint32_t channels = 0;
+
+    [[nodiscard]] bool isIdentity() const noexcept
+    {
+        return sampleFormat == oceanaudio::BridgeSampleFormat::Float32 && sampleRate == 0 && channels == 0;
+    }
+};
+
+// Turns blocks read from the ring into one consumer's format view: channel remap, then
+// rate conversion (PolyphaseResampler), then quantisation with TPDF dither
+// (SampleConversionKernels.h). Each stage runs only when the view asks for it, and a
+// view that matches the producer is a passthrough the engine skips entirely.
+//
+// Doing this once in the consumer service, rather than in every app that reads the
+// virtual microphone, is the point: the ring stays one Float32 stream at the device
+// rate, and each reader pays only for its own view.
+//
+// prepare() allocates every buffer for the largest block; process() never does.
+class FormatViewConverter
+{
+public:
+    // Fails if the rate ratio is impractical for the polyphase resampler.
+    bool prepare(const StreamFormat& sourceFormat, const FormatView& view);
+
+    // The format sinks should be opened with. framesPerBlock is the most frames one
+    // process() call can produce.
+    [[nodiscard]] StreamFormat getOutputFormat() const noexcept;
+    [[nodiscard]] bool isPassthrough() const noexcept;
+
+    // Converts one block (at most the source framesPerBlock frames) and returns the
+    // number of output frames, which may be zero while the resampler fills up.
+    std::uint32_t process(const FrameSpans& frames);
+
+    // The last process() result: interleaved float for Float32 views, packed bytes
+    // otherwise. Valid until the next process() call.
+    [[nodiscard]] const float* getFloatOutput() const noexcept;
+    [[nodiscard]] const std::byte* getPackedOutput() const noexcept;
+
+    // Group delay the resampler adds, in output frames.
+    [[nodiscard]] double getLatencyFrames() const noexcept;
+
+private:
+    void quantise(const float* input, std::size_t samples, std::size_t offset) noexcept;
+    void remapRun(const float* source, std::uint32_t frames, float* destination) const noexcept;
+
+    StreamFormat source;
+    StreamFormat output;
+    bool passthrough = true;
+    bool remapChannels = false;
+    bool resample = false;
+    PolyphaseResampler resampler;
+    oceanaudio::convert::DitherState dither;
+    std::vector<float> remapped;
+    std::vector<float> resampled;
+    std::vector<std::byte> packed;
+    const float* floatOutput = nullptr;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <OceanAudio/BridgeProtocol.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Format of the interleaved stream a sink receives. The ring carries Float32; other
+// sample formats only reach sinks opened with a format view (FormatViewConverter.h).
+struct StreamFormat
+{
+    std::uint32_t channels = 0;
+    std::uint32_t sampleRate = 0;
+    std::uint32_t framesPerBlock = 0;
+    oceanaudio::BridgeSampleFormat sampleFormat = oceanaudio::BridgeSampleFormat::Float32;
+
+    [[nodiscard]] bool isValid() const noexcept
+    {
+        return channels > 0 && sampleRate > 0;
+    }
+
+    [[nodiscard]] std::uint32_t bytesPerFrame() const noexcept
+    {
+        return channels * oceanaudio::bytesPerSample(sampleFormat);
+    }
+
+    bool operator==(const StreamFormat&) const = default;
+};
+
+// One drained block as up to two runs of interleaved frames, split where the ring
+// wraps. The pointers refer straight into the shared ring and are only valid for the
+// duration of FrameSink::write().
+struct FrameSpans
+{
+    const float* first = nullptr;
+    std::uint32_t firstFrames = 0;
+    const float* second = nullptr;
+    std::uint32_t secondFrames = 0;
+
+    [[nodiscard]] std::uint32_t totalFrames() const noexcept
+    {
+        return firstFrames + secondFrames;
+    }
+};
+
+// A converted block of integer samples (format.sampleFormat), packed and interleaved.
+// Owned by the engine and only valid for the duration of FrameSink::writePacked().
+struct PackedFrames
+{
+    const std::byte* data = nullptr;
+    std::uint32_t frames = 0;
+};
+
+// Destination for frames drained from the bridge ring. ConsumerEngine calls open()
+// before the first block and again whenever the producer changes format (with a
+// close() in between), then write() once per drained block of at most
+// format.framesPerBlock frames. write() runs on the consumer thread, should not block
+// for longer than a block period and should not allocate; buffers belong in open().
+//
+// Float32 streams arrive through write(); integer streams (format views) through
+// writePacked(). A sink that only handles float should fail open() for anything else.
+class FrameSink
+{
+public:
+    virtual ~FrameSink() = default;
+
+    virtual bool open(const StreamFormat& format) = 0;
+    virtual bool write(const FrameSpans& frames) = 0;
+    virtual void close() = 0;
+
+    virtual bool writePacked(const PackedFrames&)
+    {
+        return false;
+    }
+
+    // Bytes the sink has copied out of the ring so far, for the engine's counters.
+    [[nodiscard]] virtual std::uint64_t getBytesCopied() const noexcept
+    {
+        return 0;
+    }
+};
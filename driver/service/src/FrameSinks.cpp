@@ -0,0 +1,358 @@
+#include "FrameSinks.h"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr std::uint16_t kWaveFormatPcm = 1;
+constexpr std::uint16_t kWaveFormatIeeeFloat = 3;
+
+#if !defined(_WIN32)
+constexpr int kPartialWriteTimeoutMs = 2;
+#endif
+
+void writeLittleEndian(std::FILE* file, std::uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+    {
+        std::fputc(static_cast<int>((value >> (8 * i)) & 0xFF), file);
+    }
+}
+} // namespace
+
+bool NullFrameSink::open(const StreamFormat&)
+{
+    return true;
+}
+
+bool NullFrameSink::write(const FrameSpans& frames)
+{
+    framesWritten += frames.totalFrames();
+    return true;
+}
+
+bool NullFrameSink::writePacked(const PackedFrames& frames)
+{
+    framesWritten += frames.frames;
+    return true;
+}
+
+void NullFrameSink::close()
+{
+}
+
+std::uint64_t NullFrameSink::getFramesWritten() const noexcept
+{
+    return framesWritten;
+}
+
+MemoryFrameSink::MemoryFrameSink(std::uint64_t maxFramesToKeep)
+    : maxFrames(maxFramesToKeep)
+{
+}
+
+bool MemoryFrameSink::open(const StreamFormat& newFormat)
+{
+    if (newFormat.sampleFormat != oceanaudio::BridgeSampleFormat::Float32)
+    {
+        return false;
+    }
+
+    format = newFormat;
+    samples.clear();
+    samples.reserve(static_cast<std::size_t>(maxFrames * format.channels));
+    framesDropped = 0;
+    return true;
+}
+
+bool MemoryFrameSink::write(const FrameSpans& frames)
+{
+    const auto droppedBefore = framesDropped;
+    append(frames.first, frames.firstFrames);
+    append(frames.second, frames.secondFrames);
+    return framesDropped == droppedBefore;
+}
+
+void MemoryFrameSink::close()
+{
+}
+
+std::uint64_t MemoryFrameSink::getBytesCopied() const noexcept
+{
+    return bytesCopied;
+}
+
+const std::vector<float>& MemoryFrameSink::getSamples() const noexcept
+{
+    return samples;
+}
+
+StreamFormat MemoryFrameSink::getFormat() const noexcept
+{
+    return format;
+}
+
+std::uint64_t MemoryFrameSink::getFramesDropped() const noexcept
+{
+    return framesDropped;
+}
+
+void MemoryFrameSink::append(const float* interleavedFrames, std::uint32_t frames)
+{
+    // Capacity was reserved in open(), so this never reallocates.
+    const auto framesKept = samples.size() / (format.channels != 0 ? format.channels : 1);
+    const auto room = maxFrames > framesKept ? maxFrames - framesKept : 0;
+    const auto framesToKeep = frames < room ? frames : room;
+    const auto samplesToKeep = static_cast<std::size_t>(framesToKeep) * format.channels;
+
+    samples.insert(samples.end(), interleavedFrames, interleavedFrames + samplesToKeep);
+    bytesCopied += samplesToKeep * sizeof(float);
+    framesDropped += frames - framesToKeep;
+}
+
+WavFileFrameSink::WavFileFrameSink(std::string path)
+    : basePath(std::move(path))
+{
+}
+
+WavFileFrameSink::~WavFileFrameSink()
+{
+    close();
+}
+
+bool WavFileFrameSink::open(const StreamFormat& newFormat)
+{
+    close();
+    format = newFormat;
+    dataBytes = 0;
+
+    auto path = basePath;
+    if (segmentIndex > 0)
+    {
+        const auto extension = path.rfind('.');
+        const auto index = std::to_string(segmentIndex);
+        std::string suffix;
+        suffix.reserve(index.size() + 1);
+        suffix += '-';
+        suffix += index;
+        path.insert(extension == std::string::npos ? path.size() : extension, suffix);
+    }
+    ++segmentIndex;
+
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    writeHeader(0);
+    return true;
+}
+
+bool WavFileFrameSink::write(const FrameSpans& frames)
+{
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    const bool firstWritten = writeFrames(frames.first, frames.firstFrames);
+    return writeFrames(frames.second, frames.secondFrames) && firstWritten;
+}
+
+bool WavFileFrameSink::writePacked(const PackedFrames& frames)
+{
+    return file != nullptr && writeFrames(frames.data, frames.frames);
+}
+
+void WavFileFrameSink::close()
+{
+    if (file == nullptr)
+    {
+        return;
+    }
+
+    std::fseek(file, 0, SEEK_SET);
+    writeHeader(dataBytes);
+    std::fclose(file);
+    file = nullptr;
+}
+
+std::uint64_t WavFileFrameSink::getBytesCopied() const noexcept
+{
+    return bytesCopied;
+}
+
+bool WavFileFrameSink::writeFrames(const void* interleavedFrames, std::uint32_t frames)
+{
+    if (frames == 0)
+    {
+        return true;
+    }
+
+    const std::size_t frameBytes = format.bytesPerFrame();
+    const auto written = std::fwrite(interleavedFrames, frameBytes, frames, file);
+    dataBytes += written * frameBytes;
+    bytesCopied += written * frameBytes;
+    return written == frames;
+}
+
+void WavFileFrameSink::writeHeader(std::uint64_t bytes)
+{
+    // Plain RIFF caps out at 4 GiB; clamp rather than wrap so players still open it.
+    const auto dataSize = static_cast<std::uint32_t>(bytes < 0xFFFFFFFFull - 36 ? bytes : 0xFFFFFFFFull - 36);
+    const std::uint32_t blockAlign = format.bytesPerFrame();
+    const bool isFloat = format.sampleFormat == oceanaudio::BridgeSampleFormat::Float32;
+
+    std::fwrite("RIFF", 1, 4, file);
+    writeLittleEndian(file, 36 + dataSize, 4);
+    std::fwrite("WAVEfmt ", 1, 8, file);
+    writeLittleEndian(file, 16, 4);
+    writeLittleEndian(file, isFloat ? kWaveFormatIeeeFloat : kWaveFormatPcm, 2);
+    writeLittleEndian(file, format.channels, 2);
+    writeLittleEndian(file, format.sampleRate, 4);
+    writeLittleEndian(file, format.sampleRate * blockAlign, 4);
+    writeLittleEndian(file, blockAlign, 2);
+    writeLittleEndian(file, 8 * oceanaudio::bytesPerSample(format.sampleFormat), 2);
+    std::fwrite("data", 1, 4, file);
+    writeLittleEndian(file, dataSize, 4);
+}
+
+#if !defined(_WIN32)
+FifoFrameSink::FifoFrameSink(std::string fifoPath)
+    : path(std::move(fifoPath))
+{
+}
+
+FifoFrameSink::~FifoFrameSink()
+{
+    close();
+}
+
+bool FifoFrameSink::open(const StreamFormat& newFormat)
+{
+    format = newFormat;
+    if (::mkfifo(path.c_str(), 0660) != 0 && errno != EEXIST)
+    {
+        return false;
+    }
+
+    ensureReaderConnected();
+    return true;
+}
+
+bool FifoFrameSink::write(const FrameSpans& frames)
+{
+    if (!ensureReaderConnected())
+    {
+        ++blocksDropped;
+        return false;
+    }
+
+    std::size_t blockBytesWritten = 0;
+    if (!writeRun(frames.first, frames.firstFrames, blockBytesWritten)
+        || !writeRun(frames.second, frames.secondFrames, blockBytesWritten))
+    {
+        ++blocksDropped;
+        return false;
+    }
+
+    return true;
+}
+
+bool FifoFrameSink::writePacked(const PackedFrames& frames)
+{
+    std::size_t blockBytesWritten = 0;
+    if (!ensureReaderConnected() || !writeRun(frames.data, frames.frames, blockBytesWritten))
+    {
+        ++blocksDropped;
+        return false;
+    }
+
+    return true;
+}
+
+void FifoFrameSink::close()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+std::uint64_t FifoFrameSink::getBytesCopied() const noexcept
+{
+    return bytesCopied;
+}
+
+std::uint64_t FifoFrameSink::getBlocksDropped() const noexcept
+{
+    return blocksDropped;
+}
+
+bool FifoFrameSink::ensureReaderConnected()
+{
+    if (fd >= 0)
+    {
+        return true;
+    }
+
+    // Opening the write end without a reader fails with ENXIO instead of blocking.
+    fd = ::open(path.c_str(), O_WRONLY | O_NONBLOCK);
+    return fd >= 0;
+}
+
+bool FifoFrameSink::writeRun(const void* interleavedFrames, std::uint32_t frames, std::size_t& blockBytesWritten)
+{
+    const auto* bytes = static_cast<const std::uint8_t*>(interleavedFrames);
+    const std::size_t totalBytes = static_cast<std::size_t>(frames) * format.bytesPerFrame();
+    std::size_t offset = 0;
+
+    while (offset < totalBytes)
+    {
+        const auto written = ::write(fd, bytes + offset, totalBytes - offset);
+        if (written > 0)
+        {
+            offset += static_cast<std::size_t>(written);
+            blockBytesWritten += static_cast<std::size_t>(written);
+            bytesCopied += static_cast<std::uint64_t>(written);
+            continue;
+        }
+
+        if (written < 0 && errno != EAGAIN)
+        {
+            // Reader went away (EPIPE); reconnect lazily on a later block.
+            close();
+            return false;
+        }
+
+        if (blockBytesWritten == 0)
+        {
+            // Pipe full and nothing of this block written yet: dropping the whole
+            // block keeps framing.
+            return false;
+        }
+
+        // Part of the block is already in the pipe; give the reader a moment to make
+        // room, and if it does not, drop the connection so it resynchronises.
+        pollfd descriptor {fd, POLLOUT, 0};
+        if (::poll(&descriptor, 1, kPartialWriteTimeoutMs) <= 0)
+        {
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
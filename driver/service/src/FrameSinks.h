@@ -0,0 +1,110 @@
+#pragma once
+
+#include "FrameSink.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Discards everything; used to measure the consumer on its own.
+class NullFrameSink final : public FrameSink
+{
+public:
+    bool open(const StreamFormat& format) override;
+    bool write(const FrameSpans& frames) override;
+    bool writePacked(const PackedFrames& frames) override;
+    void close() override;
+
+    [[nodiscard]] std::uint64_t getFramesWritten() const noexcept;
+
+private:
+    std::uint64_t framesWritten = 0;
+};
+
+// Keeps the stream in memory, up to a frame limit, for inspection in tools and
+// regression runs. Frames beyond the limit are counted but dropped. Float32 only.
+class MemoryFrameSink final : public FrameSink
+{
+public:
+    explicit MemoryFrameSink(std::uint64_t maxFramesToKeep);
+
+    bool open(const StreamFormat& format) override;
+    bool write(const FrameSpans& frames) override;
+    void close() override;
+
+    [[nodiscard]] std::uint64_t getBytesCopied() const noexcept override;
+
+    [[nodiscard]] const std::vector<float>& getSamples() const noexcept;
+    [[nodiscard]] StreamFormat getFormat() const noexcept;
+    [[nodiscard]] std::uint64_t getFramesDropped() const noexcept;
+
+private:
+    void append(const float* interleavedFrames, std::uint32_t frames);
+
+    std::uint64_t maxFrames;
+    StreamFormat format;
+    std::vector<float> samples;
+    std::uint64_t framesDropped = 0;
+    std::uint64_t bytesCopied = 0;
+};
+
+// Writes 32-bit float WAV, or 16/24-bit PCM WAV for integer format views. A format
+// change closes the current file and starts a new one with a numeric suffix, since a
+// WAV file cannot change format mid-stream.
+class WavFileFrameSink final : public FrameSink
+{
+public:
+    explicit WavFileFrameSink(std::string path);
+    ~WavFileFrameSink() override;
+
+    bool open(const StreamFormat& format) override;
+    bool write(const FrameSpans& frames) override;
+    bool writePacked(const PackedFrames& frames) override;
+    void close() override;
+
+    [[nodiscard]] std::uint64_t getBytesCopied() const noexcept override;
+
+private:
+    bool writeFrames(const void* interleavedFrames, std::uint32_t frames);
+    void writeHeader(std::uint64_t dataBytes);
+
+    std::string basePath;
+    int segmentIndex = 0;
+    std::FILE* file = nullptr;
+    StreamFormat format;
+    std::uint64_t dataBytes = 0;
+    std::uint64_t bytesCopied = 0;
+};
+
+#if !defined(_WIN32)
+// Streams raw interleaved samples, in the stream's sample format, to a named pipe
+// (created if missing). Writes do not block: while no reader is attached, or when the
+// reader falls behind, blocks are dropped and counted. The process should ignore
+// SIGPIPE so a departing reader surfaces as EPIPE.
+class FifoFrameSink final : public FrameSink
+{
+public:
+    explicit FifoFrameSink(std::string path);
+    ~FifoFrameSink() override;
+
+    bool open(const StreamFormat& format) override;
+    bool write(const FrameSpans& frames) override;
+    bool writePacked(const PackedFrames& frames) override;
+    void close() override;
+
+    [[nodiscard]] std::uint64_t getBytesCopied() const noexcept override;
+    [[nodiscard]] std::uint64_t getBlocksDropped() const noexcept;
+
+private:
+    bool ensureReaderConnected();
+    bool writeRun(const void* interleavedFrames,
+                  std::uint32_t frames,
+                  std::size_t& blockBytesWritten);
+
+    std::string path;
+    StreamFormat format;
+    int fd = -1;
+    std::uint64_t blocksDropped = 0;
+    std::uint64_t bytesCopied = 0;
+};
+#endif
@@ -0,0 +1,474 @@
+#include "JitterBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+// Two blocks are what the consumer needs in hand at its tick. The third covers jitter
+// until there is a measurement.
+constexpr std::uint32_t kDefaultMinTargetBlocks = 2;
+constexpr std::uint32_t kDefaultInitialTargetBlocks = 3;
+constexpr std::uint32_t kDefaultMaxTargetBlocks = 16;
+constexpr std::uint32_t kDefaultHeadroomBlocks = 4;
+
+// 15 ms grains hold at least one pitch period down to about 80 Hz; 2.5 ms crossfades
+// are long enough not to click and short enough not to smear.
+constexpr std::uint32_t kGrainsPerSecond = 1000 / 15;
+constexpr std::uint32_t kCrossfadesPerSecond = 400;
+
+// Time constant of the running mean the queue dips are measured against.
+constexpr double kMeanSmoothingSeconds = 0.5;
+
+// The target comes down a quarter block per hold, and a dropout's floor relaxes by the
+// same step after this many holds without another.
+constexpr std::uint32_t kShrinkStepsPerBlock = 4;
+constexpr double kFloorReleaseHolds = 20.0;
+
+// Normalised cross-correlation of two runs of interleaved samples; 0 for silence.
+double similarity(const float* first, const float* second, std::size_t samples) noexcept
+{
+    double cross = 0.0;
+    double firstEnergy = 0.0;
+    double secondEnergy = 0.0;
+    for (std::size_t index = 0; index < samples; ++index)
+    {
+        cross += static_cast<double>(first[index]) * second[index];
+        firstEnergy += static_cast<double>(first[index]) * first[index];
+        secondEnergy += static_cast<double>(second[index]) * second[index];
+    }
+
+    const double norm = std::sqrt(firstEnergy * secondEnergy);
+    return norm > 0.0 ? cross / norm : 0.0;
+}
+} // namespace
+
+const char* toString(OverrunPolicy policy) noexcept
+{
+    switch (policy)
+    {
+        case OverrunPolicy::DropOldest:
+            return "drop-oldest";
+        case OverrunPolicy::DropNewest:
+            return "drop-newest";
+        case OverrunPolicy::Squeeze:
+            return "squeeze";
+    }
+    return "unknown";
+}
+
+const char* toString(UnderrunConcealment concealment) noexcept
+{
+    switch (concealment)
+    {
+        case UnderrunConcealment::FadeToSilence:
+            return "fade";
+        case UnderrunConcealment::RepeatGrain:
+            return "repeat";
+    }
+    return "unknown";
+}
+
+void JitterBuffer::prepare(const StreamFormat& streamFormat,
+                           const Settings& bufferSettings,
+                           std::uint32_t initialTargetFrames,
+                           std::uint32_t ringCapacityFrames)
+{
+    format = streamFormat;
+    settings = bufferSettings;
+
+    const auto blockFrames = format.framesPerBlock;
+    maxTarget = settings.maxTargetFrames != 0 ? settings.maxTargetFrames : blockFrames * kDefaultMaxTargetBlocks;
+    if (ringCapacityFrames > blockFrames)
+    {
+        // The producer needs room for the block it is writing.
+        maxTarget = std::min(maxTarget, ringCapacityFrames - blockFrames);
+    }
+    minTarget = std::min(settings.minTargetFrames != 0 ? settings.minTargetFrames
+                                                       : blockFrames * kDefaultMinTargetBlocks,
+                         maxTarget);
+
+    target = initialTargetFrames != 0 ? initialTargetFrames : blockFrames * kDefaultInitialTargetBlocks;
+    target = settings.adaptive ? std::clamp(target, minTarget, maxTarget) : std::min(target, maxTarget);
+
+    grain = std::max(settings.grainFrames != 0 ? settings.grainFrames : format.sampleRate / kGrainsPerSecond, 4u);
+    crossfade = std::clamp(settings.crossfadeFrames != 0 ? settings.crossfadeFrames
+                                                         : format.sampleRate / kCrossfadesPerSecond,
+                           1u,
+                           grain / 2);
+    headroom = settings.overrunHeadroomFrames != 0 ? settings.overrunHeadroomFrames
+                                                   : blockFrames * kDefaultHeadroomBlocks;
+    maxConcealFrames = static_cast<std::uint32_t>(static_cast<std::uint64_t>(format.sampleRate)
+                                                  * settings.maxConcealMilliseconds / 1000);
+
+    meanQueued = 0.0;
+    jitterPeak = 0.0;
+    observed = false;
+    underrunFloor = minTarget;
+    secondsSinceChange = 0.0;
+    secondsSinceUnderrun = 0.0;
+    framesUntilDrop = 0;
+    pendingDrop = 0;
+    pendingSqueeze = 0;
+
+    // A squeezed read is what the resampler asks for (a block and a few frames) plus
+    // the grain to splice out.
+    squeezeBuffer.assign(static_cast<std::size_t>(2 * blockFrames + grain) * format.channels, 0.0f);
+    history.assign(static_cast<std::size_t>(grain) * format.channels, 0.0f);
+    concealLoop.assign(static_cast<std::size_t>(grain) * format.channels, 0.0f);
+    loopFrames = 0;
+    concealedSoFar = 0;
+    playing = false;
+
+    stats = {};
+    stats.targetLatencyFrames = target;
+}
+
+std::uint32_t JitterBuffer::observe(double queuedFrames, double elapsedSeconds)
+{
+    if (!settings.adaptive)
+    {
+        return target;
+    }
+
+    // Only steady playout says anything about jitter: while priming, squeezing or just
+    // after a drop the level moves for reasons of our own. Nor does it count towards a
+    // hold.
+    if (!observed || !playing || pendingSqueeze != 0)
+    {
+        meanQueued = queuedFrames;
+        observed = playing && pendingSqueeze == 0;
+        return target;
+    }
+
+    const double dip = meanQueued - queuedFrames;
+    const double decay = settings.jitterHalfLifeSeconds > 0.0
+                             ? std::exp2(-elapsedSeconds / settings.jitterHalfLifeSeconds)
+                             : 0.0;
+    jitterPeak = std::max(dip, jitterPeak * decay);
+    meanQueued += (1.0 - std::exp(-elapsedSeconds / kMeanSmoothingSeconds)) * (queuedFrames - meanQueued);
+
+    updateTarget(elapsedSeconds);
+    return target;
+}
+
+std::uint32_t JitterBuffer::getPrefillFrames() const noexcept
+{
+    return settings.prefillFrames != 0 ? settings.prefillFrames : target;
+}
+
+std::uint32_t JitterBuffer::getTargetLatencyFrames() const noexcept
+{
+    return target;
+}
+
+std::uint32_t JitterBuffer::getSurplusInputFrames() const noexcept
+{
+    return settings.overrunPolicy == OverrunPolicy::Squeeze ? grain : 0;
+}
+
+std::uint32_t JitterBuffer::planOverrun(double queuedFrames, std::uint32_t ringFrames)
+{
+    if (pendingDrop != 0 || pendingSqueeze != 0 || queuedFrames <= static_cast<double>(target + headroom))
+    {
+        return 0;
+    }
+
+    const auto excess = std::min(static_cast<std::uint32_t>(queuedFrames - target), ringFrames);
+    if (excess == 0)
+    {
+        return 0;
+    }
+
+    ++stats.overruns;
+    switch (settings.overrunPolicy)
+    {
+        case OverrunPolicy::DropOldest:
+            stats.framesDropped += excess;
+            observed = false;
+            return excess;
+        case OverrunPolicy::DropNewest:
+            framesUntilDrop = ringFrames - excess;
+            pendingDrop = excess;
+            return 0;
+        case OverrunPolicy::Squeeze:
+            pendingSqueeze = excess;
+            return 0;
+    }
+    return 0;
+}
+
+std::uint32_t JitterBuffer::readLimit(std::uint32_t wanted) const noexcept
+{
+    if (pendingDrop != 0 && framesUntilDrop < wanted)
+    {
+        return static_cast<std::uint32_t>(framesUntilDrop);
+    }
+    return wanted;
+}
+
+std::uint32_t JitterBuffer::takeDueDrop() noexcept
+{
+    if (pendingDrop == 0 || framesUntilDrop != 0)
+    {
+        return 0;
+    }
+
+    const auto drop = pendingDrop;
+    pendingDrop = 0;
+    stats.framesDropped += drop;
+    observed = false;
+    return drop;
+}
+
+std::uint32_t JitterBuffer::squeezeFrames() const noexcept
+{
+    return pendingSqueeze != 0 ? grain : 0;
+}
+
+FrameSpans JitterBuffer::consume(const FrameSpans& frames)
+{
+    const auto total = frames.totalFrames();
+    if (pendingDrop != 0)
+    {
+        framesUntilDrop -= std::min<std::uint64_t>(framesUntilDrop, total);
+    }
+
+    if (pendingSqueeze == 0 || static_cast<std::size_t>(total) * format.channels > squeezeBuffer.size())
+    {
+        return frames;
+    }
+    return spliceGrain(frames);
+}
+
+void JitterBuffer::finishBlock(float* interleavedBlock, std::uint32_t renderedFrames)
+{
+    const auto channels = format.channels;
+    const auto blockFrames = format.framesPerBlock;
+
+    if (renderedFrames > 0 && !playing)
+    {
+        // Playback (re)starts: fade in, out of whatever concealment is still sounding.
+        ++stats.prefills;
+        const auto fade = std::min(crossfade, renderedFrames);
+        for (std::uint32_t frame = 0; frame < fade; ++frame)
+        {
+            const float weight = (static_cast<float>(frame) + 0.5f) / static_cast<float>(fade);
+            const float gain = (1.0f - weight) * concealGain(concealedSoFar + frame);
+            const float* concealed = loopFrame(concealedSoFar + frame);
+            float* destination = interleavedBlock + static_cast<std::size_t>(frame) * channels;
+            for (std::uint32_t channel = 0; channel < channels; ++channel)
+            {
+                destination[channel] = weight * destination[channel] + gain * concealed[channel];
+            }
+        }
+        playing = true;
+    }
+
+    if (renderedFrames > 0)
+    {
+        rememberTail(interleavedBlock, renderedFrames);
+    }
+
+    if (renderedFrames == blockFrames)
+    {
+        return;
+    }
+
+    if (playing)
+    {
+        // A dropout: whatever the jitter estimate said, the target was short. Grow by a
+        // block now and keep a step above this level until it has stayed quiet a while.
+        ++stats.underruns;
+        if (settings.adaptive)
+        {
+            const auto step = std::max(blockFrames / kShrinkStepsPerBlock, 1u);
+            underrunFloor = std::min(target + step, maxTarget);
+            target = std::min(target + blockFrames, maxTarget);
+            secondsSinceChange = 0.0;
+            secondsSinceUnderrun = 0.0;
+        }
+        updateTarget(0.0);
+        playing = false;
+        observed = false;
+        buildConcealLoop();
+        concealedSoFar = 0;
+    }
+
+    // The compensator already padded with silence; concealment replaces the start of it.
+    for (std::uint32_t frame = renderedFrames; frame < blockFrames; ++frame)
+    {
+        const float gain = concealGain(concealedSoFar);
+        if (gain <= 0.0f)
+        {
+            break;
+        }
+
+        const float* concealed = loopFrame(concealedSoFar);
+        float* destination = interleavedBlock + static_cast<std::size_t>(frame) * channels;
+        for (std::uint32_t channel = 0; channel < channels; ++channel)
+        {
+            destination[channel] = gain * concealed[channel];
+        }
+        ++concealedSoFar;
+        ++stats.concealedFrames;
+    }
+}
+
+JitterBuffer::Statistics JitterBuffer::getStatistics() const noexcept
+{
+    return stats;
+}
+
+void JitterBuffer::updateTarget(double elapsedSeconds) noexcept
+{
+    if (settings.adaptive)
+    {
+        const auto step = std::max(format.framesPerBlock / kShrinkStepsPerBlock, 1u);
+        const auto hold = settings.shrinkHoldSeconds;
+        secondsSinceChange += elapsedSeconds;
+        secondsSinceUnderrun += elapsedSeconds;
+        if (underrunFloor > minTarget && secondsSinceUnderrun >= kFloorReleaseHolds * hold)
+        {
+            underrunFloor = std::max(underrunFloor - std::min(step, underrunFloor), minTarget);
+            secondsSinceUnderrun = 0.0;
+        }
+
+        const double wanted = std::ceil(minTarget + settings.jitterSafetyFactor * jitterPeak);
+        const auto goal = static_cast<std::uint32_t>(std::clamp(wanted, static_cast<double>(underrunFloor),
+                                                                static_cast<double>(maxTarget)));
+        if (goal > target)
+        {
+            target = goal;
+            secondsSinceChange = 0.0;
+        }
+        else if (goal < target && secondsSinceChange >= hold)
+        {
+            target = std::max(goal, target - std::min(step, target));
+            secondsSinceChange = 0.0;
+        }
+    }
+    stats.targetLatencyFrames = target;
+    stats.jitterFrames = jitterPeak;
+}
+
+FrameSpans JitterBuffer::spliceGrain(const FrameSpans& frames)
+{
+    const auto channels = format.channels;
+    const auto total = frames.totalFrames();
+    if (total < 2 * crossfade)
+    {
+        return frames;
+    }
+
+    float* samples = squeezeBuffer.data();
+    std::memcpy(samples, frames.first, static_cast<std::size_t>(frames.firstFrames) * channels * sizeof(float));
+    std::memcpy(samples + static_cast<std::size_t>(frames.firstFrames) * channels,
+                frames.second,
+                static_cast<std::size_t>(frames.secondFrames) * channels * sizeof(float));
+
+    // Cut out the lag (at most a grain) whose far side best matches the start, so the
+    // splice lands a whole number of pitch periods ahead.
+    const auto longestLag = std::min(grain, total - crossfade);
+    const auto fadeSamples = static_cast<std::size_t>(crossfade) * channels;
+    auto lag = longestLag;
+    double bestScore = -2.0;
+    for (auto candidate = crossfade; candidate <= longestLag; ++candidate)
+    {
+        const double score = similarity(samples, samples + static_cast<std::size_t>(candidate) * channels, fadeSamples);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            lag = candidate;
+        }
+    }
+
+    for (std::uint32_t frame = 0; frame < crossfade; ++frame)
+    {
+        const float weight = (static_cast<float>(frame) + 0.5f) / static_cast<float>(crossfade);
+        float* destination = samples + static_cast<std::size_t>(frame) * channels;
+        const float* later = destination + static_cast<std::size_t>(lag) * channels;
+        for (std::uint32_t channel = 0; channel < channels; ++channel)
+        {
+            destination[channel] = (1.0f - weight) * destination[channel] + weight * later[channel];
+        }
+    }
+    std::memmove(samples + fadeSamples,
+                 samples + fadeSamples + static_cast<std::size_t>(lag) * channels,
+                 static_cast<std::size_t>(total - crossfade - lag) * channels * sizeof(float));
+
+    pendingSqueeze -= std::min(lag, pendingSqueeze);
+    stats.framesSqueezed += lag;
+
+    FrameSpans squeezed;
+    squeezed.first = samples;
+    squeezed.firstFrames = total - lag;
+    return squeezed;
+}
+
+void JitterBuffer::rememberTail(const float* interleavedBlock, std::uint32_t frames)
+{
+    const auto channels = format.channels;
+    const auto kept = std::min(frames, grain);
+    std::memmove(history.data(),
+                 history.data() + static_cast<std::size_t>(kept) * channels,
+                 static_cast<std::size_t>(grain - kept) * channels * sizeof(float));
+    std::memcpy(history.data() + static_cast<std::size_t>(grain - kept) * channels,
+                interleavedBlock + static_cast<std::size_t>(frames - kept) * channels,
+                static_cast<std::size_t>(kept) * channels * sizeof(float));
+}
+
+void JitterBuffer::buildConcealLoop()
+{
+    // Loop the last `period` frames of history, with the period chosen so the audio
+    // just before the loop matches the audio just before its end; the loop then
+    // continues the waveform where playback stopped. The loop's last crossfade blends
+    // back into what preceded its start, so every wrap is seamless too.
+    const auto channels = format.channels;
+    const auto fadeSamples = static_cast<std::size_t>(crossfade) * channels;
+    const float* tail = history.data() + static_cast<std::size_t>(grain - crossfade) * channels;
+
+    auto period = grain - crossfade;
+    double bestScore = -2.0;
+    for (auto candidate = crossfade; candidate <= grain - crossfade; ++candidate)
+    {
+        const double score = similarity(tail - static_cast<std::size_t>(candidate) * channels, tail, fadeSamples);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            period = candidate;
+        }
+    }
+
+    const float* start = history.data() + static_cast<std::size_t>(grain - period) * channels;
+    std::memcpy(concealLoop.data(), start, static_cast<std::size_t>(period - crossfade) * channels * sizeof(float));
+    for (std::uint32_t frame = 0; frame < crossfade; ++frame)
+    {
+        const float weight = (static_cast<float>(frame) + 0.5f) / static_cast<float>(crossfade);
+        float* destination = concealLoop.data() + static_cast<std::size_t>(period - crossfade + frame) * channels;
+        const float* end = tail + static_cast<std::size_t>(frame) * channels;
+        const float* beforeStart = end - static_cast<std::size_t>(period) * channels;
+        for (std::uint32_t channel = 0; channel < channels; ++channel)
+        {
+            destination[channel] = (1.0f - weight) * end[channel] + weight * beforeStart[channel];
+        }
+    }
+    loopFrames = period;
+}
+
+float JitterBuffer::concealGain(std::uint32_t frame) const noexcept
+{
+    // Both modes ramp down linearly; FadeToSilence just does it within one grain.
+    const auto length = settings.concealment == UnderrunConcealment::RepeatGrain ? maxConcealFrames : grain;
+    if (loopFrames == 0 || frame >= length)
+    {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(frame) / static_cast<float>(length);
+}
+
+const float* JitterBuffer::loopFrame(std::uint32_t frame) const noexcept
+{
+    return concealLoop.data() + static_cast<std::size_t>(loopFrames != 0 ? frame % loopFrames : 0) * format.channels;
+}
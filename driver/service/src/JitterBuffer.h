@@ -0,0 +1,173 @@
+#pragma once
+
+#include "FrameSink.h"
+
+#include <cstdint>
+#include <vector>
+
+// What the jitter buffer does when far more audio is queued than its target (a backlog
+// from before the consumer attached, a stall upstream, a burst from the producer).
+enum class OverrunPolicy : std::uint32_t
+{
+    // Skip the oldest excess in one go: lowest latency, one discontinuity.
+    DropOldest = 0,
+    // Play what is queued up to the target, then skip the excess that arrived after it.
+    DropNewest = 1,
+    // Splice out one pitch-aligned grain per block until the excess is gone. No skip,
+    // but the backlog takes a few blocks to work off.
+    Squeeze = 2,
+};
+
+// What the output does while the queue is dry.
+enum class UnderrunConcealment : std::uint32_t
+{
+    // Fade the last audio out over one grain, then silence.
+    FadeToSilence = 0,
+    // Keep repeating the last grain, crossfaded and decaying, then silence.
+    RepeatGrain = 1,
+};
+
+[[nodiscard]] const char* toString(OverrunPolicy policy) noexcept;
+[[nodiscard]] const char* toString(UnderrunConcealment concealment) noexcept;
+
+// Playout policy for the consumer's clocked path, on top of DriftCompensator: it picks
+// the latency target, decides how much to prefill, handles overruns and conceals
+// underruns. Every block it looks at how far the queued audio dips below its own
+// running mean; a decaying peak of that dip is the jitter the consumer has to ride
+// out, and the target is the minimum plus a safety multiple of it.
+//
+// The target grows at once and shrinks reluctantly: only after a hold period in which
+// it neither grew nor dropped out, and then a quarter block at a time. A dropout adds
+// a block on the spot and leaves a floor a step above the level it happened at, which
+// only relaxes after many dropout-free holds. Quiet machines therefore settle a little
+// above the lowest level that plays without dropouts, noisy ones at whatever they need.
+//
+// Buffers are sized by prepare(); nothing allocates per block.
+class JitterBuffer
+{
+public:
+    struct Settings
+    {
+        // Follow the observed jitter; otherwise the target stays where prepare() put it.
+        bool adaptive = true;
+        // Bounds on the adaptive target; 0 picks two blocks and sixteen blocks.
+        std::uint32_t minTargetFrames = 0;
+        std::uint32_t maxTargetFrames = 0;
+        // Target multiple of the jitter peak, and how long that peak takes to halve
+        // once the jitter dies down.
+        double jitterSafetyFactor = 2.0;
+        double jitterHalfLifeSeconds = 10.0;
+        // How long the target waits after growing, a dropout or a step down before it
+        // takes the next step down.
+        double shrinkHoldSeconds = 30.0;
+        // Queue level to wait for before playing (and again after a dropout); 0
+        // follows the target.
+        std::uint32_t prefillFrames = 0;
+        OverrunPolicy overrunPolicy = OverrunPolicy::DropOldest;
+        // Excess over the target that counts as an overrun; 0 means four blocks. Less
+        // is left to the drift controller's trim.
+        std::uint32_t overrunHeadroomFrames = 0;
+        UnderrunConcealment concealment = UnderrunConcealment::FadeToSilence;
+        // Grain and crossfade lengths for concealment and squeezing; 0 picks 15 ms and
+        // 2.5 ms.
+        std::uint32_t grainFrames = 0;
+        std::uint32_t crossfadeFrames = 0;
+        // How long RepeatGrain keeps going before it gives up to silence.
+        std::uint32_t maxConcealMilliseconds = 60;
+    };
+
+    struct Statistics
+    {
+        std::uint32_t targetLatencyFrames = 0;
+        double jitterFrames = 0.0;
+        // Dropouts (the queue ran dry mid-playout) and what covered them.
+        std::uint64_t underruns = 0;
+        std::uint64_t concealedFrames = 0;
+        std::uint64_t prefills = 0;
+        std::uint64_t overruns = 0;
+        std::uint64_t framesDropped = 0;
+        std::uint64_t framesSqueezed = 0;
+    };
+
+    void prepare(const StreamFormat& streamFormat,
+                 const Settings& bufferSettings,
+                 std::uint32_t initialTargetFrames,
+                 std::uint32_t ringCapacityFrames);
+
+    // Once per clocked block, before anything is read: updates the jitter estimate
+    // from the queue level (see DriftCompensator::estimateQueuedFrames) and returns the
+    // target the drift compensator should hold.
+    std::uint32_t observe(double queuedFrames, double elapsedSeconds);
+    // Queue level the compensator should wait for before playing.
+    [[nodiscard]] std::uint32_t getPrefillFrames() const noexcept;
+    [[nodiscard]] std::uint32_t getTargetLatencyFrames() const noexcept;
+    // Input beyond what the compensator asked for that consume() may hand it in one
+    // block (the part of a squeezed read left after the splice); size its staging for it.
+    [[nodiscard]] std::uint32_t getSurplusInputFrames() const noexcept;
+
+    // Checks for an overrun given the queue estimate and what is actually in the ring.
+    // Returns the frames to skip right away (DropOldest); DropNewest and Squeeze are
+    // scheduled and worked off through the calls below.
+    std::uint32_t planOverrun(double queuedFrames, std::uint32_t ringFrames);
+
+    // Limits a read of `wanted` ring frames so it stops where a scheduled drop starts.
+    [[nodiscard]] std::uint32_t readLimit(std::uint32_t wanted) const noexcept;
+    // Frames to skip before the next read (a DropNewest drop that is now due).
+    std::uint32_t takeDueDrop() noexcept;
+    // Extra ring frames to read this block so a grain can be spliced out.
+    [[nodiscard]] std::uint32_t squeezeFrames() const noexcept;
+
+    // Accounts for ring frames read (and, with a squeeze pending, splices a grain out
+    // of them). Returns what to push into the compensator: `frames` itself, or a span
+    // over an internal buffer valid until the next call.
+    FrameSpans consume(const FrameSpans& frames);
+
+    // After DriftCompensator::renderBlock(): `renderedFrames` of the block are audio,
+    // the rest is padding. Conceals a shortfall and fades playback back in after one.
+    void finishBlock(float* interleavedBlock, std::uint32_t renderedFrames);
+
+    [[nodiscard]] Statistics getStatistics() const noexcept;
+
+private:
+    void updateTarget(double elapsedSeconds) noexcept;
+    FrameSpans spliceGrain(const FrameSpans& frames);
+    void rememberTail(const float* interleavedBlock, std::uint32_t frames);
+    void buildConcealLoop();
+    [[nodiscard]] float concealGain(std::uint32_t frame) const noexcept;
+    [[nodiscard]] const float* loopFrame(std::uint32_t frame) const noexcept;
+
+    StreamFormat format;
+    Settings settings;
+    std::uint32_t minTarget = 0;
+    std::uint32_t maxTarget = 0;
+    std::uint32_t target = 0;
+    std::uint32_t grain = 0;
+    std::uint32_t crossfade = 0;
+    std::uint32_t headroom = 0;
+
+    double meanQueued = 0.0;
+    double jitterPeak = 0.0;
+    bool observed = false;
+    // Hysteresis: the floor left by the last dropout and the time since the target
+    // last moved (or played out) and since that dropout.
+    std::uint32_t underrunFloor = 0;
+    double secondsSinceChange = 0.0;
+    double secondsSinceUnderrun = 0.0;
+
+    // DropNewest: frames still to read before the drop, and the drop itself.
+    std::uint64_t framesUntilDrop = 0;
+    std::uint32_t pendingDrop = 0;
+    // Squeeze: excess still to splice out.
+    std::uint32_t pendingSqueeze = 0;
+    std::vector<float> squeezeBuffer;
+
+    // Last grain of audio played, and the loop cut from it at a dropout.
+    std::vector<float> history;
+    std::vector<float> concealLoop;
+    std::uint32_t loopFrames = 0;
+    std::uint32_t concealedSoFar = 0;
+    std::uint32_t maxConcealFrames = 0;
+    bool playing = false;
+
+    Statistics stats;
+};
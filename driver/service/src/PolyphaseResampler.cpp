@@ -0,0 +1,217 @@
+#include "PolyphaseResampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+// Beyond this the coefficient table stops fitting in cache; such ratios (e.g.
+// 44100 -> 47999) are not worth a view.
+constexpr std::uint32_t kMaxUpFactor = 1024;
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Zeroth-order modified Bessel function of the first kind, by its power series.
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    const double quarterSquare = x * x * 0.25;
+    for (int k = 1; k < 64 && term > sum * 1.0e-12; ++k)
+    {
+        term *= quarterSquare / (static_cast<double>(k) * k);
+        sum += term;
+    }
+    return sum;
+}
+} // namespace
+
+bool PolyphaseResampler::prepare(std::uint32_t numChannels,
+                                 std::uint32_t inputRate,
+                                 std::uint32_t outputRate,
+                                 std::uint32_t maxInputFrames)
+{
+    return prepare(numChannels, inputRate, outputRate, maxInputFrames, Settings {});
+}
+
+bool PolyphaseResampler::prepare(std::uint32_t numChannels,
+                                 std::uint32_t inputRate,
+                                 std::uint32_t outputRate,
+                                 std::uint32_t maxInputFrames,
+                                 const Settings& resamplerSettings)
+{
+    if (numChannels == 0 || inputRate == 0 || outputRate == 0 || resamplerSettings.tapsPerPhase == 0)
+    {
+        return false;
+    }
+
+    const auto divisor = std::gcd(inputRate, outputRate);
+    upFactor = outputRate / divisor;
+    downFactor = inputRate / divisor;
+    if (upFactor > kMaxUpFactor)
+    {
+        return false;
+    }
+
+    channels = numChannels;
+    maxInput = maxInputFrames;
+    const double widening = std::max(1.0, static_cast<double>(downFactor) / upFactor);
+    taps = static_cast<std::uint32_t>(std::ceil(resamplerSettings.tapsPerPhase * widening));
+
+    // Prototype at L times the input rate. The cutoff sits midway through the
+    // transition band, which starts at passbandFraction of the lower Nyquist.
+    const auto length = static_cast<std::size_t>(upFactor) * taps;
+    const double cutoff = 0.5 * (1.0 + resamplerSettings.passbandFraction) * 0.5
+                          / std::max(upFactor, downFactor);
+    const double centre = 0.5 * static_cast<double>(length - 1);
+    const double windowNorm = besselI0(resamplerSettings.kaiserBeta);
+
+    std::vector<double> prototype(length);
+    double sum = 0.0;
+    for (std::size_t n = 0; n < length; ++n)
+    {
+        const double offset = static_cast<double>(n) - centre;
+        const double argument = 2.0 * cutoff * offset;
+        const double sinc = argument == 0.0 ? 1.0 : std::sin(kPi * argument) / (kPi * argument);
+        const double ratio = length > 1 ? offset / centre : 0.0;
+        const double window = besselI0(resamplerSettings.kaiserBeta * std::sqrt(std::max(0.0, 1.0 - ratio * ratio)))
+                              / windowNorm;
+        prototype[n] = sinc * window;
+        sum += prototype[n];
+    }
+
+    // Zero-stuffing by L divides the level by L; a DC gain of L restores it.
+    const double gain = static_cast<double>(upFactor) / sum;
+    coefficients.assign(length, 0.0f);
+    for (std::uint32_t p = 0; p < upFactor; ++p)
+    {
+        for (std::uint32_t t = 0; t < taps; ++t)
+        {
+            const auto source = static_cast<std::size_t>(p) + static_cast<std::size_t>(taps - 1 - t) * upFactor;
+            coefficients[static_cast<std::size_t>(p) * taps + t] = static_cast<float>(prototype[source] * gain);
+        }
+    }
+
+    history.assign(static_cast<std::size_t>(taps - 1 + maxInput) * channels, 0.0f);
+    accumulators.assign(channels, 0.0f);
+    reset();
+    return true;
+}
+
+void PolyphaseResampler::reset()
+{
+    std::fill(history.begin(), history.end(), 0.0f);
+    bufferedFrames = taps > 0 ? taps - 1 : 0;
+    position = bufferedFrames;
+    phase = 0;
+}
+
+std::uint32_t PolyphaseResampler::maxOutputFrames(std::uint32_t inputFrames) const noexcept
+{
+    const auto upsampled = static_cast<std::uint64_t>(inputFrames) * upFactor + upFactor;
+    return static_cast<std::uint32_t>(upsampled / downFactor) + 2;
+}
+
+std::uint32_t PolyphaseResampler::process(const float* interleavedInput,
+                                          std::uint32_t inputFrames,
+                                          float* interleavedOutput)
+{
+    inputFrames = std::min(inputFrames, maxInput);
+    std::memcpy(history.data() + static_cast<std::size_t>(bufferedFrames) * channels,
+                interleavedInput,
+                static_cast<std::size_t>(inputFrames) * channels * sizeof(float));
+    bufferedFrames += inputFrames;
+
+    std::uint32_t produced = 0;
+    while (position < bufferedFrames)
+    {
+        const float* frames = history.data() + static_cast<std::size_t>(position - (taps - 1)) * channels;
+        const float* phaseTaps = coefficients.data() + static_cast<std::size_t>(phase) * taps;
+        float* destination = interleavedOutput + static_cast<std::size_t>(produced) * channels;
+
+        if (channels == 1)
+        {
+            // Four partial sums break the add dependency chain.
+            float sums[4] = {};
+            std::uint32_t t = 0;
+            for (; t + 4 <= taps; t += 4)
+            {
+                sums[0] += phaseTaps[t] * frames[t];
+                sums[1] += phaseTaps[t + 1] * frames[t + 1];
+                sums[2] += phaseTaps[t + 2] * frames[t + 2];
+                sums[3] += phaseTaps[t + 3] * frames[t + 3];
+            }
+            for (; t < taps; ++t)
+            {
+                sums[0] += phaseTaps[t] * frames[t];
+            }
+            destination[0] = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        }
+        else if (channels == 2)
+        {
+            float left = 0.0f;
+            float right = 0.0f;
+            for (std::uint32_t t = 0; t < taps; ++t)
+            {
+                left += phaseTaps[t] * frames[2 * t];
+                right += phaseTaps[t] * frames[2 * t + 1];
+            }
+            destination[0] = left;
+            destination[1] = right;
+        }
+        else
+        {
+            std::fill(accumulators.begin(), accumulators.end(), 0.0f);
+            for (std::uint32_t t = 0; t < taps; ++t)
+            {
+                const float* frame = frames + static_cast<std::size_t>(t) * channels;
+                for (std::uint32_t channel = 0; channel < channels; ++channel)
+                {
+                    accumulators[channel] += phaseTaps[t] * frame[channel];
+                }
+            }
+            std::copy(accumulators.begin(), accumulators.end(), destination);
+        }
+
+        ++produced;
+        phase += downFactor;
+        position += phase / upFactor;
+        phase %= upFactor;
+    }
+
+    // Keep the taps - 1 frames the next output reaches back over.
+    const auto discard = std::min(position - (taps - 1), bufferedFrames);
+    if (discard > 0)
+    {
+        std::memmove(history.data(),
+                     history.data() + static_cast<std::size_t>(discard) * channels,
+                     static_cast<std::size_t>(bufferedFrames - discard) * channels * sizeof(float));
+        bufferedFrames -= discard;
+        position -= discard;
+    }
+
+    return produced;
+}
+
+std::uint32_t PolyphaseResampler::getUpFactor() const noexcept
+{
+    return upFactor;
+}
+
+std::uint32_t PolyphaseResampler::getDownFactor() const noexcept
+{
+    return downFactor;
+}
+
+std::uint32_t PolyphaseResampler::getTapsPerPhase() const noexcept
+{
+    return taps;
+}
+
+double PolyphaseResampler::getLatencyFrames() const noexcept
+{
+    const double prototypeDelay = 0.5 * (static_cast<double>(upFactor) * taps - 1.0);
+    return prototypeDelay / downFactor;
+}
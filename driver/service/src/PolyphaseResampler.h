@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Fixed-ratio resampler for interleaved float frames, for format views at another rate
+// than the device's (e.g. 48 kHz -> 16 kHz for voice apps, 44.1 kHz -> 48 kHz). The
+// ratio is reduced to L/M; a Kaiser-windowed sinc low-pass is designed once at L times
+// the input rate and split into L phases, so each output frame costs one short dot
+// product per channel. When decimating the cutoff follows the output rate and the
+// filter grows by M/L to keep the same transition band.
+//
+// prepare() allocates; process() never does. Unlike DriftResampler this one is for
+// large, fixed conversions, where cubic interpolation would alias audibly.
+class PolyphaseResampler
+{
+public:
+    struct Settings
+    {
+        // Taps per phase before decimation widening; 32 gives about 0.1 dB of passband
+        // ripple up to 0.9 * Nyquist and 80 dB of stop-band rejection.
+        std::uint32_t tapsPerPhase = 32;
+        double passbandFraction = 0.9;
+        double kaiserBeta = 8.0;
+    };
+
+    bool prepare(std::uint32_t numChannels,
+                 std::uint32_t inputRate,
+                 std::uint32_t outputRate,
+                 std::uint32_t maxInputFrames,
+                 const Settings& resamplerSettings);
+    bool prepare(std::uint32_t numChannels,
+                 std::uint32_t inputRate,
+                 std::uint32_t outputRate,
+                 std::uint32_t maxInputFrames);
+    void reset();
+
+    // Largest number of frames process() can produce for `inputFrames` input frames.
+    [[nodiscard]] std::uint32_t maxOutputFrames(std::uint32_t inputFrames) const noexcept;
+
+    // Consumes up to the prepared maximum of input frames and writes the output frames
+    // that became computable; returns how many.
+    std::uint32_t process(const float* interleavedInput, std::uint32_t inputFrames, float* interleavedOutput);
+
+    [[nodiscard]] std::uint32_t getUpFactor() const noexcept;
+    [[nodiscard]] std::uint32_t getDownFactor() const noexcept;
+    [[nodiscard]] std::uint32_t getTapsPerPhase() const noexcept;
+    // Group delay in output frames.
+    [[nodiscard]] double getLatencyFrames() const noexcept;
+
+private:
+    std::uint32_t channels = 0;
+    std::uint32_t upFactor = 1;
+    std::uint32_t downFactor = 1;
+    std::uint32_t taps = 0;
+    std::uint32_t maxInput = 0;
+    // Phase p's taps in coefficients[p * taps ...], ordered oldest input frame first.
+    std::vector<float> coefficients;
+    std::vector<float> history;
+    std::vector<float> accumulators;
+    std::uint32_t bufferedFrames = 0;
+    std::uint32_t position = 0;
+    std::uint32_t phase = 0;
+};
@@ -0,0 +1,522 @@
+#include "BridgeRecorder.h"
+#include "ConsumerEngine.h"
+#include "DirectBridgeSupervisor.h"
+#include "FrameSinks.h"
+#include "StandInCapture.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Console stand-in for OceanAudioBridgeService on POSIX systems: attaches to the ring
+// the host publishes through shm_open and feeds a stand-in sink in place of the
+// virtual microphone driver, printing throughput once a second.
+//
+// Usage: OceanAudioBridgeConsumer [--sink null|memory|wav|fifo] [--path PATH]
+//                                 [--spin-us N] [--drift 0|1] [--target-frames N]
+//                                 [--adaptive 0|1] [--prefill-frames N]
+//                                 [--overrun drop-oldest|drop-newest|squeeze]
+//                                 [--conceal fade|repeat]
+//                                 [--lag-policy stall|skip|detach] [--format f32|s16|s24]
+//                                 [--view-rate N] [--view-channels N] [--lock-memory 0|1]
+//                                 [--producer-timeout-ms N] [--direct 0|1]
+//                                 [--transport named|socket] [--socket-path PATH]
+//                                 [--integrity 0|1] [--record PATH] [--record-format wav|raw]
+//                                 [--cpu N] [--seconds N]
+//
+// Several consumers can run at once; each takes its own reader slot on the ring and
+// may ask for its own format view (sample format, rate, channel count).
+//
+// --direct 1 runs Direct mode instead: a StandInCapture plays the driver, maps the
+// ring itself and reads it on its own clock, and this process only supervises
+// (DirectBridgeSupervisor). Sinks, format views and drift options do not apply there.
+//
+// --transport socket (Linux) takes the ring from the host's Unix socket instead of
+// opening /OceanAudio_AudioRing by name; the host must publish with the socket
+// transport too. --socket-path defaults to $XDG_RUNTIME_DIR/OceanAudio_AudioRing.sock.
+// Direct mode only uses the named mapping.
+//
+// --integrity 1 (the default) checks block sequence numbers, producer checksums and
+// block-boundary discontinuities on everything read, and prints each finding with its
+// block sequence number and shared-clock time.
+//
+// --record PATH records the stream as the ring carried it, with block timestamps and
+// drop markers, through a BridgeRecorder (its own Skip reader, so it cannot hold the
+// producer back). SIGUSR1 starts and stops recording at any time; without --record it
+// records to bridge-recording.wav (or .raw).
+
+namespace
+{
+std::atomic<bool> g_stopRequested {false};
+std::atomic<bool> g_recordToggleRequested {false};
+
+void handleSignal(int)
+{
+    g_stopRequested.store(true);
+}
+
+void handleRecordSignal(int)
+{
+    g_recordToggleRequested.store(true);
+}
+
+const char* stringArgument(int argc, char** argv, const char* name, const char* fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::strcmp(argv[i], name) == 0)
+        {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+int intArgument(int argc, char** argv, const char* name, int fallback)
+{
+    const auto* value = stringArgument(argc, argv, name, nullptr);
+    return value != nullptr ? std::atoi(value) : fallback;
+}
+
+void pinToCpu(int cpu)
+{
+#if defined(__linux__)
+    if (cpu < 0)
+    {
+        return;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+    {
+        std::fprintf(stderr, "[OceanAudioBridgeConsumer] Unable to pin to CPU %d\n", cpu);
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+std::unique_ptr<FrameSink> createSink(const std::string& kind, const std::string& path)
+{
+    if (kind == "null")
+    {
+        return std::make_unique<NullFrameSink>();
+    }
+    if (kind == "memory")
+    {
+        constexpr std::uint64_t kTenMinutesAt48k = 48000ull * 600ull;
+        return std::make_unique<MemoryFrameSink>(kTenMinutesAt48k);
+    }
+    if (kind == "wav")
+    {
+        return std::make_unique<WavFileFrameSink>(path.empty() ? "bridge-capture.wav" : path);
+    }
+    if (kind == "fifo")
+    {
+        return std::make_unique<FifoFrameSink>(path.empty() ? "/tmp/oceanaudio-bridge.fifo" : path);
+    }
+    return nullptr;
+}
+
+bool parseLagPolicy(const std::string& name, oceanaudio::ReaderLagPolicy& policy)
+{
+    for (const auto candidate : {oceanaudio::ReaderLagPolicy::Stall,
+                                 oceanaudio::ReaderLagPolicy::Skip,
+                                 oceanaudio::ReaderLagPolicy::Detach})
+    {
+        if (name == oceanaudio::toString(candidate))
+        {
+            policy = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseOverrunPolicy(const std::string& name, OverrunPolicy& policy)
+{
+    for (const auto candidate : {OverrunPolicy::DropOldest, OverrunPolicy::DropNewest, OverrunPolicy::Squeeze})
+    {
+        if (name == toString(candidate))
+        {
+            policy = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseConcealment(const std::string& name, UnderrunConcealment& concealment)
+{
+    for (const auto candidate : {UnderrunConcealment::FadeToSilence, UnderrunConcealment::RepeatGrain})
+    {
+        if (name == toString(candidate))
+        {
+            concealment = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+int runDirect(oceanaudio::ReaderLagPolicy lagPolicy, std::uint32_t producerTimeoutMs, int runSeconds)
+{
+    StandInCapture::Settings captureSettings;
+    captureSettings.lagPolicy = lagPolicy;
+    StandInCapture capture(captureSettings);
+
+    DirectBridgeSupervisor::Settings settings;
+    settings.producerTimeoutMs = producerTimeoutMs;
+    DirectBridgeSupervisor supervisor(capture, settings);
+    while (!supervisor.connect())
+    {
+        if (g_stopRequested.load())
+        {
+            return 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    std::printf("[OceanAudioBridgeConsumer] Direct mode: stand-in capture reads the ring itself (reader slot %u, "
+                "lag policy %s).\n",
+                supervisor.getStatistics().readerSlot,
+                oceanaudio::toString(lagPolicy));
+
+    using Clock = std::chrono::steady_clock;
+    const auto startTime = Clock::now();
+    auto lastReport = startTime;
+    auto lastCapture = capture.getStatistics();
+
+    supervisor.run([&]()
+    {
+        const auto now = Clock::now();
+        if (now - lastReport >= std::chrono::seconds(1))
+        {
+            const auto stats = supervisor.getStatistics();
+            const auto captureStats = capture.getStatistics();
+            const auto elapsed = std::chrono::duration<double>(now - lastReport).count();
+            std::printf("[OceanAudioBridgeConsumer] %.0f frames/s captured, %.0f bytes copied/s by the endpoint, "
+                        "0 by the service, %llu short packets, lag %llu frames, %llu reconnects (%llu producers "
+                        "lost, %llu endpoint losses, %llu retired mappings)\n",
+                        static_cast<double>(captureStats.framesCaptured - lastCapture.framesCaptured) / elapsed,
+                        static_cast<double>(captureStats.bytesCopied - lastCapture.bytesCopied) / elapsed,
+                        static_cast<unsigned long long>(captureStats.shortPackets),
+                        static_cast<unsigned long long>(stats.lagFrames),
+                        static_cast<unsigned long long>(stats.reconnects),
+                        static_cast<unsigned long long>(stats.producerLosses),
+                        static_cast<unsigned long long>(stats.endpointLosses),
+                        static_cast<unsigned long long>(stats.retiredMappings));
+            lastReport = now;
+            lastCapture = captureStats;
+        }
+
+        return g_stopRequested.load()
+               || (runSeconds > 0 && now - startTime >= std::chrono::seconds(runSeconds));
+    });
+
+    supervisor.disconnect();
+    return 0;
+}
+
+bool parseSampleFormat(const std::string& name, oceanaudio::BridgeSampleFormat& format)
+{
+    for (const auto candidate : {oceanaudio::BridgeSampleFormat::Float32,
+                                 oceanaudio::BridgeSampleFormat::Int16,
+                                 oceanaudio::BridgeSampleFormat::Int24})
+    {
+        if (name == oceanaudio::toString(candidate))
+        {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGUSR1, handleRecordSignal);
+
+    pinToCpu(intArgument(argc, argv, "--cpu", -1));
+    const int runSeconds = intArgument(argc, argv, "--seconds", 0);
+    const std::string sinkKind = stringArgument(argc, argv, "--sink", "null");
+
+    auto sink = createSink(sinkKind, stringArgument(argc, argv, "--path", ""));
+    if (sink == nullptr)
+    {
+        std::fprintf(stderr, "[OceanAudioBridgeConsumer] Unknown sink '%s'\n", sinkKind.c_str());
+        return 1;
+    }
+
+    ConsumerEngine::Settings settings;
+    settings.spinMicroseconds = static_cast<std::uint32_t>(
+        intArgument(argc, argv, "--spin-us", static_cast<int>(settings.spinMicroseconds)));
+    settings.compensateDrift = intArgument(argc, argv, "--drift", 0) != 0;
+    settings.drift.targetLatencyFrames = static_cast<std::uint32_t>(intArgument(argc, argv, "--target-frames", 0));
+    settings.jitter.adaptive = intArgument(argc, argv, "--adaptive", 1) != 0;
+    settings.jitter.prefillFrames = static_cast<std::uint32_t>(intArgument(argc, argv, "--prefill-frames", 0));
+    const std::string overrunPolicy = stringArgument(argc, argv, "--overrun", "drop-oldest");
+    if (!parseOverrunPolicy(overrunPolicy, settings.jitter.overrunPolicy))
+    {
+        std::fprintf(stderr, "[OceanAudioBridgeConsumer] Unknown overrun policy '%s'\n", overrunPolicy.c_str());
+        return 1;
+    }
+    const std::string concealment = stringArgument(argc, argv, "--conceal", "fade");
+    if (!parseConcealment(concealment, settings.jitter.concealment))
+    {
+        std::fprintf(stderr, "[OceanAudioBridgeConsumer] Unknown concealment '%s'\n", concealment.c_str());
+        return 1;
+    }
+    const std::string lagPolicy = stringArgument(argc, argv, "--lag-policy", "stall");
+    if (!parseLagPolicy(lagPolicy, settings.lagPolicy))
+    {
+        std::fprintf(stderr, "[OceanAudioBridgeConsumer] Unknown lag policy '%s'\n", lagPolicy.c_str());
+        return 1;
+    }
+    const std::string sampleFormat = stringArgument(argc, argv, "--format", "f32");
+    if (!parseSampleFormat(sampleFormat, settings.view.sampleFormat))
+    {
+        std::fprintf(stderr, "[OceanAudioBridgeConsumer] Unknown sample format '%s'\n", sampleFormat.c_str());
+        return 1;
+    }
+    settings.view.sampleRate = static_cast<std::uint32_t>(intArgument(argc, argv, "--view-rate", 0));
+    settings.view.channels = static_cast<std::uint32_t>(intArgument(argc, argv, "--view-channels", 0));
+    settings.residency.lock = intArgument(argc, argv, "--lock-memory", 1) != 0;
+    settings.producerTimeoutMs = static_cast<std::uint32_t>(
+        intArgument(argc, argv, "--producer-timeout-ms", static_cast<int>(settings.producerTimeoutMs)));
+    settings.integrity.enabled = intArgument(argc, argv, "--integrity", 1) != 0;
+    const std::string transport = stringArgument(argc, argv, "--transport", "named");
+    if (transport == "socket")
+    {
+#if defined(__linux__)
+        settings.socketPath = stringArgument(argc, argv, "--socket-path", "");
+        if (settings.socketPath.empty())
+        {
+            settings.socketPath = oceanaudio::posix::defaultBridgeSocketPath();
+        }
+#else
+        std::fprintf(stderr, "[OceanAudioBridgeConsumer] The socket transport needs Linux\n");
+        return 1;
+#endif
+    }
+    else if (transport != "named")
+    {
+        std::fprintf(stderr, "[OceanAudioBridgeConsumer] Unknown transport '%s'\n", transport.c_str());
+        return 1;
+    }
+    BridgeRecorder::Settings recordSettings;
+    recordSettings.socketPath = settings.socketPath;
+    recordSettings.producerTimeoutMs = settings.producerTimeoutMs;
+    const std::string recordFormat = stringArgument(argc, argv, "--record-format", "wav");
+    if (recordFormat != "wav" && recordFormat != "raw")
+    {
+        std::fprintf(stderr, "[OceanAudioBridgeConsumer] Unknown recording format '%s'\n", recordFormat.c_str());
+        return 1;
+    }
+    recordSettings.fileFormat = recordFormat == "raw" ? BridgeRecorder::FileFormat::Raw
+                                                      : BridgeRecorder::FileFormat::Wav;
+    const std::string recordPath = stringArgument(argc, argv, "--record", "");
+    recordSettings.path = !recordPath.empty() ? recordPath : "bridge-recording." + recordFormat;
+    g_recordToggleRequested.store(!recordPath.empty());
+
+    if (intArgument(argc, argv, "--direct", 0) != 0)
+    {
+        return runDirect(settings.lagPolicy, settings.producerTimeoutMs, runSeconds);
+    }
+
+    // Starting and stopping waits for the recorder's threads, so it happens here
+    // rather than on the delivery thread.
+    BridgeRecorder recorder;
+    std::thread recorderControl([&]()
+    {
+        while (!g_stopRequested.load())
+        {
+            if (g_recordToggleRequested.exchange(false))
+            {
+                if (recorder.isRecording())
+                {
+                    recorder.stop();
+                    std::printf("[OceanAudioBridgeConsumer] Recording to %s stopped.\n", recordSettings.path.c_str());
+                }
+                else if (recorder.start(recordSettings))
+                {
+                    std::printf("[OceanAudioBridgeConsumer] Recording to %s.\n", recordSettings.path.c_str());
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        recorder.stop();
+    });
+
+    ConsumerEngine engine(*sink, settings);
+    while (!engine.connect())
+    {
+        if (g_stopRequested.load())
+        {
+            recorderControl.join();
+            return 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    const auto openedStats = engine.getStatistics();
+    std::printf("[OceanAudioBridgeConsumer] Shared audio mapping opened (%s, sink: %s, reader slot %u, "
+                "lag policy %s, ring %s).\n",
+                settings.socketPath.empty() ? "named mapping" : settings.socketPath.c_str(),
+                sinkKind.c_str(),
+                openedStats.readerSlot,
+                lagPolicy.c_str(),
+                openedStats.memoryResidency.locked ? "prefaulted and locked" : "prefaulted, not locked");
+
+    using Clock = std::chrono::steady_clock;
+    const auto startTime = Clock::now();
+    auto lastReport = startTime;
+    auto lastStats = engine.getStatistics();
+    std::uint64_t lastIntegrityEvent = 0;
+
+    engine.run([&]()
+    {
+        const auto now = Clock::now();
+        if (now - lastReport >= std::chrono::seconds(1))
+        {
+            const auto stats = engine.getStatistics();
+            const auto elapsed = std::chrono::duration<double>(now - lastReport).count();
+            const auto blocks = stats.blocksDelivered - lastStats.blocksDelivered;
+            const auto deliveryNs = stats.totalDeliveryNs - lastStats.totalDeliveryNs;
+            const auto syscalls = (stats.blockingWaits - lastStats.blockingWaits)
+                                  + (stats.producerSignals - lastStats.producerSignals);
+            std::printf("[OceanAudioBridgeConsumer] %.0f frames/s, %.0f wake syscalls/s, %.0f bytes copied/s, "
+                        "%.0f allocations/s, %llu underruns, %llu sink failures, mean delivery %.1f us (max %.1f us)\n",
+                        static_cast<double>(stats.framesDelivered - lastStats.framesDelivered) / elapsed,
+                        static_cast<double>(syscalls) / elapsed,
+                        static_cast<double>(stats.bytesCopied - lastStats.bytesCopied) / elapsed,
+                        static_cast<double>(stats.allocations - lastStats.allocations) / elapsed,
+                        static_cast<unsigned long long>(stats.underruns - lastStats.underruns),
+                        static_cast<unsigned long long>(stats.sinkFailures - lastStats.sinkFailures),
+                        blocks > 0 ? static_cast<double>(deliveryNs) / static_cast<double>(blocks) * 1.0e-3 : 0.0,
+                        static_cast<double>(stats.maxDeliveryNs) * 1.0e-3);
+            std::printf("[OceanAudioBridgeConsumer] bridge latency p50 %llu us, p99 %llu us, p999 %llu us\n",
+                        static_cast<unsigned long long>(stats.residencyP50Us),
+                        static_cast<unsigned long long>(stats.residencyP99Us),
+                        static_cast<unsigned long long>(stats.residencyP999Us));
+            if (settings.lagPolicy != oceanaudio::ReaderLagPolicy::Stall)
+            {
+                std::printf("[OceanAudioBridgeConsumer] lag: %llu frames skipped, %llu frames overwritten, "
+                            "%llu rejoins\n",
+                            static_cast<unsigned long long>(stats.framesSkipped),
+                            static_cast<unsigned long long>(stats.framesOverwritten),
+                            static_cast<unsigned long long>(stats.rejoins));
+            }
+            if (stats.formatChanges != lastStats.formatChanges || stats.reconnects != lastStats.reconnects)
+            {
+                std::printf("[OceanAudioBridgeConsumer] format: %llu changes, %llu old-format frames discarded, "
+                            "%llu reconnects (%llu producers lost, %llu evictions)\n",
+                            static_cast<unsigned long long>(stats.formatChanges),
+                            static_cast<unsigned long long>(stats.framesDiscarded),
+                            static_cast<unsigned long long>(stats.reconnects),
+                            static_cast<unsigned long long>(stats.producerLosses),
+                            static_cast<unsigned long long>(stats.evictions));
+            }
+            const auto& integrityEvents = engine.getIntegrityEvents();
+            if (integrityEvents.totalRecorded() != lastIntegrityEvent
+                || stats.blocksVerified != lastStats.blocksVerified)
+            {
+                std::printf("[OceanAudioBridgeConsumer] integrity: %llu blocks verified, %llu checksum mismatches, "
+                            "%llu producer drops, %llu frames missing, %llu duplicated, %llu descriptors lost, "
+                            "%llu discontinuities\n",
+                            static_cast<unsigned long long>(stats.blocksVerified),
+                            static_cast<unsigned long long>(stats.checksumMismatches),
+                            static_cast<unsigned long long>(stats.producerDroppedBlocks),
+                            static_cast<unsigned long long>(stats.framesMissing),
+                            static_cast<unsigned long long>(stats.framesDuplicated),
+                            static_cast<unsigned long long>(stats.descriptorsLost),
+                            static_cast<unsigned long long>(stats.discontinuities));
+
+                oceanaudio::IntegrityEvent events[8];
+                const auto count = integrityEvents.copyEvents(events, 8, lastIntegrityEvent);
+                for (std::uint32_t index = 0; index < count; ++index)
+                {
+                    const auto& event = events[index];
+                    std::printf("[OceanAudioBridgeConsumer]   %s at block %llu, frame %llu (t=%llu ns): value %llu, "
+                                "channel %u, magnitude %.3f\n",
+                                oceanaudio::toString(event.kind),
+                                static_cast<unsigned long long>(event.sequence),
+                                static_cast<unsigned long long>(event.frameIndex),
+                                static_cast<unsigned long long>(event.timeNs),
+                                static_cast<unsigned long long>(event.value),
+                                event.channel,
+                                static_cast<double>(event.magnitude));
+                }
+                lastIntegrityEvent = integrityEvents.totalRecorded();
+            }
+            if (!settings.view.isIdentity())
+            {
+                const auto sinkFormat = engine.getSinkFormat();
+                const auto converted = stats.framesConverted - lastStats.framesConverted;
+                std::printf("[OceanAudioBridgeConsumer] view %s, %u Hz, %u channels: %.1f ns per output frame\n",
+                            oceanaudio::toString(sinkFormat.sampleFormat),
+                            sinkFormat.sampleRate,
+                            sinkFormat.channels,
+                            converted > 0 ? static_cast<double>(stats.conversionNs - lastStats.conversionNs)
+                                                / static_cast<double>(converted)
+                                          : 0.0);
+            }
+            const auto recordStats = recorder.getStatistics();
+            if (recordStats.recording)
+            {
+                std::printf("[OceanAudioBridgeConsumer] recording: %.1f MB, %llu blocks, %llu frames skipped, "
+                            "%llu lost to overflow, %llu overwritten, %llu write failures\n",
+                            static_cast<double>(recordStats.bytesWritten) * 1.0e-6,
+                            static_cast<unsigned long long>(recordStats.blocksRecorded),
+                            static_cast<unsigned long long>(recordStats.readerGapFrames),
+                            static_cast<unsigned long long>(recordStats.overflowFrames),
+                            static_cast<unsigned long long>(recordStats.framesOverwritten),
+                            static_cast<unsigned long long>(recordStats.writeFailures));
+            }
+            if (settings.compensateDrift)
+            {
+                std::printf("[OceanAudioBridgeConsumer] drift trim %+.1f ppm, latency %.0f frames, "
+                            "%llu starvations\n",
+                            stats.driftCorrectionPpm,
+                            stats.driftLatencyFrames,
+                            static_cast<unsigned long long>(stats.driftStarvations));
+                std::printf("[OceanAudioBridgeConsumer] jitter buffer: target %u frames, jitter %.0f frames, "
+                            "%llu prefills, %llu frames concealed, %llu overruns (%llu dropped, %llu squeezed)\n",
+                            stats.jitter.targetLatencyFrames,
+                            stats.jitter.jitterFrames,
+                            static_cast<unsigned long long>(stats.jitter.prefills),
+                            static_cast<unsigned long long>(stats.jitter.concealedFrames),
+                            static_cast<unsigned long long>(stats.jitter.overruns),
+                            static_cast<unsigned long long>(stats.jitter.framesDropped),
+                            static_cast<unsigned long long>(stats.jitter.framesSqueezed));
+            }
+            lastReport = now;
+            lastStats = stats;
+        }
+
+        return g_stopRequested.load()
+               || (runSeconds > 0 && now - startTime >= std::chrono::seconds(runSeconds));
+    });
+
+    engine.disconnect();
+    g_stopRequested.store(true);
+    recorderControl.join();
+    return 0;
+}
@@ -1,18 +1,12 @@
-#include "BridgeConsumer.h"
+#include "ConsumerEngine.h"
+#include "DirectBridgeSupervisor.h"
+#include "DriverIoctlSink.h"
 
 #include <Windows.h>
-#include <SetupAPI.h>
-#include <cfgmgr32.h>
-#include <objbase.h>
 
-#include <chrono>
 #include <iostream>
 #include <string>
 #include <thread>
-#include <vector>
-#include <cstring>
-
-#include <OceanAudio/BridgeProtocol.h>
 
 namespace
 {
@@ -20,141 +14,10 @@ constexpr wchar_t kServiceName[] = L"OceanAudioBridgeService";
 constexpr wchar_t kMappingName[] = L"Global\\OceanAudio_AudioRing";
 constexpr wchar_t kReadyEventName[] = L"Global\\OceanAudio_AudioReady";
 constexpr wchar_t kConsumedEventName[] = L"Global\\OceanAudio_AudioConsumed";
-constexpr wchar_t kDeviceInterfaceId[] = oceanaudio::kDeviceInterfaceId;
+constexpr int kMaxConnectAttempts = 50;
 
 SERVICE_STATUS_HANDLE g_statusHandle = nullptr;
 HANDLE g_stopEvent = nullptr;
-BridgeConsumer g_consumer;
-HANDLE g_driverHandle = INVALID_HANDLE_VALUE;
-GUID getBridgeInterfaceGuid()
-{
-    GUID guid {};
-    if (FAILED(CLSIDFromString(kDeviceInterfaceId, &guid)))
-    {
-        return GUID {};
-    }
-    return guid;
-}
-
-void closeDriverHandle(HANDLE& handle)
-{
-    if (handle != nullptr && handle != INVALID_HANDLE_VALUE)
-    {
-        CloseHandle(handle);
-    }
-    handle = INVALID_HANDLE_VALUE;
-}
-
-HANDLE openDriverInterface()
-{
-#if !defined(_WIN32)
-    return INVALID_HANDLE_VALUE;
-#else
-    GUID interfaceGuid = getBridgeInterfaceGuid();
-    if (interfaceGuid == GUID {})
-    {
-        OutputDebugStringW(L"[OceanAudioBridgeService] Invalid device interface GUID.\n");
-        return INVALID_HANDLE_VALUE;
-    }
-
-    HDEVINFO deviceInfoSet = SetupDiGetClassDevsW(&interfaceGuid,
-                                                  nullptr,
-                                                  nullptr,
-                                                  DIGCF_DEVICEINTERFACE | DIGCF_PRESENT);
-    if (deviceInfoSet == INVALID_HANDLE_VALUE)
-    {
-        return INVALID_HANDLE_VALUE;
-    }
-
-    SP_DEVICE_INTERFACE_DATA interfaceData;
-    interfaceData.cbSize = sizeof(SP_DEVICE_INTERFACE_DATA);
-
-    HANDLE deviceHandle = INVALID_HANDLE_VALUE;
-
-    for (DWORD index = 0; SetupDiEnumDeviceInterfaces(deviceInfoSet, nullptr, &interfaceGuid, index, &interfaceData); ++index)
-    {
-        DWORD requiredSize = 0;
-        SetupDiGetDeviceInterfaceDetailW(deviceInfoSet, &interfaceData, nullptr, 0, &requiredSize, nullptr);
-        if (requiredSize == 0)
-        {
-            continue;
-        }
-
-        std::vector<wchar_t> buffer(requiredSize / sizeof(wchar_t) + 1);
-        auto* detailData = reinterpret_cast<PSP_DEVICE_INTERFACE_DETAIL_DATA_W>(buffer.data());
-        detailData->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_W);
-
-        if (!SetupDiGetDeviceInterfaceDetailW(deviceInfoSet, &interfaceData, detailData, requiredSize, nullptr, nullptr))
-        {
-            continue;
-        }
-
-        deviceHandle = CreateFileW(detailData->DevicePath,
-                                   GENERIC_READ | GENERIC_WRITE,
-                                   FILE_SHARE_READ | FILE_SHARE_WRITE,
-                                   nullptr,
-                                   OPEN_EXISTING,
-                                   FILE_ATTRIBUTE_NORMAL,
-                                   nullptr);
-        if (deviceHandle != INVALID_HANDLE_VALUE)
-        {
-            break;
-        }
-    }
-
-    SetupDiDestroyDeviceInfoList(deviceInfoSet);
-    return deviceHandle;
-#endif
-}
-
-bool submitFramesToDriver(HANDLE driverHandle, const std::vector<float>& buffer, std::uint32_t frames)
-{
-#if !defined(_WIN32)
-    (void)driverHandle;
-    (void)buffer;
-    (void)frames;
-    return false;
-#else
-    if (driverHandle == INVALID_HANDLE_VALUE || frames == 0 || buffer.empty())
-    {
-        return false;
-    }
-
-    const std::size_t payloadBytes = buffer.size() * sizeof(float);
-    const std::size_t totalBytes = sizeof(oceanaudio::BridgeAudioPacket) + payloadBytes;
-
-    std::vector<std::uint8_t> ioBuffer(totalBytes);
-    auto* packet = reinterpret_cast<oceanaudio::BridgeAudioPacket*>(ioBuffer.data());
-    packet->framesWritten = frames;
-    packet->reserved = 0;
-    std::memcpy(ioBuffer.data() + sizeof(oceanaudio::BridgeAudioPacket),
-                buffer.data(),
-                payloadBytes);
-
-    DWORD bytesReturned = 0;
-    const auto ioctlCode = oceanaudio::BridgeIoctlCode(oceanaudio::BridgeIoctl::SubmitFrames);
-    const BOOL result = DeviceIoControl(driverHandle,
-                                        ioctlCode,
-                                        ioBuffer.data(),
-                                        static_cast<DWORD>(ioBuffer.size()),
-                                        nullptr,
-                                        0,
-                                        &bytesReturned,
-                                        nullptr);
-
-    if (result == FALSE)
-    {
-        const auto error = GetLastError();
-        if (error != ERROR_NOT_SUPPORTED)
-        {
-            OutputDebugStringW(L"[OceanAudioBridgeService] DeviceIoControl failed when submitting frames.\n");
-        }
-        return false;
-    }
-
-    return true;
-#endif
-}
 
 void reportServiceStatus(DWORD currentState, DWORD win32ExitCode, DWORD waitHint)
 {
@@ -193,56 +56,104 @@ void WINAPI serviceControlHandler(DWORD controlCode)
     }
 }
 
-void processAudioStream(HANDLE stopEvent)
+void logRejectedMapping(oceanaudio::SharedLayoutStatus layoutStatus, oceanaudio::SharedLayoutStatus& lastLayoutStatus)
 {
-    constexpr int kMaxAttempts = 50;
+    if (layoutStatus != oceanaudio::SharedLayoutStatus::Uninitialised && layoutStatus != lastLayoutStatus)
+    {
+        OutputDebugStringA("[OceanAudioBridgeService] Shared mapping rejected: ");
+        OutputDebugStringA(oceanaudio::toString(layoutStatus));
+        OutputDebugStringA("\n");
+    }
+    lastLayoutStatus = layoutStatus;
+}
+
+// Offers the driver the ring itself and supervises it until the service stops.
+// Returns false if the driver is missing or wants its blocks handed over (Copy), now
+// or after a reconnect, so the caller falls back to draining the ring.
+bool superviseDirect(DriverIoctlSink& driverSink, HANDLE stopEvent)
+{
+    DirectBridgeSupervisor::Settings settings;
+    settings.mappingName = kMappingName;
+    DirectBridgeSupervisor supervisor(driverSink, settings);
+
     int attempts = 0;
-    while (!g_consumer.open(kMappingName, kReadyEventName, kConsumedEventName))
+    auto lastLayoutStatus = oceanaudio::SharedLayoutStatus::Compatible;
+    while (!supervisor.connect())
     {
+        // The mapping was fine; the driver could not be reached.
+        if (supervisor.getLayoutStatus() == oceanaudio::SharedLayoutStatus::Compatible)
+        {
+            return false;
+        }
+        logRejectedMapping(supervisor.getLayoutStatus(), lastLayoutStatus);
+
         if (WaitForSingleObject(stopEvent, 100) != WAIT_TIMEOUT)
         {
-            return;
+            return true;
         }
 
-        if (++attempts >= kMaxAttempts)
+        // Leave the rest of the waiting, and the giving up, to the copy path.
+        if (++attempts >= kMaxConnectAttempts)
         {
-            OutputDebugStringW(L"[OceanAudioBridgeService] Failed to open shared mapping after multiple attempts.\n");
-            return;
+            return false;
         }
     }
 
-    OutputDebugStringW(L"[OceanAudioBridgeService] Shared audio mapping opened.\n");
+    if (!supervisor.isDirect())
+    {
+        return false;
+    }
 
-    g_driverHandle = openDriverInterface();
-    if (g_driverHandle == INVALID_HANDLE_VALUE)
+    OutputDebugStringW(L"[OceanAudioBridgeService] Driver reads the shared audio mapping directly.\n");
+    supervisor.run([stopEvent]()
     {
-        OutputDebugStringW(L"[OceanAudioBridgeService] Driver handle unavailable; will continue without IOCTL forwarding.\n");
+        return WaitForSingleObject(stopEvent, 0) != WAIT_TIMEOUT;
+    });
+    supervisor.disconnect();
+    return WaitForSingleObject(stopEvent, 0) != WAIT_TIMEOUT;
+}
+
+void processAudioStream(HANDLE stopEvent)
+{
+    DriverIoctlSink driverSink;
+    if (superviseDirect(driverSink, stopEvent))
+    {
+        return;
     }
 
-    std::vector<float> buffer;
-    buffer.reserve(48000);
+    ConsumerEngine::Settings settings;
+    settings.mappingName = kMappingName;
+    settings.readyEventName = kReadyEventName;
+    settings.consumedEventName = kConsumedEventName;
+
+    ConsumerEngine engine(driverSink, settings);
 
-    while (WaitForSingleObject(stopEvent, 0) == WAIT_TIMEOUT)
+    int attempts = 0;
+    auto lastLayoutStatus = oceanaudio::SharedLayoutStatus::Compatible;
+    while (!engine.connect())
     {
-        if (!g_consumer.waitForData(10))
-        {
-            continue;
-        }
+        logRejectedMapping(engine.getLayoutStatus(), lastLayoutStatus);
 
-        std::uint32_t framesRead = 0;
-        if (g_consumer.readAvailableFrames(buffer, framesRead))
+        if (WaitForSingleObject(stopEvent, 100) != WAIT_TIMEOUT)
         {
-            submitFramesToDriver(g_driverHandle, buffer, framesRead);
+            return;
         }
-        else
+
+        if (++attempts >= kMaxConnectAttempts)
         {
-            // No frames available; sleep briefly to avoid busy waiting.
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            OutputDebugStringW(L"[OceanAudioBridgeService] Failed to open shared mapping after multiple attempts.\n");
+            return;
         }
     }
 
-    g_consumer.close();
-    closeDriverHandle(g_driverHandle);
+    OutputDebugStringW(L"[OceanAudioBridgeService] Shared audio mapping opened.\n");
+
+    engine.run([stopEvent]()
+    {
+        return WaitForSingleObject(stopEvent, 0) != WAIT_TIMEOUT;
+    });
+
+    engine.disconnect();
 }
 
 void WINAPI serviceMain(DWORD, LPWSTR*)
@@ -0,0 +1,298 @@
+#include "StandInCapture.h"
+
+#include "TickClock.h"
+
+#include <OceanAudio/WakeupSignalling.h>
+
+#include <cstring>
+
+namespace
+{
+// Packet size when the producer does not state a block size: 10 ms at 48 kHz, the
+// packet AVStream capture pins commonly use.
+constexpr std::uint32_t kDefaultPacketFrames = 480;
+} // namespace
+
+StandInCapture::StandInCapture()
+    : StandInCapture(Settings {})
+{
+}
+
+StandInCapture::StandInCapture(Settings captureSettings)
+    : settings(captureSettings)
+{
+}
+
+StandInCapture::~StandInCapture()
+{
+    releaseSharedBuffer();
+}
+
+bool StandInCapture::querySharedBuffer(const oceanaudio::SharedBufferInfo& offer, oceanaudio::SharedBufferInfo& answer)
+{
+    releaseSharedBuffer();
+
+    answer = offer;
+    answer.transferMode = static_cast<std::uint32_t>(oceanaudio::BridgeTransferMode::Copy);
+    answer.readerSlot = 0;
+
+    // Anything short of a mapping we can read ourselves is answered with Copy, never
+    // with a failure: the service then drains the ring for us as before.
+    if (!settings.acceptDirect
+        || offer.transferMode != static_cast<std::uint32_t>(oceanaudio::BridgeTransferMode::Direct)
+        || offer.layoutVersion != oceanaudio::SharedAudioRingBufferHeader::kVersion || !mapOffer(offer))
+    {
+        return true;
+    }
+
+    const bool formatRead = header->readFormatBounded(format);
+
+    if (!formatRead || !header->isReadable(format)
+        || !ring.attach(header->writeCursor,
+                        header->readers,
+                        format.frameCapacity,
+                        settings.lagPolicy,
+                        format.framesPerBlock,
+                        format.generation))
+    {
+        format = {};
+        unmap();
+        return true;
+    }
+
+    header->attachedReaders.fetch_or(1u << ring.getSlotIndex(), std::memory_order_acq_rel);
+    packetFrames = settings.packetFrames != 0 ? settings.packetFrames
+                   : format.framesPerBlock != 0 ? format.framesPerBlock
+                                                : kDefaultPacketFrames;
+    captureBuffer.assign(static_cast<std::size_t>(packetFrames) * format.channels, 0.0f);
+    started = false;
+    evicted.store(false, std::memory_order_relaxed);
+    attachments.fetch_add(1, std::memory_order_relaxed);
+
+    answer.transferMode = static_cast<std::uint32_t>(oceanaudio::BridgeTransferMode::Direct);
+    answer.readerSlot = ring.getSlotIndex();
+    answer.channels = format.channels;
+    answer.sampleRate = format.sampleRate;
+    answer.frameCapacity = format.frameCapacity;
+    answer.framesPerBlock = packetFrames;
+
+    stopRequested.store(false, std::memory_order_relaxed);
+    captureThread = std::thread([this]()
+    {
+        captureLoop();
+    });
+    return true;
+}
+
+void StandInCapture::releaseSharedBuffer()
+{
+    stopRequested.store(true, std::memory_order_relaxed);
+    if (captureThread.joinable())
+    {
+        captureThread.join();
+    }
+
+    // An evicted reader's slot may already belong to someone else.
+    if (header != nullptr && ring.isAttached() && !ring.isEvicted())
+    {
+        const auto slot = ring.getSlotIndex();
+        header->attachedReaders.fetch_and(~(1u << slot), std::memory_order_acq_rel);
+        oceanaudio::wakeup::cancelSleep(header->readerWaiting[slot]);
+    }
+    ring.detach();
+    unmap();
+    format = {};
+}
+
+bool StandInCapture::isCapturing() const noexcept
+{
+    return header != nullptr && !evicted.load(std::memory_order_relaxed);
+}
+
+StandInCapture::Statistics StandInCapture::getStatistics() const noexcept
+{
+    Statistics snapshot;
+    snapshot.packets = packets.load(std::memory_order_relaxed);
+    snapshot.framesCaptured = framesCaptured.load(std::memory_order_relaxed);
+    snapshot.shortPackets = shortPackets.load(std::memory_order_relaxed);
+    snapshot.bytesCopied = bytesCopied.load(std::memory_order_relaxed);
+    snapshot.formatChanges = formatChanges.load(std::memory_order_relaxed);
+    snapshot.framesSkipped = framesSkipped.load(std::memory_order_relaxed);
+    snapshot.attachments = attachments.load(std::memory_order_relaxed);
+    snapshot.evicted = evicted.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+bool StandInCapture::mapOffer(const oceanaudio::SharedBufferInfo& offer)
+{
+#if defined(_WIN32)
+    // The driver references the section behind the service's handle; in-process, a
+    // duplicate does the same job.
+    HANDLE duplicate = nullptr;
+    if (!DuplicateHandle(GetCurrentProcess(),
+                         reinterpret_cast<HANDLE>(static_cast<std::uintptr_t>(offer.sharedMemoryHandle)),
+                         GetCurrentProcess(),
+                         &duplicate,
+                         0,
+                         FALSE,
+                         DUPLICATE_SAME_ACCESS))
+    {
+        return false;
+    }
+
+    auto* view = MapViewOfFile(duplicate, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(duplicate);
+        return false;
+    }
+
+    MEMORY_BASIC_INFORMATION regionInfo {};
+    const std::size_t mappedBytes = VirtualQuery(view, &regionInfo, sizeof(regionInfo)) != 0 ? regionInfo.RegionSize : 0;
+    mappingHandle = duplicate;
+#else
+    if (!mapping.openFromDescriptor(static_cast<int>(offer.sharedMemoryHandle)))
+    {
+        return false;
+    }
+
+    auto* view = mapping.data();
+    const std::size_t mappedBytes = mapping.sizeInBytes();
+#endif
+
+    header = static_cast<oceanaudio::SharedAudioRingBufferHeader*>(view);
+    if (oceanaudio::checkSharedLayout(view, mappedBytes) != oceanaudio::SharedLayoutStatus::Compatible)
+    {
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+void StandInCapture::unmap() noexcept
+{
+#if defined(_WIN32)
+    if (header != nullptr)
+    {
+        UnmapViewOfFile(header);
+    }
+    if (mappingHandle != nullptr)
+    {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+#else
+    mapping.close();
+#endif
+    header = nullptr;
+}
+
+void StandInCapture::captureLoop()
+{
+    TickClock packetClock;
+    while (!stopRequested.load(std::memory_order_relaxed))
+    {
+        const auto periodNs = static_cast<std::uint64_t>(packetFrames) * 1'000'000'000ull
+                              / (format.sampleRate != 0 ? format.sampleRate : 48000);
+        packetClock.waitForTick(periodNs);
+        capturePacket();
+    }
+}
+
+void StandInCapture::capturePacket()
+{
+    if (evicted.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    if (!ring.heartbeat(oceanaudio::sharedClockNanoseconds()))
+    {
+        evicted.store(true, std::memory_order_relaxed);
+        return;
+    }
+    // An eviction racing with a new claim of this slot can clear the new owner's bit.
+    const auto bit = 1u << ring.getSlotIndex();
+    if ((header->attachedReaders.load(std::memory_order_relaxed) & bit) == 0)
+    {
+        header->attachedReaders.fetch_or(bit, std::memory_order_acq_rel);
+    }
+
+    if (!followFormat())
+    {
+        return;
+    }
+
+    // The pin plays a packet every period whatever the ring holds; what is missing
+    // stays silent.
+    const std::size_t frameStride = format.channels;
+    std::uint32_t frames = 0;
+    if (ring.readableFrames() > 0)
+    {
+        const auto regions = ring.prepareRead(packetFrames);
+        // A format change published since followFormat(): the frames past the old
+        // format's end are not frames at all. Take them with the next packet.
+        if (header->formatGeneration.load(std::memory_order_relaxed) == format.generation)
+        {
+            const auto* payload = header->payload();
+            std::memcpy(captureBuffer.data(),
+                        payload + regions.first.offset * frameStride,
+                        regions.first.frames * frameStride * sizeof(float));
+            std::memcpy(captureBuffer.data() + regions.first.frames * frameStride,
+                        payload + regions.second.offset * frameStride,
+                        regions.second.frames * frameStride * sizeof(float));
+            frames = regions.totalFrames();
+            ring.commitRead(frames);
+        }
+    }
+
+    if (ring.isEvicted())
+    {
+        evicted.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    std::memset(captureBuffer.data() + frames * frameStride, 0, (packetFrames - frames) * frameStride * sizeof(float));
+    started = started || frames > 0;
+    if (started && frames < packetFrames)
+    {
+        shortPackets.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    packets.fetch_add(1, std::memory_order_relaxed);
+    framesCaptured.fetch_add(frames, std::memory_order_relaxed);
+    bytesCopied.fetch_add(static_cast<std::uint64_t>(frames) * frameStride * sizeof(float), std::memory_order_relaxed);
+    framesSkipped.store(ring.getFramesSkipped(), std::memory_order_relaxed);
+}
+
+bool StandInCapture::followFormat()
+{
+    const auto generation = header->formatGeneration.load(std::memory_order_acquire);
+    if (generation == format.generation)
+    {
+        return true;
+    }
+
+    // Retired: the service notices too, releases us and offers the next mapping.
+    if (generation == oceanaudio::SharedAudioRingBufferHeader::kFormatRetired)
+    {
+        return false;
+    }
+
+    oceanaudio::BridgeFormat next;
+    if (!header->readFormat(next) || !header->isReadable(next))
+    {
+        return false;
+    }
+
+    ring.reformat(next.frameCapacity, next.framesPerBlock, next.startFrame, next.generation);
+    format = next;
+    if (settings.packetFrames == 0 && format.framesPerBlock != 0)
+    {
+        packetFrames = format.framesPerBlock;
+    }
+    // Off the audio path in the stand-in; the driver sizes its buffer for the reservation.
+    captureBuffer.resize(static_cast<std::size_t>(packetFrames) * format.channels);
+    formatChanges.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "CaptureEndpoint.h"
+
+#include <OceanAudio/BridgeSharedMemory.h>
+#include <OceanAudio/BroadcastRing.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <OceanAudio/PosixSharedMemory.h>
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// User-mode stand-in for the virtual microphone driver in Direct mode, so the path can
+// be built and measured without the AVStream miniport. It does what the capture pin
+// will do: maps the ring from the handle in the offer, attaches as a reader, and on its
+// own clock copies one packet per period straight from the ring into its capture
+// buffer (the DMA buffer's role), following format changes and beating its reader
+// heartbeat. Like a pin it never sleeps on the ready event, and it only uses the
+// shared headers, so the same code can move into the driver.
+class StandInCapture final : public CaptureEndpoint
+{
+public:
+    struct Settings
+    {
+        // Answer Copy instead, like a driver that predates Direct mode.
+        bool acceptDirect = true;
+        // A capture pin must never hold the host back.
+        oceanaudio::ReaderLagPolicy lagPolicy = oceanaudio::ReaderLagPolicy::Skip;
+        // Frames per capture packet; 0 uses the producer's block size.
+        std::uint32_t packetFrames = 0;
+    };
+
+    struct Statistics
+    {
+        std::uint64_t packets = 0;
+        std::uint64_t framesCaptured = 0;
+        // Packets the ring could not fill completely once audio had started.
+        std::uint64_t shortPackets = 0;
+        // Bytes copied out of the ring into the capture buffer: the only copy left
+        // between the host's ring write and the endpoint.
+        std::uint64_t bytesCopied = 0;
+        std::uint64_t formatChanges = 0;
+        std::uint64_t framesSkipped = 0;
+        // Mappings taken through QuerySharedBuffer, and whether the producer has
+        // evicted the current one's reader.
+        std::uint64_t attachments = 0;
+        bool evicted = false;
+    };
+
+    StandInCapture();
+    explicit StandInCapture(Settings captureSettings);
+    ~StandInCapture() override;
+
+    StandInCapture(const StandInCapture&) = delete;
+    StandInCapture& operator=(const StandInCapture&) = delete;
+
+    bool querySharedBuffer(const oceanaudio::SharedBufferInfo& offer, oceanaudio::SharedBufferInfo& answer) override;
+    void releaseSharedBuffer() override;
+
+    [[nodiscard]] bool isCapturing() const noexcept;
+    // Safe to call from any thread.
+    [[nodiscard]] Statistics getStatistics() const noexcept;
+
+private:
+    bool mapOffer(const oceanaudio::SharedBufferInfo& offer);
+    void unmap() noexcept;
+    void captureLoop();
+    void capturePacket();
+    bool followFormat();
+
+    Settings settings;
+#if defined(_WIN32)
+    HANDLE mappingHandle = nullptr;
+#else
+    oceanaudio::posix::SharedMapping mapping;
+#endif
+    oceanaudio::SharedAudioRingBufferHeader* header = nullptr;
+    oceanaudio::BroadcastRingReader ring;
+    oceanaudio::BridgeFormat format;
+    std::vector<float> captureBuffer;
+    std::uint32_t packetFrames = 0;
+    bool started = false;
+
+    std::thread captureThread;
+    std::atomic<bool> stopRequested {false};
+
+    std::atomic<std::uint64_t> packets {0};
+    std::atomic<std::uint64_t> framesCaptured {0};
+    std::atomic<std::uint64_t> shortPackets {0};
+    std::atomic<std::uint64_t> bytesCopied {0};
+    std::atomic<std::uint64_t> formatChanges {0};
+    std::atomic<std::uint64_t> framesSkipped {0};
+    std::atomic<std::uint64_t> attachments {0};
+    std::atomic<bool> evicted {false};
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+// Paces a loop to a fixed period on the steady clock, the way a device clock would.
+// Used by the clocked consumer and the stand-in capture pin.
+class TickClock
+{
+public:
+    struct Tick
+    {
+        // Steady-clock time the tick was taken, and the time since the previous one.
+        std::uint64_t nowNs = 0;
+        double elapsedSeconds = 0.0;
+    };
+
+    static std::uint64_t nowNanoseconds() noexcept
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              std::chrono::steady_clock::now().time_since_epoch())
+                                              .count());
+    }
+
+    // The next tick starts the clock again, e.g. after a format change.
+    void reset() noexcept
+    {
+        nextTickNs = 0;
+    }
+
+    // Sleeps until the next tick is due. The first tick after a reset is due at once
+    // and reports one period elapsed.
+    Tick waitForTick(std::uint64_t periodNs)
+    {
+        auto now = nowNanoseconds();
+        if (nextTickNs == 0)
+        {
+            nextTickNs = now;
+            lastTickNs = now - periodNs;
+        }
+
+        if (now < nextTickNs)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(nextTickNs - now));
+            now = nowNanoseconds();
+        }
+        else if (now - nextTickNs > 4 * periodNs)
+        {
+            // Stalled (debugger, suspend): pick the clock up from here rather than burst.
+            nextTickNs = now;
+        }
+
+        const Tick tick {now, static_cast<double>(now - lastTickNs) * 1.0e-9};
+        lastTickNs = now;
+        nextTickNs += periodNs;
+        return tick;
+    }
+
+private:
+    std::uint64_t nextTickNs = 0;
+    std::uint64_t lastTickNs = 0;
+};
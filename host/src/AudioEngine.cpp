@@ -3,18 +3,15 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
 
+#include <OceanAudio/PeerHeartbeat.h>
+
+#include <algorithm>
+
 namespace
 {
 constexpr double kDefaultSampleRate = 48000.0;
 constexpr int kDefaultBufferSize = 256;
-
-juce::String createIdentifierString(const juce::PluginDescription& description)
-{
-    return juce::PluginDescription::createIdentifierString(description.pluginFormatName,
-                                                           description.name,
-                                                           description.version,
-                                                           description.fileOrIdentifier);
-}
+constexpr int kLoadLogIntervalMs = 10000;
 }
 
 AudioEngine::AudioEngine()
@@ -23,26 +20,27 @@ AudioEngine::AudioEngine()
     setup.bufferSize = kDefaultBufferSize;
     setup.sampleRate = kDefaultSampleRate;
 
+    auto defaultChain = std::make_unique<PluginChain>();
+    defaultChain->initialiseDefaultChain();
+    chains.publish(std::move(defaultChain));
     deviceManager.initialiseWithDefaultDevices(2, 2);
     deviceManager.addAudioCallback(this);
 
-    processorPlayer.setProcessor(pluginChain.getProcessor());
-    deviceManager.addAudioCallback(&processorPlayer);
-
-    pluginChain.initialiseDefaultChain();
     pluginManager.initialise();
     presetManager.loadFactoryPresets();
     presetManager.loadUserPresets();
     prepareForVirtualOutput();
 
-    lastStatus = "Audio engine initialised";
+    loadMeter.setLogging(juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                             .getChildFile("OceanAudio")
+                             .getChildFile("Logs")
+                             .getChildFile("DspLoad.log"),
+                         kLoadLogIntervalMs);
 }
 
 AudioEngine::~AudioEngine()
 {
-    deviceManager.removeAudioCallback(&processorPlayer);
     deviceManager.removeAudioCallback(this);
-    processorPlayer.setProcessor(nullptr);
     pluginManager.shutdown();
 }
 
@@ -69,7 +67,65 @@ void AudioEngine::openDeviceSettings()
 
 juce::String AudioEngine::getStatusText() const
 {
-    return lastStatus;
+    const auto engine = telemetry.snapshot();
+    juce::String status;
+    if (!engine.running)
+    {
+        status = engine.deviceGeneration == 0 ? "Audio device not started" : "Audio device stopped";
+    }
+    else if (engine.callbacks == 0)
+    {
+        status = juce::String::formatted("Audio device started @ %0.1f Hz, %d samples", engine.sampleRate,
+                                         engine.blockSize);
+    }
+    else
+    {
+        status = juce::String::formatted("Streaming %d samples @ %0.1f Hz (queued frames: %d, dropped blocks: %llu)"
+                                         " | callback %.2f ms, max %.2f ms, xruns %llu",
+                                         engine.callbackFrames,
+                                         engine.sampleRate,
+                                         engine.queuedFrames,
+                                         static_cast<unsigned long long>(engine.droppedBlocks),
+                                         static_cast<double>(engine.lastCallbackNs) * 1.0e-6,
+                                         static_cast<double>(engine.maxCallbackNs) * 1.0e-6,
+                                         static_cast<unsigned long long>(engine.xruns));
+
+        const auto load = loadMeter.getSummary();
+        status += juce::String::formatted(" | DSP load p50 %.0f%%, p99 %.0f%%, max %.0f%% (late callbacks %llu)",
+                                          load.loadP50 * 100.0,
+                                          load.loadP99 * 100.0,
+                                          load.loadMax * 100.0,
+                                          static_cast<unsigned long long>(load.lateCallbacks));
+    }
+
+    const auto latency = bridgeClient.getBridgeLatency();
+    if (latency.blocks > 0)
+    {
+        status += juce::String::formatted(" | bridge latency p50 %.2f ms, p99 %.2f ms, p99.9 %.2f ms",
+                                          static_cast<double>(latency.p50Us) * 1.0e-3,
+                                          static_cast<double>(latency.p99Us) * 1.0e-3,
+                                          static_cast<double>(latency.p999Us) * 1.0e-3);
+    }
+
+    const auto stats = bridgeClient.getStatistics();
+    if (stats.probedCallbacks > 0)
+    {
+        status += juce::String::formatted(" | page faults in first %d callbacks: %d%s",
+                                          stats.probedCallbacks,
+                                          stats.probedPageFaults,
+                                          stats.memoryResidency.locked ? " (ring locked)" : "");
+    }
+    return status;
+}
+
+EngineTelemetry::Snapshot AudioEngine::getTelemetry() const
+{
+    return telemetry.snapshot();
+}
+
+const DspLoadMeter& AudioEngine::getDspLoadMeter() const
+{
+    return loadMeter;
 }
 
 void AudioEngine::prepareForVirtualOutput()
@@ -82,6 +138,16 @@ PluginManager& AudioEngine::getPluginManager()
     return pluginManager;
 }
 
+void AudioEngine::setMonitorEnabled(bool enabled)
+{
+    monitorOutput.store(enabled, std::memory_order_relaxed);
+}
+
+bool AudioEngine::isMonitorEnabled() const
+{
+    return monitorOutput.load(std::memory_order_relaxed);
+}
+
 bool AudioEngine::addPlugin(const juce::PluginDescription& description, juce::String& errorMessage)
 {
     auto* device = deviceManager.getCurrentAudioDevice();
@@ -94,9 +160,9 @@ bool AudioEngine::addPlugin(const juce::PluginDescription& description, juce::St
         return false;
     }
 
-    const auto identifier = createIdentifierString(description);
+    const auto identifier = PluginManager::createIdentifierString(description);
 
-    if (!pluginChain.addPlugin(std::move(instance), description.name, identifier))
+    if (!chains.getCurrent().addPlugin(std::move(instance), description.name, identifier))
     {
         errorMessage = "Unable to add plugin to processing graph";
         return false;
@@ -107,17 +173,22 @@ bool AudioEngine::addPlugin(const juce::PluginDescription& description, juce::St
 
 void AudioEngine::removePlugin(size_t index)
 {
-    pluginChain.removePlugin(index);
+    chains.getCurrent().removePlugin(index);
 }
 
 void AudioEngine::movePlugin(size_t index, int delta)
 {
-    pluginChain.movePlugin(index, delta);
+    chains.getCurrent().movePlugin(index, delta);
 }
 
 juce::StringArray AudioEngine::getLoadedPluginNames() const
 {
-    return pluginChain.getPluginNames();
+    return chains.getCurrent().getPluginNames();
+}
+
+void AudioEngine::setChainCrossfade(int milliseconds)
+{
+    chains.setCrossfadeMilliseconds(milliseconds);
 }
 
 const juce::Array<PresetManager::ChainPreset>& AudioEngine::getPresets() const
@@ -125,62 +196,35 @@ const juce::Array<PresetManager::ChainPreset>& AudioEngine::getPresets() const
     return presetManager.getPresets();
 }
 
-bool AudioEngine::applyPreset(const PresetManager::ChainPreset& preset, juce::String& errorMessage)
+void AudioEngine::applyPreset(const PresetManager::ChainPreset& preset,
+                              ChainBuilder::ProgressCallback onProgress,
+                              PresetLoadCallback onLoaded)
 {
-    pluginChain.initialiseDefaultChain();
-
-    const auto& knownList = pluginManager.getKnownPluginList();
     auto* device = deviceManager.getCurrentAudioDevice();
     const double sampleRate = device != nullptr ? device->getCurrentSampleRate() : kDefaultSampleRate;
     const int blockSize = device != nullptr ? device->getCurrentBufferSizeSamples() : kDefaultBufferSize;
 
-    for (const auto& pluginPreset : preset.plugins)
+    // The live chain keeps playing while the new one loads beside it. It is replaced
+    // unless every slot of a non-empty preset failed.
+    chainBuilder.build(preset,
+                       sampleRate,
+                       blockSize,
+                       std::move(onProgress),
+                       [this, onLoaded = std::move(onLoaded)](std::unique_ptr<PluginChain> chain,
+                                                              const juce::Array<ChainBuilder::SlotReport>& slots)
     {
-        auto type = knownList.getTypeForIdentifierString(pluginPreset.pluginId);
-        if (type == nullptr)
+        const bool anyLoaded = std::any_of(slots.begin(), slots.end(), [](const auto& slot) { return slot.loaded; });
+        const bool applied = slots.isEmpty() || anyLoaded;
+        if (applied)
         {
-            for (int i = 0; i < knownList.getNumTypes(); ++i)
-            {
-                if (auto* candidate = knownList.getType(i))
-                {
-                    if (candidate->name == pluginPreset.pluginName)
-                    {
-                        type = candidate;
-                        break;
-                    }
-                }
-            }
+            chains.publish(std::move(chain));
         }
 
-        if (type == nullptr)
+        if (onLoaded != nullptr)
         {
-            const auto label = pluginPreset.pluginName.isNotEmpty() ? pluginPreset.pluginName : pluginPreset.pluginId;
-            errorMessage = "Preset references unknown plugin: " + label;
-            return false;
+            onLoaded(applied, slots);
         }
-
-        auto instance = pluginManager.createPluginInstance(*type, sampleRate, blockSize, errorMessage);
-        if (instance == nullptr)
-        {
-            return false;
-        }
-
-        if (pluginPreset.state.getSize() > 0)
-        {
-            instance->setStateInformation(pluginPreset.state.getData(),
-                                          static_cast<int>(pluginPreset.state.getSize()));
-        }
-
-        const auto identifier = createIdentifierString(*type);
-
-        if (!pluginChain.addPlugin(std::move(instance), type->name, identifier))
-        {
-            errorMessage = "Failed to insert plugin into chain";
-            return false;
-        }
-    }
-
-    return true;
+    });
 }
 
 bool AudioEngine::saveCurrentChainAsPreset(const juce::String& presetName, juce::String& errorMessage)
@@ -248,7 +292,7 @@ PresetManager::ChainPreset AudioEngine::createPresetFromCurrentChain(const juce:
     preset.name = presetName;
     preset.isFactory = false;
 
-    pluginChain.forEachPlugin([&preset](juce::AudioProcessor& processor,
+    chains.getCurrent().forEachPlugin([&preset](juce::AudioProcessor& processor,
                                         const juce::String& pluginName,
                                         const juce::String& identifier)
     {
@@ -272,38 +316,133 @@ void AudioEngine::audioDeviceIOCallback(const float* const* inputChannelData,
                                         int numOutputChannels,
                                         int numSamples)
 {
-    juce::ignoreUnused(outputChannelData, numOutputChannels);
+    DspLoadMeter::CallbackTiming timing;
+    timing.entryNs = oceanaudio::sharedClockNanoseconds();
+    timing.frames = numSamples;
+    // Stage times summed over the slices; with one slice these are the timestamps.
+    std::uint64_t graphNs = 0;
+    std::uint64_t bridgeNs = 0;
+
+    const int capacity = processBuffer.getNumSamples();
+    const bool monitoring = monitorOutput.load(std::memory_order_relaxed);
+
+    // Devices may deliver more than they announced; take such callbacks in slices.
+    for (int offset = 0; capacity > 0 && offset < numSamples; offset += capacity)
+    {
+        const auto sliceStartNs = offset == 0 ? timing.entryNs : oceanaudio::sharedClockNanoseconds();
+        const int blockSamples = juce::jmin(capacity, numSamples - offset);
+        // Refers to the preallocated channels, so it does not allocate.
+        juce::AudioBuffer<float> block(processBuffer.getArrayOfWritePointers(),
+                                       PluginChain::kNumChannels,
+                                       blockSamples);
+
+        // The one copy: the device's input is read-only and the graph works in place.
+        // A mono input feeds both channels.
+        for (int channel = 0; channel < PluginChain::kNumChannels; ++channel)
+        {
+            const auto* source = numInputChannels > 0 ? inputChannelData[juce::jmin(channel, numInputChannels - 1)]
+                                                      : nullptr;
+            if (source != nullptr)
+            {
+                block.copyFrom(channel, 0, source + offset, blockSamples);
+            }
+            else
+            {
+                block.clear(channel, 0, blockSamples);
+            }
+        }
 
-    bridgeClient.sendAudio(inputChannelData, numInputChannels, numSamples);
+        midiBuffer.clear();
+        chains.process(block, midiBuffer);
+        const auto graphDoneNs = oceanaudio::sharedClockNanoseconds();
+        bridgeClient.sendAudio(block.getArrayOfReadPointers(), PluginChain::kNumChannels, blockSamples);
+        const auto bridgeDoneNs = oceanaudio::sharedClockNanoseconds();
+        graphNs += graphDoneNs - sliceStartNs;
+        bridgeNs += bridgeDoneNs - graphDoneNs;
 
-    auto* device = deviceManager.getCurrentAudioDevice();
-    const auto sampleRate = device != nullptr ? device->getCurrentSampleRate() : 0.0;
+        for (int channel = 0; channel < numOutputChannels; ++channel)
+        {
+            if (auto* destination = outputChannelData[channel])
+            {
+                if (monitoring && channel < PluginChain::kNumChannels)
+                {
+                    juce::FloatVectorOperations::copy(destination + offset,
+                                                      block.getReadPointer(channel),
+                                                      blockSamples);
+                }
+                else
+                {
+                    juce::FloatVectorOperations::clear(destination + offset, blockSamples);
+                }
+            }
+        }
+    }
 
-    const auto stats = bridgeClient.getStatistics();
-    lastStatus = juce::String::formatted("Streaming %d samples @ %0.1f Hz (queued frames: %d, dropped blocks: %d)",
-                                         numSamples,
-                                         sampleRate,
-                                         stats.queuedFrames,
-                                         stats.droppedBlocks);
+    if (capacity == 0)
+    {
+        // Not prepared yet: play silence.
+        for (int channel = 0; channel < numOutputChannels; ++channel)
+        {
+            if (auto* destination = outputChannelData[channel])
+            {
+                juce::FloatVectorOperations::clear(destination, numSamples);
+            }
+        }
+    }
+
+    timing.graphNs = timing.entryNs + graphNs;
+    timing.bridgeNs = timing.graphNs + bridgeNs;
+    timing.exitNs = oceanaudio::sharedClockNanoseconds();
+    const auto load = loadMeter.record(timing);
+
+    const auto durationNs = timing.exitNs - timing.entryNs;
+    auto& values = deviceTelemetry;
+    values.callbackFrames = numSamples;
+    values.queuedFrames = bridgeClient.getQueuedFrames();
+    values.droppedBlocks = bridgeClient.getDroppedBlocks();
+    ++values.callbacks;
+    values.lastCallbackNs = durationNs;
+    values.maxCallbackNs = juce::jmax(values.maxCallbackNs, durationNs);
+    values.load = load.load;
+    if (load.xrun)
+    {
+        ++values.xruns;
+    }
+    telemetry.publish(values);
 }
 
 void AudioEngine::audioDeviceAboutToStart(juce::AudioIODevice* device)
 {
     if (device == nullptr)
     {
-        lastStatus = "Audio device unavailable";
+        deviceTelemetry.running = false;
+        telemetry.publish(deviceTelemetry);
         return;
     }
 
-    bridgeClient.setFormat(static_cast<int>(device->getCurrentSampleRate()),
-                           device->getCurrentBufferSizeSamples(),
-                           device->getActiveInputChannels().countNumberOfSetBits());
-
-    lastStatus = "Audio device started";
+    const auto sampleRate = device->getCurrentSampleRate();
+    const auto blockSize = device->getCurrentBufferSizeSamples();
+    processBuffer.setSize(PluginChain::kNumChannels, blockSize);
+    chains.prepareToPlay(sampleRate, blockSize);
+    loadMeter.prepare(sampleRate);
+
+    // The bridge carries the chain's output, so its format is the chain's.
+    bridgeClient.setFormat(static_cast<int>(sampleRate), blockSize, PluginChain::kNumChannels);
+
+    // Counters start over with every device start; the generation tells readers so.
+    const auto generation = deviceTelemetry.deviceGeneration + 1;
+    deviceTelemetry = {};
+    deviceTelemetry.sampleRate = sampleRate;
+    deviceTelemetry.blockSize = blockSize;
+    deviceTelemetry.deviceGeneration = generation;
+    deviceTelemetry.running = true;
+    telemetry.publish(deviceTelemetry);
 }
 
 void AudioEngine::audioDeviceStopped()
 {
-    lastStatus = "Audio device stopped";
+    chains.releaseResources();
+    deviceTelemetry.running = false;
+    telemetry.publish(deviceTelemetry);
 }
 
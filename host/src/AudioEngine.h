@@ -1,12 +1,21 @@
 #pragma once
 
 #include "BridgeClient.h"
+#include "ChainBuilder.h"
+#include "ChainSwitcher.h"
+#include "DspLoadMeter.h"
+#include "EngineTelemetry.h"
 #include "PluginChain.h"
 #include "PluginManager.h"
 #include "PresetManager.h"
 
 #include <juce_audio_utils/juce_audio_utils.h>
 
+#include <atomic>
+
+// Owns the device and its only callback, which runs the plugin chain in place on a
+// preallocated buffer and hands the processed audio to the bridge, and optionally to
+// the device outputs for monitoring.
 class AudioEngine final : private juce::AudioIODeviceCallback
 {
 public:
@@ -14,18 +23,38 @@ public:
     ~AudioEngine() override;
 
     void openDeviceSettings();
+    // Formats the telemetry snapshot; any thread but the audio thread.
     juce::String getStatusText() const;
+    EngineTelemetry::Snapshot getTelemetry() const;
+    // Per-stage callback timing and load histograms; logged to
+    // OceanAudio/Logs/DspLoad.log under the user's application data every 10 s.
+    const DspLoadMeter& getDspLoadMeter() const;
 
     void prepareForVirtualOutput();
     PluginManager& getPluginManager();
 
+    // Whether the processed chain also plays on the device outputs; the bridge gets
+    // it either way. On by default.
+    void setMonitorEnabled(bool enabled);
+    bool isMonitorEnabled() const;
+
     bool addPlugin(const juce::PluginDescription& description, juce::String& errorMessage);
     void removePlugin(size_t index);
     void movePlugin(size_t index, int delta);
     juce::StringArray getLoadedPluginNames() const;
+    // Crossfade applied when a preset replaces the chain; 50 ms by default.
+    void setChainCrossfade(int milliseconds);
 
     const juce::Array<PresetManager::ChainPreset>& getPresets() const;
-    bool applyPreset(const PresetManager::ChainPreset& preset, juce::String& errorMessage);
+    // Message thread. Loads the preset's chain in the background (see ChainBuilder) and
+    // crossfades to it once built; slots that fail are reported and left out. Starting
+    // another preset drops a load still in progress. `applied` is false when nothing
+    // of a non-empty preset loaded, in which case the live chain stays.
+    using PresetLoadCallback
+        = std::function<void(bool applied, const juce::Array<ChainBuilder::SlotReport>& slots)>;
+    void applyPreset(const PresetManager::ChainPreset& preset,
+                     ChainBuilder::ProgressCallback onProgress,
+                     PresetLoadCallback onLoaded);
     bool saveCurrentChainAsPreset(const juce::String& presetName, juce::String& errorMessage);
     bool removeUserPreset(int userIndex, juce::String& errorMessage);
     bool updateUserPreset(int userIndex, const PresetManager::ChainPreset& preset, juce::String& errorMessage);
@@ -42,11 +71,20 @@ private:
     void audioDeviceStopped() override;
 
     juce::AudioDeviceManager deviceManager;
-    juce::AudioProcessorPlayer processorPlayer;
-    PluginChain pluginChain;
+    ChainSwitcher chains;
     PluginManager pluginManager;
+    ChainBuilder chainBuilder {pluginManager};
     PresetManager presetManager;
     BridgeClient bridgeClient;
-    juce::String lastStatus;
+    EngineTelemetry telemetry;
+    DspLoadMeter loadMeter;
+    // The device callbacks' working copy, published after every change.
+    EngineTelemetry::Snapshot deviceTelemetry;
+
+    // Sized for the device's block in audioDeviceAboutToStart(); the callback only
+    // ever refers to it.
+    juce::AudioBuffer<float> processBuffer;
+    juce::MidiBuffer midiBuffer;
+    std::atomic<bool> monitorOutput {true};
 };
 
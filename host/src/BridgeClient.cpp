@@ -1,6 +1,11 @@
 #include "BridgeClient.h"
 
+#include <OceanAudio/InterleaveKernels.h>
+#include <OceanAudio/WakeupSignalling.h>
+
+#include <bit>
 #include <cstring>
+#include <string>
 
 #if JUCE_WINDOWS
     #define NOMINMAX
@@ -15,19 +20,34 @@ constexpr wchar_t kAudioReadyEventName[] = L"Global\\OceanAudio_AudioReady";
 constexpr wchar_t kAudioConsumedEventName[] = L"Global\\OceanAudio_AudioConsumed";
 #endif
 
+// Well inside oceanaudio::kDefaultPeerTimeoutMs, so a couple of late ticks never look
+// like a dead producer.
+constexpr int kHeartbeatIntervalMs = 50;
+
 constexpr int kMinCapacityMultiplier = 16;
 constexpr int kMaxCapacitySamples = 1 << 19; // 524,288 frames
-} // namespace
 
-BridgeClient::BridgeClient()
-    : connected(false)
-#if !JUCE_WINDOWS
-    , fifo(1024)
-    , fifoCapacity(1024)
-#endif
+// The mapping is sized for at least this block size and channel count, so device
+// switches within it (rate, block size, stereo/mono) are applied in place instead of
+// tearing the mapping down under the readers. 4096-frame stereo reserves 512 KiB.
+constexpr int kReservedFramesPerBlock = 4096;
+constexpr int kReservedChannels = 2;
+
+int computeRingCapacity(int framesPerBlock)
 {
+    // The ring masks its cursors, so the capacity must stay a power of two.
+    return juce::jmin(juce::nextPowerOfTwo(framesPerBlock * kMinCapacityMultiplier), kMaxCapacitySamples);
 }
 
+std::size_t computePayloadReservation(int channels, int framesPerBlock)
+{
+    return static_cast<std::size_t>(computeRingCapacity(juce::jmax(framesPerBlock, kReservedFramesPerBlock)))
+           * static_cast<std::size_t>(juce::jmax(channels, kReservedChannels)) * sizeof(float);
+}
+} // namespace
+
+BridgeClient::BridgeClient() = default;
+
 BridgeClient::~BridgeClient()
 {
     disconnect();
@@ -35,54 +55,52 @@ BridgeClient::~BridgeClient()
 
 void BridgeClient::connect()
 {
-    const juce::ScopedLock guard(lock);
-    stats.droppedBlocks = 0;
-    stats.queuedFrames = 0;
-#if JUCE_WINDOWS
-    if (sharedMemory.header == nullptr && stats.channels > 0 && stats.bufferSize > 0)
     {
-        ensureSharedMemory(stats.channels, stats.sampleRate, stats.bufferSize);
-    }
-#else
-    fifo.reset();
-    pendingBlocks.clearQuick();
-    ensureBuffer(stats.channels > 0 ? stats.channels : 2, fifoCapacity);
+        const juce::ScopedLock guard(lock);
+        droppedBlocks.store(0, std::memory_order_relaxed);
+        queuedFrames.store(0, std::memory_order_relaxed);
+        idleBlocks.store(0, std::memory_order_relaxed);
+
+#if JUCE_LINUX
+        if (transport == Transport::UnixSocket && !socketServer.isListening())
+        {
+            const auto path = transportSocketPath.isNotEmpty() ? transportSocketPath.toStdString()
+                                                               : oceanaudio::posix::defaultBridgeSocketPath();
+            if (!socketServer.listen(path))
+            {
+                // Another producer owns the socket; stay reachable by name instead.
+                DBG("BridgeClient: cannot listen on " << juce::String(path) << ", publishing the named mapping");
+            }
+        }
 #endif
-    connected = true;
+
+        if (sharedMemory.header == nullptr && stats.channels > 0 && stats.bufferSize > 0)
+        {
+            const juce::SpinLock::ScopedLockType realtimeGuard(realtimeLock);
+            ensureSharedMemory(stats.channels, stats.sampleRate, stats.bufferSize);
+        }
+
+        connected.store(true, std::memory_order_release);
+    }
+
+    startTimer(kHeartbeatIntervalMs);
 }
 
 void BridgeClient::disconnect()
 {
+    // Outside `lock`: the timer callback takes it, and stopTimer waits for the callback.
+    stopTimer();
+
     const juce::ScopedLock guard(lock);
-    connected = false;
-#if JUCE_WINDOWS
+    connected.store(false, std::memory_order_release);
+
+    const juce::SpinLock::ScopedLockType realtimeGuard(realtimeLock);
     destroySharedMemory();
-#else
-    pendingBlocks.clearQuick();
-    fifo.reset();
-    transferBuffer.setSize(0, 0, false, false, true);
+#if JUCE_LINUX
+    socketServer.close();
 #endif
 }
 
-#if !JUCE_WINDOWS
-void BridgeClient::ensureBuffer(int channels, int capacitySamples)
-{
-    if (channels <= 0)
-    {
-        channels = 2;
-    }
-
-    if (transferBuffer.getNumChannels() != channels || transferBuffer.getNumSamples() < capacitySamples)
-    {
-        transferBuffer.setSize(channels,
-                               juce::jmax(capacitySamples, transferBuffer.getNumSamples()),
-                               false,
-                               false,
-                               true);
-    }
-}
-#endif
-
 void BridgeClient::sendAudio(const float* const* samples, int numChannels, int numSamples)
 {
     if (samples == nullptr || numChannels <= 0 || numSamples <= 0)
@@ -90,50 +108,44 @@ void BridgeClient::sendAudio(const float* const* samples, int numChannels, int n
         return;
     }
 
-    const juce::ScopedLock guard(lock);
-    if (!connected)
+    if (!connected.load(std::memory_order_acquire))
     {
         return;
     }
 
-#if JUCE_WINDOWS
-    if (!writeToSharedMemory(samples, numChannels, numSamples))
+    // Nobody has read for a while: leave the ring alone rather than fill it for no one.
+    if (!consumerAlive.load(std::memory_order_relaxed))
     {
-        ++stats.droppedBlocks;
+        idleBlocks.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
-#else
-    ensureBuffer(numChannels, fifoCapacity);
 
-    int start1 = 0, size1 = 0, start2 = 0, size2 = 0;
-    if (!fifo.write(numSamples, start1, size1, start2, size2))
+    const juce::SpinLock::ScopedTryLockType realtimeGuard(realtimeLock);
+    if (!realtimeGuard.isLocked())
     {
-        ++stats.droppedBlocks;
+        droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        ++unpublishedDrops;
         return;
     }
 
-    for (int channel = 0; channel < numChannels; ++channel)
-    {
-        if (size1 > 0)
-        {
-            transferBuffer.copyFrom(channel, start1, samples[channel], size1);
-        }
-        if (size2 > 0)
-        {
-            transferBuffer.copyFrom(channel, start2, samples[channel] + size1, size2);
-        }
-    }
+    // Reading the fault counter is a system call, so only the first callbacks after a
+    // new mapping or format are probed.
+    const bool probing = probeCallbacksLeft.load(std::memory_order_relaxed) > 0;
+    const auto faultsBefore = probing ? oceanaudio::threadPageFaults() : 0;
 
-    if (size1 > 0)
+    if (!writeToSharedMemory(samples, numChannels, numSamples))
     {
-        pendingBlocks.add({start1, size1});
-        stats.queuedFrames += size1;
+        droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        ++unpublishedDrops;
     }
-    if (size2 > 0)
+
+    if (probing)
     {
-        pendingBlocks.add({start2, size2});
-        stats.queuedFrames += size2;
+        probedPageFaults.fetch_add(static_cast<int>(oceanaudio::threadPageFaults() - faultsBefore),
+                                   std::memory_order_relaxed);
+        probedCallbacks.fetch_add(1, std::memory_order_relaxed);
+        probeCallbacksLeft.fetch_sub(1, std::memory_order_relaxed);
     }
-#endif
 }
 
 void BridgeClient::setFormat(int sampleRate, int bufferSize, int channels)
@@ -143,90 +155,186 @@ void BridgeClient::setFormat(int sampleRate, int bufferSize, int channels)
     stats.bufferSize = bufferSize;
     stats.channels = channels;
 
-#if JUCE_WINDOWS
-    if (connected && channels > 0 && bufferSize > 0)
+    if (connected.load(std::memory_order_relaxed) && channels > 0 && bufferSize > 0)
     {
+        const juce::SpinLock::ScopedLockType realtimeGuard(realtimeLock);
         ensureSharedMemory(channels, sampleRate, bufferSize);
     }
-#else
-    fifoCapacity = juce::nextPowerOfTwo(bufferSize * kMinCapacityMultiplier);
-    fifoCapacity = juce::jlimit(bufferSize * kMinCapacityMultiplier, kMaxCapacitySamples, fifoCapacity);
-    fifo.setTotalSize(fifoCapacity);
-    pendingBlocks.clearQuick();
-    fifo.reset();
-    ensureBuffer(channels, fifoCapacity);
-#endif
 }
 
 bool BridgeClient::isConnected() const
+{
+    return connected.load(std::memory_order_acquire);
+}
+
+void BridgeClient::setMemorySettings(const MemorySettings& settings)
 {
     const juce::ScopedLock guard(lock);
-    return connected;
+    memorySettings = settings;
 }
 
-BridgeClient::Statistics BridgeClient::getStatistics() const
+void BridgeClient::setConsumerTimeout(int milliseconds)
 {
     const juce::ScopedLock guard(lock);
-    return stats;
+    consumerTimeoutMs = juce::jmax(milliseconds, 0);
+    beatHeartbeat();
 }
 
-#if !JUCE_WINDOWS
-bool BridgeClient::popPendingBlock(juce::AudioBuffer<float>& buffer, int& validSamples)
+void BridgeClient::setTransport(Transport newTransport, const juce::String& socketPath)
 {
     const juce::ScopedLock guard(lock);
-    if (pendingBlocks.isEmpty())
+    transport = newTransport;
+    transportSocketPath = socketPath;
+}
+
+void BridgeClient::setBlockChecksums(bool enabled)
+{
+    blockChecksums.store(enabled, std::memory_order_relaxed);
+}
+
+void BridgeClient::hiResTimerCallback()
+{
+    const juce::ScopedLock guard(lock);
+    beatHeartbeat();
+#if JUCE_LINUX
+    // New consumers get the ring within one tick; nothing here blocks.
+    socketServer.acceptPending();
+#endif
+}
+
+void BridgeClient::beatHeartbeat()
+{
+    auto* header = sharedMemory.header;
+    if (header == nullptr)
     {
-        return false;
+        consumerAlive.store(false, std::memory_order_relaxed);
+        return;
     }
 
-    const auto pending = pendingBlocks.removeAndReturn(0);
-    validSamples = pending.size;
+    const auto now = oceanaudio::sharedClockNanoseconds();
+    header->producerHeartbeat.beat(now);
+    if (consumerTimeoutMs == 0)
+    {
+        consumerAlive.store(true, std::memory_order_relaxed);
+        return;
+    }
 
-    if (buffer.getNumChannels() != transferBuffer.getNumChannels()
-        || buffer.getNumSamples() < pending.size)
+    // `lock` keeps the mapping alive; evictions race only with readers, which the slot
+    // protocol handles, so the audio thread is never held up.
+    const auto timeoutNs = static_cast<std::uint64_t>(consumerTimeoutMs) * 1'000'000;
+    header->evictDeadReaders(now, timeoutNs);
+    consumerAlive.store(header->anyReaderAlive(now, timeoutNs), std::memory_order_relaxed);
+}
+
+int BridgeClient::getQueuedFrames() const noexcept
+{
+    return queuedFrames.load(std::memory_order_relaxed);
+}
+
+std::uint64_t BridgeClient::getDroppedBlocks() const noexcept
+{
+    return droppedBlocks.load(std::memory_order_relaxed);
+}
+
+BridgeClient::Statistics BridgeClient::getStatistics() const
+{
+    const juce::ScopedLock guard(lock);
+    auto snapshot = stats;
+    snapshot.droppedBlocks = droppedBlocks.load(std::memory_order_relaxed);
+    snapshot.queuedFrames = queuedFrames.load(std::memory_order_relaxed);
+    snapshot.consumerAlive = consumerAlive.load(std::memory_order_relaxed);
+    snapshot.idleBlocks = idleBlocks.load(std::memory_order_relaxed);
+    snapshot.probedCallbacks = probedCallbacks.load(std::memory_order_relaxed);
+    snapshot.probedPageFaults = probedPageFaults.load(std::memory_order_relaxed);
+    if (sharedMemory.header != nullptr)
     {
-        buffer.setSize(transferBuffer.getNumChannels(), pending.size, false, false, true);
+        snapshot.formatGeneration
+            = static_cast<int>(sharedMemory.header->formatGeneration.load(std::memory_order_relaxed));
+        snapshot.attachedReaders
+            = std::popcount(sharedMemory.header->attachedReaders.load(std::memory_order_relaxed));
+        snapshot.readerDetachments
+            = static_cast<int>(sharedMemory.header->readerDetachments.load(std::memory_order_relaxed));
+        snapshot.readerEvictions
+            = static_cast<int>(sharedMemory.header->readerEvictions.load(std::memory_order_relaxed));
     }
+#if JUCE_LINUX
+    snapshot.socketClients = static_cast<int>(socketServer.clientCount());
+#endif
+    return snapshot;
+}
 
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+BridgeClient::LatencySummary BridgeClient::getBridgeLatency() const
+{
+    const juce::ScopedLock guard(lock);
+    LatencySummary summary;
+    if (sharedMemory.header == nullptr)
     {
-        buffer.copyFrom(channel, 0, transferBuffer, channel, pending.offset, pending.size);
+        return summary;
     }
 
-    fifo.finishedRead(pending.size);
-    stats.queuedFrames = juce::jmax(0, stats.queuedFrames - pending.size);
-    return true;
+    const auto& residency = sharedMemory.header->residency;
+    summary.blocks = residency.totalCount.load(std::memory_order_relaxed);
+    summary.p50Us = residency.percentileUs(0.50);
+    summary.p99Us = residency.percentileUs(0.99);
+    summary.p999Us = residency.percentileUs(0.999);
+    summary.maxUs = residency.maxValueUs.load(std::memory_order_relaxed);
+    return summary;
 }
-#endif
 
-#if JUCE_WINDOWS
 void BridgeClient::ensureSharedMemory(int channels, int sampleRate, int framesPerBlock)
 {
     jassert(channels > 0);
     jassert(framesPerBlock > 0);
 
-    const int desiredCapacity = juce::nextPowerOfTwo(framesPerBlock * kMinCapacityMultiplier);
-    const int capacity = juce::jlimit(framesPerBlock * kMinCapacityMultiplier, kMaxCapacitySamples, desiredCapacity);
-    const std::size_t requiredBytes = sizeof(oceanaudio::SharedAudioRingBufferHeader)
-        + static_cast<std::size_t>(capacity) * static_cast<std::size_t>(channels) * sizeof(float);
-
+    const int capacity = computeRingCapacity(framesPerBlock);
     if (sharedMemory.header != nullptr
-        && sharedMemory.header->channels == static_cast<std::uint32_t>(channels)
-        && sharedMemory.header->frameCapacity == static_cast<std::uint32_t>(capacity))
+        && sharedMemory.header->fitsReservation(static_cast<std::uint32_t>(channels), static_cast<std::uint32_t>(capacity)))
     {
-        sharedMemory.header->sampleRate = static_cast<std::uint32_t>(sampleRate);
-        sharedMemory.header->framesPerBlock = static_cast<std::uint32_t>(framesPerBlock);
+        publishFormat(channels, sampleRate, capacity, framesPerBlock);
+        startPageFaultProbe();
         return;
     }
 
+    // Too big for the reservation: retire this mapping (readers reopen) and make a
+    // larger one.
     destroySharedMemory();
 
-    HANDLE mappingHandle = CreateFileMappingW(INVALID_HANDLE_VALUE,
-                                              nullptr,
-                                              PAGE_READWRITE,
-                                              0,
-                                              static_cast<DWORD>(requiredBytes),
-                                              kMappingName);
+    const auto& residencyOptions = memorySettings.residency;
+    const std::size_t hugePageBytes = residencyOptions.hugePages ? oceanaudio::hugePageSize() : 0;
+
+    // Huge pages need the whole mapping in whole huge pages; the rounding goes to the
+    // payload reservation.
+    const std::size_t requiredBytes = oceanaudio::roundUpToMultiple(
+        sizeof(oceanaudio::SharedAudioRingBufferHeader) + computePayloadReservation(channels, framesPerBlock),
+        hugePageBytes);
+    const std::size_t payloadBytes = requiredBytes - sizeof(oceanaudio::SharedAudioRingBufferHeader);
+
+#if JUCE_WINDOWS
+    // A large-page section is committed and non-pageable from the start; if the
+    // privilege or enough contiguous memory is missing, fall back to a normal one.
+    HANDLE mappingHandle = nullptr;
+    bool largePages = false;
+    if (hugePageBytes > 0 && oceanaudio::enableLockMemoryPrivilege())
+    {
+        mappingHandle = CreateFileMappingW(INVALID_HANDLE_VALUE,
+                                           nullptr,
+                                           PAGE_READWRITE | SEC_COMMIT | SEC_LARGE_PAGES,
+                                           0,
+                                           static_cast<DWORD>(requiredBytes),
+                                           kMappingName);
+        largePages = mappingHandle != nullptr && GetLastError() != ERROR_ALREADY_EXISTS;
+    }
+
+    if (mappingHandle == nullptr)
+    {
+        mappingHandle = CreateFileMappingW(INVALID_HANDLE_VALUE,
+                                           nullptr,
+                                           PAGE_READWRITE,
+                                           0,
+                                           static_cast<DWORD>(requiredBytes),
+                                           kMappingName);
+    }
+
     if (mappingHandle == nullptr)
     {
         jassertfalse;
@@ -245,32 +353,171 @@ void BridgeClient::ensureSharedMemory(int channels, int sampleRate, int framesPe
     }
 
     sharedMemory.mappingHandle = mappingHandle;
+
+    auto pagingOptions = residencyOptions;
+    pagingOptions.hugePages = false;
+    pagingOptions.lock = residencyOptions.lock && !largePages;
+    stats.memoryResidency = oceanaudio::makeResident(header, requiredBytes, pagingOptions);
+    stats.memoryResidency.hugePages = largePages;
+    stats.memoryResidency.locked = stats.memoryResidency.locked || largePages;
+#else
+    bool newlyCreated = false;
+    if (!createPosixMapping(requiredBytes, hugePageBytes, newlyCreated))
+    {
+        jassertfalse;
+        return;
+    }
+
+    auto* header = static_cast<oceanaudio::SharedAudioRingBufferHeader*>(posixMapping.data());
+
+    // Before the layout check below writes to it, so huge-page advice still applies to
+    // a fresh object's pages.
+    stats.memoryResidency = oceanaudio::makeResident(header, requiredBytes, residencyOptions);
+#endif
+
     sharedMemory.header = header;
     sharedMemory.mappedSizeBytes = requiredBytes;
 
-    if (newlyCreated
-        || header->magic != oceanaudio::SharedAudioRingBufferHeader::kMagic
-        || header->version != oceanaudio::SharedAudioRingBufferHeader::kVersion)
+    const auto layoutStatus = newlyCreated ? oceanaudio::SharedLayoutStatus::Uninitialised
+                                           : oceanaudio::checkSharedLayoutVersion(header);
+    if (layoutStatus != oceanaudio::SharedLayoutStatus::Compatible)
     {
-        std::memset(header, 0, requiredBytes);
+        if (!newlyCreated)
+        {
+            DBG("BridgeClient: reinitialising existing bridge mapping ("
+                << oceanaudio::toString(layoutStatus) << ")");
+        }
+
+        std::memset(static_cast<void*>(header), 0, requiredBytes);
         header->magic = oceanaudio::SharedAudioRingBufferHeader::kMagic;
         header->version = oceanaudio::SharedAudioRingBufferHeader::kVersion;
     }
+    header->payloadCapacityBytes = payloadBytes;
+
+    // Beat before publishing the format, so readers waiting on a mapping we took over
+    // from a dead producer see it come back to life straight away. Readers that died
+    // with it are evicted here too.
+    beatHeartbeat();
 
-    header->channels = static_cast<std::uint32_t>(channels);
-    header->sampleRate = static_cast<std::uint32_t>(sampleRate);
-    header->frameCapacity = static_cast<std::uint32_t>(capacity);
-    header->framesPerBlock = static_cast<std::uint32_t>(framesPerBlock);
-    header->writePosition.store(0, std::memory_order_release);
-    header->readPosition.store(0, std::memory_order_release);
-    header->framesAvailable.store(0, std::memory_order_release);
+    // A mapping left by an earlier producer (readers still holding it keep the name
+    // alive) is taken over like any other format change: its readers keep their slots
+    // and move to the new generation.
+    publishFormat(channels, sampleRate, capacity, framesPerBlock);
 
-    sharedMemory.audioReadyEvent = CreateEventW(nullptr, FALSE, FALSE, kAudioReadyEventName);
+#if JUCE_WINDOWS
+    for (std::uint32_t slot = 0; slot < oceanaudio::kMaxBroadcastReaders; ++slot)
+    {
+        const auto eventName = oceanaudio::readerEventName(std::wstring(kAudioReadyEventName), slot);
+        sharedMemory.audioReadyEvents[slot] = CreateEventW(nullptr, FALSE, FALSE, eventName.c_str());
+    }
     sharedMemory.audioConsumedEvent = CreateEventW(nullptr, FALSE, TRUE, kAudioConsumedEventName);
+#else
+    createPosixEvents();
+#endif
+
+    startPageFaultProbe();
+}
+
+#if !JUCE_WINDOWS
+bool BridgeClient::createPosixMapping(std::size_t requiredBytes, std::size_t hugePageBytes, bool& newlyCreated)
+{
+#if JUCE_LINUX
+    if (socketServer.isListening())
+    {
+        // Nobody else can reach an anonymous object, so there is never one to take over.
+        newlyCreated = true;
+        return posixMapping.createAnonymous(oceanaudio::posix::kAnonymousMappingName, requiredBytes, hugePageBytes);
+    }
+#endif
+    return posixMapping.create(oceanaudio::posix::kMappingName, requiredBytes, newlyCreated, hugePageBytes);
+}
+
+void BridgeClient::createPosixEvents()
+{
+#if JUCE_LINUX
+    if (socketServer.isListening())
+    {
+        int descriptors[oceanaudio::posix::kAnnouncedDescriptorCount];
+        descriptors[oceanaudio::posix::kAnnouncedRingDescriptor] = posixMapping.descriptor();
+        posixAudioConsumedEvent.createDescriptor(true);
+        descriptors[oceanaudio::posix::kAnnouncedConsumedEventDescriptor] = posixAudioConsumedEvent.descriptor();
+        for (std::uint32_t slot = 0; slot < oceanaudio::kMaxBroadcastReaders; ++slot)
+        {
+            posixAudioReadyEvents[slot].createDescriptor(false);
+            descriptors[oceanaudio::posix::kAnnouncedReadyEventDescriptor + slot] = posixAudioReadyEvents[slot].descriptor();
+        }
+
+        // Connected consumers get the new ring now, later ones when they are accepted.
+        oceanaudio::posix::SocketBridgeAnnouncement announcement;
+        announcement.layoutVersion = oceanaudio::SharedAudioRingBufferHeader::kVersion;
+        announcement.descriptorCount = oceanaudio::posix::kAnnouncedDescriptorCount;
+        socketServer.announce(announcement, descriptors);
+        return;
+    }
+#endif
+
+    for (std::uint32_t slot = 0; slot < oceanaudio::kMaxBroadcastReaders; ++slot)
+    {
+        posixAudioReadyEvents[slot].create(
+            oceanaudio::readerEventName(std::string(oceanaudio::posix::kAudioReadyEventName), slot), false);
+    }
+    posixAudioConsumedEvent.create(oceanaudio::posix::kAudioConsumedEventName, true);
+}
+#endif
+
+void BridgeClient::publishFormat(int channels, int sampleRate, int capacity, int framesPerBlock)
+{
+    auto* header = sharedMemory.header;
+
+    // New-format frames start one old capacity past the last old-format frame. Cursors
+    // never go backwards, and a Skip reader still holding old frames finds them
+    // overwritten rather than reading new-format data at the old stride.
+    // The format goes out before the cursor moves, so a reader that sees the jump also
+    // sees the new generation and does not read the gap as frames.
+    const auto previousCapacity = header->frameCapacity.load(std::memory_order_relaxed);
+    const auto startFrame = header->writeCursor.load(std::memory_order_relaxed) + previousCapacity;
+    const auto generation = header->writeFormat(static_cast<std::uint32_t>(channels),
+                                                static_cast<std::uint32_t>(sampleRate),
+                                                static_cast<std::uint32_t>(capacity),
+                                                static_cast<std::uint32_t>(framesPerBlock),
+                                                startFrame);
+    header->writeCursor.store(startFrame, std::memory_order_release);
+
+    // Writes are held back until every Stall reader has finished its current span and
+    // moved to the new generation, which takes them one wakeup.
+    ringProducer.setFormatGeneration(generation);
+    ringProducer.attach(header->writeCursor,
+                        header->readers,
+                        static_cast<std::uint32_t>(capacity),
+                        &header->readerDetachments);
+    queuedFrames.store(0, std::memory_order_relaxed);
+
+    // Sleeping readers would otherwise only notice on their wait timeout.
+    header->wakeSleepingReaders([this, header](std::uint32_t slot) { signalReader(header, slot); });
+}
+
+void BridgeClient::startPageFaultProbe()
+{
+    // Runs under realtimeLock, so no callback is in the middle of a probe.
+    probedCallbacks.store(0, std::memory_order_relaxed);
+    probedPageFaults.store(0, std::memory_order_relaxed);
+    probeCallbacksLeft.store(juce::jmax(memorySettings.pageFaultProbeCallbacks, 0), std::memory_order_relaxed);
 }
 
 void BridgeClient::destroySharedMemory()
 {
+    ringProducer.detach();
+    queuedFrames.store(0, std::memory_order_relaxed);
+
+    if (auto* header = sharedMemory.header)
+    {
+        // Readers may keep this mapping alive after we let go; tell them to reopen.
+        header->formatGeneration.store(oceanaudio::SharedAudioRingBufferHeader::kFormatRetired,
+                                       std::memory_order_release);
+        header->wakeSleepingReaders([this, header](std::uint32_t slot) { signalReader(header, slot); });
+    }
+
+#if JUCE_WINDOWS
     if (sharedMemory.header != nullptr)
     {
         UnmapViewOfFile(sharedMemory.header);
@@ -283,10 +530,13 @@ void BridgeClient::destroySharedMemory()
         sharedMemory.mappingHandle = nullptr;
     }
 
-    if (sharedMemory.audioReadyEvent != nullptr)
+    for (auto& readyEvent : sharedMemory.audioReadyEvents)
     {
-        CloseHandle(static_cast<HANDLE>(sharedMemory.audioReadyEvent));
-        sharedMemory.audioReadyEvent = nullptr;
+        if (readyEvent != nullptr)
+        {
+            CloseHandle(static_cast<HANDLE>(readyEvent));
+            readyEvent = nullptr;
+        }
     }
 
     if (sharedMemory.audioConsumedEvent != nullptr)
@@ -294,8 +544,24 @@ void BridgeClient::destroySharedMemory()
         CloseHandle(static_cast<HANDLE>(sharedMemory.audioConsumedEvent));
         sharedMemory.audioConsumedEvent = nullptr;
     }
+#else
+#if JUCE_LINUX
+    // Before the descriptors it hands out are closed.
+    socketServer.withdraw();
+#endif
+    sharedMemory.header = nullptr;
+    posixMapping.close();
+    for (auto& readyEvent : posixAudioReadyEvents)
+    {
+        readyEvent.close();
+    }
+    posixAudioConsumedEvent.close();
+#endif
 
     sharedMemory.mappedSizeBytes = 0;
+    stats.memoryResidency = {};
+    consumerAlive.store(false, std::memory_order_relaxed);
+    probeCallbacksLeft.store(0, std::memory_order_relaxed);
 }
 
 bool BridgeClient::writeToSharedMemory(const float* const* samples, int numChannels, int numSamples)
@@ -306,46 +572,68 @@ bool BridgeClient::writeToSharedMemory(const float* const* samples, int numChann
         return false;
     }
 
-    const int channels = static_cast<int>(header->channels);
+    const int channels = static_cast<int>(header->channels.load(std::memory_order_relaxed));
     if (channels <= 0)
     {
         return false;
     }
 
-    const int capacity = static_cast<int>(header->frameCapacity);
-    const int available = static_cast<int>(header->framesAvailable.load(std::memory_order_acquire));
-    if (numSamples > capacity || available + numSamples > capacity)
+    oceanaudio::SpscRingRegions regions;
+    if (!ringProducer.prepareWrite(static_cast<std::uint32_t>(numSamples), regions))
     {
         header->overruns.fetch_add(1, std::memory_order_relaxed);
-        stats.queuedFrames = capacity;
+        queuedFrames.store(static_cast<int>(ringProducer.capacity()), std::memory_order_relaxed);
         return false;
     }
 
-    const int writePosition = static_cast<int>(header->writePosition.load(std::memory_order_relaxed));
-    float* payload = reinterpret_cast<float*>(header + 1);
+    float* payload = header->payload();
+    const auto stride = static_cast<std::size_t>(channels);
 
-    for (int sample = 0; sample < numSamples; ++sample)
-    {
-        const int frameIndex = (writePosition + sample) % capacity;
-        const int frameOffset = frameIndex * channels;
-        for (int channel = 0; channel < channels; ++channel)
-        {
-            const int sourceChannel = channel < numChannels ? channel : (numChannels - 1);
-            payload[frameOffset + channel] = samples[sourceChannel][sample];
-        }
-    }
+    const auto sourceChannels = static_cast<std::size_t>(numChannels);
 
-    const int newWritePosition = (writePosition + numSamples) % capacity;
-    header->writePosition.store(static_cast<std::uint32_t>(newWritePosition), std::memory_order_release);
-    header->framesAvailable.fetch_add(static_cast<std::uint32_t>(numSamples), std::memory_order_release);
-    stats.queuedFrames = static_cast<int>(header->framesAvailable.load(std::memory_order_relaxed));
+    oceanaudio::interleave::fromPlanar(samples, sourceChannels, 0,
+                                       payload + regions.first.offset * stride, stride, regions.first.frames);
+    oceanaudio::interleave::fromPlanar(samples, sourceChannels, regions.first.frames,
+                                       payload + regions.second.offset * stride, stride, regions.second.frames);
 
-    if (sharedMemory.audioReadyEvent != nullptr)
+    // Summed from the ring itself, so the checksum covers exactly what readers see.
+    const bool summing = blockChecksums.load(std::memory_order_relaxed);
+    std::uint32_t checksum = 0;
+    if (summing)
     {
-        SetEvent(static_cast<HANDLE>(sharedMemory.audioReadyEvent));
+        checksum = oceanaudio::crc32c(0, payload + regions.first.offset * stride,
+                                      regions.first.frames * stride * sizeof(float));
+        checksum = oceanaudio::crc32c(checksum, payload + regions.second.offset * stride,
+                                      regions.second.frames * stride * sizeof(float));
     }
 
+    const auto captureTime = oceanaudio::sharedClockNanoseconds();
+    header->publishBlock(ringProducer.cursor(), static_cast<std::uint32_t>(numSamples), captureTime,
+                         unpublishedDrops, summing ? oceanaudio::kBlockHasChecksum : 0u, checksum);
+    unpublishedDrops = 0;
+    header->writeTimestampNs.store(captureTime, std::memory_order_relaxed);
+    ringProducer.commitWrite(static_cast<std::uint32_t>(numSamples));
+    queuedFrames.store(static_cast<int>(ringProducer.queuedFrames()), std::memory_order_relaxed);
+
+    // Only pay for a kernel signal to readers that said they are going to sleep; while
+    // they spin or are still draining they will find the new frames on their own.
+    header->wakeSleepingReaders([this, header](std::uint32_t slot) { signalReader(header, slot); });
+
     return true;
 }
-#endif
 
+void BridgeClient::signalReader(oceanaudio::SharedAudioRingBufferHeader* header, std::uint32_t slot)
+{
+    header->wakeSignals.fetch_add(1, std::memory_order_relaxed);
+#if JUCE_WINDOWS
+    if (sharedMemory.audioReadyEvents[slot] != nullptr)
+    {
+        SetEvent(static_cast<HANDLE>(sharedMemory.audioReadyEvents[slot]));
+    }
+#else
+    if (posixAudioReadyEvents[slot].isOpen())
+    {
+        posixAudioReadyEvents[slot].set();
+    }
+#endif
+}
@@ -1,15 +1,30 @@
 #pragma once
 
+#include <OceanAudio/BridgeIntegrity.h>
 #include <OceanAudio/BridgeSharedMemory.h>
+#include <OceanAudio/BroadcastRing.h>
+#include <OceanAudio/MappingResidency.h>
+#include <OceanAudio/PosixSharedMemory.h>
+#include <OceanAudio/SpscRing.h>
+
+#if JUCE_LINUX
+    #include <OceanAudio/UnixSocketTransport.h>
+#endif
 
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
 
-class BridgeClient
+#include <atomic>
+
+// Producer side of the bridge. While connected, a heartbeat timer beats the
+// producer's heartbeat in the header, evicts readers that stopped beating and tells
+// the audio thread whether anyone is still reading.
+class BridgeClient : private juce::HighResolutionTimer
 {
 public:
     BridgeClient();
-    ~BridgeClient();
+    ~BridgeClient() override;
 
     void connect();
     void disconnect();
@@ -17,57 +32,147 @@ public:
     void setFormat(int sampleRate, int bufferSize, int channels);
     bool isConnected() const;
 
+    struct MemorySettings
+    {
+        // Applied whenever a mapping is created, on the thread that calls setFormat()
+        // or connect(), so before the device's first callback.
+        oceanaudio::MappingResidencyOptions residency;
+        // Page faults are counted around sendAudio for this many callbacks after every
+        // new mapping or format; 0 turns the probe off.
+        int pageFaultProbeCallbacks = 256;
+    };
+
+    // Takes effect with the next mapping BridgeClient creates.
+    void setMemorySettings(const MemorySettings& settings);
+
+    // Readers silent for this long are evicted, and once none is left alive sendAudio
+    // stops writing until one attaches. 0 keeps every reader and always writes.
+    void setConsumerTimeout(int milliseconds);
+
+    enum class Transport
+    {
+        // The ring and events are opened by name (Win32 objects, or shm_open and futex
+        // words elsewhere).
+        NamedMapping,
+        // Linux only: the ring is a memfd and the events eventfds, handed to consumers
+        // over a Unix socket (see UnixSocketTransport.h). Ignored elsewhere.
+        UnixSocket,
+    };
+
+    // Takes effect with the next connect(). An empty path uses the default socket in
+    // $XDG_RUNTIME_DIR.
+    void setTransport(Transport newTransport, const juce::String& socketPath = {});
+
+    // Puts a CRC-32C of every block's payload into its descriptor, so consumers can
+    // verify what they read (see BridgeConsumer::IntegritySettings). Costs one pass
+    // over the block on the audio thread; off by default. Takes effect with the next
+    // block.
+    void setBlockChecksums(bool enabled);
+
     struct Statistics
     {
         int sampleRate = 0;
         int channels = 0;
         int bufferSize = 0;
-        int droppedBlocks = 0;
+        // Blocks sendAudio could not write. Each published block also carries the
+        // drops since the previous one, so consumers see them where they happened.
+        std::uint64_t droppedBlocks = 0;
+        // Relative to the slowest reader the producer holds back for.
         int queuedFrames = 0;
+        int attachedReaders = 0;
+        int readerDetachments = 0;
+        // Advances by two on every format change applied in place.
+        int formatGeneration = 0;
+        // Whether any reader beat within the consumer timeout, blocks not written
+        // because none had, and readers evicted for missing heartbeats.
+        bool consumerAlive = false;
+        int idleBlocks = 0;
+        int readerEvictions = 0;
+        // What MemorySettings::residency achieved on the current mapping, and the page
+        // faults sendAudio took over the callbacks probed so far. Zero faults means the
+        // audio thread never touched a non-resident page of the ring. The count is per
+        // thread on Linux and process-wide elsewhere.
+        oceanaudio::MappingResidency memoryResidency;
+        int probedCallbacks = 0;
+        int probedPageFaults = 0;
+        // Socket transport only: consumers connected to the socket.
+        int socketClients = 0;
+    };
+
+    // Capture-to-consumption time per block, as recorded by the consumer in the shared
+    // residency histogram. Walks the histogram, so call it from the UI, not the audio
+    // thread; all zero until a consumer has released a block.
+    struct LatencySummary
+    {
+        std::uint64_t blocks = 0;
+        std::uint64_t p50Us = 0;
+        std::uint64_t p99Us = 0;
+        std::uint64_t p999Us = 0;
+        std::uint64_t maxUs = 0;
     };
 
     Statistics getStatistics() const;
+    LatencySummary getBridgeLatency() const;
 
-#if !JUCE_WINDOWS
-    bool popPendingBlock(juce::AudioBuffer<float>& buffer, int& validSamples);
-#endif
+    // Lock-free reads of two Statistics fields, for the audio thread.
+    int getQueuedFrames() const noexcept;
+    std::uint64_t getDroppedBlocks() const noexcept;
 
 private:
-#if !JUCE_WINDOWS
-    void ensureBuffer(int channels, int capacitySamples);
-#endif
-
-#if JUCE_WINDOWS
+    void hiResTimerCallback() override;
+    void beatHeartbeat();
     void ensureSharedMemory(int channels, int sampleRate, int framesPerBlock);
+    void publishFormat(int channels, int sampleRate, int capacity, int framesPerBlock);
     void destroySharedMemory();
+    void startPageFaultProbe();
     bool writeToSharedMemory(const float* const* samples, int numChannels, int numSamples);
+    void signalReader(oceanaudio::SharedAudioRingBufferHeader* header, std::uint32_t slot);
+#if !JUCE_WINDOWS
+    bool createPosixMapping(std::size_t requiredBytes, std::size_t hugePageBytes, bool& newlyCreated);
+    void createPosixEvents();
+#endif
 
     struct SharedMemoryHandles
     {
         void* mappingHandle = nullptr;
-        void* audioReadyEvent = nullptr;
+        // One ready event per reader slot (see oceanaudio::readerEventName).
+        void* audioReadyEvents[oceanaudio::kMaxBroadcastReaders] {};
         void* audioConsumedEvent = nullptr;
         oceanaudio::SharedAudioRingBufferHeader* header = nullptr;
         std::size_t mappedSizeBytes = 0;
     };
 
     SharedMemoryHandles sharedMemory;
-#else
-    juce::AudioBuffer<float> transferBuffer;
-    juce::AbstractFifo fifo;
-
-    struct PendingBlock
-    {
-        int offset = 0;
-        int size = 0;
-    };
+    oceanaudio::BroadcastRingProducer ringProducer;
 
-    juce::Array<PendingBlock> pendingBlocks;
-    int fifoCapacity;
+#if !JUCE_WINDOWS
+    oceanaudio::posix::SharedMapping posixMapping;
+    oceanaudio::posix::NamedEvent posixAudioReadyEvents[oceanaudio::kMaxBroadcastReaders];
+    oceanaudio::posix::NamedEvent posixAudioConsumedEvent;
+#endif
+#if JUCE_LINUX
+    oceanaudio::posix::BridgeSocketServer socketServer;
 #endif
 
+    // `lock` serialises the control thread and the statistics; the audio thread only
+    // ever try-locks `realtimeLock`, which reconfiguration holds while it swaps the
+    // mapping, so sendAudio never waits.
     juce::CriticalSection lock;
+    juce::SpinLock realtimeLock;
     Statistics stats;
-    bool connected;
+    MemorySettings memorySettings;
+    int consumerTimeoutMs = static_cast<int>(oceanaudio::kDefaultPeerTimeoutMs);
+    Transport transport = Transport::NamedMapping;
+    juce::String transportSocketPath;
+    std::atomic<std::uint64_t> droppedBlocks {0};
+    std::atomic<bool> blockChecksums {false};
+    // Drops not yet reported in a block descriptor; audio thread only.
+    std::uint32_t unpublishedDrops = 0;
+    std::atomic<int> queuedFrames {0};
+    std::atomic<bool> connected {false};
+    std::atomic<bool> consumerAlive {false};
+    std::atomic<int> idleBlocks {0};
+    std::atomic<int> probeCallbacksLeft {0};
+    std::atomic<int> probedCallbacks {0};
+    std::atomic<int> probedPageFaults {0};
 };
-
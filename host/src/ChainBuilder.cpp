@@ -0,0 +1,244 @@
+#include "ChainBuilder.h"
+
+namespace
+{
+double millisecondsSince(double startMs)
+{
+    return juce::Time::getMillisecondCounterHiRes() - startMs;
+}
+
+// By identifier, falling back to the first plugin of the same name.
+bool findPluginType(const juce::KnownPluginList& knownList,
+                    const PresetManager::PluginPreset& pluginPreset,
+                    juce::PluginDescription& description)
+{
+    if (auto type = knownList.getTypeForIdentifierString(pluginPreset.pluginId))
+    {
+        description = *type;
+        return true;
+    }
+
+    for (int i = 0; i < knownList.getNumTypes(); ++i)
+    {
+        if (auto* candidate = knownList.getType(i))
+        {
+            if (candidate->name == pluginPreset.pluginName)
+            {
+                description = *candidate;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+} // namespace
+
+// Shared by the builder and the creation callback still in flight. Message thread only.
+struct ChainBuilder::Build
+{
+    struct Slot
+    {
+        juce::PluginDescription description;
+        bool resolved = false;
+        juce::MemoryBlock state;
+        std::unique_ptr<juce::AudioPluginInstance> instance;
+        SlotReport report;
+    };
+
+    std::vector<Slot> slots;
+    double sampleRate = 0.0;
+    int blockSize = 0;
+    ProgressCallback onProgress;
+    CompletionCallback onComplete;
+    int nextToInstantiate = 0;
+    int settled = 0;
+    bool cancelled = false;
+};
+
+ChainBuilder::ChainBuilder(PluginManager& manager)
+    : pluginManager(manager)
+{
+}
+
+ChainBuilder::~ChainBuilder()
+{
+    cancel();
+}
+
+void ChainBuilder::build(const PresetManager::ChainPreset& preset,
+                         double sampleRate,
+                         int blockSize,
+                         ProgressCallback onProgress,
+                         CompletionCallback onComplete)
+{
+    cancel();
+
+    auto build = std::make_shared<Build>();
+    build->sampleRate = sampleRate;
+    build->blockSize = blockSize;
+    build->onProgress = std::move(onProgress);
+    build->onComplete = std::move(onComplete);
+    build->slots.resize(static_cast<std::size_t>(preset.plugins.size()));
+
+    const auto& knownList = pluginManager.getKnownPluginList();
+    for (int index = 0; index < preset.plugins.size(); ++index)
+    {
+        const auto& pluginPreset = preset.plugins.getReference(index);
+        auto& slot = build->slots[static_cast<std::size_t>(index)];
+        slot.report.slot = index;
+        slot.report.pluginName = pluginPreset.pluginName.isNotEmpty() ? pluginPreset.pluginName : pluginPreset.pluginId;
+        slot.state = pluginPreset.state;
+
+        if (findPluginType(knownList, pluginPreset, slot.description))
+        {
+            slot.resolved = true;
+            slot.report.pluginName = slot.description.name;
+        }
+        else
+        {
+            slot.report.error = "Preset references unknown plugin: " + slot.report.pluginName;
+        }
+    }
+
+    currentBuild = build;
+
+    // Unknown plugins settle at once; the rest as their instances arrive.
+    for (int index = 0; index < static_cast<int>(build->slots.size()); ++index)
+    {
+        if (!build->slots[static_cast<std::size_t>(index)].resolved)
+        {
+            settle(build, index);
+        }
+    }
+
+    if (build->slots.empty())
+    {
+        finish(build);
+        return;
+    }
+
+    instantiateNext(build);
+}
+
+void ChainBuilder::cancel()
+{
+    if (currentBuild != nullptr)
+    {
+        currentBuild->cancelled = true;
+        currentBuild.reset();
+    }
+}
+
+bool ChainBuilder::isBuilding() const
+{
+    return currentBuild != nullptr;
+}
+
+void ChainBuilder::instantiateNext(const std::shared_ptr<Build>& build)
+{
+    auto& slots = build->slots;
+    while (build->nextToInstantiate < static_cast<int>(slots.size())
+           && !slots[static_cast<std::size_t>(build->nextToInstantiate)].resolved)
+    {
+        ++build->nextToInstantiate;
+    }
+    if (build->nextToInstantiate >= static_cast<int>(slots.size()))
+    {
+        return;
+    }
+
+    const int index = build->nextToInstantiate++;
+    const auto requestedMs = juce::Time::getMillisecondCounterHiRes();
+    pluginManager.createPluginInstanceAsync(
+        slots[static_cast<std::size_t>(index)].description,
+        build->sampleRate,
+        build->blockSize,
+        [this, build, index, requestedMs](std::unique_ptr<juce::AudioPluginInstance> instance,
+                                          const juce::String& error)
+        {
+            if (build->cancelled)
+            {
+                return;
+            }
+
+            auto& slot = build->slots[static_cast<std::size_t>(index)];
+            slot.report.instantiateMilliseconds = millisecondsSince(requestedMs);
+            slot.instance = std::move(instance);
+
+            // Queue the next creation first; it is served after this callback returns.
+            instantiateNext(build);
+
+            if (slot.instance == nullptr)
+            {
+                slot.report.error = error.isNotEmpty() ? error : juce::String("Plugin could not be instantiated");
+                settle(build, index);
+                return;
+            }
+
+            restoreState(build, index);
+        });
+}
+
+void ChainBuilder::restoreState(const std::shared_ptr<Build>& build, int slot)
+{
+    auto& entry = build->slots[static_cast<std::size_t>(slot)];
+    if (entry.state.getSize() == 0)
+    {
+        settle(build, slot);
+        return;
+    }
+
+    const auto startMs = juce::Time::getMillisecondCounterHiRes();
+    entry.instance->setStateInformation(entry.state.getData(), static_cast<int>(entry.state.getSize()));
+    entry.report.stateMilliseconds = millisecondsSince(startMs);
+    settle(build, slot);
+}
+
+void ChainBuilder::settle(const std::shared_ptr<Build>& build, int slot)
+{
+    auto& entry = build->slots[static_cast<std::size_t>(slot)];
+    entry.report.loaded = entry.instance != nullptr && entry.report.error.isEmpty();
+    ++build->settled;
+
+    if (build->onProgress != nullptr)
+    {
+        build->onProgress(entry.report, build->settled, static_cast<int>(build->slots.size()));
+    }
+
+    if (build->settled == static_cast<int>(build->slots.size()))
+    {
+        finish(build);
+    }
+}
+
+void ChainBuilder::finish(const std::shared_ptr<Build>& build)
+{
+    if (currentBuild == build)
+    {
+        currentBuild.reset();
+    }
+
+    auto chain = std::make_unique<PluginChain>();
+    chain->initialiseDefaultChain();
+
+    juce::Array<SlotReport> reports;
+    for (auto& slot : build->slots)
+    {
+        if (slot.report.loaded)
+        {
+            const auto identifier = PluginManager::createIdentifierString(slot.description);
+            if (!chain->addPlugin(std::move(slot.instance), slot.description.name, identifier))
+            {
+                slot.report.loaded = false;
+                slot.report.error = "Failed to insert plugin into chain";
+            }
+        }
+        reports.add(slot.report);
+    }
+
+    chain->prepareToPlay(build->sampleRate, build->blockSize);
+    if (build->onComplete != nullptr)
+    {
+        build->onComplete(std::move(chain), reports);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "PluginChain.h"
+#include "PluginManager.h"
+#include "PresetManager.h"
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <functional>
+#include <memory>
+
+// Builds the PluginChain for a preset without blocking the message thread for the
+// whole preset. Every slot is instantiated through
+// PluginManager::createPluginInstanceAsync, one request after the other, and its saved
+// state is restored as its instance arrives. Creation and restore are both serial and
+// both on the message thread: JUCE's formats create instances there whatever thread
+// asks, and the host only loads VST3, which requires IComponent::setState there too.
+// The message loop runs between slots, so the UI stays responsive and shows progress.
+//
+// A slot that cannot be resolved, instantiated or inserted is reported and left out;
+// the other slots still load. Progress and the finished chain arrive on the message
+// thread. Starting another build, cancel() or destruction drops the current one.
+class ChainBuilder
+{
+public:
+    struct SlotReport
+    {
+        int slot = 0;
+        juce::String pluginName;
+        bool loaded = false;
+        juce::String error;
+        // Request to instance, including the wait behind earlier slots' creation.
+        double instantiateMilliseconds = 0.0;
+        double stateMilliseconds = 0.0;
+    };
+
+    // Message thread, once per slot as it settles.
+    using ProgressCallback = std::function<void(const SlotReport& slot, int settledSlots, int totalSlots)>;
+    // Message thread, once. `chain` holds the slots that loaded, in preset order, and is
+    // prepared at the rate and block size the build was started with.
+    using CompletionCallback
+        = std::function<void(std::unique_ptr<PluginChain> chain, const juce::Array<SlotReport>& slots)>;
+
+    explicit ChainBuilder(PluginManager& manager);
+    ~ChainBuilder();
+
+    // Message thread.
+    void build(const PresetManager::ChainPreset& preset,
+               double sampleRate,
+               int blockSize,
+               ProgressCallback onProgress,
+               CompletionCallback onComplete);
+    void cancel();
+    bool isBuilding() const;
+
+private:
+    struct Build;
+
+    void instantiateNext(const std::shared_ptr<Build>& build);
+    void restoreState(const std::shared_ptr<Build>& build, int slot);
+    void settle(const std::shared_ptr<Build>& build, int slot);
+    void finish(const std::shared_ptr<Build>& build);
+
+    PluginManager& pluginManager;
+    std::shared_ptr<Build> currentBuild;
+};
@@ -0,0 +1,239 @@
+#include "ChainSwitcher.h"
+
+#include <cmath>
+
+namespace
+{
+constexpr int kReclaimIntervalMs = 100;
+constexpr float kHalfPi = 1.57079632679489661923F;
+} // namespace
+
+ChainSwitcher::ChainSwitcher()
+{
+    startTimer(kReclaimIntervalMs);
+}
+
+ChainSwitcher::~ChainSwitcher()
+{
+    stopTimer();
+    reclaimRetired();
+
+    delete pending.exchange(nullptr, std::memory_order_acquire);
+    delete fading;
+    delete active;
+}
+
+void ChainSwitcher::publish(std::unique_ptr<PluginChain> chain)
+{
+    jassert(chain != nullptr);
+    prepareForDevice(*chain);
+    current = chain.get();
+
+    // Whatever was still pending was never picked up, so nobody else refers to it.
+    delete pending.exchange(chain.release(), std::memory_order_acq_rel);
+}
+
+PluginChain& ChainSwitcher::getCurrent()
+{
+    jassert(current != nullptr);
+    return *current;
+}
+
+const PluginChain& ChainSwitcher::getCurrent() const
+{
+    jassert(current != nullptr);
+    return *current;
+}
+
+void ChainSwitcher::setCrossfadeMilliseconds(int milliseconds)
+{
+    crossfadeMs.store(juce::jmax(0, milliseconds), std::memory_order_relaxed);
+}
+
+void ChainSwitcher::prepareToPlay(double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate;
+    blockSize = maximumBlockSize;
+    deviceSampleRate.store(newSampleRate, std::memory_order_relaxed);
+    deviceBlockSize.store(maximumBlockSize, std::memory_order_relaxed);
+    fadeBuffer.setSize(PluginChain::kNumChannels, maximumBlockSize);
+
+    // A restart is a cut anyway; finish any crossfade now.
+    if (fading != nullptr && retireRoom() > 0)
+    {
+        retire(fading);
+        fading = nullptr;
+    }
+
+    if (active != nullptr)
+    {
+        active->prepareToPlay(newSampleRate, maximumBlockSize);
+    }
+    if (fading != nullptr)
+    {
+        fading->prepareToPlay(newSampleRate, maximumBlockSize);
+    }
+}
+
+void ChainSwitcher::releaseResources()
+{
+    deviceSampleRate.store(0.0, std::memory_order_relaxed);
+    deviceBlockSize.store(0, std::memory_order_relaxed);
+    if (active != nullptr)
+    {
+        active->releaseResources();
+    }
+    if (fading != nullptr)
+    {
+        fading->releaseResources();
+    }
+}
+
+void ChainSwitcher::process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi) noexcept
+{
+    // Only take a new chain when both outgoing chains can be handed back; otherwise
+    // it waits a block or two for the message thread to reclaim.
+    if (retireRoom() >= 2)
+    {
+        auto* next = pending.exchange(nullptr, std::memory_order_acq_rel);
+        if (next != nullptr && !next->isPreparedFor(sampleRate, blockSize))
+        {
+            // Prepared for a configuration the device has since left, which cannot be
+            // fixed here: hand it back for the message thread to prepare, or retire it
+            // if a newer chain has been published meanwhile.
+            PluginChain* expected = nullptr;
+            if (!pending.compare_exchange_strong(expected, next, std::memory_order_acq_rel))
+            {
+                retire(next);
+            }
+            next = nullptr;
+        }
+
+        if (next != nullptr)
+        {
+            if (fading != nullptr)
+            {
+                retire(fading);
+                fading = nullptr;
+            }
+
+            fadeLength = static_cast<int>(crossfadeMs.load(std::memory_order_relaxed) * sampleRate / 1000.0);
+            if (active != nullptr && fadeLength > 0)
+            {
+                fading = active;
+            }
+            else if (active != nullptr)
+            {
+                retire(active);
+            }
+            active = next;
+            fadePosition = 0;
+        }
+    }
+
+    const int numSamples = buffer.getNumSamples();
+    if (active == nullptr)
+    {
+        buffer.clear();
+        return;
+    }
+
+    if (fading == nullptr)
+    {
+        active->process(buffer, midi);
+        return;
+    }
+
+    // Both chains run on the same input while the fade lasts: the outgoing one on a
+    // copy, so its tails ring out under the incoming one.
+    juce::AudioBuffer<float> outgoing(fadeBuffer.getArrayOfWritePointers(), PluginChain::kNumChannels, numSamples);
+    for (int channel = 0; channel < PluginChain::kNumChannels; ++channel)
+    {
+        outgoing.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+    }
+    fadeMidi.clear();
+    fading->process(outgoing, fadeMidi);
+    active->process(buffer, midi);
+
+    // Equal power: the gains are the sine and cosine of the same angle, so the summed
+    // power of uncorrelated chains stays constant through the fade.
+    const int fadeSamples = juce::jmin(numSamples, fadeLength - fadePosition);
+    for (int channel = 0; channel < PluginChain::kNumChannels; ++channel)
+    {
+        auto* incoming = buffer.getWritePointer(channel);
+        const auto* outgoingSamples = outgoing.getReadPointer(channel);
+        for (int sample = 0; sample < fadeSamples; ++sample)
+        {
+            const float angle = kHalfPi * static_cast<float>(fadePosition + sample) / static_cast<float>(fadeLength);
+            incoming[sample] = incoming[sample] * std::sin(angle) + outgoingSamples[sample] * std::cos(angle);
+        }
+    }
+
+    fadePosition += fadeSamples;
+    if (fadePosition >= fadeLength)
+    {
+        // process() only picks up a chain with room for two retirements, so this fits.
+        retire(fading);
+        fading = nullptr;
+    }
+}
+
+void ChainSwitcher::timerCallback()
+{
+    reclaimRetired();
+    preparePending();
+}
+
+void ChainSwitcher::preparePending()
+{
+    // Take the chain off the audio thread's hands while preparing it. Normally nothing
+    // is pending here, as the audio thread picks chains up within a block.
+    auto* chain = pending.exchange(nullptr, std::memory_order_acq_rel);
+    if (chain == nullptr)
+    {
+        return;
+    }
+
+    prepareForDevice(*chain);
+    PluginChain* expected = nullptr;
+    if (!pending.compare_exchange_strong(expected, chain, std::memory_order_acq_rel))
+    {
+        // The audio thread handed back an older chain meanwhile; ours is newer.
+        delete pending.exchange(chain, std::memory_order_acq_rel);
+    }
+}
+
+void ChainSwitcher::prepareForDevice(PluginChain& chain) const
+{
+    const auto rate = deviceSampleRate.load(std::memory_order_relaxed);
+    const auto block = deviceBlockSize.load(std::memory_order_relaxed);
+    if (rate > 0.0 && block > 0 && !chain.isPreparedFor(rate, block))
+    {
+        chain.prepareToPlay(rate, block);
+    }
+}
+
+void ChainSwitcher::reclaimRetired()
+{
+    auto head = retireHead.load(std::memory_order_relaxed);
+    const auto tail = retireTail.load(std::memory_order_acquire);
+    while (head != tail)
+    {
+        delete retired[head % kRetireSlots];
+        retired[head % kRetireSlots] = nullptr;
+        ++head;
+    }
+    retireHead.store(head, std::memory_order_release);
+}
+
+void ChainSwitcher::retire(PluginChain* chain) noexcept
+{
+    const auto tail = retireTail.load(std::memory_order_relaxed);
+    retired[tail % kRetireSlots] = chain;
+    retireTail.store(tail + 1, std::memory_order_release);
+}
+
+std::uint32_t ChainSwitcher::retireRoom() const noexcept
+{
+    return kRetireSlots - (retireTail.load(std::memory_order_relaxed) - retireHead.load(std::memory_order_acquire));
+}
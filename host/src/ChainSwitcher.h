@@ -0,0 +1,89 @@
+#pragma once
+
+#include "PluginChain.h"
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+// Hands complete plugin chains to the audio thread without stopping it. A new chain is
+// built and prepared elsewhere, then published with one atomic pointer exchange; the
+// audio thread picks it up at the start of its next block and equal-power crossfades
+// from the chain it was playing over the configured window. Chains the audio thread is
+// done with go back through a fixed single-producer queue and are deleted on the
+// message thread, where plugin instances have to be destroyed; the audio thread never
+// allocates or frees.
+//
+// Ownership moves with the pointer: whoever exchanges a chain out of `pending` owns
+// it, and only the message thread ever deletes one. publish() prepares the chain at
+// the device's configuration before handing it over. If the device restarted in
+// between, the audio thread hands the chain back (it cannot prepare it) and the reclaim
+// timer prepares it again; the device thread never touches a pending chain. The
+// message thread only ever edits the newest published chain (getCurrent()), which the
+// audio thread does not retire until a newer one has replaced it.
+class ChainSwitcher final : private juce::Timer
+{
+public:
+    ChainSwitcher();
+    // Call only once the device callback is gone.
+    ~ChainSwitcher() override;
+
+    // Message thread. Prepares `chain` at the device's rate and block size unless it
+    // already is; a chain the audio thread has not picked up yet is replaced (and
+    // deleted) without ever being heard.
+    void publish(std::unique_ptr<PluginChain> chain);
+    PluginChain& getCurrent();
+    const PluginChain& getCurrent() const;
+
+    // Length of the crossfade to the next published chain; 0 switches on a block
+    // boundary. 50 ms by default.
+    void setCrossfadeMilliseconds(int milliseconds);
+
+    // Device thread, while no callback runs: prepares the chains the audio side holds
+    // and records the configuration for chains published from now on.
+    void prepareToPlay(double sampleRate, int maximumBlockSize);
+    void releaseResources();
+
+    // Audio thread. `buffer` holds the chain's input and gets its output, in place;
+    // at most the prepared block size.
+    void process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi) noexcept;
+
+private:
+    static constexpr std::uint32_t kRetireSlots = 8;
+
+    void timerCallback() override;
+    void reclaimRetired();
+    // Message thread: prepares a pending chain the audio thread handed back.
+    void preparePending();
+    void prepareForDevice(PluginChain& chain) const;
+    // Audio thread; the caller checks there is room.
+    void retire(PluginChain* chain) noexcept;
+    std::uint32_t retireRoom() const noexcept;
+
+    // Newest published chain: what the message thread edits.
+    PluginChain* current = nullptr;
+    std::atomic<PluginChain*> pending {nullptr};
+    // The device's configuration as of its last start, for the message thread; 0 while
+    // stopped.
+    std::atomic<double> deviceSampleRate {0.0};
+    std::atomic<int> deviceBlockSize {0};
+
+    // Audio thread (and prepareToPlay(), while no callback runs).
+    PluginChain* active = nullptr;
+    PluginChain* fading = nullptr;
+    int fadePosition = 0;
+    int fadeLength = 0;
+    double sampleRate = 0.0;
+    int blockSize = 0;
+    juce::AudioBuffer<float> fadeBuffer;
+    juce::MidiBuffer fadeMidi;
+
+    std::atomic<int> crossfadeMs {50};
+
+    // Audio thread pushes at the tail, the message thread deletes from the head.
+    std::array<PluginChain*, kRetireSlots> retired {};
+    std::atomic<std::uint32_t> retireHead {0};
+    std::atomic<std::uint32_t> retireTail {0};
+};
@@ -0,0 +1,247 @@
+#include "DspLoadMeter.h"
+
+namespace
+{
+using Histogram = oceanaudio::SharedLatencyHistogram;
+
+constexpr const char* kStageNames[] = {"graph", "bridge", "callback", "interval"};
+
+// Value at `quantile` of the counts added since `since`, as the middle of its bucket.
+std::uint64_t windowPercentile(const std::array<std::uint64_t, Histogram::kBucketCount>& counts,
+                               const std::array<std::uint64_t, Histogram::kBucketCount>& since,
+                               double quantile)
+{
+    std::uint64_t total = 0;
+    for (std::uint32_t index = 0; index < Histogram::kBucketCount; ++index)
+    {
+        total += counts[index] - since[index];
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    const auto rank = static_cast<std::uint64_t>(quantile * static_cast<double>(total - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::uint32_t index = 0; index < Histogram::kBucketCount; ++index)
+    {
+        seen += counts[index] - since[index];
+        if (seen >= rank)
+        {
+            const auto lower = Histogram::bucketLowerBound(index);
+            const auto upper = index + 1 < Histogram::kBucketCount ? Histogram::bucketLowerBound(index + 1) : lower + 1;
+            return lower + (upper - lower) / 2;
+        }
+    }
+    return 0;
+}
+
+// Highest non-empty bucket in the window, reported by its upper bound.
+std::uint64_t windowMaximum(const std::array<std::uint64_t, Histogram::kBucketCount>& counts,
+                            const std::array<std::uint64_t, Histogram::kBucketCount>& since)
+{
+    for (auto index = Histogram::kBucketCount; index-- > 0;)
+    {
+        if (counts[index] != since[index])
+        {
+            return index + 1 < Histogram::kBucketCount ? Histogram::bucketLowerBound(index + 1) - 1
+                                                       : Histogram::bucketLowerBound(index);
+        }
+    }
+    return 0;
+}
+
+void bump(std::atomic<std::uint64_t>& counter) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+} // namespace
+
+DspLoadMeter::DspLoadMeter()
+    : juce::Thread("DSP load log")
+{
+}
+
+DspLoadMeter::~DspLoadMeter()
+{
+    setLogging({}, 0);
+}
+
+void DspLoadMeter::prepare(double newSampleRate) noexcept
+{
+    sampleRate = newSampleRate;
+    previousEntryNs = 0;
+    previousFrames = 0;
+}
+
+DspLoadMeter::Result DspLoadMeter::record(const CallbackTiming& timing) noexcept
+{
+    Result result;
+    stageHistograms[static_cast<int>(Stage::Graph)].record((timing.graphNs - timing.entryNs) / 1000);
+    stageHistograms[static_cast<int>(Stage::Bridge)].record((timing.bridgeNs - timing.graphNs) / 1000);
+    stageHistograms[static_cast<int>(Stage::Callback)].record((timing.exitNs - timing.entryNs) / 1000);
+
+    if (sampleRate > 0.0 && timing.frames > 0)
+    {
+        const double periodNs = static_cast<double>(timing.frames) * 1.0e9 / sampleRate;
+        result.load = static_cast<double>(timing.exitNs - timing.entryNs) / periodNs;
+        loadHistogram.record(static_cast<std::uint64_t>(result.load * 1000.0));
+        if (result.load > 1.0)
+        {
+            bump(overruns);
+            result.xrun = true;
+        }
+    }
+
+    if (previousEntryNs != 0 && previousFrames > 0 && sampleRate > 0.0)
+    {
+        const auto intervalNs = timing.entryNs - previousEntryNs;
+        stageHistograms[static_cast<int>(Stage::Interval)].record(intervalNs / 1000);
+        const double expectedNs = static_cast<double>(previousFrames) * 1.0e9 / sampleRate;
+        if (static_cast<double>(intervalNs) > expectedNs * kLateCallbackRatio)
+        {
+            bump(lateCallbacks);
+            result.xrun = true;
+        }
+    }
+
+    previousEntryNs = timing.entryNs;
+    previousFrames = timing.frames;
+    return result;
+}
+
+DspLoadMeter::Summary DspLoadMeter::getSummary() const
+{
+    Summary summary;
+    summary.callbacks = stageHistograms[static_cast<int>(Stage::Callback)].totalCount.load(std::memory_order_relaxed);
+    summary.lateCallbacks = lateCallbacks.load(std::memory_order_relaxed);
+    summary.overruns = overruns.load(std::memory_order_relaxed);
+    summary.loadP50 = static_cast<double>(loadHistogram.percentileUs(0.5)) * 1.0e-3;
+    summary.loadP99 = static_cast<double>(loadHistogram.percentileUs(0.99)) * 1.0e-3;
+    summary.loadMax = static_cast<double>(loadHistogram.maxValueUs.load(std::memory_order_relaxed)) * 1.0e-3;
+    for (int stage = 0; stage < 4; ++stage)
+    {
+        const auto& histogram = stageHistograms[stage];
+        summary.stages[stage].p50Us = histogram.percentileUs(0.5);
+        summary.stages[stage].p99Us = histogram.percentileUs(0.99);
+        summary.stages[stage].p999Us = histogram.percentileUs(0.999);
+        summary.stages[stage].maxUs = histogram.maxValueUs.load(std::memory_order_relaxed);
+    }
+    return summary;
+}
+
+const oceanaudio::SharedLatencyHistogram& DspLoadMeter::getHistogram(Stage stage) const noexcept
+{
+    return stageHistograms[static_cast<int>(stage)];
+}
+
+const oceanaudio::SharedLatencyHistogram& DspLoadMeter::getLoadHistogram() const noexcept
+{
+    return loadHistogram;
+}
+
+void DspLoadMeter::setLogging(const juce::File& file, int intervalMs)
+{
+    stopThread(2000);
+    flushLog();
+
+    {
+        const juce::ScopedLock guard(logLock);
+        logFile = file;
+        logIntervalMs = juce::jmax(intervalMs, 100);
+    }
+
+    if (file != juce::File())
+    {
+        file.getParentDirectory().createDirectory();
+        // The first window starts now, not at construction.
+        const auto counts = takeCounts();
+        {
+            const juce::ScopedLock guard(logLock);
+            loggedCounts = counts;
+        }
+        startThread(juce::Thread::Priority::low);
+    }
+}
+
+void DspLoadMeter::run()
+{
+    while (!threadShouldExit())
+    {
+        int intervalMs = 0;
+        {
+            const juce::ScopedLock guard(logLock);
+            intervalMs = logIntervalMs;
+        }
+
+        wait(intervalMs);
+        flushLog();
+    }
+}
+
+DspLoadMeter::WindowCounts DspLoadMeter::takeCounts() const
+{
+    WindowCounts counts;
+    for (int stage = 0; stage < 4; ++stage)
+    {
+        for (std::uint32_t index = 0; index < Histogram::kBucketCount; ++index)
+        {
+            counts.stages[stage][index] = stageHistograms[stage].counts[index].load(std::memory_order_relaxed);
+        }
+    }
+    for (std::uint32_t index = 0; index < Histogram::kBucketCount; ++index)
+    {
+        counts.load[index] = loadHistogram.counts[index].load(std::memory_order_relaxed);
+    }
+    counts.lateCallbacks = lateCallbacks.load(std::memory_order_relaxed);
+    counts.overruns = overruns.load(std::memory_order_relaxed);
+    return counts;
+}
+
+void DspLoadMeter::flushLog()
+{
+    const juce::ScopedLock guard(logLock);
+    if (logFile == juce::File())
+    {
+        return;
+    }
+
+    const auto counts = takeCounts();
+    const auto& since = loggedCounts;
+    std::uint64_t callbacks = 0;
+    for (std::uint32_t index = 0; index < Histogram::kBucketCount; ++index)
+    {
+        callbacks += counts.stages[static_cast<int>(Stage::Callback)][index]
+                     - since.stages[static_cast<int>(Stage::Callback)][index];
+    }
+    if (callbacks == 0)
+    {
+        return;
+    }
+
+    auto line = juce::Time::getCurrentTime().toISO8601(true)
+                + juce::String::formatted(" callbacks %llu, late %llu, overruns %llu,"
+                                          " load p50 %.1f%% p99 %.1f%% max %.1f%%",
+                                          static_cast<unsigned long long>(callbacks),
+                                          static_cast<unsigned long long>(counts.lateCallbacks - since.lateCallbacks),
+                                          static_cast<unsigned long long>(counts.overruns - since.overruns),
+                                          static_cast<double>(windowPercentile(counts.load, since.load, 0.5)) * 0.1,
+                                          static_cast<double>(windowPercentile(counts.load, since.load, 0.99)) * 0.1,
+                                          static_cast<double>(windowMaximum(counts.load, since.load)) * 0.1);
+    for (int stage = 0; stage < 4; ++stage)
+    {
+        line += juce::String::formatted(", %s us p50 %llu p99 %llu p99.9 %llu max %llu",
+                                        kStageNames[stage],
+                                        static_cast<unsigned long long>(
+                                            windowPercentile(counts.stages[stage], since.stages[stage], 0.5)),
+                                        static_cast<unsigned long long>(
+                                            windowPercentile(counts.stages[stage], since.stages[stage], 0.99)),
+                                        static_cast<unsigned long long>(
+                                            windowPercentile(counts.stages[stage], since.stages[stage], 0.999)),
+                                        static_cast<unsigned long long>(
+                                            windowMaximum(counts.stages[stage], since.stages[stage])));
+    }
+
+    logFile.appendText(line + "\n", false, false, "\n");
+    loggedCounts = counts;
+}
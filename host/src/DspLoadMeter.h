@@ -0,0 +1,126 @@
+#pragma once
+
+#include <OceanAudio/LatencyHistogram.h>
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// How long the device callback takes and how close it runs to its deadline. The audio
+// thread hands over its timestamps once per callback; everything it touches is
+// preallocated single-writer atomics, and the histograms are the bridge's log-linear
+// SharedLatencyHistogram, so readers can take percentiles at any time.
+//
+// Load is the callback's duration over the period of the frames it was asked for, so
+// 1.0 means the chain and the bridge used the whole buffer. A callback is an xrun when
+// its load exceeds 1.0 or when it starts later than kLateCallbackRatio periods of the
+// previous callback after that one started: the device could not have kept its
+// buffers full either way.
+//
+// With logging on, a background thread appends one line per interval with the
+// window's percentiles, so chain budgets can be set from a real session.
+class DspLoadMeter : private juce::Thread
+{
+public:
+    enum class Stage
+    {
+        // Entry to the end of the graph: input copy and plugin chain.
+        Graph,
+        // The bridge write after the graph.
+        Bridge,
+        // Entry to exit, output copy included.
+        Callback,
+        // Entry to entry of consecutive callbacks.
+        Interval,
+    };
+
+    struct CallbackTiming
+    {
+        std::uint64_t entryNs = 0;
+        std::uint64_t graphNs = 0;
+        std::uint64_t bridgeNs = 0;
+        std::uint64_t exitNs = 0;
+        int frames = 0;
+    };
+
+    struct Result
+    {
+        double load = 0.0;
+        bool xrun = false;
+    };
+
+    struct StageSummary
+    {
+        std::uint64_t p50Us = 0;
+        std::uint64_t p99Us = 0;
+        std::uint64_t p999Us = 0;
+        std::uint64_t maxUs = 0;
+    };
+
+    struct Summary
+    {
+        std::uint64_t callbacks = 0;
+        std::uint64_t lateCallbacks = 0;
+        std::uint64_t overruns = 0;
+        double loadP50 = 0.0;
+        double loadP99 = 0.0;
+        double loadMax = 0.0;
+        // Indexed by Stage.
+        StageSummary stages[4];
+    };
+
+    DspLoadMeter();
+    ~DspLoadMeter() override;
+
+    // Device thread, while no callback runs. Forgets the previous callback, so the gap
+    // across a device restart is not taken for an xrun. Histograms keep accumulating.
+    void prepare(double sampleRate) noexcept;
+
+    // Audio thread only.
+    Result record(const CallbackTiming& timing) noexcept;
+
+    // Cumulative since construction; any thread but the audio thread.
+    Summary getSummary() const;
+    const oceanaudio::SharedLatencyHistogram& getHistogram(Stage stage) const noexcept;
+    // Load in permille (1000 = the whole period); its "Us" accessors read permille.
+    const oceanaudio::SharedLatencyHistogram& getLoadHistogram() const noexcept;
+
+    // Appends a summary of each interval to `file`; an empty file stops logging. The
+    // pending interval is flushed when logging stops or the meter is destroyed.
+    void setLogging(const juce::File& file, int intervalMs);
+
+    static constexpr double kLateCallbackRatio = 1.5;
+
+private:
+    using BucketCounts = std::array<std::uint64_t, oceanaudio::SharedLatencyHistogram::kBucketCount>;
+
+    struct WindowCounts
+    {
+        BucketCounts stages[4] {};
+        BucketCounts load {};
+        std::uint64_t lateCallbacks = 0;
+        std::uint64_t overruns = 0;
+    };
+
+    void run() override;
+    void flushLog();
+    WindowCounts takeCounts() const;
+
+    oceanaudio::SharedLatencyHistogram stageHistograms[4];
+    oceanaudio::SharedLatencyHistogram loadHistogram;
+    std::atomic<std::uint64_t> lateCallbacks {0};
+    std::atomic<std::uint64_t> overruns {0};
+
+    // Audio thread (and prepare(), while the callback is stopped).
+    double sampleRate = 0.0;
+    std::uint64_t previousEntryNs = 0;
+    int previousFrames = 0;
+
+    // Log thread.
+    juce::CriticalSection logLock;
+    juce::File logFile;
+    int logIntervalMs = 0;
+    WindowCounts loggedCounts;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// What the audio callback reports about itself. The audio thread is the only writer
+// and publishes once per callback with plain relaxed stores under a sequence counter
+// (odd while a publish is in progress), the same scheme as the bridge header's
+// format fields. Readers on any thread take a consistent copy with snapshot() and do
+// their own formatting; nothing here allocates, locks or waits.
+class EngineTelemetry
+{
+public:
+    struct Snapshot
+    {
+        double sampleRate = 0.0;
+        // The block size the device announced and the frames of the last callback.
+        int blockSize = 0;
+        int callbackFrames = 0;
+        // Bridge ring fill and blocks sendAudio could not write, as of the last callback.
+        int queuedFrames = 0;
+        std::uint64_t droppedBlocks = 0;
+        std::uint64_t callbacks = 0;
+        std::uint64_t lastCallbackNs = 0;
+        std::uint64_t maxCallbackNs = 0;
+        // The last callback's duration over its buffer period (see DspLoadMeter).
+        double load = 0.0;
+        // Callbacks that overran their buffer period or started late.
+        std::uint64_t xruns = 0;
+        // Bumped on every device start, so readers can tell a restart from a quiet device.
+        std::uint32_t deviceGeneration = 0;
+        bool running = false;
+    };
+
+    // Audio or device thread, one writer at a time.
+    void publish(const Snapshot& values) noexcept
+    {
+        const auto start = sequence.load(std::memory_order_relaxed);
+        sequence.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        sampleRate.store(values.sampleRate, std::memory_order_relaxed);
+        blockSize.store(values.blockSize, std::memory_order_relaxed);
+        callbackFrames.store(values.callbackFrames, std::memory_order_relaxed);
+        queuedFrames.store(values.queuedFrames, std::memory_order_relaxed);
+        droppedBlocks.store(values.droppedBlocks, std::memory_order_relaxed);
+        callbacks.store(values.callbacks, std::memory_order_relaxed);
+        lastCallbackNs.store(values.lastCallbackNs, std::memory_order_relaxed);
+        maxCallbackNs.store(values.maxCallbackNs, std::memory_order_relaxed);
+        load.store(values.load, std::memory_order_relaxed);
+        xruns.store(values.xruns, std::memory_order_relaxed);
+        deviceGeneration.store(values.deviceGeneration, std::memory_order_relaxed);
+        running.store(values.running, std::memory_order_relaxed);
+        sequence.store(start + 2, std::memory_order_release);
+    }
+
+    // One attempt at a consistent copy; fails only while a publish is in progress.
+    bool tryRead(Snapshot& values) const noexcept
+    {
+        const auto start = sequence.load(std::memory_order_acquire);
+        if ((start & 1u) != 0)
+        {
+            return false;
+        }
+
+        values.sampleRate = sampleRate.load(std::memory_order_relaxed);
+        values.blockSize = blockSize.load(std::memory_order_relaxed);
+        values.callbackFrames = callbackFrames.load(std::memory_order_relaxed);
+        values.queuedFrames = queuedFrames.load(std::memory_order_relaxed);
+        values.droppedBlocks = droppedBlocks.load(std::memory_order_relaxed);
+        values.callbacks = callbacks.load(std::memory_order_relaxed);
+        values.lastCallbackNs = lastCallbackNs.load(std::memory_order_relaxed);
+        values.maxCallbackNs = maxCallbackNs.load(std::memory_order_relaxed);
+        values.load = load.load(std::memory_order_relaxed);
+        values.xruns = xruns.load(std::memory_order_relaxed);
+        values.deviceGeneration = deviceGeneration.load(std::memory_order_relaxed);
+        values.running = running.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence.load(std::memory_order_relaxed) == start;
+    }
+
+    // Retries until a copy is consistent. A publish is a dozen stores, so this spins
+    // for nanoseconds at worst.
+    Snapshot snapshot() const noexcept
+    {
+        Snapshot values;
+        while (!tryRead(values))
+        {
+        }
+        return values;
+    }
+
+private:
+    std::atomic<std::uint32_t> sequence {0};
+    std::atomic<double> sampleRate {0.0};
+    std::atomic<int> blockSize {0};
+    std::atomic<int> callbackFrames {0};
+    std::atomic<int> queuedFrames {0};
+    std::atomic<std::uint64_t> droppedBlocks {0};
+    std::atomic<std::uint64_t> callbacks {0};
+    std::atomic<std::uint64_t> lastCallbackNs {0};
+    std::atomic<std::uint64_t> maxCallbackNs {0};
+    std::atomic<double> load {0.0};
+    std::atomic<std::uint64_t> xruns {0};
+    std::atomic<std::uint32_t> deviceGeneration {0};
+    std::atomic<bool> running {false};
+};
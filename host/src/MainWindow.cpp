@@ -43,6 +43,13 @@ MainWindow::RootComponent::RootComponent(AudioEngine& engine)
         audioEngine.openDeviceSettings();
     };
 
+    addAndMakeVisible(monitorToggle);
+    monitorToggle.setToggleState(audioEngine.isMonitorEnabled(), juce::dontSendNotification);
+    monitorToggle.onClick = [this]()
+    {
+        audioEngine.setMonitorEnabled(monitorToggle.getToggleState());
+    };
+
     pluginListComponent = std::make_unique<PluginListComponent>(audioEngine.getPluginManager());
     pluginListComponent->setSelectionCallback([this](const juce::PluginDescription& description)
     {
@@ -250,7 +257,10 @@ void MainWindow::RootComponent::resized()
     auto area = getLocalBounds().reduced(16);
     statusLabel.setBounds(area.removeFromTop(24));
     area.removeFromTop(12);
-    openPrefsButton.setBounds(area.removeFromTop(32).removeFromLeft(200));
+    auto deviceRow = area.removeFromTop(32);
+    openPrefsButton.setBounds(deviceRow.removeFromLeft(200));
+    deviceRow.removeFromLeft(12);
+    monitorToggle.setBounds(deviceRow.removeFromLeft(160));
 
     area.removeFromTop(12);
     auto contentArea = area;
@@ -334,18 +344,49 @@ void MainWindow::RootComponent::listBoxItemClicked(int row, const juce::MouseEve
 
     if (juce::isPositiveAndBelow(row, audioEngine.getPresets().size()))
     {
-        juce::String error;
-        if (!audioEngine.applyPreset(audioEngine.getPresets().getReference(row), error)
-            && error.isNotEmpty())
+        juce::Component::SafePointer<RootComponent> safeThis(this);
+        auto onProgress = [safeThis](const ChainBuilder::SlotReport& slot, int settledSlots, int totalSlots)
         {
-            juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon,
-                                                   "Preset Load Failed",
-                                                   error);
-        }
-        else if (pluginChainComponent != nullptr)
+            if (safeThis != nullptr)
+            {
+                const auto loadMs = slot.instantiateMilliseconds + slot.stateMilliseconds;
+                const auto text = juce::String::formatted("Presets - loading %d/%d (", settledSlots, totalSlots)
+                                  + slot.pluginName + juce::String::formatted(" %.0f ms)", loadMs);
+                safeThis->presetLabel.setText(text, juce::dontSendNotification);
+            }
+        };
+
+        auto onLoaded = [safeThis](bool applied, const juce::Array<ChainBuilder::SlotReport>& slots)
         {
-            pluginChainComponent->refresh();
-        }
+            if (safeThis == nullptr)
+            {
+                return;
+            }
+
+            safeThis->presetLabel.setText("Presets", juce::dontSendNotification);
+            if (applied && safeThis->pluginChainComponent != nullptr)
+            {
+                safeThis->pluginChainComponent->refresh();
+            }
+
+            juce::StringArray failures;
+            for (const auto& slot : slots)
+            {
+                if (!slot.loaded)
+                {
+                    failures.add(juce::String(slot.slot + 1) + ". " + slot.pluginName + ": " + slot.error);
+                }
+            }
+
+            if (!failures.isEmpty())
+            {
+                juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon,
+                                                       applied ? "Preset Partly Loaded" : "Preset Load Failed",
+                                                       failures.joinIntoString("\n"));
+            }
+        };
+
+        audioEngine.applyPreset(audioEngine.getPresets().getReference(row), std::move(onProgress), std::move(onLoaded));
     }
 
     updatePresetButtons();
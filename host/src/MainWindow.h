@@ -44,6 +44,7 @@ private:
         AudioEngine& audioEngine;
         juce::Label statusLabel;
         juce::TextButton openPrefsButton;
+        juce::ToggleButton monitorToggle {"Monitor output"};
         std::unique_ptr<class PluginListComponent> pluginListComponent;
         std::unique_ptr<class PluginChainComponent> pluginChainComponent;
         juce::Label presetLabel;
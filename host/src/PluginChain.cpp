@@ -1,10 +1,5 @@
 #include "PluginChain.h"
 
-namespace
-{
-constexpr int kNumChannels = 2;
-}
-
 PluginChain::PluginChain()
     : graph(std::make_unique<juce::AudioProcessorGraph>()),
       inputNode(),
@@ -35,6 +30,46 @@ void PluginChain::initialiseDefaultChain()
     rebuildConnections();
 }
 
+void PluginChain::prepareToPlay(double sampleRate, int maximumBlockSize)
+{
+    graph->setPlayConfigDetails(kNumChannels, kNumChannels, sampleRate, maximumBlockSize);
+    graph->prepareToPlay(sampleRate, maximumBlockSize);
+    preparedSampleRate = sampleRate;
+    preparedBlockSize = maximumBlockSize;
+}
+
+void PluginChain::releaseResources()
+{
+    graph->releaseResources();
+    preparedSampleRate = 0.0;
+    preparedBlockSize = 0;
+}
+
+bool PluginChain::isPreparedFor(double sampleRate, int maximumBlockSize) const noexcept
+{
+    return preparedSampleRate == sampleRate && preparedBlockSize == maximumBlockSize;
+}
+
+void PluginChain::process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
+{
+    // The graph swaps its render sequence under this lock when plugins are added,
+    // removed or moved. Unlike juce::AudioProcessorPlayer we do not wait for it: the
+    // buffer already holds the input, so a busy block goes out dry.
+    const juce::ScopedTryLock callbackLock(graph->getCallbackLock());
+    if (!callbackLock.isLocked())
+    {
+        return;
+    }
+
+    if (graph->isSuspended())
+    {
+        buffer.clear();
+        return;
+    }
+
+    graph->processBlock(buffer, midi);
+}
+
 bool PluginChain::addPlugin(std::unique_ptr<juce::AudioProcessor> processor,
                             const juce::String& name,
                             const juce::String& identifier)
@@ -7,11 +7,27 @@
 class PluginChain
 {
 public:
+    // The chain is stereo in and out, whatever the device offers.
+    static constexpr int kNumChannels = 2;
+
     PluginChain();
     ~PluginChain();
 
     juce::AudioProcessor* getProcessor();
     void initialiseDefaultChain();
+
+    // Prepares the graph for the device's rate and largest block; call before the
+    // first process() and whenever the device restarts.
+    void prepareToPlay(double sampleRate, int maximumBlockSize);
+    void releaseResources();
+    // Whether the last prepareToPlay() (not since released) was for this configuration.
+    bool isPreparedFor(double sampleRate, int maximumBlockSize) const noexcept;
+    // Runs the graph in place on `buffer` (kNumChannels channels, at most the prepared
+    // block size). Audio thread; leaves silence while the graph is suspended. Never
+    // waits: while an edit on the message thread holds the graph's callback lock, the
+    // input passes through unprocessed for that block.
+    void process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi);
+
     bool addPlugin(std::unique_ptr<juce::AudioProcessor> processor,
                    const juce::String& name,
                    const juce::String& identifier);
@@ -40,5 +56,7 @@ private:
     juce::Array<NodeID> pluginNodes;
     juce::StringArray pluginNames;
     juce::StringArray pluginIdentifiers;
+    double preparedSampleRate = 0.0;
+    int preparedBlockSize = 0;
 };
 
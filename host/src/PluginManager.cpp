@@ -176,6 +176,40 @@ std::unique_ptr<juce::AudioPluginInstance> PluginManager::createPluginInstance(c
     return instance;
 }
 
+void PluginManager::createPluginInstanceAsync(const juce::PluginDescription& description,
+                                              double sampleRate,
+                                              int blockSize,
+                                              juce::AudioPluginFormat::PluginCreationCallback callback)
+{
+    if (formatManager.findFormatForDescription(description) == nullptr)
+    {
+        callback(nullptr, "Format not available for plugin");
+        return;
+    }
+
+    formatManager.createPluginInstanceAsync(description,
+                                            sampleRate,
+                                            blockSize,
+                                            [sampleRate, blockSize, callback = std::move(callback)](
+                                                std::unique_ptr<juce::AudioPluginInstance> instance,
+                                                const juce::String& error)
+    {
+        if (instance != nullptr)
+        {
+            instance->setRateAndBufferSizeDetails(sampleRate, blockSize);
+        }
+        callback(std::move(instance), error);
+    });
+}
+
+juce::String PluginManager::createIdentifierString(const juce::PluginDescription& description)
+{
+    return juce::PluginDescription::createIdentifierString(description.pluginFormatName,
+                                                           description.name,
+                                                           description.version,
+                                                           description.fileOrIdentifier);
+}
+
 juce::File PluginManager::getDeadMansPedalFile() const
 {
     return deadMansPedalFile;
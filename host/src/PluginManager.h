@@ -24,6 +24,15 @@ public:
                                                                     double sampleRate,
                                                                     int blockSize,
                                                                     juce::String& errorMessage) const;
+    // Message thread. Returns at once; the format creates the instance on the message
+    // thread and `callback` is called there.
+    void createPluginInstanceAsync(const juce::PluginDescription& description,
+                                   double sampleRate,
+                                   int blockSize,
+                                   juce::AudioPluginFormat::PluginCreationCallback callback);
+
+    // Identifier stored in presets for `description`.
+    static juce::String createIdentifierString(const juce::PluginDescription& description);
 
     juce::File getDeadMansPedalFile() const;
 
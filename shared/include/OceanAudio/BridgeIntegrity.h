@@ -0,0 +1,383 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define OCEANAUDIO_CRC32C_SSE42 1
+    #include <nmmintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+    #endif
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+    #define OCEANAUDIO_CRC32C_ARM 1
+    #include <arm_acle.h>
+#endif
+
+// Integrity checks for the bridge stream: a block checksum the producer may put in
+// each block descriptor, a detector for sample jumps at block boundaries, and the log
+// a reader keeps of what it found (see BridgeConsumer).
+namespace oceanaudio
+{
+namespace detail
+{
+// CRC-32C (Castagnoli), reflected, as computed by the SSE4.2 and ARMv8 instructions.
+inline constexpr std::uint32_t kCrc32cPolynomial = 0x82F63B78u;
+
+struct Crc32cTables
+{
+    std::uint32_t table[8][256] {};
+};
+
+constexpr Crc32cTables makeCrc32cTables() noexcept
+{
+    Crc32cTables tables;
+    for (std::uint32_t byte = 0; byte < 256; ++byte)
+    {
+        auto crc = byte;
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc >> 1) ^ ((crc & 1u) != 0 ? kCrc32cPolynomial : 0u);
+        }
+        tables.table[0][byte] = crc;
+    }
+    for (std::uint32_t byte = 0; byte < 256; ++byte)
+    {
+        for (int slice = 1; slice < 8; ++slice)
+        {
+            const auto previous = tables.table[slice - 1][byte];
+            tables.table[slice][byte] = (previous >> 8) ^ tables.table[0][previous & 0xFFu];
+        }
+    }
+    return tables;
+}
+
+inline constexpr Crc32cTables kCrc32cTables = makeCrc32cTables();
+
+#if OCEANAUDIO_CRC32C_SSE42
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("sse4.2")))
+#endif
+inline std::uint32_t crc32cSse42(std::uint32_t crc, const unsigned char* input, std::size_t bytes) noexcept
+{
+    std::uint64_t wide = crc;
+    for (; bytes >= 8; bytes -= 8, input += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, input, sizeof(word));
+        wide = _mm_crc32_u64(wide, word);
+    }
+    crc = static_cast<std::uint32_t>(wide);
+    for (; bytes > 0; --bytes, ++input)
+    {
+        crc = _mm_crc32_u8(crc, *input);
+    }
+    return crc;
+}
+
+inline bool cpuHasSse42() noexcept
+{
+#if defined(__SSE4_2__)
+    return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4] {};
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+// Probed once at start-up, so the audio thread only ever reads a bool.
+inline const bool kCrc32cUseSse42 = cpuHasSse42();
+#endif
+} // namespace detail
+
+// CRC-32C of `bytes` bytes, continuing from `crc` (0 to start), so a block that wraps
+// around the ring can be summed span by span. Unlike the interleave kernels the
+// instruction is picked at run time on x64, since baseline x64 builds cannot assume
+// SSE4.2 and the table fallback is several times slower; ARMv8 builds use the CRC
+// extension when compiled for it. Everything else slices by eight through tables.
+// The tables assume a little-endian machine, as every supported target is.
+[[nodiscard]] inline std::uint32_t crc32c(std::uint32_t crc, const void* data, std::size_t bytes) noexcept
+{
+    const auto* input = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+#if OCEANAUDIO_CRC32C_SSE42
+    if (detail::kCrc32cUseSse42)
+    {
+        return ~detail::crc32cSse42(crc, input, bytes);
+    }
+#endif
+#if OCEANAUDIO_CRC32C_ARM
+    for (; bytes >= 8; bytes -= 8, input += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, input, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+    for (; bytes > 0; --bytes, ++input)
+    {
+        crc = __crc32cb(crc, *input);
+    }
+#else
+    const auto& table = detail::kCrc32cTables.table;
+    for (; bytes >= 8; bytes -= 8, input += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, input, sizeof(word));
+        word ^= crc;
+        crc = table[7][word & 0xFFu] ^ table[6][(word >> 8) & 0xFFu] ^ table[5][(word >> 16) & 0xFFu]
+              ^ table[4][(word >> 24) & 0xFFu] ^ table[3][(word >> 32) & 0xFFu] ^ table[2][(word >> 40) & 0xFFu]
+              ^ table[1][(word >> 48) & 0xFFu] ^ table[0][word >> 56];
+    }
+    for (; bytes > 0; --bytes, ++input)
+    {
+        crc = (crc >> 8) ^ table[0][(crc ^ *input) & 0xFFu];
+    }
+#endif
+    return ~crc;
+}
+
+enum class IntegrityEventKind : std::uint32_t
+{
+    // The producer dropped blocks (ring full, or a reconfiguration in the way) before
+    // this one; `value` is how many.
+    ProducerDrop,
+    // Frames missing from this reader's stream (it skipped ahead, or the producer's
+    // stream jumped); `value` is how many.
+    FrameGap,
+    // Frames delivered twice: this reader's stream or a block went back over frames
+    // already seen; `value` is how many.
+    DuplicateFrames,
+    // Block descriptors overwritten before the reader got to them, so those blocks
+    // went unchecked; `value` is how many.
+    DescriptorsLost,
+    // The block's payload does not match the producer's checksum; `value` is the
+    // checksum the reader computed.
+    ChecksumMismatch,
+    // A sample jump at the start of the block (see BlockBoundaryDetector); `channel`
+    // and `magnitude` say where and how large.
+    Discontinuity,
+};
+
+[[nodiscard]] inline const char* toString(IntegrityEventKind kind) noexcept
+{
+    switch (kind)
+    {
+        case IntegrityEventKind::ProducerDrop: return "producer drop";
+        case IntegrityEventKind::FrameGap: return "frame gap";
+        case IntegrityEventKind::DuplicateFrames: return "duplicate frames";
+        case IntegrityEventKind::DescriptorsLost: return "descriptors lost";
+        case IntegrityEventKind::ChecksumMismatch: return "checksum mismatch";
+        case IntegrityEventKind::Discontinuity: return "discontinuity";
+    }
+    return "unknown";
+}
+
+struct IntegrityEvent
+{
+    IntegrityEventKind kind = IntegrityEventKind::ProducerDrop;
+    std::uint32_t channel = 0;
+    // Block sequence number (0 if the event is not tied to a block) and the frame in
+    // the producer's stream where it happened.
+    std::uint64_t sequence = 0;
+    std::uint64_t frameIndex = 0;
+    // sharedClockNanoseconds() when the reader noticed, to line up with host telemetry.
+    std::uint64_t timeNs = 0;
+    std::uint64_t value = 0;
+    float magnitude = 0.0f;
+};
+
+// The newest kCapacity events of one reader, oldest overwritten first. Fixed size so
+// recording never allocates on the delivery thread; read it from the same thread, as
+// with the rest of the reader's statistics.
+class IntegrityEventLog
+{
+public:
+    static constexpr std::uint32_t kCapacity = 64;
+
+    void record(const IntegrityEvent& event) noexcept
+    {
+        entries[recorded % kCapacity] = event;
+        ++recorded;
+    }
+
+    // Events recorded so far, including the ones since overwritten.
+    [[nodiscard]] std::uint64_t totalRecorded() const noexcept
+    {
+        return recorded;
+    }
+
+    // Copies up to `maxEvents` of the retained events recorded after the first
+    // `since`, oldest first, and returns how many it copied. Pass the previous
+    // totalRecorded() to get only what is new.
+    std::uint32_t copyEvents(IntegrityEvent* destination, std::uint32_t maxEvents, std::uint64_t since = 0) const noexcept
+    {
+        const auto oldest = recorded > kCapacity ? recorded - kCapacity : 0;
+        auto index = since > oldest ? since : oldest;
+        std::uint32_t copied = 0;
+        for (; index < recorded && copied < maxEvents; ++index, ++copied)
+        {
+            destination[copied] = entries[index % kCapacity];
+        }
+        return copied;
+    }
+
+private:
+    IntegrityEvent entries[kCapacity] {};
+    std::uint64_t recorded = 0;
+};
+
+struct DiscontinuitySettings
+{
+    // The first frame of a block is a click when it misses the value extrapolated from
+    // the two frames before it by at least this much (full scale is 1.0)...
+    float minimumJump = 0.1f;
+    // ...and by this many times the signal's own curvature (second difference) on
+    // either side. Real transients bend gradually; a click is a step out of nowhere.
+    float slopeRatio = 8.0f;
+};
+
+// Flags sample-level jumps where one block meets the next: the mark a dropped, doubled
+// or reordered block leaves in otherwise continuous audio even when every counter
+// agrees. Fed the stream in order, span by span; keeps the last few frames (of up to
+// kMaxChannels channels) to extrapolate the next block's first frame from and to
+// judge how rough the signal is anyway.
+class BlockBoundaryDetector
+{
+public:
+    static constexpr std::uint32_t kMaxChannels = 32;
+    static constexpr std::uint32_t kHistoryFrames = 4;
+    // Frames after the boundary the roughness is measured over.
+    static constexpr std::uint32_t kLookaheadFrames = 5;
+
+    struct Finding
+    {
+        bool found = false;
+        std::uint32_t channel = 0;
+        float jump = 0.0f;
+    };
+
+    void setSettings(const DiscontinuitySettings& newSettings) noexcept
+    {
+        settings = newSettings;
+    }
+
+    // Forget the history, e.g. after frames were skipped or the format changed.
+    void reset() noexcept
+    {
+        historyFrames = 0;
+    }
+
+    // `frames` interleaved frames that follow the ones fed last. If `blockStart`, the
+    // first of them begins a block and is checked against the frames before it; the
+    // worst channel over the threshold is returned.
+    Finding feed(const float* interleaved, std::uint32_t frames, std::uint32_t channels, bool blockStart) noexcept
+    {
+        Finding finding;
+        if (frames == 0 || channels == 0)
+        {
+            return finding;
+        }
+
+        const auto checked = channels < kMaxChannels ? channels : kMaxChannels;
+        if (checked != historyChannels)
+        {
+            historyChannels = checked;
+            historyFrames = 0;
+        }
+
+        if (blockStart && historyFrames > 0)
+        {
+            for (std::uint32_t channel = 0; channel < checked; ++channel)
+            {
+                const auto jump = std::fabs(interleaved[channel] - extrapolate(channel));
+                const auto before = curvatureBefore(channel);
+                const auto after = curvatureAfter(interleaved, frames, channels, channel);
+                const auto curvature = before > after ? before : after;
+                if (jump >= settings.minimumJump && jump > settings.slopeRatio * curvature && jump > finding.jump)
+                {
+                    finding.found = true;
+                    finding.channel = channel;
+                    finding.jump = jump;
+                }
+            }
+        }
+
+        const auto kept = frames < kHistoryFrames ? frames : kHistoryFrames;
+        for (auto frame = frames - kept; frame < frames; ++frame)
+        {
+            const auto* source = interleaved + static_cast<std::size_t>(frame) * channels;
+            for (std::uint32_t channel = 0; channel < checked; ++channel)
+            {
+                for (auto age = kHistoryFrames - 1; age > 0; --age)
+                {
+                    history[age][channel] = history[age - 1][channel];
+                }
+                history[0][channel] = source[channel];
+            }
+        }
+        historyFrames = historyFrames + kept < kHistoryFrames ? historyFrames + kept : kHistoryFrames;
+        return finding;
+    }
+
+private:
+    // Where the signal would have gone next, from its last two frames.
+    [[nodiscard]] float extrapolate(std::uint32_t channel) const noexcept
+    {
+        return historyFrames > 1 ? 2.0f * history[0][channel] - history[1][channel] : history[0][channel];
+    }
+
+    // How far the signal itself strays from a straight line (the largest second
+    // difference) just before and just after the boundary. Taking the largest of a few
+    // keeps noise-like signals, whose second differences swing widely, from passing
+    // for clicks. With too few frames this falls back to the plain step.
+    [[nodiscard]] float curvatureBefore(std::uint32_t channel) const noexcept
+    {
+        if (historyFrames < 3)
+        {
+            return historyFrames > 1 ? std::fabs(history[0][channel] - history[1][channel]) : 0.0f;
+        }
+
+        float largest = 0.0f;
+        for (std::uint32_t frame = 0; frame + 2 < historyFrames; ++frame)
+        {
+            const auto curvature = std::fabs(history[frame][channel] - 2.0f * history[frame + 1][channel]
+                                             + history[frame + 2][channel]);
+            largest = curvature > largest ? curvature : largest;
+        }
+        return largest;
+    }
+
+    [[nodiscard]] static float curvatureAfter(const float* interleaved,
+                                              std::uint32_t frames,
+                                              std::uint32_t channels,
+                                              std::uint32_t channel) noexcept
+    {
+        if (frames < 3)
+        {
+            return frames > 1 ? std::fabs(interleaved[channels + channel] - interleaved[channel]) : 0.0f;
+        }
+
+        const auto measured = frames < kLookaheadFrames ? frames : kLookaheadFrames;
+        float largest = 0.0f;
+        for (std::uint32_t frame = 0; frame + 2 < measured; ++frame)
+        {
+            const auto* sample = interleaved + static_cast<std::size_t>(frame) * channels + channel;
+            const auto curvature = std::fabs(sample[0] - 2.0f * sample[channels] + sample[2 * channels]);
+            largest = curvature > largest ? curvature : largest;
+        }
+        return largest;
+    }
+
+    DiscontinuitySettings settings;
+    // history[0] is the newest frame.
+    float history[kHistoryFrames][kMaxChannels] {};
+    std::uint32_t historyFrames = 0;
+    std::uint32_t historyChannels = 0;
+};
+} // namespace oceanaudio
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #if defined(_WIN32)
@@ -20,10 +21,62 @@ inline constexpr std::uint32_t kDeviceType = 0x9C40; // FILE_DEVICE_UNKNOWN rang
 
 enum class BridgeIoctl : std::uint32_t
 {
-    QuerySharedBuffer = 0x800, // returns SharedBufferInfo
-    SubmitFrames = 0x801,      // accepts BridgeAudioPacket + float payload
+    QuerySharedBuffer = 0x800,   // SharedBufferInfo in (the service's offer) and out (the answer)
+    SubmitFrames = 0x801,        // accepts BridgeAudioPacket + interleaved payload
+    ReleaseSharedBuffer = 0x802, // direct mode: stop reading the ring and unmap it
 };
 
+// How audio gets from the ring to the final consumer, agreed through QuerySharedBuffer.
+enum class BridgeTransferMode : std::uint32_t
+{
+    // The service reads the ring and forwards every block with SubmitFrames.
+    Copy = 0,
+    // The consumer maps the ring itself and reads it as one of the broadcast readers;
+    // the service only supervises the connection.
+    Direct = 1,
+};
+
+[[nodiscard]] constexpr const char* toString(BridgeTransferMode mode) noexcept
+{
+    switch (mode)
+    {
+        case BridgeTransferMode::Copy: return "copy";
+        case BridgeTransferMode::Direct: return "direct";
+    }
+    return "unknown";
+}
+
+// Sample encodings a consumer can ask the bridge service for. The ring itself always
+// carries Float32; integer formats are packed little-endian, Int24 in three bytes.
+enum class BridgeSampleFormat : std::uint32_t
+{
+    Float32 = 0,
+    Int16 = 1,
+    Int24 = 2,
+};
+
+[[nodiscard]] constexpr std::uint32_t bytesPerSample(BridgeSampleFormat format) noexcept
+{
+    switch (format)
+    {
+        case BridgeSampleFormat::Float32: return 4;
+        case BridgeSampleFormat::Int16: return 2;
+        case BridgeSampleFormat::Int24: return 3;
+    }
+    return 4;
+}
+
+[[nodiscard]] constexpr const char* toString(BridgeSampleFormat format) noexcept
+{
+    switch (format)
+    {
+        case BridgeSampleFormat::Float32: return "f32";
+        case BridgeSampleFormat::Int16: return "s16";
+        case BridgeSampleFormat::Int24: return "s24";
+    }
+    return "unknown";
+}
+
 #if defined(_WIN32)
 inline constexpr std::uint32_t BridgeIoctlCode(BridgeIoctl code)
 {
@@ -36,18 +89,32 @@ inline constexpr std::uint32_t BridgeIoctlCode(BridgeIoctl code)
 
 struct SharedBufferInfo
 {
-    std::uint64_t sharedMemoryHandle; // HANDLE value (UMDF) or section pointer
+    std::uint64_t sharedMemoryHandle; // HANDLE value (UMDF), section pointer or POSIX descriptor
     std::uint32_t channels;
     std::uint32_t sampleRate;
     std::uint32_t frameCapacity;
     std::uint32_t framesPerBlock;
+    // In the offer: the mode the service asks for and the header version of the
+    // mapping. In the answer: the mode the consumer took and, in Direct mode, the reader
+    // slot it attached to. A consumer that answers without both fields predates
+    // negotiation and takes Copy.
+    std::uint32_t transferMode;
+    std::uint32_t layoutVersion;
+    std::uint32_t readerSlot;
+    std::uint32_t reserved;
 };
 
+// Answers at least this long carry transferMode and readerSlot; shorter ones take Copy.
+inline constexpr std::size_t kNegotiatingSharedBufferInfoSize =
+    offsetof(SharedBufferInfo, readerSlot) + sizeof(std::uint32_t);
+
 struct BridgeAudioPacket
 {
     std::uint32_t framesWritten;
-    std::uint32_t reserved;
-    // Sample data follows this struct (float interleaved).
+    // A BridgeSampleFormat value. This used to be a reserved zero, which reads as
+    // Float32, so packets from older services stay valid.
+    std::uint32_t sampleFormat;
+    // Interleaved sample data in that format follows this struct.
 };
 } // namespace oceanaudio
 
@@ -1,36 +1,456 @@
 #pragma once
 
-#include <cstdint>
+#include <OceanAudio/BroadcastRing.h>
+#include <OceanAudio/LatencyHistogram.h>
+#include <OceanAudio/PeerHeartbeat.h>
+#include <OceanAudio/WakeupSignalling.h>
+
 #include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 
 namespace oceanaudio
 {
-struct SharedAudioRingBufferHeader
+// Capacity of the block-descriptor side ring. The frame ring holds at most 32 blocks
+// of the advertised size; the slack covers hosts that deliver smaller blocks.
+inline constexpr std::uint32_t kBlockDescriptorCount = 256;
+
+// BridgeBlockDescriptor::flags: `checksum` holds the CRC-32C of the block's
+// interleaved payload (see BridgeIntegrity.h). Producers that do not sum leave it clear.
+inline constexpr std::uint32_t kBlockHasChecksum = 1u << 0;
+
+// Timing and integrity data of one committed block. Written seqlock-style by the
+// producer: `sequence` is zeroed, the fields are written, then `sequence` is
+// published, so a reader that sees the same non-zero sequence before and after
+// reading the fields has a consistent copy. Sequence numbers advance by one per block,
+// so a reader walking them can tell a lost block from a late one.
+struct BridgeBlockDescriptor
 {
-    static constexpr std::uint32_t kMagic = 0x4F415342; // 'OASB'
-    static constexpr std::uint32_t kVersion = 1;
+    std::atomic<std::uint64_t> sequence {0};
+    std::atomic<std::uint64_t> frameIndex {0};
+    std::atomic<std::uint64_t> captureTimeNs {0};
+    std::atomic<std::uint32_t> frames {0};
+    // Blocks the producer dropped since the previous descriptor, so readers learn of
+    // drops at the point in the stream where they happened.
+    std::atomic<std::uint32_t> droppedBefore {0};
+    std::atomic<std::uint32_t> flags {0};
+    std::atomic<std::uint32_t> checksum {0};
+};
 
-    std::uint32_t magic = kMagic;
-    std::uint32_t version = kVersion;
+// Plain copy of a descriptor as read by the consumer.
+struct BridgeBlockTiming
+{
+    std::uint64_t sequence = 0;
+    std::uint64_t frameIndex = 0;
+    std::uint64_t captureTimeNs = 0;
+    std::uint32_t frames = 0;
+    std::uint32_t droppedBefore = 0;
+    std::uint32_t flags = 0;
+    std::uint32_t checksum = 0;
+};
+
+// The producer's format as one consistent copy (see SharedAudioRingBufferHeader::
+// readFormat). Frames from `startFrame` on are in this format.
+struct BridgeFormat
+{
+    std::uint32_t generation = 0;
     std::uint32_t channels = 0;
     std::uint32_t sampleRate = 0;
     std::uint32_t frameCapacity = 0;
     std::uint32_t framesPerBlock = 0;
-    std::atomic<std::uint32_t> writePosition {0};
-    std::atomic<std::uint32_t> readPosition {0};
-    std::atomic<std::uint32_t> framesAvailable {0};
+    std::uint64_t startFrame = 0;
+};
+
+// Every header revision starts with these two fields so that a peer can recognise a
+// mapping it does not understand before touching anything else.
+struct SharedAudioRingBufferPrefix
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+};
+
+// The header is split into cache-line-sized regions so that the producer's and the
+// consumer's stores never invalidate each other's lines or the format fields that
+// both sides read on every block:
+//   - read-mostly: identity, payload reservation and format, rewritten only on format
+//     changes under the format generation seqlock
+//   - producer-owned: write cursor, overrun counter and the producer's heartbeat
+//   - reader slots: one line per registered reader (cursor, lag policy, underruns,
+//     heartbeat)
+//   - wakeup: waiter flags (WakeupSignalling.h); written only around a sleep
+//   - block descriptors: producer-written capture timestamps, drop counts and
+//     checksums, one per block
+//   - residency histogram: consumer-written, read by anyone (host UI, tools)
+// sizeof(header) is a multiple of the cache line, so the payload that follows is
+// cache-line aligned as long as the mapping itself is (mappings are page aligned).
+struct alignas(kCacheLineSize) SharedAudioRingBufferHeader
+{
+    static constexpr std::uint32_t kMagic = 0x4F415342; // 'OASB'
+    // Version 2 replaced the 32-bit positions and the shared framesAvailable counter
+    // with free-running 64-bit cursors driven through SpscRing.h. Version 3 moved the
+    // cursors and counters onto their own cache lines. Version 4 added the waiter
+    // flags; a peer that ignores them would never be woken. Version 5 added the block
+    // descriptors and the residency histogram. Version 6 replaced the single read
+    // cursor with broadcast reader slots (BroadcastRing.h). Version 7 put the format
+    // under a generation seqlock and reserved payload room for in-place changes.
+    // Version 8 added heartbeats for the producer and every reader. Version 9 added
+    // drop counts, flags and an optional checksum to the block descriptors.
+    static constexpr std::uint32_t kVersion = 9;
+
+    // Odd generation the producer leaves behind when it gives a mapping up for good
+    // (disconnect, or a format too large for the reservation). Readers must reopen.
+    static constexpr std::uint32_t kFormatRetired = 0xFFFFFFFFu;
+
+    std::uint32_t magic = kMagic;
+    std::uint32_t version = kVersion;
+    // Even while the format is stable, odd while the producer rewrites it. Each change
+    // advances it by two; readers acknowledge the value they have adopted in their
+    // reader slot, and the producer holds back until Stall readers have.
+    std::atomic<std::uint32_t> formatGeneration {0};
+    std::atomic<std::uint32_t> channels {0};
+    std::atomic<std::uint32_t> sampleRate {0};
+    std::atomic<std::uint32_t> frameCapacity {0};
+    std::atomic<std::uint32_t> framesPerBlock {0};
+    // Write cursor at the last format change; earlier frames are in the old format.
+    std::atomic<std::uint64_t> formatStartFrame {0};
+    // Payload bytes the mapping holds, fixed at creation. Any format whose ring fits
+    // is applied in place.
+    std::uint64_t payloadCapacityBytes = 0;
+
+    alignas(kCacheLineSize) std::atomic<std::uint64_t> writeCursor {0};
     std::atomic<std::uint32_t> overruns {0};
-    std::atomic<std::uint32_t> underruns {0};
+    // sharedClockNanoseconds() of the last commit; 0 if the producer does not stamp.
+    // Lets the consumer tell how far the producer is into its next block.
+    std::atomic<std::uint64_t> writeTimestampNs {0};
+    // Sequence number of the newest published block descriptor (the first is 1).
+    std::atomic<std::uint64_t> blockSequence {0};
+    // Detach-policy readers the producer cut loose because they fell a ring behind.
+    std::atomic<std::uint32_t> readerDetachments {0};
+    // Readers the producer freed the slot of because they stopped beating.
+    std::atomic<std::uint32_t> readerEvictions {0};
+    // Beaten by the producer while it owns the mapping, whether or not audio flows, so
+    // readers can tell a dead producer from a quiet one.
+    PeerHeartbeat producerHeartbeat;
+
+    // One slot per reader; the producer holds back for the slowest gating one.
+    BroadcastReaderSlot readers[kMaxBroadcastReaders];
+
+    // Bit n is set while reader slot n is attached, so the producer only checks the
+    // waiter flags of readers that exist.
+    alignas(kCacheLineSize) std::atomic<std::uint32_t> attachedReaders {0};
+    // Raised by a reader before it blocks on its ready event (and by the producer
+    // before blocking on the consumed event). The peer signals only while it is set.
+    std::atomic<std::uint32_t> readerWaiting[kMaxBroadcastReaders] {};
+    std::atomic<std::uint32_t> producerWaiting {0};
+    // Kernel signals actually issued by the producer, for diagnostics.
+    std::atomic<std::uint32_t> wakeSignals {0};
+
+    alignas(kCacheLineSize) BridgeBlockDescriptor blockDescriptors[kBlockDescriptorCount];
+
+    // Time from a block's capture timestamp until the reader in slot 0 released its
+    // last frame. Only that reader records, which keeps the histogram single-writer.
+    alignas(kCacheLineSize) SharedLatencyHistogram residency;
 
     [[nodiscard]] std::uint32_t bytesPerFrame() const noexcept
     {
-        return channels * sizeof(float);
+        return channels.load(std::memory_order_relaxed) * static_cast<std::uint32_t>(sizeof(float));
     }
 
     [[nodiscard]] std::uint32_t bufferSizeBytes() const noexcept
     {
-        return frameCapacity * bytesPerFrame();
+        return frameCapacity.load(std::memory_order_relaxed) * bytesPerFrame();
+    }
+
+    // Producer: rewrite the format. Readers that look meanwhile see an odd generation
+    // or a changed one and retry; frames from `startFrame` on are in the new format.
+    // Returns the new generation.
+    std::uint32_t writeFormat(std::uint32_t newChannels,
+                              std::uint32_t newSampleRate,
+                              std::uint32_t newFrameCapacity,
+                              std::uint32_t newFramesPerBlock,
+                              std::uint64_t startFrame) noexcept
+    {
+        auto generation = formatGeneration.load(std::memory_order_relaxed);
+        generation = generation == kFormatRetired ? 0 : generation & ~1u;
+
+        formatGeneration.store(generation + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        channels.store(newChannels, std::memory_order_relaxed);
+        sampleRate.store(newSampleRate, std::memory_order_relaxed);
+        frameCapacity.store(newFrameCapacity, std::memory_order_relaxed);
+        framesPerBlock.store(newFramesPerBlock, std::memory_order_relaxed);
+        formatStartFrame.store(startFrame, std::memory_order_relaxed);
+        formatGeneration.store(generation + 2, std::memory_order_release);
+        return generation + 2;
+    }
+
+    // Reader: one attempt at a consistent copy of the format. Fails while a change is
+    // in progress (retry shortly) and once the mapping is retired (check generation).
+    bool readFormat(BridgeFormat& format) const noexcept
+    {
+        const auto generation = formatGeneration.load(std::memory_order_acquire);
+        format.generation = generation;
+        if ((generation & 1u) != 0)
+        {
+            return false;
+        }
+
+        format.channels = channels.load(std::memory_order_relaxed);
+        format.sampleRate = sampleRate.load(std::memory_order_relaxed);
+        format.frameCapacity = frameCapacity.load(std::memory_order_relaxed);
+        format.framesPerBlock = framesPerBlock.load(std::memory_order_relaxed);
+        format.startFrame = formatStartFrame.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return formatGeneration.load(std::memory_order_relaxed) == generation;
+    }
+
+    // A format rewrite is a handful of stores; this many failed snapshots means the
+    // producer died half-way through one.
+    static constexpr int kFormatReadAttempts = 1000;
+
+    // Reader: retries readFormat until it succeeds, the mapping is retired or the
+    // attempts run out. For attach paths, which can afford to spin briefly.
+    bool readFormatBounded(BridgeFormat& format) const noexcept
+    {
+        for (int attempt = 0; attempt < kFormatReadAttempts; ++attempt)
+        {
+            if (readFormat(format))
+            {
+                return true;
+            }
+            if (format.generation == kFormatRetired)
+            {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    // Whether a ring of this shape fits the mapping's payload reservation.
+    [[nodiscard]] bool fitsReservation(std::uint32_t ringChannels, std::uint32_t ringCapacity) const noexcept
+    {
+        return static_cast<std::uint64_t>(ringCapacity) * ringChannels * sizeof(float) <= payloadCapacityBytes;
+    }
+
+    // Whether a reader can use `format`: some channels and a power-of-two ring that fits.
+    [[nodiscard]] bool isReadable(const BridgeFormat& format) const noexcept
+    {
+        return format.channels != 0 && isValidRingCapacity(format.frameCapacity)
+               && fitsReservation(format.channels, format.frameCapacity);
+    }
+
+    [[nodiscard]] float* payload() noexcept
+    {
+        return reinterpret_cast<float*>(this + 1);
+    }
+
+    [[nodiscard]] const float* payload() const noexcept
+    {
+        return reinterpret_cast<const float*>(this + 1);
+    }
+
+    // Producer: describe the block about to be committed at `frameIndex`. Call before
+    // the commit so the descriptor is visible by the time its frames are.
+    // `droppedBefore` is the blocks dropped since the last call; pass kBlockHasChecksum
+    // in `flags` when `checksum` is set.
+    void publishBlock(std::uint64_t frameIndex,
+                      std::uint32_t frames,
+                      std::uint64_t captureTimeNs,
+                      std::uint32_t droppedBefore = 0,
+                      std::uint32_t flags = 0,
+                      std::uint32_t checksum = 0) noexcept
+    {
+        const auto sequence = blockSequence.load(std::memory_order_relaxed) + 1;
+        auto& descriptor = blockDescriptors[sequence % kBlockDescriptorCount];
+
+        descriptor.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        descriptor.frameIndex.store(frameIndex, std::memory_order_relaxed);
+        descriptor.captureTimeNs.store(captureTimeNs, std::memory_order_relaxed);
+        descriptor.frames.store(frames, std::memory_order_relaxed);
+        descriptor.droppedBefore.store(droppedBefore, std::memory_order_relaxed);
+        descriptor.flags.store(flags, std::memory_order_relaxed);
+        descriptor.checksum.store(checksum, std::memory_order_relaxed);
+        descriptor.sequence.store(sequence, std::memory_order_release);
+        blockSequence.store(sequence, std::memory_order_release);
+    }
+
+    // Producer, after a commit: calls `signalReader(slot)` for every attached reader
+    // that announced a sleep, clearing its flag so one sleep costs one signal.
+    template <typename SignalReader>
+    void wakeSleepingReaders(SignalReader&& signalReader) noexcept
+    {
+        for (auto pending = attachedReaders.load(std::memory_order_relaxed); pending != 0; pending &= pending - 1)
+        {
+            const auto slot = static_cast<std::uint32_t>(std::countr_zero(pending));
+            if (wakeup::claimSleepingPeer(readerWaiting[slot]))
+            {
+                signalReader(slot);
+            }
+        }
+    }
+
+    // Whether any attached reader has beaten within `timeoutNs`.
+    [[nodiscard]] bool anyReaderAlive(std::uint64_t nowNs, std::uint64_t timeoutNs) const noexcept
+    {
+        for (auto pending = attachedReaders.load(std::memory_order_acquire); pending != 0; pending &= pending - 1)
+        {
+            if (readers[std::countr_zero(pending)].heartbeat.isAlive(nowNs, timeoutNs))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Producer: frees the slot of every reader that has not beaten within `timeoutNs`
+    // (crashed, or frozen that long), so a dead Stall reader cannot hold the ring back
+    // for good and its slot can be claimed again. A reader that was only frozen finds
+    // the slot gone on its next read and attaches afresh. Returns the readers evicted.
+    std::uint32_t evictDeadReaders(std::uint64_t nowNs, std::uint64_t timeoutNs) noexcept
+    {
+        std::uint32_t evicted = 0;
+        for (std::uint32_t slot = 0; slot < kMaxBroadcastReaders; ++slot)
+        {
+            auto& reader = readers[slot];
+            auto state = reader.state.load(std::memory_order_acquire);
+            if ((state != static_cast<std::uint32_t>(ReaderSlotState::Active)
+                 && state != static_cast<std::uint32_t>(ReaderSlotState::Detached))
+                || reader.heartbeat.isAlive(nowNs, timeoutNs))
+            {
+                continue;
+            }
+
+            if (reader.state.compare_exchange_strong(state,
+                                                     static_cast<std::uint32_t>(ReaderSlotState::Free),
+                                                     std::memory_order_acq_rel))
+            {
+                attachedReaders.fetch_and(~(1u << slot), std::memory_order_acq_rel);
+                wakeup::cancelSleep(readerWaiting[slot]);
+                ++evicted;
+            }
+        }
+
+        readerEvictions.fetch_add(evicted, std::memory_order_relaxed);
+        return evicted;
+    }
+
+    // Consumer: copy descriptor `sequence`. Fails if the slot holds another block (not
+    // yet published, or already overwritten) or is being rewritten right now.
+    bool readBlock(std::uint64_t sequence, BridgeBlockTiming& timing) const noexcept
+    {
+        const auto& descriptor = blockDescriptors[sequence % kBlockDescriptorCount];
+        if (descriptor.sequence.load(std::memory_order_acquire) != sequence)
+        {
+            return false;
+        }
+
+        timing.sequence = sequence;
+        timing.frameIndex = descriptor.frameIndex.load(std::memory_order_relaxed);
+        timing.captureTimeNs = descriptor.captureTimeNs.load(std::memory_order_relaxed);
+        timing.frames = descriptor.frames.load(std::memory_order_relaxed);
+        timing.droppedBefore = descriptor.droppedBefore.load(std::memory_order_relaxed);
+        timing.flags = descriptor.flags.load(std::memory_order_relaxed);
+        timing.checksum = descriptor.checksum.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return descriptor.sequence.load(std::memory_order_relaxed) == sequence;
     }
 };
-} // namespace oceanaudio
 
+static_assert(sizeof(SharedAudioRingBufferHeader) % kCacheLineSize == 0);
+static_assert(offsetof(SharedAudioRingBufferHeader, writeCursor) % kCacheLineSize == 0);
+static_assert(offsetof(SharedAudioRingBufferHeader, payloadCapacityBytes) + sizeof(std::uint64_t) <= kCacheLineSize);
+static_assert(offsetof(SharedAudioRingBufferHeader, producerHeartbeat) + sizeof(PeerHeartbeat)
+              <= offsetof(SharedAudioRingBufferHeader, writeCursor) + kCacheLineSize);
+static_assert(offsetof(SharedAudioRingBufferHeader, readers) % kCacheLineSize == 0);
+static_assert(offsetof(SharedAudioRingBufferHeader, readers) - offsetof(SharedAudioRingBufferHeader, writeCursor)
+              >= kCacheLineSize);
+static_assert(offsetof(SharedAudioRingBufferHeader, attachedReaders) % kCacheLineSize == 0);
+static_assert(offsetof(SharedAudioRingBufferHeader, residency) % kCacheLineSize == 0);
+
+enum class SharedLayoutStatus
+{
+    Compatible,
+    Uninitialised,  // magic missing: nothing (or something foreign) in the mapping
+    OlderVersion,   // written by an older peer
+    NewerVersion,   // written by a newer peer
+    Truncated,      // mapping smaller than the header plus the advertised payload
+    InvalidFormat,  // header fields cannot describe a usable ring
+    ProducerGone,   // the producer stopped beating without retiring the mapping
+};
+
+[[nodiscard]] inline const char* toString(SharedLayoutStatus status) noexcept
+{
+    switch (status)
+    {
+        case SharedLayoutStatus::Compatible: return "compatible";
+        case SharedLayoutStatus::Uninitialised: return "uninitialised";
+        case SharedLayoutStatus::OlderVersion: return "older layout version";
+        case SharedLayoutStatus::NewerVersion: return "newer layout version";
+        case SharedLayoutStatus::Truncated: return "mapping truncated";
+        case SharedLayoutStatus::InvalidFormat: return "invalid format";
+        case SharedLayoutStatus::ProducerGone: return "producer gone";
+    }
+    return "unknown";
+}
+
+// Checks only the identity prefix; safe on any mapping of at least eight bytes.
+[[nodiscard]] inline SharedLayoutStatus checkSharedLayoutVersion(const void* mapping) noexcept
+{
+    const auto* prefix = static_cast<const SharedAudioRingBufferPrefix*>(mapping);
+    if (prefix->magic != SharedAudioRingBufferHeader::kMagic)
+    {
+        return SharedLayoutStatus::Uninitialised;
+    }
+
+    if (prefix->version < SharedAudioRingBufferHeader::kVersion)
+    {
+        return SharedLayoutStatus::OlderVersion;
+    }
+
+    if (prefix->version > SharedAudioRingBufferHeader::kVersion)
+    {
+        return SharedLayoutStatus::NewerVersion;
+    }
+
+    return SharedLayoutStatus::Compatible;
+}
+
+// Full check for a consumer attaching to an existing mapping of `mappedBytes` bytes.
+[[nodiscard]] inline SharedLayoutStatus checkSharedLayout(const void* mapping, std::size_t mappedBytes) noexcept
+{
+    if (mappedBytes < sizeof(SharedAudioRingBufferPrefix))
+    {
+        return SharedLayoutStatus::Truncated;
+    }
+
+    const auto status = checkSharedLayoutVersion(mapping);
+    if (status != SharedLayoutStatus::Compatible)
+    {
+        return status;
+    }
+
+    if (mappedBytes < sizeof(SharedAudioRingBufferHeader))
+    {
+        return SharedLayoutStatus::Truncated;
+    }
+
+    // A producer that retires or rewrites the format right now is caught later by the
+    // reader's generation check; this only has to reject nonsense.
+    const auto* header = static_cast<const SharedAudioRingBufferHeader*>(mapping);
+    const auto capacity = header->frameCapacity.load(std::memory_order_acquire);
+    const auto channels = header->channels.load(std::memory_order_acquire);
+    if (channels == 0 || capacity == 0 || (capacity & (capacity - 1)) != 0 || !header->fitsReservation(channels, capacity))
+    {
+        return SharedLayoutStatus::InvalidFormat;
+    }
+
+    if (mappedBytes < sizeof(SharedAudioRingBufferHeader) + header->payloadCapacityBytes)
+    {
+        return SharedLayoutStatus::Truncated;
+    }
+
+    return SharedLayoutStatus::Compatible;
+}
+} // namespace oceanaudio
@@ -0,0 +1,613 @@
+#pragma once
+
+#include <OceanAudio/PeerHeartbeat.h>
+#include <OceanAudio/SpscRing.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace oceanaudio
+{
+// Reader slots in a broadcast ring. Slot 0's ready event keeps the single-consumer
+// name, so the first reader to attach looks exactly like the old consumer.
+inline constexpr std::uint32_t kMaxBroadcastReaders = 8;
+
+// What the producer does about a reader that falls a whole ring behind.
+enum class ReaderLagPolicy : std::uint32_t
+{
+    // Hold back for it: new blocks are dropped (overruns) until it catches up. This is
+    // the single-consumer behaviour and suits a consumer that must not lose audio; one
+    // stalled reader of this kind stalls every reader.
+    Stall = 0,
+    // Never wait for it. A reader that falls too far behind jumps forward to the newest
+    // audio and counts the frames it skipped.
+    Skip = 1,
+    // Wait for it until it would cost a block, then detach it. The reader notices on its
+    // next read and rejoins at the newest frame.
+    Detach = 2,
+};
+
+[[nodiscard]] inline const char* toString(ReaderLagPolicy policy) noexcept
+{
+    switch (policy)
+    {
+        case ReaderLagPolicy::Stall: return "stall";
+        case ReaderLagPolicy::Skip: return "skip";
+        case ReaderLagPolicy::Detach: return "detach";
+    }
+    return "unknown";
+}
+
+enum class ReaderSlotState : std::uint32_t
+{
+    Free = 0,
+    Claiming = 1, // taken, cursor not yet positioned; the producer ignores it
+    Active = 2,
+    Detached = 3, // set by the producer; only the reader moves it on from here
+};
+
+// One reader's cursor, on its own cache line so readers never contend with each other.
+// The reader writes `cursor` on every read; the producer only looks at the slots when
+// its cached view of the slowest reader says the ring is full. `formatGeneration` is
+// the last format generation the reader adopted (see BroadcastRingProducer::
+// setFormatGeneration). `epoch` advances with every claim, so a reader whose slot was
+// taken from it (see SharedAudioRingBufferHeader::evictDeadReaders) can tell even if
+// someone else has claimed it since; `heartbeat` is what that eviction goes by.
+struct alignas(kCacheLineSize) BroadcastReaderSlot
+{
+    std::atomic<std::uint32_t> state {0};
+    std::atomic<std::uint32_t> policy {0};
+    std::atomic<std::uint64_t> cursor {0};
+    std::atomic<std::uint32_t> underruns {0};
+    std::atomic<std::uint32_t> formatGeneration {0};
+    std::atomic<std::uint32_t> epoch {0};
+    PeerHeartbeat heartbeat;
+};
+
+static_assert(sizeof(BroadcastReaderSlot) == kCacheLineSize);
+
+// Producer half of a single-producer/multi-reader broadcast ring. Every reader sees
+// every frame (nothing is copied per reader); the write cursor is free-running as in
+// SpscRingProducer, and each reader keeps its own cursor in a BroadcastReaderSlot.
+//
+// The producer caches the slowest gating reader's cursor and rescans the slots only
+// when that cached value says the block will not fit, so with room in the ring a block
+// still costs one release store. Skip readers never gate it; Detach readers gate it
+// until they would cost a block. With no gating readers the ring free-runs and the
+// oldest audio is simply overwritten.
+//
+// Format changes are negotiated through a generation number. After
+// setFormatGeneration() the producer treats the ring as full until every Stall reader
+// has acknowledged the new generation (BroadcastRingReader::reformat), so none of them
+// is still reading old-format frames when new ones land. Skip and Detach readers are
+// not waited for; until they adopt the new generation they are treated as Skip readers
+// (old-format frames they had not read are dropped by the change anyway).
+class BroadcastRingProducer
+{
+public:
+    // `detachmentCounter`, if given, is bumped for every reader the producer detaches.
+    void attach(std::atomic<std::uint64_t>& writeCursorToUse,
+                BroadcastReaderSlot* readerSlots,
+                std::uint32_t capacityFrames,
+                std::atomic<std::uint32_t>* detachmentCounter = nullptr) noexcept
+    {
+        writeCursor = &writeCursorToUse;
+        slots = readerSlots;
+        detachments = detachmentCounter;
+        mask = capacityFrames - 1;
+        localWrite = writeCursor->load(std::memory_order_relaxed);
+        cachedSlowest = localWrite;
+        findSlowestReader(0);
+    }
+
+    void detach() noexcept
+    {
+        writeCursor = nullptr;
+        slots = nullptr;
+        detachments = nullptr;
+        mask = 0;
+        localWrite = 0;
+        cachedSlowest = 0;
+        generation = 0;
+        awaitingAcknowledgements = false;
+    }
+
+    // Starts a format generation; call before attach() when the capacity changes too.
+    // Writes fail until every Stall reader has moved to it.
+    void setFormatGeneration(std::uint32_t formatGeneration) noexcept
+    {
+        generation = formatGeneration;
+        awaitingAcknowledgements = true;
+    }
+
+    // True while the producer is holding back for readers to adopt a new format.
+    [[nodiscard]] bool isAwaitingAcknowledgements() const noexcept
+    {
+        return awaitingAcknowledgements;
+    }
+
+    [[nodiscard]] bool isAttached() const noexcept
+    {
+        return writeCursor != nullptr;
+    }
+
+    [[nodiscard]] std::uint32_t capacity() const noexcept
+    {
+        return isAttached() ? mask + 1 : 0;
+    }
+
+    // Frames the slowest gating reader still has to read, as last observed.
+    [[nodiscard]] std::uint32_t queuedFrames() const noexcept
+    {
+        return static_cast<std::uint32_t>(localWrite - cachedSlowest);
+    }
+
+    [[nodiscard]] std::uint64_t cursor() const noexcept
+    {
+        return localWrite;
+    }
+
+    // Reserves space for exactly `frames` frames, or fails without side effects other
+    // than detaching Detach readers that would have blocked it.
+    [[nodiscard]] bool prepareWrite(std::uint32_t frames, SpscRingRegions& regions) noexcept
+    {
+        if (!isAttached() || frames > capacity())
+        {
+            return false;
+        }
+
+        if (awaitingAcknowledgements || capacity() - queuedFrames() < frames)
+        {
+            findSlowestReader(frames);
+            if (awaitingAcknowledgements || capacity() - queuedFrames() < frames)
+            {
+                return false;
+            }
+        }
+
+        regions = detail::makeRingRegions(localWrite, frames, mask);
+        return true;
+    }
+
+    void commitWrite(std::uint32_t frames) noexcept
+    {
+        localWrite += frames;
+        writeCursor->store(localWrite, std::memory_order_release);
+    }
+
+private:
+    void findSlowestReader(std::uint32_t framesToWrite) noexcept
+    {
+        // Pairs with the fence in BroadcastRingReader::joinAtHead(): a reader this scan
+        // misses is guaranteed to position itself at or after our current cursor.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        auto slowest = localWrite;
+        bool staleReaders = false;
+        for (std::uint32_t index = 0; index < kMaxBroadcastReaders; ++index)
+        {
+            auto& slot = slots[index];
+            if (slot.state.load(std::memory_order_acquire) != static_cast<std::uint32_t>(ReaderSlotState::Active))
+            {
+                continue;
+            }
+
+            const auto policy = static_cast<ReaderLagPolicy>(slot.policy.load(std::memory_order_relaxed));
+            if (policy == ReaderLagPolicy::Skip)
+            {
+                continue;
+            }
+
+            // A cursor ahead of ours means the reader has not yet noticed a producer
+            // restart; it will resync on its next read and holds nothing back.
+            // The reader stores its cursor before acknowledging a generation, so an
+            // acknowledged reader's cursor is already in the new format.
+            const bool stale = slot.formatGeneration.load(std::memory_order_acquire) != generation;
+            const auto readerCursor = slot.cursor.load(std::memory_order_acquire);
+            const auto lag = localWrite > readerCursor ? localWrite - readerCursor : 0;
+
+            if (stale)
+            {
+                staleReaders = staleReaders || policy == ReaderLagPolicy::Stall;
+                continue;
+            }
+
+            if (policy == ReaderLagPolicy::Detach && lag + framesToWrite > capacity())
+            {
+                auto expected = static_cast<std::uint32_t>(ReaderSlotState::Active);
+                if (slot.state.compare_exchange_strong(expected,
+                                                       static_cast<std::uint32_t>(ReaderSlotState::Detached),
+                                                       std::memory_order_acq_rel)
+                    && detachments != nullptr)
+                {
+                    detachments->fetch_add(1, std::memory_order_relaxed);
+                }
+                continue;
+            }
+
+            if (localWrite - lag < slowest)
+            {
+                slowest = localWrite - lag;
+            }
+        }
+
+        awaitingAcknowledgements = staleReaders;
+        cachedSlowest = slowest;
+    }
+
+    std::atomic<std::uint64_t>* writeCursor = nullptr;
+    BroadcastReaderSlot* slots = nullptr;
+    std::uint32_t mask = 0;
+    std::uint64_t localWrite = 0;
+    std::uint64_t cachedSlowest = 0;
+    std::atomic<std::uint32_t>* detachments = nullptr;
+    std::uint32_t generation = 0;
+    bool awaitingAcknowledgements = false;
+};
+
+// Reader half of the broadcast ring. attach() claims a free slot and starts at the
+// newest frame; the read API mirrors SpscRingConsumer. The reader has to beat its
+// slot's heartbeat while attached, or the producer may evict it; once evicted it
+// reads nothing and no longer writes to the slot, and the owner must attach again.
+// Every store into the slot first checks the slot is still ours (not freed, same
+// epoch), and the cursor is only ever moved by compare-exchange from the value this
+// reader last stored, so a reader that froze past its eviction cannot overwrite a
+// cursor a new owner has positioned.
+//
+// Skip and Detach readers are not waited for, so the producer may reach frames while
+// they are still being read. commitRead() checks for that after the fact (the way a
+// seqlock reader does) and counts such frames as overwritten; `guardFrames` is the
+// largest block the producer may have in flight past its published cursor.
+class BroadcastRingReader
+{
+public:
+    // Fails when every slot is taken. `formatGeneration` is the generation the reader
+    // read its format from.
+    [[nodiscard]] bool attach(std::atomic<std::uint64_t>& writeCursorToUse,
+                              BroadcastReaderSlot* readerSlots,
+                              std::uint32_t capacityFrames,
+                              ReaderLagPolicy lagPolicy,
+                              std::uint32_t guardFrames,
+                              std::uint32_t formatGeneration = 0) noexcept
+    {
+        for (std::uint32_t index = 0; index < kMaxBroadcastReaders; ++index)
+        {
+            auto expected = static_cast<std::uint32_t>(ReaderSlotState::Free);
+            if (readerSlots[index].state.compare_exchange_strong(expected,
+                                                                 static_cast<std::uint32_t>(ReaderSlotState::Claiming),
+                                                                 std::memory_order_acq_rel))
+            {
+                writeCursor = &writeCursorToUse;
+                slot = &readerSlots[index];
+                slotIndex = index;
+                mask = capacityFrames - 1;
+                policy = lagPolicy;
+                guard = guardFrames < capacityFrames ? guardFrames : capacityFrames / 2;
+                evicted = false;
+                epoch = slot->epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+                publishedRead = slot->cursor.load(std::memory_order_relaxed);
+                slot->heartbeat.beat(sharedClockNanoseconds());
+                slot->policy.store(static_cast<std::uint32_t>(policy), std::memory_order_relaxed);
+                slot->formatGeneration.store(formatGeneration, std::memory_order_relaxed);
+                joinAtHead(ReaderSlotState::Claiming);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Gives the slot back, unless it was already taken from us.
+    void detach() noexcept
+    {
+        if (slot != nullptr && ownsSlot())
+        {
+            // The producer may detach or evict us meanwhile; after an eviction there is
+            // nothing left to give back.
+            auto state = slot->state.load(std::memory_order_acquire);
+            while ((state == static_cast<std::uint32_t>(ReaderSlotState::Active)
+                    || state == static_cast<std::uint32_t>(ReaderSlotState::Detached))
+                   && !slot->state.compare_exchange_weak(state,
+                                                         static_cast<std::uint32_t>(ReaderSlotState::Free),
+                                                         std::memory_order_acq_rel))
+            {
+            }
+        }
+
+        writeCursor = nullptr;
+        slot = nullptr;
+        slotIndex = 0;
+        mask = 0;
+        localRead = 0;
+        publishedRead = 0;
+        cachedWrite = 0;
+        readStart = 0;
+        evicted = false;
+    }
+
+    [[nodiscard]] bool isAttached() const noexcept
+    {
+        return slot != nullptr;
+    }
+
+    [[nodiscard]] std::uint32_t capacity() const noexcept
+    {
+        return isAttached() ? mask + 1 : 0;
+    }
+
+    [[nodiscard]] std::uint32_t getSlotIndex() const noexcept
+    {
+        return slotIndex;
+    }
+
+    [[nodiscard]] BroadcastReaderSlot* getSlot() const noexcept
+    {
+        return slot;
+    }
+
+    [[nodiscard]] ReaderLagPolicy getPolicy() const noexcept
+    {
+        return policy;
+    }
+
+    [[nodiscard]] std::uint64_t cursor() const noexcept
+    {
+        return localRead;
+    }
+
+    // Returns false, and beats nothing, once the slot has been taken from us.
+    bool heartbeat(std::uint64_t nowNs) noexcept
+    {
+        if (!isAttached() || !ownsSlot())
+        {
+            return false;
+        }
+        slot->heartbeat.beat(nowNs);
+        return true;
+    }
+
+    // True once the producer evicted this reader; noticed on the next readableFrames(),
+    // heartbeat() or store into the slot.
+    [[nodiscard]] bool isEvicted() const noexcept
+    {
+        return evicted;
+    }
+
+    // Reloads the producer's cursor and returns the number of frames ready to read.
+    // Rejoins at the newest frame if the producer detached this reader, and skips ahead
+    // if this is a Skip reader about to be overwritten.
+    [[nodiscard]] std::uint32_t readableFrames() noexcept
+    {
+        if (!isAttached() || !ownsSlot())
+        {
+            return 0;
+        }
+
+        if (slot->state.load(std::memory_order_acquire) == static_cast<std::uint32_t>(ReaderSlotState::Detached))
+        {
+            ++rejoins;
+            joinAtHead(ReaderSlotState::Detached);
+            return 0;
+        }
+
+        cachedWrite = writeCursor->load(std::memory_order_acquire);
+        if (cachedWrite < localRead)
+        {
+            // The producer reset or re-seeded its cursor; skip to its position rather
+            // than read frames that were never written.
+            moveTo(cachedWrite);
+            return 0;
+        }
+
+        const auto available = cachedWrite - localRead;
+        if (policy == ReaderLagPolicy::Skip && available > capacity() - guard)
+        {
+            // Keep the newest half of what is still safe to read so the reader resumes
+            // with some slack instead of right at the producer's heels.
+            const auto keep = (capacity() - guard) / 2;
+            framesSkipped += available - keep;
+            moveTo(cachedWrite - keep);
+            return keep;
+        }
+
+        if (available > capacity())
+        {
+            // Lapped while being detached; the next call rejoins.
+            moveTo(cachedWrite);
+            return 0;
+        }
+
+        return static_cast<std::uint32_t>(available);
+    }
+
+    // Maps up to `maxFrames` readable frames; an empty result means nothing is ready.
+    [[nodiscard]] SpscRingRegions prepareRead(std::uint32_t maxFrames) noexcept
+    {
+        auto available = static_cast<std::uint32_t>(cachedWrite - localRead);
+        if (available < maxFrames)
+        {
+            available = readableFrames();
+        }
+
+        const auto frames = available < maxFrames ? available : maxFrames;
+        readStart = localRead;
+        return detail::makeRingRegions(localRead, frames, mask);
+    }
+
+    // Returns false if the producer may have overwritten some of the frames while they
+    // were being read (never for Stall readers).
+    bool commitRead(std::uint32_t frames) noexcept
+    {
+        localRead += frames;
+        if (evicted || !storeCursor(localRead))
+        {
+            return false;
+        }
+
+        if (policy == ReaderLagPolicy::Stall || frames == 0)
+        {
+            return true;
+        }
+
+        // The frame loads above must not drift past the check below.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const bool intact = policy == ReaderLagPolicy::Skip
+                                ? writeCursor->load(std::memory_order_relaxed) + guard <= readStart + capacity()
+                                : slot->state.load(std::memory_order_relaxed)
+                                      == static_cast<std::uint32_t>(ReaderSlotState::Active);
+        if (!intact)
+        {
+            framesOverwritten += frames;
+        }
+        return intact;
+    }
+
+    // Adopts a new format generation: the ring may have a new capacity, and frames from
+    // `startCursor` on are in the new format. The producer starts the new format one
+    // old capacity past its last old-format frame (so a Skip reader still reading old
+    // frames sees them as overwritten); old frames this reader never got to are
+    // counted as discarded. Call with no read in progress.
+    void reformat(std::uint32_t capacityFrames,
+                  std::uint32_t guardFrames,
+                  std::uint64_t startCursor,
+                  std::uint32_t formatGeneration) noexcept
+    {
+        if (!isAttached() || evicted)
+        {
+            return;
+        }
+
+        if (startCursor > localRead)
+        {
+            const auto oldEnd = startCursor > capacity() ? startCursor - capacity() : 0;
+            framesDiscarded += oldEnd > localRead ? oldEnd - localRead : 0;
+            moveTo(startCursor);
+        }
+        mask = capacityFrames - 1;
+        guard = guardFrames < capacityFrames ? guardFrames : capacityFrames / 2;
+        cachedWrite = localRead;
+        if (ownsSlot())
+        {
+            slot->formatGeneration.store(formatGeneration, std::memory_order_release);
+        }
+    }
+
+    [[nodiscard]] std::uint64_t getFramesDiscarded() const noexcept
+    {
+        return framesDiscarded;
+    }
+
+    [[nodiscard]] std::uint64_t getFramesSkipped() const noexcept
+    {
+        return framesSkipped;
+    }
+
+    [[nodiscard]] std::uint64_t getFramesOverwritten() const noexcept
+    {
+        return framesOverwritten;
+    }
+
+    [[nodiscard]] std::uint64_t getRejoins() const noexcept
+    {
+        return rejoins;
+    }
+
+private:
+    // False (and the reader counts as evicted from then on) once the producer has freed
+    // the slot or someone else has claimed it since.
+    bool ownsSlot() noexcept
+    {
+        if (!evicted
+            && (slot->state.load(std::memory_order_acquire) == static_cast<std::uint32_t>(ReaderSlotState::Free)
+                || slot->epoch.load(std::memory_order_acquire) != epoch))
+        {
+            evicted = true;
+            cachedWrite = localRead;
+        }
+        return !evicted;
+    }
+
+    // The slot can still be reclaimed between ownsSlot() and the store, so the store is a
+    // compare-exchange from our last cursor: a new owner has positioned it elsewhere.
+    bool storeCursor(std::uint64_t position) noexcept
+    {
+        if (!ownsSlot())
+        {
+            return false;
+        }
+
+        auto expected = publishedRead;
+        if (!slot->cursor.compare_exchange_strong(expected, position, std::memory_order_release,
+                                                  std::memory_order_relaxed))
+        {
+            evicted = true;
+            cachedWrite = localRead;
+            return false;
+        }
+        publishedRead = position;
+        return true;
+    }
+
+    void moveTo(std::uint64_t position) noexcept
+    {
+        localRead = position;
+        storeCursor(localRead);
+    }
+
+    // Positions the cursor at the producer's, then goes active from `from` (Claiming on
+    // attach, Detached on a rejoin); if the slot is no longer in that state it was taken
+    // from us. The producer may scan in between: the first store gives it a cursor that
+    // is at worst a little old, and the fence (paired with the producer's) makes sure a
+    // scan that still missed us happened before the write cursor we reload, so we never
+    // start behind what the producer believes is free.
+    void joinAtHead(ReaderSlotState from) noexcept
+    {
+        if (!storeCursor(writeCursor->load(std::memory_order_acquire)))
+        {
+            return;
+        }
+
+        auto expected = static_cast<std::uint32_t>(from);
+        if (!slot->state.compare_exchange_strong(expected,
+                                                 static_cast<std::uint32_t>(ReaderSlotState::Active),
+                                                 std::memory_order_seq_cst))
+        {
+            evicted = true;
+            cachedWrite = localRead;
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cachedWrite = writeCursor->load(std::memory_order_acquire);
+        moveTo(cachedWrite);
+    }
+
+    std::atomic<std::uint64_t>* writeCursor = nullptr;
+    BroadcastReaderSlot* slot = nullptr;
+    std::uint32_t slotIndex = 0;
+    std::uint32_t mask = 0;
+    std::uint32_t guard = 0;
+    ReaderLagPolicy policy = ReaderLagPolicy::Stall;
+    std::uint64_t localRead = 0;
+    // The cursor value this reader last stored in the slot.
+    std::uint64_t publishedRead = 0;
+    std::uint64_t cachedWrite = 0;
+    std::uint64_t readStart = 0;
+    std::uint64_t framesSkipped = 0;
+    std::uint64_t framesOverwritten = 0;
+    std::uint64_t framesDiscarded = 0;
+    std::uint64_t rejoins = 0;
+    std::uint32_t epoch = 0;
+    bool evicted = false;
+};
+
+// Name of reader `slot`'s ready event: the base name for slot 0, "<base>_<slot>" after.
+template <typename String>
+[[nodiscard]] String readerEventName(String baseName, std::uint32_t slot)
+{
+    if (slot != 0)
+    {
+        baseName.push_back('_');
+        baseName.push_back(static_cast<typename String::value_type>('0' + slot));
+    }
+    return baseName;
+}
+} // namespace oceanaudio
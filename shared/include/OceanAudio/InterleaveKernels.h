@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX__) || defined(__AVX2__)
+    #define OCEANAUDIO_INTERLEAVE_AVX 1
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define OCEANAUDIO_INTERLEAVE_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+// Planar <-> interleaved float conversion for the bridge ring.
+//
+// The specialised kernels cover the layouts that actually occur (mono, stereo, and a
+// mono source duplicated into a stereo ring); everything else goes through the
+// generic strided path. Callers hand in one contiguous span at a time, i.e. the
+// request is split only where the ring wraps, never per sample. The vector width is
+// chosen at compile time: AVX builds (e.g. /arch:AVX2 or -mavx2) get 256-bit kernels,
+// x64 builds get SSE2, everything else the scalar loops.
+namespace oceanaudio::interleave
+{
+inline void copyMono(const float* source, float* destination, std::size_t frames) noexcept
+{
+    std::memcpy(destination, source, frames * sizeof(float));
+}
+
+inline void stereo(const float* left, const float* right, float* destination, std::size_t frames) noexcept
+{
+    std::size_t frame = 0;
+#if OCEANAUDIO_INTERLEAVE_AVX
+    for (; frame + 8 <= frames; frame += 8)
+    {
+        const __m256 l = _mm256_loadu_ps(left + frame);
+        const __m256 r = _mm256_loadu_ps(right + frame);
+        const __m256 low = _mm256_unpacklo_ps(l, r);
+        const __m256 high = _mm256_unpackhi_ps(l, r);
+        _mm256_storeu_ps(destination + 2 * frame, _mm256_permute2f128_ps(low, high, 0x20));
+        _mm256_storeu_ps(destination + 2 * frame + 8, _mm256_permute2f128_ps(low, high, 0x31));
+    }
+#elif OCEANAUDIO_INTERLEAVE_SSE2
+    for (; frame + 4 <= frames; frame += 4)
+    {
+        const __m128 l = _mm_loadu_ps(left + frame);
+        const __m128 r = _mm_loadu_ps(right + frame);
+        _mm_storeu_ps(destination + 2 * frame, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(destination + 2 * frame + 4, _mm_unpackhi_ps(l, r));
+    }
+#endif
+    for (; frame < frames; ++frame)
+    {
+        destination[2 * frame] = left[frame];
+        destination[2 * frame + 1] = right[frame];
+    }
+}
+
+inline void monoToStereo(const float* source, float* destination, std::size_t frames) noexcept
+{
+    std::size_t frame = 0;
+#if OCEANAUDIO_INTERLEAVE_AVX
+    for (; frame + 8 <= frames; frame += 8)
+    {
+        const __m256 s = _mm256_loadu_ps(source + frame);
+        const __m256 low = _mm256_unpacklo_ps(s, s);
+        const __m256 high = _mm256_unpackhi_ps(s, s);
+        _mm256_storeu_ps(destination + 2 * frame, _mm256_permute2f128_ps(low, high, 0x20));
+        _mm256_storeu_ps(destination + 2 * frame + 8, _mm256_permute2f128_ps(low, high, 0x31));
+    }
+#elif OCEANAUDIO_INTERLEAVE_SSE2
+    for (; frame + 4 <= frames; frame += 4)
+    {
+        const __m128 s = _mm_loadu_ps(source + frame);
+        _mm_storeu_ps(destination + 2 * frame, _mm_unpacklo_ps(s, s));
+        _mm_storeu_ps(destination + 2 * frame + 4, _mm_unpackhi_ps(s, s));
+    }
+#endif
+    for (; frame < frames; ++frame)
+    {
+        destination[2 * frame] = source[frame];
+        destination[2 * frame + 1] = source[frame];
+    }
+}
+
+// Destination channels beyond the source's repeat its last channel.
+inline void generic(const float* const* source,
+                    std::size_t sourceChannels,
+                    std::size_t sourceOffset,
+                    float* destination,
+                    std::size_t destinationChannels,
+                    std::size_t frames) noexcept
+{
+    for (std::size_t channel = 0; channel < destinationChannels; ++channel)
+    {
+        const float* input = source[channel < sourceChannels ? channel : sourceChannels - 1] + sourceOffset;
+        float* output = destination + channel;
+        for (std::size_t frame = 0; frame < frames; ++frame)
+        {
+            output[frame * destinationChannels] = input[frame];
+        }
+    }
+}
+
+// Writes `frames` frames starting at source[*][sourceOffset] into `destination`,
+// which holds `destinationChannels` interleaved channels.
+inline void fromPlanar(const float* const* source,
+                       std::size_t sourceChannels,
+                       std::size_t sourceOffset,
+                       float* destination,
+                       std::size_t destinationChannels,
+                       std::size_t frames) noexcept
+{
+    if (frames == 0 || sourceChannels == 0)
+    {
+        return;
+    }
+
+    if (destinationChannels == 1)
+    {
+        copyMono(source[0] + sourceOffset, destination, frames);
+    }
+    else if (destinationChannels == 2 && sourceChannels >= 2)
+    {
+        stereo(source[0] + sourceOffset, source[1] + sourceOffset, destination, frames);
+    }
+    else if (destinationChannels == 2)
+    {
+        monoToStereo(source[0] + sourceOffset, destination, frames);
+    }
+    else
+    {
+        generic(source, sourceChannels, sourceOffset, destination, destinationChannels, frames);
+    }
+}
+} // namespace oceanaudio::interleave
+
+namespace oceanaudio::deinterleave
+{
+inline void stereo(const float* source, float* left, float* right, std::size_t frames) noexcept
+{
+    std::size_t frame = 0;
+#if OCEANAUDIO_INTERLEAVE_AVX
+    for (; frame + 8 <= frames; frame += 8)
+    {
+        const __m256 a = _mm256_loadu_ps(source + 2 * frame);
+        const __m256 b = _mm256_loadu_ps(source + 2 * frame + 8);
+        const __m256 low = _mm256_permute2f128_ps(a, b, 0x20);
+        const __m256 high = _mm256_permute2f128_ps(a, b, 0x31);
+        _mm256_storeu_ps(left + frame, _mm256_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm256_storeu_ps(right + frame, _mm256_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#elif OCEANAUDIO_INTERLEAVE_SSE2
+    for (; frame + 4 <= frames; frame += 4)
+    {
+        const __m128 a = _mm_loadu_ps(source + 2 * frame);
+        const __m128 b = _mm_loadu_ps(source + 2 * frame + 4);
+        _mm_storeu_ps(left + frame, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + frame, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#endif
+    for (; frame < frames; ++frame)
+    {
+        left[frame] = source[2 * frame];
+        right[frame] = source[2 * frame + 1];
+    }
+}
+
+// Destination channels beyond the source's are left untouched.
+inline void generic(const float* source,
+                    std::size_t sourceChannels,
+                    float* const* destination,
+                    std::size_t destinationChannels,
+                    std::size_t destinationOffset,
+                    std::size_t frames) noexcept
+{
+    const auto channels = destinationChannels < sourceChannels ? destinationChannels : sourceChannels;
+    for (std::size_t channel = 0; channel < channels; ++channel)
+    {
+        const float* input = source + channel;
+        float* output = destination[channel] + destinationOffset;
+        for (std::size_t frame = 0; frame < frames; ++frame)
+        {
+            output[frame] = input[frame * sourceChannels];
+        }
+    }
+}
+
+// Inverse of interleave::fromPlanar: splits `frames` interleaved frames into
+// destination[*][destinationOffset...].
+inline void toPlanar(const float* source,
+                     std::size_t sourceChannels,
+                     float* const* destination,
+                     std::size_t destinationChannels,
+                     std::size_t destinationOffset,
+                     std::size_t frames) noexcept
+{
+    if (frames == 0 || sourceChannels == 0 || destinationChannels == 0)
+    {
+        return;
+    }
+
+    if (sourceChannels == 1)
+    {
+        std::memcpy(destination[0] + destinationOffset, source, frames * sizeof(float));
+    }
+    else if (sourceChannels == 2 && destinationChannels >= 2)
+    {
+        stereo(source, destination[0] + destinationOffset, destination[1] + destinationOffset, frames);
+    }
+    else
+    {
+        generic(source, sourceChannels, destination, destinationChannels, destinationOffset, frames);
+    }
+}
+} // namespace oceanaudio::deinterleave
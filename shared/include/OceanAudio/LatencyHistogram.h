@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+namespace oceanaudio
+{
+// Log-linear histogram of microsecond values in the spirit of HdrHistogram, laid out
+// as plain atomics so it can live in shared memory. Values below 32 us get a bucket
+// each; above that every power of two is split into 16 buckets, so any recorded value
+// is reported within 1/16 (6.25%) of its true size. Values past ~9.5 hours land in the
+// last bucket.
+//
+// There is a single writer (record() uses load + store, not read-modify-write);
+// readers on either side of the mapping may take percentiles at any time and see a
+// slightly stale but never torn count per bucket. Counts are cumulative since the
+// mapping was created; diff two snapshots for a window.
+struct SharedLatencyHistogram
+{
+    static constexpr std::uint32_t kLinearBuckets = 32;
+    static constexpr std::uint32_t kSubBucketsPerOctave = 16;
+    static constexpr std::uint32_t kFirstLogExponent = 5; // log2(kLinearBuckets)
+    static constexpr std::uint32_t kLastExponent = 35;
+    static constexpr std::uint32_t kBucketCount
+        = kLinearBuckets + (kLastExponent - kFirstLogExponent + 1) * kSubBucketsPerOctave;
+
+    std::atomic<std::uint64_t> totalCount {0};
+    std::atomic<std::uint64_t> maxValueUs {0};
+    std::atomic<std::uint64_t> counts[kBucketCount] {};
+
+    static constexpr std::uint32_t bucketIndex(std::uint64_t valueUs) noexcept
+    {
+        if (valueUs < kLinearBuckets)
+        {
+            return static_cast<std::uint32_t>(valueUs);
+        }
+
+        auto exponent = static_cast<std::uint32_t>(std::bit_width(valueUs)) - 1;
+        if (exponent > kLastExponent)
+        {
+            return kBucketCount - 1;
+        }
+
+        // The top five bits of the value: 1 followed by the sub-bucket.
+        const auto mantissa = static_cast<std::uint32_t>(valueUs >> (exponent - 4));
+        return kLinearBuckets + (exponent - kFirstLogExponent) * kSubBucketsPerOctave
+               + (mantissa - kSubBucketsPerOctave);
+    }
+
+    // Smallest value that lands in `index`.
+    static constexpr std::uint64_t bucketLowerBound(std::uint32_t index) noexcept
+    {
+        if (index < kLinearBuckets)
+        {
+            return index;
+        }
+
+        const auto exponent = (index - kLinearBuckets) / kSubBucketsPerOctave + kFirstLogExponent;
+        const auto mantissa = (index - kLinearBuckets) % kSubBucketsPerOctave + kSubBucketsPerOctave;
+        return static_cast<std::uint64_t>(mantissa) << (exponent - 4);
+    }
+
+    void record(std::uint64_t valueUs) noexcept
+    {
+        auto& bucket = counts[bucketIndex(valueUs)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        totalCount.store(totalCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (valueUs > maxValueUs.load(std::memory_order_relaxed))
+        {
+            maxValueUs.store(valueUs, std::memory_order_relaxed);
+        }
+    }
+
+    // Value at `quantile` (0..1), reported as the middle of its bucket; 0 when empty.
+    [[nodiscard]] std::uint64_t percentileUs(double quantile) const noexcept
+    {
+        std::uint64_t total = 0;
+        for (const auto& count : counts)
+        {
+            total += count.load(std::memory_order_relaxed);
+        }
+        if (total == 0)
+        {
+            return 0;
+        }
+
+        const auto rank = static_cast<std::uint64_t>(quantile * static_cast<double>(total - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::uint32_t index = 0; index < kBucketCount; ++index)
+        {
+            seen += counts[index].load(std::memory_order_relaxed);
+            if (seen >= rank)
+            {
+                const auto lower = bucketLowerBound(index);
+                const auto upper = index + 1 < kBucketCount ? bucketLowerBound(index + 1) : lower + 1;
+                return lower + (upper - lower) / 2;
+            }
+        }
+        return maxValueUs.load(std::memory_order_relaxed);
+    }
+};
+
+static_assert(SharedLatencyHistogram::bucketIndex(31) == 31);
+static_assert(SharedLatencyHistogram::bucketIndex(32) == 32);
+static_assert(SharedLatencyHistogram::bucketIndex(63) == 47);
+static_assert(SharedLatencyHistogram::bucketLowerBound(SharedLatencyHistogram::bucketIndex(1000)) <= 1000);
+static_assert(SharedLatencyHistogram::bucketIndex(~std::uint64_t {0}) == SharedLatencyHistogram::kBucketCount - 1);
+} // namespace oceanaudio
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/resource.h>
+    #include <unistd.h>
+#endif
+
+// Keeps the bridge mapping resident so the audio thread never takes a page fault on it.
+// A fresh mapping is only backed page by page as it is first touched, so without this
+// the first pass through the ring after the device starts faults on every page, and
+// under memory pressure the OS may page it out again later. The helpers run on the
+// control thread before the first callback; threadPageFaults() is what the audio
+// thread uses to check they did their job.
+namespace oceanaudio
+{
+struct MappingResidencyOptions
+{
+    // Touch every page once up front.
+    bool prefault = true;
+    // Pin the pages (mlock / VirtualLock). Fails quietly if the memlock limit or the
+    // working-set quota is too small; the pages are still prefaulted.
+    bool lock = true;
+    // Back the mapping with huge pages where the OS allows it: transparent huge pages
+    // for the shared-memory object on Linux, a large-page section on Windows (which
+    // needs SeLockMemoryPrivilege). Everywhere else this is a no-op.
+    bool hugePages = false;
+};
+
+// What was actually applied; each flag can be false even though it was asked for.
+struct MappingResidency
+{
+    bool prefaulted = false;
+    bool locked = false;
+    bool hugePages = false;
+};
+
+[[nodiscard]] inline std::size_t systemPageSize() noexcept
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info {};
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    const auto size = ::sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<std::size_t>(size) : 4096;
+#endif
+}
+
+// Size (and alignment) a mapping needs for huge pages to back it; 0 when the platform
+// has none.
+[[nodiscard]] inline std::size_t hugePageSize() noexcept
+{
+#if defined(_WIN32)
+    return GetLargePageMinimum();
+#elif defined(__linux__)
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+    std::size_t size = 0;
+    return file >> size ? size : 0;
+#else
+    return 0;
+#endif
+}
+
+[[nodiscard]] inline std::size_t roundUpToMultiple(std::size_t bytes, std::size_t granularity) noexcept
+{
+    return granularity == 0 ? bytes : (bytes + granularity - 1) / granularity * granularity;
+}
+
+// Write-faults every page without changing its contents. Readers in other processes
+// may already be using the mapping (a producer taking over a live one), and header
+// words are updated atomically from both sides, so each touch is an atomic add of
+// zero rather than a plain store.
+inline void touchPages(void* address, std::size_t bytes) noexcept
+{
+    auto* base = static_cast<std::byte*>(address);
+    const auto pageSize = systemPageSize();
+    for (std::size_t offset = 0; offset < bytes; offset += pageSize)
+    {
+        std::atomic_ref<std::uint32_t>(*reinterpret_cast<std::uint32_t*>(base + offset))
+            .fetch_add(0, std::memory_order_relaxed);
+    }
+}
+
+inline bool lockPages(void* address, std::size_t bytes) noexcept
+{
+#if defined(_WIN32)
+    // VirtualLock is capped by the minimum working set, so grow it by what we lock.
+    SIZE_T minimum = 0;
+    SIZE_T maximum = 0;
+    if (GetProcessWorkingSetSize(GetCurrentProcess(), &minimum, &maximum))
+    {
+        SetProcessWorkingSetSize(GetCurrentProcess(), minimum + bytes, maximum > minimum + bytes ? maximum : minimum + bytes);
+    }
+    return VirtualLock(address, bytes) != FALSE;
+#else
+    return ::mlock(address, bytes) == 0;
+#endif
+}
+
+inline void unlockPages(void* address, std::size_t bytes) noexcept
+{
+#if defined(_WIN32)
+    VirtualUnlock(address, bytes);
+#else
+    ::munlock(address, bytes);
+#endif
+}
+
+// Linux only: asks for transparent huge pages on a shared mapping. Only takes effect
+// for pages not faulted in yet, on a range aligned to hugePageSize(), and when the
+// administrator allows it for shared memory (transparent_hugepage/shmem_enabled set
+// to "advise" or "always").
+inline bool adviseHugePages(void* address, std::size_t bytes) noexcept
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    return ::madvise(address, bytes, MADV_HUGEPAGE) == 0;
+#else
+    (void) address;
+    (void) bytes;
+    return false;
+#endif
+}
+
+#if defined(_WIN32)
+// Large-page sections need SeLockMemoryPrivilege enabled in the process token. The
+// account has to hold it ("Lock pages in memory"); this only switches it on.
+inline bool enableLockMemoryPrivilege() noexcept
+{
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+    {
+        return false;
+    }
+
+    TOKEN_PRIVILEGES privileges {};
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    const bool enabled = LookupPrivilegeValueW(nullptr, L"SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)
+                         && AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+                         && GetLastError() == ERROR_SUCCESS;
+    CloseHandle(token);
+    return enabled;
+}
+#endif
+
+// Applies `options` to a mapping the caller has just mapped. Huge-page advice goes
+// first since it only affects pages that are not resident yet.
+inline MappingResidency makeResident(void* address, std::size_t bytes, const MappingResidencyOptions& options) noexcept
+{
+    MappingResidency residency;
+    if (address == nullptr || bytes == 0)
+    {
+        return residency;
+    }
+
+    if (options.hugePages)
+    {
+        residency.hugePages = adviseHugePages(address, bytes);
+    }
+    if (options.prefault)
+    {
+        touchPages(address, bytes);
+        residency.prefaulted = true;
+    }
+    if (options.lock)
+    {
+        residency.locked = lockPages(address, bytes);
+    }
+    return residency;
+}
+
+// Page faults (minor and major) taken so far: by the calling thread on Linux, by the
+// whole process elsewhere. A system call, so only sample it for a bounded number of
+// audio callbacks.
+[[nodiscard]] inline std::uint64_t threadPageFaults() noexcept
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters {};
+    counters.cb = sizeof(counters);
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PageFaultCount : 0;
+#else
+    #if defined(RUSAGE_THREAD)
+    constexpr int kWho = RUSAGE_THREAD;
+    #else
+    constexpr int kWho = RUSAGE_SELF;
+    #endif
+    struct rusage usage {};
+    if (::getrusage(kWho, &usage) != 0)
+    {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(usage.ru_minflt) + static_cast<std::uint64_t>(usage.ru_majflt);
+#endif
+}
+} // namespace oceanaudio
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace oceanaudio
+{
+// Timestamps exchanged through the header. steady_clock is system-wide on the
+// supported platforms (QueryPerformanceCounter on Windows, CLOCK_MONOTONIC elsewhere),
+// so both processes read the same clock.
+inline std::uint64_t sharedClockNanoseconds() noexcept
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count());
+}
+
+// How long a peer may go without a heartbeat before the other side treats it as gone.
+// Both sides beat at least every few tens of milliseconds while alive, quiet or not.
+inline constexpr std::uint32_t kDefaultPeerTimeoutMs = 500;
+
+// A peer's sign of life in the mapping: a counter it bumps and the shared-clock time
+// of the last bump. Several threads of the same peer may beat; the counter never goes
+// backwards and a timestamp that does by a few microseconds is harmless.
+struct PeerHeartbeat
+{
+    std::atomic<std::uint64_t> beats {0};
+    std::atomic<std::uint64_t> lastBeatNs {0};
+
+    void beat(std::uint64_t nowNs) noexcept
+    {
+        lastBeatNs.store(nowNs, std::memory_order_relaxed);
+        beats.fetch_add(1, std::memory_order_release);
+    }
+
+    [[nodiscard]] std::uint64_t getBeats() const noexcept
+    {
+        return beats.load(std::memory_order_acquire);
+    }
+
+    // False for a peer that never beat, so a mapping left by a crashed peer and one
+    // whose peer has not started yet look the same; check getBeats() to tell them apart.
+    [[nodiscard]] bool isAlive(std::uint64_t nowNs, std::uint64_t timeoutNs) const noexcept
+    {
+        const auto last = lastBeatNs.load(std::memory_order_relaxed);
+        return last != 0 && (last >= nowNs || nowNs - last <= timeoutNs);
+    }
+};
+
+static_assert(sizeof(PeerHeartbeat) == 16);
+} // namespace oceanaudio
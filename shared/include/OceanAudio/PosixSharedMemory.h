@@ -0,0 +1,446 @@
+#pragma once
+
+#if !defined(_WIN32)
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+    #include <linux/futex.h>
+    #include <poll.h>
+    #include <sys/eventfd.h>
+    #include <sys/syscall.h>
+    #include <time.h>
+#endif
+
+// POSIX counterparts of the Win32 objects the bridge uses: a named file mapping
+// (shm_open + mmap) and a named auto-reset event. Object names follow the Win32
+// ones with the "Global\" prefix replaced by "/". On Linux both also come in an
+// anonymous form (memfd, eventfd) that is handed over as descriptors instead of
+// opened by name; see UnixSocketTransport.h.
+namespace oceanaudio::posix
+{
+inline constexpr char kMappingName[] = "/OceanAudio_AudioRing";
+inline constexpr char kAudioReadyEventName[] = "/OceanAudio_AudioReady";
+inline constexpr char kAudioConsumedEventName[] = "/OceanAudio_AudioConsumed";
+
+// Maps a Win32 object name such as L"Global\\OceanAudio_AudioRing" onto its POSIX
+// shared-memory name. Only ASCII names are supported.
+inline std::string toObjectName(const std::wstring& win32Name)
+{
+    constexpr wchar_t kGlobalPrefix[] = L"Global\\";
+    auto name = win32Name;
+    if (name.rfind(kGlobalPrefix, 0) == 0)
+    {
+        name.erase(0, sizeof(kGlobalPrefix) / sizeof(wchar_t) - 1);
+    }
+
+    std::string result = "/";
+    for (const auto character : name)
+    {
+        result.push_back(character == L'\\' || character == L'/' ? '_' : static_cast<char>(character));
+    }
+    return result;
+}
+
+class SharedMapping
+{
+public:
+    SharedMapping() = default;
+    ~SharedMapping() { close(); }
+
+    SharedMapping(const SharedMapping&) = delete;
+    SharedMapping& operator=(const SharedMapping&) = delete;
+
+    // Creates (or resizes) the named object and maps it read/write. `newlyCreated` is
+    // false when another process already owned an object of that name. A non-zero
+    // `alignment` (a power of two) places the view on that boundary, which transparent
+    // huge pages need (see MappingResidency.h).
+    bool create(const std::string& objectName, std::size_t bytes, bool& newlyCreated, std::size_t alignment = 0)
+    {
+        close();
+
+        int fd = ::shm_open(objectName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+        newlyCreated = fd >= 0;
+        if (fd < 0 && errno == EEXIST)
+        {
+            fd = ::shm_open(objectName.c_str(), O_RDWR, 0660);
+        }
+
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info {};
+        const bool sizeOk = ::fstat(fd, &info) == 0
+                            && (static_cast<std::size_t>(info.st_size) == bytes
+                                || ::ftruncate(fd, static_cast<off_t>(bytes)) == 0);
+        if (!sizeOk)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        name = objectName;
+        owner = true;
+        return mapDescriptor(fd, bytes, alignment);
+    }
+
+    // Maps an existing object at whatever size its creator gave it.
+    bool open(const std::string& objectName)
+    {
+        close();
+
+        const int fd = ::shm_open(objectName.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        name = objectName;
+        owner = false;
+        return mapDescriptor(fd, static_cast<std::size_t>(info.st_size), 0);
+    }
+
+    // Maps an object someone else opened and handed over as a descriptor, the way a
+    // driver maps the section handle it receives; the caller keeps its descriptor.
+    bool openFromDescriptor(int descriptor)
+    {
+        close();
+
+        struct stat info {};
+        if (descriptor < 0 || ::fstat(descriptor, &info) != 0 || info.st_size <= 0)
+        {
+            return false;
+        }
+
+        const int fd = ::dup(descriptor);
+        if (fd < 0)
+        {
+            return false;
+        }
+        return mapDescriptor(fd, static_cast<std::size_t>(info.st_size), 0);
+    }
+
+    // A descriptor for handing the named object to another component; close it once
+    // that has mapped it.
+    static int openDescriptor(const std::string& objectName) noexcept
+    {
+        return ::shm_open(objectName.c_str(), O_RDWR, 0);
+    }
+
+#if defined(__linux__)
+    // Creates an object without a name (memfd) and maps it read/write. Peers map it
+    // from descriptor(), which only the creator can hand out, and it goes away with the
+    // last descriptor and view: nothing is left in /dev/shm if the creator crashes.
+    bool createAnonymous(const char* debugName, std::size_t bytes, std::size_t alignment = 0)
+    {
+        close();
+
+        const int fd = ::memfd_create(debugName, MFD_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        anonymousDescriptor = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (anonymousDescriptor < 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        if (!mapDescriptor(fd, bytes, alignment))
+        {
+            ::close(anonymousDescriptor);
+            anonymousDescriptor = -1;
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    // The object behind an anonymous mapping, valid until close(); -1 for named ones,
+    // which peers open by name instead.
+    [[nodiscard]] int descriptor() const noexcept { return anonymousDescriptor; }
+
+    void close() noexcept
+    {
+        if (address != nullptr)
+        {
+            ::munmap(address, size);
+            address = nullptr;
+        }
+
+        if (anonymousDescriptor >= 0)
+        {
+            ::close(anonymousDescriptor);
+            anonymousDescriptor = -1;
+        }
+
+        if (owner && !name.empty())
+        {
+            // Like the last CloseHandle on a Win32 mapping: peers keep their view, but
+            // the name is free for the next creator.
+            ::shm_unlink(name.c_str());
+        }
+
+        name.clear();
+        owner = false;
+        size = 0;
+    }
+
+    [[nodiscard]] void* data() const noexcept { return address; }
+    [[nodiscard]] std::size_t sizeInBytes() const noexcept { return size; }
+    [[nodiscard]] bool isMapped() const noexcept { return address != nullptr; }
+
+private:
+    bool mapDescriptor(int fd, std::size_t bytes, std::size_t alignment)
+    {
+        void* mapped = alignment > 0 ? mapAligned(fd, bytes, alignment)
+                                     : ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            name.clear();
+            owner = false;
+            return false;
+        }
+
+        address = mapped;
+        size = bytes;
+        return true;
+    }
+
+    // Reserves enough address space to find an aligned start, maps the object over it
+    // and hands the slack on either side back.
+    static void* mapAligned(int fd, std::size_t bytes, std::size_t alignment)
+    {
+        const std::size_t reservedBytes = bytes + alignment;
+        void* reserved = ::mmap(nullptr, reservedBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved == MAP_FAILED)
+        {
+            return MAP_FAILED;
+        }
+
+        const auto base = reinterpret_cast<std::uintptr_t>(reserved);
+        const auto aligned = (base + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+        void* mapped = ::mmap(reinterpret_cast<void*>(aligned), bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            ::munmap(reserved, reservedBytes);
+            return MAP_FAILED;
+        }
+
+        if (aligned > base)
+        {
+            ::munmap(reserved, aligned - base);
+        }
+        const auto end = aligned + bytes;
+        if (end < base + reservedBytes)
+        {
+            ::munmap(reinterpret_cast<void*>(end), base + reservedBytes - end);
+        }
+        return mapped;
+    }
+
+    std::string name;
+    void* address = nullptr;
+    std::size_t size = 0;
+    bool owner = false;
+    int anonymousDescriptor = -1;
+};
+
+// Auto-reset event shared between processes: one futex word in its own small mapping.
+// set() is cheap when nobody waits (a store and, on Linux, one FUTEX_WAKE syscall).
+// Platforms without futexes fall back to sleeping in short slices. On Linux the event
+// can be an eventfd instead, for peers that receive it as a descriptor.
+class NamedEvent
+{
+public:
+    NamedEvent() = default;
+    ~NamedEvent() { close(); }
+
+    NamedEvent(const NamedEvent&) = delete;
+    NamedEvent& operator=(const NamedEvent&) = delete;
+
+    bool create(const std::string& objectName, bool initiallySignalled)
+    {
+        bool newlyCreated = false;
+        if (!mapping.create(objectName, sizeof(State), newlyCreated))
+        {
+            return false;
+        }
+
+        state()->signalled.store(initiallySignalled ? 1u : 0u, std::memory_order_release);
+        return true;
+    }
+
+    bool open(const std::string& objectName)
+    {
+        return mapping.open(objectName) && mapping.sizeInBytes() >= sizeof(State);
+    }
+
+#if defined(__linux__)
+    // An unnamed event; hand descriptor() to the peer, which adopts its copy.
+    bool createDescriptor(bool initiallySignalled)
+    {
+        close();
+        eventDescriptor = ::eventfd(initiallySignalled ? 1u : 0u, EFD_CLOEXEC | EFD_NONBLOCK);
+        return eventDescriptor >= 0;
+    }
+
+    // Takes ownership of an eventfd received from the creator.
+    bool adoptDescriptor(int descriptor)
+    {
+        close();
+        eventDescriptor = descriptor;
+        return eventDescriptor >= 0;
+    }
+#endif
+
+    // The eventfd behind an unnamed event, or -1.
+    [[nodiscard]] int descriptor() const noexcept { return eventDescriptor; }
+
+    void close() noexcept
+    {
+        mapping.close();
+        if (eventDescriptor >= 0)
+        {
+            ::close(eventDescriptor);
+            eventDescriptor = -1;
+        }
+    }
+
+    [[nodiscard]] bool isOpen() const noexcept
+    {
+        return mapping.isMapped() || eventDescriptor >= 0;
+    }
+
+    void set() noexcept
+    {
+#if defined(__linux__)
+        if (eventDescriptor >= 0)
+        {
+            // A full counter still reads as signalled, so a failed add loses nothing.
+            const std::uint64_t increment = 1;
+            [[maybe_unused]] const auto written = ::write(eventDescriptor, &increment, sizeof(increment));
+            return;
+        }
+#endif
+
+        auto* word = &state()->signalled;
+        if (word->exchange(1u, std::memory_order_release) == 0u)
+        {
+#if defined(__linux__)
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#endif
+        }
+    }
+
+    // Returns true if the event was (or became) signalled within the timeout, and
+    // resets it in that case.
+    bool wait(std::uint32_t timeoutMs) noexcept
+    {
+#if defined(__linux__)
+        if (eventDescriptor >= 0)
+        {
+            return waitDescriptor(timeoutMs);
+        }
+#endif
+
+        auto* word = &state()->signalled;
+        if (word->exchange(0u, std::memory_order_acquire) == 1u)
+        {
+            return true;
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        for (;;)
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+            {
+                return word->exchange(0u, std::memory_order_acquire) == 1u;
+            }
+
+#if defined(__linux__)
+            const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+            timespec timeout {};
+            timeout.tv_sec = static_cast<time_t>(remaining / 1'000'000'000);
+            timeout.tv_nsec = static_cast<long>(remaining % 1'000'000'000);
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), FUTEX_WAIT, 0u, &timeout, nullptr, 0);
+#else
+            std::this_thread::sleep_for(std::chrono::microseconds(250));
+#endif
+
+            if (word->exchange(0u, std::memory_order_acquire) == 1u)
+            {
+                return true;
+            }
+        }
+    }
+
+private:
+    struct State
+    {
+        std::atomic<std::uint32_t> signalled;
+    };
+
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+                  "futex word must be a plain 32-bit integer");
+
+    State* state() const noexcept
+    {
+        return static_cast<State*>(mapping.data());
+    }
+
+#if defined(__linux__)
+    // Reading an eventfd returns its count and zeroes it, which is the auto-reset.
+    bool waitDescriptor(std::uint32_t timeoutMs) noexcept
+    {
+        std::uint64_t count = 0;
+        if (::read(eventDescriptor, &count, sizeof(count)) == sizeof(count))
+        {
+            return true;
+        }
+
+        pollfd descriptorPoll {eventDescriptor, POLLIN, 0};
+        if (::poll(&descriptorPoll, 1, static_cast<int>(timeoutMs)) <= 0)
+        {
+            return false;
+        }
+        return ::read(eventDescriptor, &count, sizeof(count)) == sizeof(count);
+    }
+#endif
+
+    SharedMapping mapping;
+    int eventDescriptor = -1;
+};
+} // namespace oceanaudio::posix
+
+#endif
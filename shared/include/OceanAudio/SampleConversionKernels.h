@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+    #define OCEANAUDIO_CONVERT_AVX2 1
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define OCEANAUDIO_CONVERT_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+// Float to integer sample conversion for bridge format views.
+//
+// Samples are scaled, optionally dithered, clamped and rounded to nearest in the
+// vector unit; Int16 is then packed with a saturating pack, Int24 is written three
+// bytes at a time from the converted 32-bit lanes. The dither is TPDF (the sum of two
+// uniform variables, spanning +/-1 LSB), generated in the same registers from one
+// xorshift32 stream per lane, so dithering does not leave the vector loop. Builds with
+// AVX2 get 8-lane kernels, x64 builds SSE2, everything else the scalar loops below,
+// which also handle the tails.
+namespace oceanaudio::convert
+{
+inline constexpr float kInt16Scale = 32767.0f;
+inline constexpr float kInt24Scale = 8388607.0f;
+
+// Per-lane generator state; keep one per stream so the dither does not repeat when a
+// block is split.
+struct DitherState
+{
+    alignas(32) std::uint32_t lanes[8];
+
+    explicit DitherState(std::uint32_t seed = 0x2545F491u) noexcept
+    {
+        for (auto& lane : lanes)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            lane = seed | 1u; // xorshift must never hold zero
+        }
+    }
+};
+
+namespace scalar
+{
+inline std::uint32_t nextRandom(std::uint32_t& state) noexcept
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Triangular value in (-1, 1) from the two 16-bit halves of one random word.
+inline float triangular(std::uint32_t random) noexcept
+{
+    return (static_cast<float>(random & 0xFFFFu) - static_cast<float>(random >> 16)) * (1.0f / 65536.0f);
+}
+
+inline std::int32_t quantise(float sample, float scale, float dither) noexcept
+{
+    float value = sample * scale + dither;
+    value = value < -scale - 1.0f ? -scale - 1.0f : (value > scale ? scale : value);
+    return static_cast<std::int32_t>(std::lrintf(value));
+}
+
+inline void toInt16(const float* source, std::int16_t* destination, std::size_t samples, DitherState* dither) noexcept
+{
+    for (std::size_t i = 0; i < samples; ++i)
+    {
+        const float noise = dither != nullptr ? triangular(nextRandom(dither->lanes[0])) : 0.0f;
+        destination[i] = static_cast<std::int16_t>(quantise(source[i], kInt16Scale, noise));
+    }
+}
+
+inline void storeInt24(std::int32_t value, std::uint8_t* destination) noexcept
+{
+    destination[0] = static_cast<std::uint8_t>(value);
+    destination[1] = static_cast<std::uint8_t>(value >> 8);
+    destination[2] = static_cast<std::uint8_t>(value >> 16);
+}
+
+inline void toInt24(const float* source, std::uint8_t* destination, std::size_t samples, DitherState* dither) noexcept
+{
+    for (std::size_t i = 0; i < samples; ++i)
+    {
+        const float noise = dither != nullptr ? triangular(nextRandom(dither->lanes[0])) : 0.0f;
+        storeInt24(quantise(source[i], kInt24Scale, noise), destination + 3 * i);
+    }
+}
+} // namespace scalar
+
+namespace detail
+{
+#if OCEANAUDIO_CONVERT_AVX2
+inline __m256 triangular8(__m256i& state) noexcept
+{
+    state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 13));
+    state = _mm256_xor_si256(state, _mm256_srli_epi32(state, 17));
+    state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 5));
+    const __m256 low = _mm256_cvtepi32_ps(_mm256_and_si256(state, _mm256_set1_epi32(0xFFFF)));
+    const __m256 high = _mm256_cvtepi32_ps(_mm256_srli_epi32(state, 16));
+    return _mm256_mul_ps(_mm256_sub_ps(low, high), _mm256_set1_ps(1.0f / 65536.0f));
+}
+
+inline __m256i quantise8(const float* source, float scale, __m256i* state) noexcept
+{
+    __m256 value = _mm256_mul_ps(_mm256_loadu_ps(source), _mm256_set1_ps(scale));
+    if (state != nullptr)
+    {
+        value = _mm256_add_ps(value, triangular8(*state));
+    }
+    value = _mm256_max_ps(_mm256_min_ps(value, _mm256_set1_ps(scale)), _mm256_set1_ps(-scale - 1.0f));
+    return _mm256_cvtps_epi32(value);
+}
+#elif OCEANAUDIO_CONVERT_SSE2
+inline __m128 triangular4(__m128i& state) noexcept
+{
+    state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+    state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+    state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+    const __m128 low = _mm_cvtepi32_ps(_mm_and_si128(state, _mm_set1_epi32(0xFFFF)));
+    const __m128 high = _mm_cvtepi32_ps(_mm_srli_epi32(state, 16));
+    return _mm_mul_ps(_mm_sub_ps(low, high), _mm_set1_ps(1.0f / 65536.0f));
+}
+
+inline __m128i quantise4(const float* source, float scale, __m128i* state) noexcept
+{
+    __m128 value = _mm_mul_ps(_mm_loadu_ps(source), _mm_set1_ps(scale));
+    if (state != nullptr)
+    {
+        value = _mm_add_ps(value, triangular4(*state));
+    }
+    value = _mm_max_ps(_mm_min_ps(value, _mm_set1_ps(scale)), _mm_set1_ps(-scale - 1.0f));
+    return _mm_cvtps_epi32(value);
+}
+#endif
+} // namespace detail
+
+// `dither` may be null for plain rounding (e.g. when the source is already quantised).
+inline void toInt16(const float* source, std::int16_t* destination, std::size_t samples, DitherState* dither) noexcept
+{
+    std::size_t i = 0;
+#if OCEANAUDIO_CONVERT_AVX2
+    __m256i state = dither != nullptr ? _mm256_load_si256(reinterpret_cast<const __m256i*>(dither->lanes))
+                                      : _mm256_setzero_si256();
+    auto* lanes = dither != nullptr ? &state : nullptr;
+    for (; i + 8 <= samples; i += 8)
+    {
+        const __m256i value = detail::quantise8(source + i, kInt16Scale, lanes);
+        const __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), packed);
+    }
+    if (dither != nullptr)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dither->lanes), state);
+    }
+#elif OCEANAUDIO_CONVERT_SSE2
+    __m128i state = dither != nullptr ? _mm_load_si128(reinterpret_cast<const __m128i*>(dither->lanes))
+                                      : _mm_setzero_si128();
+    auto* lanes = dither != nullptr ? &state : nullptr;
+    for (; i + 8 <= samples; i += 8)
+    {
+        const __m128i low = detail::quantise4(source + i, kInt16Scale, lanes);
+        const __m128i high = detail::quantise4(source + i + 4, kInt16Scale, lanes);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_packs_epi32(low, high));
+    }
+    if (dither != nullptr)
+    {
+        _mm_store_si128(reinterpret_cast<__m128i*>(dither->lanes), state);
+    }
+#endif
+    scalar::toInt16(source + i, destination + i, samples - i, dither);
+}
+
+inline void toInt24(const float* source, std::uint8_t* destination, std::size_t samples, DitherState* dither) noexcept
+{
+    std::size_t i = 0;
+#if OCEANAUDIO_CONVERT_AVX2 || OCEANAUDIO_CONVERT_SSE2
+    alignas(32) std::int32_t converted[8];
+#endif
+#if OCEANAUDIO_CONVERT_AVX2
+    __m256i state = dither != nullptr ? _mm256_load_si256(reinterpret_cast<const __m256i*>(dither->lanes))
+                                      : _mm256_setzero_si256();
+    auto* lanes = dither != nullptr ? &state : nullptr;
+    for (; i + 8 <= samples; i += 8)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(converted), detail::quantise8(source + i, kInt24Scale, lanes));
+        for (std::size_t lane = 0; lane < 8; ++lane)
+        {
+            scalar::storeInt24(converted[lane], destination + 3 * (i + lane));
+        }
+    }
+    if (dither != nullptr)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dither->lanes), state);
+    }
+#elif OCEANAUDIO_CONVERT_SSE2
+    __m128i state = dither != nullptr ? _mm_load_si128(reinterpret_cast<const __m128i*>(dither->lanes))
+                                      : _mm_setzero_si128();
+    auto* lanes = dither != nullptr ? &state : nullptr;
+    for (; i + 8 <= samples; i += 8)
+    {
+        _mm_store_si128(reinterpret_cast<__m128i*>(converted), detail::quantise4(source + i, kInt24Scale, lanes));
+        _mm_store_si128(reinterpret_cast<__m128i*>(converted + 4),
+                        detail::quantise4(source + i + 4, kInt24Scale, lanes));
+        for (std::size_t lane = 0; lane < 8; ++lane)
+        {
+            scalar::storeInt24(converted[lane], destination + 3 * (i + lane));
+        }
+    }
+    if (dither != nullptr)
+    {
+        _mm_store_si128(reinterpret_cast<__m128i*>(dither->lanes), state);
+    }
+#endif
+    scalar::toInt24(source + i, destination + i * 3, samples - i, dither);
+}
+} // namespace oceanaudio::convert
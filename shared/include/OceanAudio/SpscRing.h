@@ -0,0 +1,230 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace oceanaudio
+{
+inline constexpr std::size_t kCacheLineSize = 64;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "Ring cursors live in shared memory and must be lock-free");
+
+// A contiguous run of frames inside the ring payload, in frames from the payload start.
+struct SpscRingSpan
+{
+    std::uint32_t offset = 0;
+    std::uint32_t frames = 0;
+};
+
+// Any request against the ring wraps at most once, so it maps onto at most two spans.
+struct SpscRingRegions
+{
+    SpscRingSpan first;
+    SpscRingSpan second;
+
+    [[nodiscard]] std::uint32_t totalFrames() const noexcept
+    {
+        return first.frames + second.frames;
+    }
+};
+
+[[nodiscard]] constexpr bool isValidRingCapacity(std::uint32_t frames) noexcept
+{
+    return frames != 0 && (frames & (frames - 1)) == 0;
+}
+
+namespace detail
+{
+[[nodiscard]] inline SpscRingRegions makeRingRegions(std::uint64_t cursor,
+                                                     std::uint32_t frames,
+                                                     std::uint32_t mask) noexcept
+{
+    const auto offset = static_cast<std::uint32_t>(cursor) & mask;
+    const auto framesUntilWrap = (mask - offset) + 1;
+
+    SpscRingRegions regions;
+    regions.first.offset = offset;
+    regions.first.frames = frames < framesUntilWrap ? frames : framesUntilWrap;
+    regions.second.offset = 0;
+    regions.second.frames = frames - regions.first.frames;
+    return regions;
+}
+} // namespace detail
+
+// Producer half of a wait-free single-producer/single-consumer ring.
+//
+// Both cursors are free-running 64-bit frame counts that never wrap in practice; the
+// fill level is writeCursor - readCursor, so there is no counter that both sides
+// modify. Positions inside the payload are cursor & (capacity - 1), which is why the
+// capacity has to be a power of two. The producer keeps its own cursor locally and
+// caches the consumer's, reloading it only when the cached value says the ring is too
+// full, so a block normally costs a single release store to the producer's cursor.
+class SpscRingProducer
+{
+public:
+    void attach(std::atomic<std::uint64_t>& writeCursorToUse,
+                std::atomic<std::uint64_t>& readCursorToUse,
+                std::uint32_t capacityFrames) noexcept
+    {
+        writeCursor = &writeCursorToUse;
+        readCursor = &readCursorToUse;
+        mask = capacityFrames - 1;
+        localWrite = writeCursor->load(std::memory_order_relaxed);
+        cachedRead = readCursor->load(std::memory_order_acquire);
+    }
+
+    void detach() noexcept
+    {
+        writeCursor = nullptr;
+        readCursor = nullptr;
+        mask = 0;
+        localWrite = 0;
+        cachedRead = 0;
+    }
+
+    [[nodiscard]] bool isAttached() const noexcept
+    {
+        return writeCursor != nullptr;
+    }
+
+    [[nodiscard]] std::uint32_t capacity() const noexcept
+    {
+        return isAttached() ? mask + 1 : 0;
+    }
+
+    // Fill level as last observed by the producer; an upper bound on the real value.
+    [[nodiscard]] std::uint32_t queuedFrames() const noexcept
+    {
+        return static_cast<std::uint32_t>(localWrite - cachedRead);
+    }
+
+    [[nodiscard]] std::uint64_t cursor() const noexcept
+    {
+        return localWrite;
+    }
+
+    // Reserves space for exactly `frames` frames, or fails without side effects.
+    [[nodiscard]] bool prepareWrite(std::uint32_t frames, SpscRingRegions& regions) noexcept
+    {
+        if (!isAttached() || frames > capacity())
+        {
+            return false;
+        }
+
+        if (capacity() - queuedFrames() < frames)
+        {
+            cachedRead = readCursor->load(std::memory_order_acquire);
+            if (capacity() - queuedFrames() < frames)
+            {
+                return false;
+            }
+        }
+
+        regions = detail::makeRingRegions(localWrite, frames, mask);
+        return true;
+    }
+
+    void commitWrite(std::uint32_t frames) noexcept
+    {
+        localWrite += frames;
+        writeCursor->store(localWrite, std::memory_order_release);
+    }
+
+private:
+    std::atomic<std::uint64_t>* writeCursor = nullptr;
+    std::atomic<std::uint64_t>* readCursor = nullptr;
+    std::uint32_t mask = 0;
+    std::uint64_t localWrite = 0;
+    std::uint64_t cachedRead = 0;
+};
+
+// Consumer half of the ring; see SpscRingProducer for the cursor scheme.
+class SpscRingConsumer
+{
+public:
+    void attach(std::atomic<std::uint64_t>& writeCursorToUse,
+                std::atomic<std::uint64_t>& readCursorToUse,
+                std::uint32_t capacityFrames) noexcept
+    {
+        writeCursor = &writeCursorToUse;
+        readCursor = &readCursorToUse;
+        mask = capacityFrames - 1;
+        localRead = readCursor->load(std::memory_order_relaxed);
+        cachedWrite = writeCursor->load(std::memory_order_acquire);
+    }
+
+    void detach() noexcept
+    {
+        writeCursor = nullptr;
+        readCursor = nullptr;
+        mask = 0;
+        localRead = 0;
+        cachedWrite = 0;
+    }
+
+    [[nodiscard]] bool isAttached() const noexcept
+    {
+        return readCursor != nullptr;
+    }
+
+    [[nodiscard]] std::uint32_t capacity() const noexcept
+    {
+        return isAttached() ? mask + 1 : 0;
+    }
+
+    [[nodiscard]] std::uint64_t cursor() const noexcept
+    {
+        return localRead;
+    }
+
+    // Reloads the producer's cursor and returns the number of frames ready to read.
+    [[nodiscard]] std::uint32_t readableFrames() noexcept
+    {
+        if (!isAttached())
+        {
+            return 0;
+        }
+
+        cachedWrite = writeCursor->load(std::memory_order_acquire);
+        const auto available = cachedWrite - localRead;
+        if (available > capacity())
+        {
+            // The producer reset or re-seeded its cursor; skip to its position rather
+            // than read frames that were never written.
+            localRead = cachedWrite;
+            readCursor->store(localRead, std::memory_order_release);
+            return 0;
+        }
+
+        return static_cast<std::uint32_t>(available);
+    }
+
+    // Maps up to `maxFrames` readable frames; an empty result means nothing is ready.
+    [[nodiscard]] SpscRingRegions prepareRead(std::uint32_t maxFrames) noexcept
+    {
+        auto available = static_cast<std::uint32_t>(cachedWrite - localRead);
+        if (available < maxFrames)
+        {
+            available = readableFrames();
+        }
+
+        const auto frames = available < maxFrames ? available : maxFrames;
+        return detail::makeRingRegions(localRead, frames, mask);
+    }
+
+    void commitRead(std::uint32_t frames) noexcept
+    {
+        localRead += frames;
+        readCursor->store(localRead, std::memory_order_release);
+    }
+
+private:
+    std::atomic<std::uint64_t>* writeCursor = nullptr;
+    std::atomic<std::uint64_t>* readCursor = nullptr;
+    std::uint32_t mask = 0;
+    std::uint64_t localRead = 0;
+    std::uint64_t cachedWrite = 0;
+};
+} // namespace oceanaudio
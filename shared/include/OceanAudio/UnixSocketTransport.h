@@ -0,0 +1,440 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <OceanAudio/BroadcastRing.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Socket transport for the bridge (Linux). The producer creates the ring in a memfd and
+// its events as eventfds, and hands all of them to each consumer over a Unix domain
+// socket with SCM_RIGHTS. The socket is only the control plane: audio still goes
+// through the shared ring and the eventfds, exactly as with the named mapping. Nothing
+// is reachable by name except the socket, so a crashed producer leaves no mapping
+// behind and only processes allowed to connect to the socket can map the ring.
+namespace oceanaudio::posix
+{
+inline constexpr char kBridgeSocketName[] = "OceanAudio_AudioRing.sock";
+inline constexpr char kAnonymousMappingName[] = "OceanAudio_AudioRing";
+
+// Descriptors sent with every announcement, in this order: the ring, the consumed
+// event, then one ready event per reader slot.
+inline constexpr std::size_t kAnnouncedRingDescriptor = 0;
+inline constexpr std::size_t kAnnouncedConsumedEventDescriptor = 1;
+inline constexpr std::size_t kAnnouncedReadyEventDescriptor = 2;
+inline constexpr std::size_t kAnnouncedDescriptorCount = kAnnouncedReadyEventDescriptor + kMaxBroadcastReaders;
+
+// $XDG_RUNTIME_DIR is per user and private to them; /tmp is the fallback for sessions
+// without one.
+inline std::string defaultBridgeSocketPath()
+{
+    const char* runtimeDirectory = std::getenv("XDG_RUNTIME_DIR");
+    std::string path = runtimeDirectory != nullptr && runtimeDirectory[0] != '\0' ? runtimeDirectory : "/tmp";
+    path += '/';
+    path += kBridgeSocketName;
+    return path;
+}
+
+// The message that carries the descriptors. The producer sends one to every client when
+// it connects and again whenever it replaces the mapping.
+struct SocketBridgeAnnouncement
+{
+    static constexpr std::uint32_t kMagic = 0x4B53414F; // 'OASK'
+
+    std::uint32_t magic = kMagic;
+    // SharedAudioRingBufferHeader::kVersion of the announced ring.
+    std::uint32_t layoutVersion = 0;
+    std::uint32_t descriptorCount = 0;
+    std::uint32_t reserved = 0;
+};
+
+// Descriptors received with an announcement. Whatever the receiver does not take() is
+// closed with it.
+class AnnouncedDescriptors
+{
+public:
+    AnnouncedDescriptors() { std::fill(std::begin(descriptors), std::end(descriptors), -1); }
+    ~AnnouncedDescriptors() { reset(); }
+
+    AnnouncedDescriptors(const AnnouncedDescriptors&) = delete;
+    AnnouncedDescriptors& operator=(const AnnouncedDescriptors&) = delete;
+
+    [[nodiscard]] int get(std::size_t index) const noexcept { return descriptors[index]; }
+
+    // Hands ownership of one descriptor to the caller.
+    int take(std::size_t index) noexcept
+    {
+        const int descriptor = descriptors[index];
+        descriptors[index] = -1;
+        return descriptor;
+    }
+
+    // Takes ownership of `descriptor`, closing the one held at `index` before.
+    void adopt(std::size_t index, int descriptor) noexcept
+    {
+        if (descriptors[index] >= 0)
+        {
+            ::close(descriptors[index]);
+        }
+        descriptors[index] = descriptor;
+    }
+
+    void swap(AnnouncedDescriptors& other) noexcept
+    {
+        std::swap(descriptors, other.descriptors);
+    }
+
+    void reset() noexcept
+    {
+        for (auto& descriptor : descriptors)
+        {
+            if (descriptor >= 0)
+            {
+                ::close(descriptor);
+                descriptor = -1;
+            }
+        }
+    }
+
+private:
+    int descriptors[kAnnouncedDescriptorCount];
+};
+
+// Sends the announcement with its descriptors; the caller keeps its own copies. Never
+// blocks: a client whose queue is full misses this one and picks up a later one.
+inline bool sendAnnouncement(int socket, const SocketBridgeAnnouncement& announcement, const int* descriptors)
+{
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kAnnouncedDescriptorCount)] {};
+    iovec payload {const_cast<SocketBridgeAnnouncement*>(&announcement), sizeof(announcement)};
+
+    msghdr message {};
+    message.msg_iov = &payload;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    auto* rights = CMSG_FIRSTHDR(&message);
+    rights->cmsg_level = SOL_SOCKET;
+    rights->cmsg_type = SCM_RIGHTS;
+    rights->cmsg_len = CMSG_LEN(sizeof(int) * kAnnouncedDescriptorCount);
+    std::memcpy(CMSG_DATA(rights), descriptors, sizeof(int) * kAnnouncedDescriptorCount);
+
+    return ::sendmsg(socket, &message, MSG_NOSIGNAL | MSG_DONTWAIT) == static_cast<ssize_t>(sizeof(announcement));
+}
+
+// Takes one queued announcement without blocking. False if none was queued or it was
+// malformed; `hungUp` is set once the producer has closed its end.
+inline bool receiveAnnouncement(int socket,
+                                SocketBridgeAnnouncement& announcement,
+                                AnnouncedDescriptors& received,
+                                bool& hungUp)
+{
+    received.reset();
+    hungUp = false;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kAnnouncedDescriptorCount)] {};
+    SocketBridgeAnnouncement incoming;
+    iovec payload {&incoming, sizeof(incoming)};
+
+    msghdr message {};
+    message.msg_iov = &payload;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    const auto bytes = ::recvmsg(socket, &message, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if (bytes <= 0)
+    {
+        hungUp = bytes == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+        return false;
+    }
+
+    // Keep every descriptor that arrived, so a malformed message cannot leak any.
+    std::size_t count = 0;
+    for (auto* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header))
+    {
+        if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+        {
+            continue;
+        }
+
+        const auto descriptorsInHeader = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (std::size_t index = 0; index < descriptorsInHeader; ++index)
+        {
+            int descriptor = -1;
+            std::memcpy(&descriptor, CMSG_DATA(header) + index * sizeof(int), sizeof(int));
+            if (count < kAnnouncedDescriptorCount)
+            {
+                received.adopt(count++, descriptor);
+            }
+            else
+            {
+                ::close(descriptor);
+            }
+        }
+    }
+
+    if (static_cast<std::size_t>(bytes) != sizeof(incoming) || (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0
+        || incoming.magic != SocketBridgeAnnouncement::kMagic || incoming.descriptorCount != kAnnouncedDescriptorCount
+        || count != kAnnouncedDescriptorCount)
+    {
+        received.reset();
+        return false;
+    }
+
+    announcement = incoming;
+    return true;
+}
+
+inline bool toSocketAddress(const std::string& path, sockaddr_un& address) noexcept
+{
+    address = {};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Producer end: a listening SOCK_SEQPACKET socket, so every announcement arrives as one
+// message with its descriptors. Driven from a control thread; nothing in it blocks.
+class BridgeSocketServer
+{
+public:
+    BridgeSocketServer() { std::fill(std::begin(currentDescriptors), std::end(currentDescriptors), -1); }
+    ~BridgeSocketServer() { close(); }
+
+    BridgeSocketServer(const BridgeSocketServer&) = delete;
+    BridgeSocketServer& operator=(const BridgeSocketServer&) = delete;
+
+    // Fails if another producer is already listening on `socketPath`; a socket file
+    // left by a dead one is replaced.
+    bool listen(const std::string& socketPath)
+    {
+        close();
+
+        sockaddr_un address {};
+        if (!toSocketAddress(socketPath, address))
+        {
+            return false;
+        }
+
+        const int probe = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (probe >= 0)
+        {
+            const bool inUse = ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+            ::close(probe);
+            if (inUse)
+            {
+                return false;
+            }
+        }
+        ::unlink(socketPath.c_str());
+
+        listener = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listener < 0)
+        {
+            return false;
+        }
+
+        if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+            || ::listen(listener, static_cast<int>(kMaxBroadcastReaders) * 2) != 0)
+        {
+            ::close(listener);
+            listener = -1;
+            return false;
+        }
+
+        path = socketPath;
+        return true;
+    }
+
+    void close() noexcept
+    {
+        for (const int client : clients)
+        {
+            ::close(client);
+        }
+        clients.clear();
+        withdraw();
+
+        if (listener >= 0)
+        {
+            ::close(listener);
+            listener = -1;
+            ::unlink(path.c_str());
+        }
+        path.clear();
+    }
+
+    [[nodiscard]] bool isListening() const noexcept { return listener >= 0; }
+    [[nodiscard]] const std::string& getPath() const noexcept { return path; }
+    [[nodiscard]] std::size_t clientCount() const noexcept { return clients.size(); }
+
+    // Makes this the mapping new clients receive and sends it to every connected one.
+    // The descriptors stay the caller's and must stay open until withdraw().
+    void announce(const SocketBridgeAnnouncement& announcement, const int* descriptors)
+    {
+        current = announcement;
+        std::copy(descriptors, descriptors + kAnnouncedDescriptorCount, currentDescriptors);
+        hasCurrent = true;
+        for (const int client : clients)
+        {
+            sendAnnouncement(client, current, currentDescriptors);
+        }
+    }
+
+    // No mapping any more; clients that connect from now on wait for the next one.
+    void withdraw() noexcept
+    {
+        hasCurrent = false;
+        std::fill(std::begin(currentDescriptors), std::end(currentDescriptors), -1);
+    }
+
+    // Accepts clients waiting to connect, sends them the current mapping, and forgets
+    // clients that hung up. Call it every few tens of milliseconds.
+    void acceptPending()
+    {
+        if (listener < 0)
+        {
+            return;
+        }
+
+        for (;;)
+        {
+            const int client = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0)
+            {
+                break;
+            }
+
+            clients.push_back(client);
+            if (hasCurrent)
+            {
+                sendAnnouncement(client, current, currentDescriptors);
+            }
+        }
+
+        for (std::size_t index = 0; index < clients.size();)
+        {
+            pollfd clientPoll {clients[index], 0, 0};
+            if (::poll(&clientPoll, 1, 0) > 0 && (clientPoll.revents & (POLLHUP | POLLERR)) != 0)
+            {
+                ::close(clients[index]);
+                clients[index] = clients.back();
+                clients.pop_back();
+                continue;
+            }
+            ++index;
+        }
+    }
+
+private:
+    std::string path;
+    int listener = -1;
+    std::vector<int> clients;
+    SocketBridgeAnnouncement current;
+    int currentDescriptors[kAnnouncedDescriptorCount];
+    bool hasCurrent = false;
+};
+
+// Consumer end.
+class BridgeSocketClient
+{
+public:
+    BridgeSocketClient() = default;
+    ~BridgeSocketClient() { close(); }
+
+    BridgeSocketClient(const BridgeSocketClient&) = delete;
+    BridgeSocketClient& operator=(const BridgeSocketClient&) = delete;
+
+    bool connect(const std::string& socketPath)
+    {
+        close();
+
+        sockaddr_un address {};
+        if (!toSocketAddress(socketPath, address))
+        {
+            return false;
+        }
+
+        connection = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (connection < 0)
+        {
+            return false;
+        }
+
+        if (::connect(connection, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() noexcept
+    {
+        if (connection >= 0)
+        {
+            ::close(connection);
+            connection = -1;
+        }
+    }
+
+    [[nodiscard]] bool isConnected() const noexcept { return connection >= 0; }
+
+    // Takes the newest mapping announced so far; older ones still queued were replaced
+    // and are closed unread. False if nothing new was announced. Closes the connection
+    // once the producer has hung up, so the caller knows to connect again.
+    bool receiveLatest(SocketBridgeAnnouncement& announcement, AnnouncedDescriptors& descriptors)
+    {
+        if (connection < 0)
+        {
+            return false;
+        }
+
+        bool received = false;
+        for (;;)
+        {
+            SocketBridgeAnnouncement next;
+            AnnouncedDescriptors nextDescriptors;
+            bool hungUp = false;
+            if (!receiveAnnouncement(connection, next, nextDescriptors, hungUp))
+            {
+                if (hungUp)
+                {
+                    close();
+                }
+                break;
+            }
+
+            // The one it replaces goes out of scope with nextDescriptors.
+            announcement = next;
+            descriptors.swap(nextDescriptors);
+            received = true;
+        }
+        return received;
+    }
+
+private:
+    int connection = -1;
+};
+} // namespace oceanaudio::posix
+
+#endif
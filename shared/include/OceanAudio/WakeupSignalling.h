@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+// Waiter-flag signalling for the bridge ring. A side that is about to block on its
+// event first raises its flag in the shared header; the other side only pays for the
+// kernel signal (SetEvent / FUTEX_WAKE) when it finds the flag raised, and clears it so
+// one sleep costs at most one signal.
+//
+// Both sides order "store my side, then load the peer's" with a sequentially
+// consistent fence, so at least one of them observes the other:
+//   sleeper:   announceSleep(flag); if (data available) cancelSleep(flag); else block;
+//   publisher: commit cursor (release); if (claimSleepingPeer(flag)) signal;
+namespace oceanaudio::wakeup
+{
+inline void announceSleep(std::atomic<std::uint32_t>& waitingFlag) noexcept
+{
+    waitingFlag.store(1u, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+inline void cancelSleep(std::atomic<std::uint32_t>& waitingFlag) noexcept
+{
+    waitingFlag.store(0u, std::memory_order_relaxed);
+}
+
+// Call after publishing. Returns true exactly once per announced sleep.
+inline bool claimSleepingPeer(std::atomic<std::uint32_t>& waitingFlag) noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return waitingFlag.load(std::memory_order_relaxed) != 0u
+           && waitingFlag.exchange(0u, std::memory_order_relaxed) != 0u;
+}
+
+inline void cpuRelax() noexcept
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+} // namespace oceanaudio::wakeup